@@ -44,6 +44,8 @@ class ABChunker : public AbstractChunker
         char *_pktSaved;
         unsigned int _x;
         unsigned int _y;
+        int _priority; // nice value of the capture thread (0 = unchanged)
+        bool _placed;
 };
 
 PELICAN_DECLARE_CHUNKER(ABChunker)
@@ -0,0 +1,101 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <cstddef>
+
+/**
+ * @file Affinity.h
+ */
+
+namespace pelican {
+class ConfigNode;
+
+namespace ampp {
+
+/**
+ * @class Affinity
+ *
+ * @brief
+ *    Process wide placement of threads on cores and of buffers on NUMA nodes
+ * @details
+ *    Configured from an
+ *    <Affinity capture="0-3" compute="4-15" io="16-19"
+ *              captureNode="0" computeNode="0" ioNode="1"/>
+ *    element in the configuration of a chunker or pipeline. Each thread
+ *    role is given a core list (see CPU_Resource::parseCpuList) and
+ *    optionally a NUMA node; if the node is not given it is the node of the
+ *    first core of the list. Roles without a core list are left alone.
+ *
+ *    Threads place themselves with pinCurrentThread() when they start, or
+ *    at the start of each task for pool threads (repeated calls for the
+ *    same role are free). A thread pinned to a role with a node also
+ *    prefers that node for its own allocations, so blobs sized by the
+ *    pipeline thread land on the compute node. OpenMP workers inherit the
+ *    placement of the thread that first starts a parallel region.
+ *
+ *    Buffers shared between roles (chunk buffers, dedispersion buffers)
+ *    are moved explicitly with bind().
+ *
+ *    Each placement is printed the first time it is made, and report()
+ *    prints them all.
+ */
+
+class Affinity
+{
+    public:
+        enum Role { Capture = 0, Compute, IO, Roles };
+
+    public:
+        /// the placement of this process
+        static Affinity& instance();
+
+        /// set the placement from an <Affinity> element. Roles not
+        //  mentioned keep their current placement
+        void configure( const ConfigNode& config );
+        void setCores( Role role, const QList<int>& cores, int node = -1 );
+
+        /// the cores of a role (empty if not placed)
+        QList<int> cores( Role role ) const;
+        /// the NUMA node of a role (-1 if none)
+        int node( Role role ) const;
+
+        /// pin the calling thread to the cores of a role. Returns false
+        //  if the role is not placed or pinning failed
+        bool pinCurrentThread( Role role, const QString& name );
+
+        /// move the pages of a buffer to the node of a role. Each address
+        //  is only moved once. Returns false if the role has no node or
+        //  binding failed
+        bool bind( const void* address, size_t bytes, Role role, const QString& name );
+
+        /// print where the threads and buffers have been placed
+        void report() const;
+
+        /// the name of a role
+        static QString roleName( Role role );
+
+        /// the NUMA node of a core (-1 if unknown)
+        static int nodeOfCore( int core );
+
+    private:
+        Affinity();
+        Affinity( const Affinity& );
+        void _record( const QString& line );
+
+    private:
+        mutable QMutex _mutex;
+        QList<int> _cores[Roles];
+        int _nodes[Roles];
+        unsigned _generation; // changes whenever the placement changes
+        QSet<const void*> _bound;
+        QStringList _placements;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // AFFINITY_H
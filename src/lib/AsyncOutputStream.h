@@ -0,0 +1,139 @@
+#ifndef ASYNCOUTPUTSTREAM_H
+#define ASYNCOUTPUTSTREAM_H
+
+#include "pelican/output/AbstractOutputStream.h"
+#include "pelican/utility/ConfigNode.h"
+#include "BlockingQueue.hpp"
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+
+/**
+ * @file AsyncOutputStream.h
+ */
+
+namespace pelican {
+class DataBlob;
+
+namespace ampp {
+
+/**
+ * @class AsyncOutputStream
+ *
+ * @brief
+ *    Runs another output stream on a dedicated I/O thread
+ * @details
+ *    sendStream() copies the blob and queues it for the I/O thread, which
+ *    passes it on to the wrapped writer, so a slow disk or socket no longer
+ *    stalls the thread calling dataOutput(). Blobs are written in order.
+ *
+ *    Configured with
+ *    <asyncOutput depth="8" policy="block" spill="32" warn="0.75"/>
+ *    When depth blobs are waiting a new blob is handled according to policy:
+ *      block - wait for the writer to catch up (the default)
+ *      drop  - discard the new blob
+ *      spill - keep queueing, up to spill more blobs, then block
+ *    A warning is printed when the queue passes warn * depth.
+ *
+ *    Only blob types that can be copied here (the spectrum and time series
+ *    data sets) are queued; others, such as analysis results that refer
+ *    to pooled data, are written on the calling thread.
+ *
+ *    The writers are registered as Async<Writer>, e.g. AsyncSigprocStokesWriter,
+ *    and read their own options from the same configuration node.
+ *    statistics() gives the queue depth and the write latency.
+ */
+
+class AsyncOutputStream : public AbstractOutputStream
+{
+    public:
+        enum Policy { Block, Drop, Spill };
+
+        /// queue and writer performance
+        struct Statistics {
+            unsigned queued;   // blobs queued for the I/O thread
+            unsigned written;  // blobs written (including on the calling thread)
+            unsigned dropped;
+            unsigned spilled;  // blobs queued beyond the depth
+            int depth;         // blobs waiting now
+            int maxDepth;
+            double meanLatency; // mean time (s) from sendStream to written
+            double maxLatency;
+            double meanWrite;   // mean time (s) in the wrapped writer
+            double maxWrite;
+            double blocked;     // total time (s) the caller spent blocked
+        };
+
+    public:
+        /// takes ownership of the writer
+        AsyncOutputStream( const ConfigNode& config, AbstractOutputStream* writer );
+        ~AsyncOutputStream();
+
+        /// the wrapped writer
+        AbstractOutputStream* writer() const { return _writer; }
+
+        /// wait until all the queued blobs have been written
+        void flush();
+
+        Statistics statistics() const;
+
+        /// print the statistics to stdout
+        void report() const;
+
+        /// return a copy of the blob that can be written later, or 0 if
+        //  the type is not supported
+        static DataBlob* copyBlob( const DataBlob* blob );
+
+    protected:
+        virtual void sendStream( const QString& streamName, const DataBlob* dataBlob );
+
+    private:
+        struct Item {
+            QString stream;
+            DataBlob* blob; // 0 to stop the thread
+            double queued;  // time (s) at sendStream
+        };
+        class Worker;
+        friend class Worker;
+        void _run();
+        void _write( const QString& stream, const DataBlob* blob, double queued );
+        static double _now();
+
+    private:
+        AbstractOutputStream* _writer;
+        BlockingQueue<Item> _queue;
+        Worker* _thread;
+        Policy _policy;
+        int _depth;
+        int _spill;
+        int _warnDepth;
+        bool _warned;
+
+        QMutex _writerMutex;
+        mutable QMutex _mutex; // the statistics
+        QMutex _flushMutex;
+        QWaitCondition _drained;
+        int _pending; // blobs queued and not yet written
+        unsigned _queued, _written, _dropped, _spilled;
+        int _maxDepth;
+        double _latencySum, _maxLatency;
+        double _writeSum, _maxWrite;
+};
+
+/**
+ * @class AsyncOutput
+ *
+ * @brief
+ *    An AsyncOutputStream around a particular writer type
+ */
+template<typename WriterT>
+class AsyncOutput : public AsyncOutputStream
+{
+    public:
+        AsyncOutput( const ConfigNode& config )
+            : AsyncOutputStream( config, new WriterT( config ) ) {}
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // ASYNCOUTPUTSTREAM_H
@@ -5,6 +5,7 @@
 #include "pelican/core/AbstractModule.h"
 #include <boost/function.hpp>
 #include "ProcessingChain1.h"
+#include "DataBlobLockCounter.h"
 #include <iostream>
 
 /**
@@ -23,7 +24,20 @@ class GPU_Manager;
  * @brief
  *     Base class for Asyncronous Pelican Modules
  * @details
- * 
+ *     Jobs are run on all the NVidia cards found. Host worker pools
+ *     (CPU_Resource) can be added with
+ *     <hostResources count="1" threads="8" cpus="0-7"/>, by default one
+ *     pool of all cores is used if there are no cards.
+ *
+ *     Jobs are submitted with the module's <priority value="0"/>; higher
+ *     priority jobs are taken first when resources are contended. Timing
+ *     statistics are collected under the module's type name.
+ *
+ *     DataBlobs that carry a DataBlobLockCounter (e.g. the SpectrumDataSet
+ *     types) are locked with an atomic count on the blob itself, in a slot
+ *     reserved for this module; any other DataBlob, or every DataBlob once
+ *     all the slots are taken, falls back to a lock table protected by
+ *     lockerMutex.
  */
 
 class AsyncronousModule : public AbstractModule
@@ -49,8 +63,12 @@ class AsyncronousModule : public AbstractModule
         /// return the number of locks for the specified object
         int lockNumber( const DataBlob* ) const;
 
-        /// block the thread until all asyncronous jobs have completed
-        void waitForJobCompletion() const;
+        /// block the thread until all asyncronous jobs have completed,
+        //  or until timeout ms have passed. Returns false on timeout
+        bool waitForJobCompletion( unsigned long timeout = ULONG_MAX ) const;
+
+        /// the time taken by the last waitForJobCompletion call (ms)
+        int lastDrainTime() const;
 
     protected:
         /// queue a GPU_Job for submission
@@ -76,20 +94,38 @@ class AsyncronousModule : public AbstractModule
         void lock( const DataBlob* );
 
         // mark DataBlob as being in use
-        // without invoking the lock mutex
+        // without invoking the lock mutex for DataBlobs without
+        // their own lock counter
         // (Assumes you have done this already)
         inline void lockUnprotected( const DataBlob* d ) {
-            ++_dataLocker[d];
+            const DataBlobLockCounter* counter = lockCounter(d);
+            if( counter ) counter->addLock( _lockSlot );
+            else ++_dataLocker[d];
         }
 
-        /// mark a list of DataBlobs as being in use with a single
-        // mutex lock
+        /// mark a list of DataBlobs as being in use. The mutex
+        // is only taken for DataBlobs without their own lock counter
         template<class DataBlobPtr>
         void lock( const QList<DataBlobPtr>& data ) {
-            QMutexLocker lock(&lockerMutex);
-            foreach( const DataBlob* d, data ) {
-                ++_dataLocker[d];
-            }
+            lockAll( data );
+        }
+
+        /// mark all the DataBlobs in the ContainerType as locked. The mutex
+        // is taken once, and only if some of the DataBlobs have no lock counter
+        template<class ContainerType>
+        void lockAll( const ContainerType& data ) {
+             bool uncounted = false;
+             for(int i=0; i < data.size(); ++i ) {
+                const DataBlobLockCounter* counter = lockCounter( data[i] );
+                if( counter ) counter->addLock( _lockSlot );
+                else uncounted = true;
+             }
+             if( uncounted ) {
+                 QMutexLocker lock(&lockerMutex);
+                 for(int i=0; i < data.size(); ++i ) {
+                     if( ! lockCounter( data[i] ) ) ++_dataLocker[data[i]];
+                 }
+             }
         }
 
         /// mark all the DataBlobs in the ContainerType
@@ -108,6 +144,13 @@ class AsyncronousModule : public AbstractModule
     protected:
         static GPU_Manager* gpuManager();
 
+        /// return the lock counter carried by the DataBlob, if any and
+        //  if this module has a slot in it
+        inline const DataBlobLockCounter* lockCounter( const DataBlob* d ) const {
+            if( _lockSlot < 0 ) return 0;
+            return dynamic_cast<const DataBlobLockCounter*>(d);
+        }
+
     private:
         ProcessingChain1<DataBlob*>* _chain;
 
@@ -121,6 +164,9 @@ class AsyncronousModule : public AbstractModule
         QList<UnlockCallBackT> _unlockTriggers;
         QList<boost::function0<void> > _callbacks; // end of chain callbacks
         QList<DataBlob*> _recentUnlocked;
+        int _priority;
+        QString _jobType;
+        int _lockSlot; // DataBlobLockCounter slot, -1 if none was free
 };
 
 } // namespace ampp
@@ -0,0 +1,137 @@
+#ifndef BLOCKINGQUEUE_H
+#define BLOCKINGQUEUE_H
+#include <QQueue>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QMutexLocker>
+#include "TimerData.h"
+
+
+/**
+ * @file BlockingQueue.hpp
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class BlockingQueue
+ *  
+ * @brief
+ *    Bounded FIFO queue between threads
+ * @details
+ *    push() blocks while the queue is full and pop() while it is empty.
+ *    The occupancy seen by pop() and the time each side spends blocked
+ *    are accumulated for performance monitoring.
+ */
+
+template<typename T>
+class BlockingQueue
+{
+    public:
+        /// queue usage statistics
+        struct Statistics {
+            unsigned pops;
+            double meanOccupancy; // mean number of items waiting when pop() is called
+            int maxOccupancy;
+            double pushBlocked;   // total time (s) spent waiting in push()
+            double popBlocked;    // total time (s) spent waiting in pop()
+        };
+
+    public:
+        BlockingQueue( int capacity = 1 )
+            : _capacity(capacity), _pops(0), _occupancySum(0), _maxOccupancy(0) {};
+        ~BlockingQueue() {};
+
+        /// set the maximum number of items held
+        void setCapacity( int capacity ) {
+            QMutexLocker lock(&_mutex);
+            _capacity = capacity;
+            _notFull.wakeAll();
+        }
+        int capacity() const { return _capacity; }
+
+        /// add an item to the back of the queue, blocking while it is full
+        void push( const T& item ) {
+            QMutexLocker lock(&_mutex);
+            if( _queue.size() >= _capacity ) {
+                _pushWait.tick();
+                while( _queue.size() >= _capacity ) {
+                    _notFull.wait(&_mutex);
+                }
+                _pushWait.tock();
+            }
+            _queue.enqueue( item );
+            _notEmpty.wakeOne();
+        }
+
+        /// add an item if there is room, returning false if the queue is full
+        bool tryPush( const T& item ) {
+            QMutexLocker lock(&_mutex);
+            if( _queue.size() >= _capacity ) return false;
+            _queue.enqueue( item );
+            _notEmpty.wakeOne();
+            return true;
+        }
+
+        /// add an item regardless of the capacity
+        void forcePush( const T& item ) {
+            QMutexLocker lock(&_mutex);
+            _queue.enqueue( item );
+            _notEmpty.wakeOne();
+        }
+
+        /// remove the item at the front of the queue, blocking while it is empty
+        T pop() {
+            QMutexLocker lock(&_mutex);
+            int occupancy = _queue.size();
+            if( ! occupancy ) {
+                _popWait.tick();
+                while( _queue.isEmpty() ) {
+                    _notEmpty.wait(&_mutex);
+                }
+                _popWait.tock();
+            }
+            ++_pops;
+            _occupancySum += occupancy;
+            if( occupancy > _maxOccupancy ) _maxOccupancy = occupancy;
+            T item = _queue.dequeue();
+            _notFull.wakeOne();
+            return item;
+        }
+
+        /// the number of items waiting
+        int size() const {
+            QMutexLocker lock(&_mutex);
+            return _queue.size();
+        }
+
+        /// return the usage statistics so far
+        Statistics statistics() const {
+            QMutexLocker lock(&_mutex);
+            Statistics s;
+            s.pops = _pops;
+            s.meanOccupancy = _pops ? (double)_occupancySum / _pops : 0.0;
+            s.maxOccupancy = _maxOccupancy;
+            s.pushBlocked = _pushWait.timeAverage * _pushWait.counter;
+            s.popBlocked = _popWait.timeAverage * _popWait.counter;
+            return s;
+        }
+
+    private:
+        mutable QMutex _mutex;
+        QWaitCondition _notEmpty;
+        QWaitCondition _notFull;
+        QQueue<T> _queue;
+        int _capacity;
+        unsigned _pops;
+        unsigned long _occupancySum;
+        int _maxOccupancy;
+        TimerData _pushWait;
+        TimerData _popWait;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // BLOCKINGQUEUE_H 
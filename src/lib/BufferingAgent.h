@@ -3,11 +3,12 @@
 
 
 #include "pelican/core/AbstractDataClient.h"
-#include "LockingContainer.hpp"
+#include "TimerData.h"
 #include <QList>
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include <boost/function.hpp>
-#include <deque>
 
 /**
  * @file BufferingAgent.h
@@ -23,7 +24,10 @@ namespace ampp {
  * @brief
  *    A dedicated thread for buffering data 
  * @details
- * 
+ *    The agent thread fills up to queueLength DataBlobHash objects ahead of
+ *    the consumer. Both sides sleep on a wait condition when the queue is
+ *    full (agent) or empty (getData), and the time spent blocked on each side
+ *    is accumulated along with the queue occupancy seen by the consumer.
  */
 
 class BufferingAgent : public QThread
@@ -32,22 +36,52 @@ class BufferingAgent : public QThread
         typedef pelican::AbstractDataClient::DataBlobHash DataBlobHash;
         typedef boost::function1<void, DataBlobHash&> DataFetchFunction;
 
+        /// queue usage statistics
+        struct Statistics {
+            unsigned fetches;          // objects served by getData()
+            double meanOccupancy;      // mean number of objects ready when getData() is called
+            unsigned maxOccupancy;
+            double producerBlocked;    // total time (s) the agent waited for a free slot
+            double consumerBlocked;    // total time (s) getData() waited for data
+        };
+
     public:
-        BufferingAgent( const DataFetchFunction& fn );
+        BufferingAgent( const DataFetchFunction& fn, unsigned int queueLength = 3 );
         ~BufferingAgent();
 
         void run();
         void stop();
 
+        /// swap the next filled hash into the argument, blocking until
+        //  one is ready. Returns without touching hash if the agent is stopped
         void getData(DataBlobHash& hash);
 
+        /// the number of objects the agent will fetch ahead
+        unsigned int queueLength() const { return _max_queue_length; }
+
+        /// return the queue statistics so far
+        Statistics statistics() const;
+
+        /// print the queue statistics to stdout
+        void report() const;
+
     private:
         unsigned int _max_queue_length;
         bool _halt;
         DataFetchFunction _fn;
-        std::deque<DataBlobHash*> _queue; // objects ready for serving
+        mutable QMutex _mutex;
+        QWaitCondition _dataReady;  // signalled when an object is queued
+        QWaitCondition _spaceReady; // signalled when an object is freed
+        QList<DataBlobHash*> _queue; // objects ready for serving
+        QList<DataBlobHash*> _free;  // objects ready for filling
         QList<DataBlobHash> _buffer_objects;
-        LockingContainer<DataBlobHash> _buffer;
+
+        // statistics
+        unsigned _fetches;
+        unsigned long _occupancySum;
+        unsigned _maxOccupancy;
+        TimerData _producerWait;
+        TimerData _consumerWait;
 };
 
 } // namespace ampp
@@ -13,7 +13,9 @@ namespace ampp {
  *  
  * @brief
  *     Wraps another DataClient in the background, running it in its own thread
- * 
+ * @details
+ *     Up to <prefetch depth="3"/> data hashes are fetched ahead of the
+ *     pipeline.
  */
 
 template<class DataClientType>
@@ -29,6 +31,8 @@ class BufferingDataClient : public DataClientType
     private:
         // fn to execute the event loop
         //void exec();
+        // fetch data from the wrapped client (non-virtual call)
+        void _fetch(pelican::AbstractDataClient::DataBlobHash&);
 
     private:
         BufferingAgent _agent;
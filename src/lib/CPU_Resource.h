@@ -0,0 +1,91 @@
+#ifndef CPU_RESOURCE_H
+#define CPU_RESOURCE_H
+
+#include "GPU_Resource.h"
+#include <QList>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <boost/function.hpp>
+#include <vector>
+
+/**
+ * @file CPU_Resource.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+class GPU_Manager;
+
+/**
+ * @class CPU_Resource
+ *  
+ * @brief
+ *    A pool of host worker threads that a GPU_Manager can run GPU_Jobs on
+ * @details
+ *    Only jobs whose kernels all have a host implementation
+ *    (GPU_Kernel::hasHostImplementation()) are accepted. Each kernel's
+ *    runOnHost() method is called with this resource, and can spread its
+ *    work over the worker threads with parallelFor(). Each worker keeps
+ *    its own scratch memory between jobs.
+ *
+ *    If a list of cpus is given, worker i is pinned to cpus[i % size].
+ */
+
+class CPU_Resource : public GPU_Resource
+{
+    public:
+        typedef boost::function2<void, int, unsigned> TaskT; // (item, worker)
+
+    public:
+        CPU_Resource( unsigned threads, const QList<int>& cpus = QList<int>() );
+        ~CPU_Resource();
+
+        virtual bool canRun( GPU_Job* job ) const;
+
+        /// return the number of worker threads
+        unsigned threads() const { return _workers.size(); }
+
+        /// call task( i, worker ) for each i in [0, n) using all the
+        //  workers. Returns when all calls are complete.
+        void parallelFor( int n, const TaskT& task );
+
+        /// return the scratch memory belonging to a worker
+        std::vector<char>& scratch( unsigned worker ) { return _scratch[worker]; }
+
+        /// add host resources to the manager
+        static void initialiseResources( GPU_Manager* manager, unsigned resources,
+                                         unsigned threadsPerResource,
+                                         const QList<int>& cpus = QList<int>() );
+
+        /// convert a list of cpus such as "0-3,8,10-11"
+        static QList<int> parseCpuList( const QString& list );
+
+    protected:
+        virtual void run( GPU_Job* job );
+
+    private:
+        class Worker;
+        friend class Worker;
+        void _work( unsigned worker );
+
+    private:
+        QList<Worker*> _workers;
+        std::vector<std::vector<char> > _scratch;
+        QMutex _mutex;
+        QWaitCondition _start;
+        QWaitCondition _done;
+        const TaskT* _task;
+        int _items;
+        QAtomicInt _next;
+        unsigned _generation;
+        unsigned _busy;
+        bool _exit;
+        QString _error;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // CPU_RESOURCE_H 
@@ -0,0 +1,82 @@
+#ifndef CANDIDATEFILE_H
+#define CANDIDATEFILE_H
+
+#include <QtGlobal>
+
+class QIODevice;
+class QTextStream;
+
+/**
+ * @file CandidateFile.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class CandidateFile
+ *
+ * @brief
+ *    The binary candidate format written by DedispersionDataAnalysisOutput
+ * @details
+ *    A file is a Header followed by any number of Records, both 32 bytes
+ *    in the byte order of the machine that wrote them (recorded in the
+ *    header). Each searched buffer gives one Event record per candidate
+ *    followed by a Buffer record with the start of the buffer and its
+ *    best candidate, as in the "# Written buffer" lines of the text format.
+ *
+ *    writeText() gives the text format the writer produces, line for
+ *    line; the candidateConvert tool uses it to turn binary files back
+ *    into text.
+ */
+
+class CandidateFile
+{
+    public:
+        enum RecordType { Event = 0, Buffer = 1 };
+
+        struct Header {
+            char magic[8];       // "AMPPCAND"
+            quint32 version;
+            quint32 recordSize;  // sizeof(Record)
+            quint32 byteOrder;   // 0x01020304 as written
+            quint32 beam;
+            double created;      // unix time
+        };
+
+        struct Record {
+            double mjd;          // of the event, or the start of the buffer
+            float dm;            // of the event, or the best in the buffer
+            float snr;           // of the event, or the best in the buffer
+            quint32 width;       // matched filter width in samples (events)
+            quint32 buffer;      // count of buffers written, from 1
+            quint16 beam;
+            quint8 type;         // RecordType
+            quint8 degradation;  // load shedding level (see OverloadMonitor)
+            quint32 reserved;
+        };
+
+        static const quint32 version = 1;
+
+    public:
+        /// a header for a new file
+        static Header header( unsigned beam );
+
+        /// read and check the header, throwing a QString if the device
+        //  does not hold a candidate file this code can read
+        static Header readHeader( QIODevice& device );
+
+        /// read up to n records, returning the number read
+        static qint64 readRecords( QIODevice& device, Record* records, qint64 n );
+
+        /// the comment lines at the start of a text file
+        static void writeTextHeader( QTextStream& out );
+
+        /// a record in the text format
+        static void writeText( QTextStream& out, const Record& record );
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // CANDIDATEFILE_H
@@ -0,0 +1,155 @@
+#ifndef CHUNKCOMPRESSOR_H
+#define CHUNKCOMPRESSOR_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QList>
+#include <ostream>
+#include <vector>
+
+class QIODevice;
+
+/**
+ * @file ChunkCompressor.h
+ */
+
+namespace pelican {
+class ConfigNode;
+
+namespace ampp {
+
+/**
+ * @class ChunkCompressor
+ *
+ * @brief
+ *    Lossless compression of a writer's data in independent chunks
+ * @details
+ *    Configured in the writer's config node with
+ *    <compression active="true" chunkSize="4194304" level="1" threads="2"
+ *                 shuffle="true"/>
+ *
+ *    The data passed to write() is cut into chunks of chunkSize bytes.
+ *    Each chunk is bit-shuffled (bit i of every element of elementSize
+ *    bytes gathered into one plane), which turns the slowly varying
+ *    high bits of quantised or floating point spectra into long runs,
+ *    and then deflated at the given zlib level (1 is the fastest). A
+ *    chunk that does not shrink is stored as it is. Up to threads
+ *    chunks are compressed at once, and written out in order.
+ *
+ *    Each chunk in the file is a ChunkHeader followed by its data, so
+ *    a file can be read from the start without the index. finish()
+ *    appends the index, one IndexEntry per chunk holding where it is,
+ *    its compression ratio and the CPU time it took, and a Trailer at
+ *    the very end pointing at the index so readers can seek to any
+ *    chunk. All fields are in the byte order of the writing machine.
+ */
+
+class ChunkCompressor
+{
+    public:
+        enum Flags { Shuffled = 1, Deflated = 2 };
+
+        struct ChunkHeader {
+            char magic[8];          // "AMPZCHNK"
+            quint32 rawSize;
+            quint32 compressedSize; // of the data following the header
+            quint16 elementSize;    // bytes, for the shuffle
+            quint16 flags;          // Flags
+            quint32 reserved;
+        };
+
+        struct IndexEntry {
+            quint64 offset;         // of the ChunkHeader in the file
+            quint64 rawOffset;      // of the chunk in the uncompressed data
+            quint32 rawSize;
+            quint32 compressedSize;
+            float ratio;            // rawSize / compressedSize
+            float cpu;              // CPU seconds to shuffle and compress
+        };
+
+        struct Trailer {
+            char magic[8];          // "AMPZTAIL"
+            quint64 chunks;
+            quint64 indexOffset;    // of the "AMPZINDX" marker
+        };
+
+        /// totals over the chunks written
+        struct Statistics {
+            unsigned long chunks;
+            double rawBytes;
+            double compressedBytes;
+            double cpu;             // seconds, summed over the threads
+            double wall;            // seconds spent compressing
+        };
+
+    public:
+        ChunkCompressor( const ConfigNode& config );
+        ~ChunkCompressor();
+
+        bool active() const { return _active; }
+
+        /// the size of the elements to shuffle (4 for floats, 1 for
+        //  packed samples). Takes effect from the next start()
+        void setElementSize( unsigned bytes );
+
+        /// write chunks to out from its current position
+        void start( std::ostream& out );
+        bool started() const { return _out != 0; }
+
+        /// add data to be compressed
+        void write( const char* data, size_t size );
+
+        /// write out the last partial chunk and the index
+        void finish();
+
+        const Statistics& statistics() const { return _statistics; }
+
+        /// print the compression ratio and rate to stdout
+        void report( const char* name ) const;
+
+        /// true if the next bytes in the device are compressed chunks
+        //  (or the index that follows them)
+        static bool isCompressed( QIODevice* in );
+
+        /// read the chunk at the current position, returning its
+        //  uncompressed data. An empty array is returned at the index or
+        //  the end of the data. Throws a QString if the chunk is damaged
+        static QByteArray readChunk( QIODevice* in );
+
+        /// read the index from the end of a compressed file. The device
+        //  must be seekable; its position is left after the index
+        static QList<IndexEntry> readIndex( QIODevice* in );
+
+        /// bit-shuffle size bytes of elements of elementSize bytes.
+        //  Bytes beyond the last whole group of 8 elements are copied
+        static void shuffle( const char* in, char* out, size_t size, unsigned elementSize );
+        static void unshuffle( const char* in, char* out, size_t size, unsigned elementSize );
+
+    private:
+        // compress and write the n chunks filled in _raw
+        void _compress( int n, size_t lastSize );
+        static double _now();
+        static double _cpuTime();
+
+    private:
+        bool _active;
+        size_t _chunkSize;
+        int _level;
+        int _threads;
+        bool _shuffle;
+        unsigned _elementSize;
+        std::ostream* _out;
+        quint64 _offset;           // in the file
+        quint64 _rawOffset;
+        std::vector<char> _raw;    // threads chunks
+        size_t _fill;
+        std::vector< std::vector<char> > _shuffled; // per chunk scratch
+        std::vector<QByteArray> _compressed;
+        std::vector<float> _cpu;
+        std::vector<IndexEntry> _index;
+        Statistics _statistics;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // CHUNKCOMPRESSOR_H
@@ -0,0 +1,80 @@
+#ifndef COREBUDGET_H
+#define COREBUDGET_H
+
+#include <QMutex>
+
+class QThreadPool;
+
+/**
+ * @file CoreBudget.h
+ */
+
+namespace pelican {
+class ConfigNode;
+
+namespace ampp {
+
+/**
+ * @class CoreBudget
+ *
+ * @brief
+ *    Process wide allocation of cores between the streams and modules
+ * @details
+ *    Configured from a pipeline's
+ *    <coreBudget cores="16" streams="2"/> element: cores is the number of
+ *    cores available to all the streams sharing the budget (default: all
+ *    the cores of the host), streams the number of streams sharing them,
+ *    whether they run as pipelines in this process or as separate
+ *    processes on the same host.
+ *
+ *    Each stream's modules size their OpenMP regions with threads(), which
+ *    never exceeds the stream's share of the cores. Asynchronous tasks of all
+ *    the streams in the process run on the one shared pool() (the Qt global
+ *    thread pool used by QtConcurrent), limited to the shares of the streams
+ *    registered in this process.
+ */
+
+class CoreBudget
+{
+    public:
+        /// the budget of this process
+        static CoreBudget& instance();
+
+        /// set the budget from a <coreBudget> element. Attributes not
+        //  present keep their current values
+        void configure( const ConfigNode& config );
+        void configure( unsigned cores, unsigned streams );
+
+        /// the cores shared by all the streams
+        unsigned cores() const;
+        /// the number of streams sharing the cores
+        unsigned streams() const;
+        /// the number of cores available to each stream
+        unsigned share() const;
+
+        /// the number of threads a module should use, given the number it
+        //  asked for (0 = as many as the budget allows)
+        unsigned threads( unsigned requested = 0 ) const;
+
+        /// record that a stream (pipeline) in this process is using the
+        //  budget, growing the shared pool by one share
+        void registerStream();
+
+        /// the pool shared by the asynchronous tasks of all the streams
+        QThreadPool* pool() const;
+
+    private:
+        CoreBudget();
+        CoreBudget( const CoreBudget& );
+        void _updatePool();
+
+    private:
+        mutable QMutex _mutex;
+        unsigned _cores;
+        unsigned _streams;
+        unsigned _localStreams; // streams registered in this process
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // COREBUDGET_H
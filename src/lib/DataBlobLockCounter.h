@@ -0,0 +1,54 @@
+#ifndef DATABLOBLOCKCOUNTER_H
+#define DATABLOBLOCKCOUNTER_H
+
+#include <QAtomicInt>
+
+/**
+ * @file DataBlobLockCounter.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class DataBlobLockCounter
+ *
+ * @brief
+ *    Intrusive reference count for DataBlobs shared with asynchronous tasks
+ * @details
+ *    DataBlobs that inherit from this class are locked and unlocked by the
+ *    AsyncronousModule with a single atomic operation rather than through
+ *    the module's lock table and mutex. The blob keeps a separate count
+ *    for each module (one slot per module, see AsyncronousModule), so
+ *    every module sees its own locks reach zero.
+ *    Copies of a blob start unlocked.
+ */
+
+class DataBlobLockCounter
+{
+    public:
+        /// the number of modules that can hold a count at the same time
+        enum { Slots = 8 };
+
+    public:
+        DataBlobLockCounter() {}
+        DataBlobLockCounter( const DataBlobLockCounter& ) {}
+        DataBlobLockCounter& operator=( const DataBlobLockCounter& ) { return *this; }
+
+        /// the number of locks currently held in the slot
+        int lockCount( int slot ) const { return (int)_locks[slot]; }
+
+        /// add a lock, returning the number of locks now held in the slot
+        int addLock( int slot ) const { return _locks[slot].fetchAndAddOrdered(1) + 1; }
+
+        /// remove a lock, returning the number of locks remaining in the slot
+        int removeLock( int slot ) const { return _locks[slot].fetchAndAddOrdered(-1) - 1; }
+
+    private:
+        mutable QAtomicInt _locks[Slots];
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // DATABLOBLOCKCOUNTER_H
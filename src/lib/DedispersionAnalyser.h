@@ -4,6 +4,10 @@
 
 #include "pelican/modules/AbstractModule.h"
 #include "DedispersionSpectra.h"
+#include "TimerData.h"
+#include <QList>
+#include <QAtomicInt>
+#include <vector>
 
 /**
  * @file DedispersionAnalyser.h
@@ -20,7 +24,10 @@ class DedispersionDataAnalysis;
  * @brief
  *    Extract astronomical events form dedispersion data
  * @details
- *
+ *    Each DM trial is convolved with boxcars of the widths given in
+ *    <boxcarWidths value="1,2,3,4,6,8"/> (full resolution samples,
+ *    default powers of 2 up to 2^power2ForBinning). DM trials are
+ *    searched in parallel directly from the DedispersionSpectra.
  */
 
 class DedispersionAnalyser : public AbstractModule
@@ -30,10 +37,35 @@ class DedispersionAnalyser : public AbstractModule
         ~DedispersionAnalyser();
         int analyse( DedispersionSpectra*, DedispersionDataAnalysis* );
 
+        /// return the boxcar widths searched
+        const QList<unsigned>& boxcarWidths() const { return _widths; }
+
+        /// raise the detection threshold by offset sigma (used to shed
+        //  load when overloaded). Takes effect from the next analyse()
+        void setThresholdOffset( float offset ) { _thresholdOffset = offset; }
+        float thresholdOffset() const { return _thresholdOffset; }
+
+    private:
+        struct Event {
+            int dm;
+            unsigned sample;
+            float width;
+            float value;
+        };
+        void _search( const float* trial, int nSamples, unsigned ds, int dm, float rms,
+                      float threshold,
+                      std::vector<double>& cumulative, std::vector<float>& boxcar,
+                      std::vector<Event>& events ) const;
+
     private:
         float _detectionThreshold; // self-explanatory
+        volatile float _thresholdOffset;
         unsigned _useStokesStats; // whether to use the noise values in the stokes blob or recompute
         unsigned _binPow2;
+        QList<unsigned> _widths;
+        TimerData _analysisTime;
+        QAtomicInt _buffers; // analysed, for the summary on shutdown
+        QAtomicInt _events;
 };
 
 PELICAN_DECLARE_MODULE(DedispersionAnalyser)
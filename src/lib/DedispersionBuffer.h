@@ -75,6 +75,18 @@ class DedispersionBuffer
                 return _inputBlobs; };
 
         std::vector<float>& getData() { return _timedata; };
+
+        /// also store the data quantised to 8 or 16 bit signed integers
+        //  as round(value * scale) (bits = 32 disables)
+        void setQuantisation( unsigned bits, float scale );
+        unsigned quantisationBits() const { return _bits; }
+        float quantisationScale() const { return _scale; }
+        std::vector<char>& getQuantisedData() { return _quantised; }
+
+        /// sum each group of factor samples in a channel ordered block
+        //  of nSamples per channel into out (nSamples/factor per channel)
+        static void downsample( const std::vector<float>& in, unsigned nSamples,
+                                unsigned factor, std::vector<float>& out );
         inline float rms() const { return _rms; };
         inline float mean() const { return _mean; };
 
@@ -84,18 +96,45 @@ class DedispersionBuffer
     private:
         unsigned int _addSamples( WeightedSpectrumDataSet* data, std::vector<float>& noiseTemplate, unsigned *sampleOffset, unsigned numSamples /* max number fo samples to insert */ );
         unsigned int _addSamples( SpectrumDataSetStokes* data, std::vector<float>& noiseTemplate, unsigned *sampleOffset, unsigned numSamples /* max number fo samples to insert */ );
+        inline void _set( unsigned index, float value );
+        template<typename T> inline T _quantise( float value, float max ) const;
         QList<SpectrumDataSetStokes* > _inputBlobs;
         std::vector<float> _timedata;
+        std::vector<char> _quantised;
+        unsigned _bits;
+        float _scale;
         unsigned int _nsamp;
         unsigned int _sampleCount;
         unsigned int _sampleSize;
         float _mean;
         float _rms;
         bool _invertChannels;
+        unsigned _threads; // OpenMP threads, within the core budget
         unsigned int  _firstSample;
         DEFINE_TIMER(_addSampleTimer)
 };
 
+template<typename T>
+inline T DedispersionBuffer::_quantise( float value, float max ) const {
+    float v = value * _scale;
+    v = ( v > max ) ? max : ( ( v < -max ) ? -max : v );
+    return (T)( v < 0.0f ? v - 0.5f : v + 0.5f );
+}
+
+inline void DedispersionBuffer::_set( unsigned index, float value ) {
+    _timedata[index] = value;
+    switch( _bits ) {
+        case 8:
+            reinterpret_cast<signed char*>(&_quantised[0])[index] = _quantise<signed char>( value, 127.0f );
+            break;
+        case 16:
+            reinterpret_cast<short*>(&_quantised[0])[index] = _quantise<short>( value, 32767.0f );
+            break;
+        default:
+            break;
+    }
+}
+
 } // namespace ampp
 } // namespace pelican
 #endif // DEDISPERSIONBUFFER_H
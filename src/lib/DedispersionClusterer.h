@@ -0,0 +1,67 @@
+#ifndef DEDISPERSIONCLUSTERER_H
+#define DEDISPERSIONCLUSTERER_H
+
+
+#include "pelican/modules/AbstractModule.h"
+#include "TimerData.h"
+#include <vector>
+
+/**
+ * @file DedispersionClusterer.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+class DedispersionDataAnalysis;
+
+/**
+ * @class DedispersionClusterer
+ *
+ * @brief
+ *    Merge the events found by the DedispersionAnalyser into candidates
+ * @details
+ *    A single bright pulse is detected in many neighbouring DM trials,
+ *    samples and boxcar widths. Events are linked (friends-of-friends) if
+ *    their DM indices differ by no more than the dm link and their time
+ *    spans (start to start + boxcar width) come within the time link of
+ *    each other. Each resulting cluster is reported as its highest S/N
+ *    event, with the extent and number of members of the cluster.
+ *
+ *    Events are sorted by time and split wherever no link can cross,
+ *    so that the independent groups can be clustered in parallel.
+ *
+ *    Configuration:
+ *    @verbatim
+ *    <DedispersionClusterer>
+ *        <link dm="2" time="4" />    (DM trials, full resolution samples)
+ *        <minMembers value="1" />     (smaller clusters are dropped)
+ *    </DedispersionClusterer>
+ *    @endverbatim
+ */
+
+class DedispersionClusterer : public AbstractModule
+{
+    public:
+        DedispersionClusterer( const ConfigNode& config );
+        ~DedispersionClusterer();
+
+        /// fill candidates with one event per cluster found in events
+        //  returns the number of candidates
+        int cluster( const DedispersionDataAnalysis* events,
+                     DedispersionDataAnalysis* candidates );
+
+    private:
+        int _find( std::vector<int>& parent, int i ) const;
+
+    private:
+        int _dmLink;
+        unsigned _timeLink;
+        unsigned _minMembers;
+        TimerData _clusterTime;
+};
+
+PELICAN_DECLARE_MODULE(DedispersionClusterer)
+} // namespace ampp
+} // namespace pelican
+#endif // DEDISPERSIONCLUSTERER_H
@@ -36,6 +36,7 @@ class DedispersionDataAnalysis : public DataBlob
 
         /// add an event
         void addEvent( unsigned dm, unsigned timeBin, float mfBinFactor, float mfBinValue );
+        void addEvent( const DedispersionEvent& event );
 
         /// return the number of events found
         int eventsFound() const; 
@@ -55,10 +56,16 @@ class DedispersionDataAnalysis : public DataBlob
         /// Set the rms of the data;                                                                                                                        
         void setRMS(float rms) { _rms = rms; }
 
+        /// the load shedding level in force when the data was searched
+        //  (0 = full processing, see OverloadMonitor)
+        int degradation() const { return _degradation; }
+        void setDegradation( int level ) { _degradation = level; }
+
     private:
         const DedispersionSpectra* _data;
         EventIndexT _eventIndex;
         float _rms;
+        int _degradation;
 };
 
 PELICAN_DECLARE_DATABLOB(DedispersionDataAnalysis)
@@ -3,9 +3,12 @@
 
 
 #include "pelican/output/AbstractOutputStream.h"
+#include "CandidateFile.h"
 #include <QTextStream>
 #include <QString>
+#include <QTime>
 #include <QMutexLocker>
+#include <vector>
 
 /**
  * @file DedispersionDataAnalysisOutput.h
@@ -15,6 +18,7 @@ namespace pelican {
 class ConfigNode;
 
 namespace ampp {
+class DedispersionDataAnalysis;
 
 /**
  * @class DedispersionDataAnalysisOutput
@@ -22,7 +26,15 @@ namespace ampp {
  * @brief
  *     Basic File Output for DedispersionDataAnalysis
  * @details
- * 
+ *     <format value="text"/> (the default) writes each candidate as a line
+ *     of text and flushes after every buffer. <format value="binary"/>
+ *     writes fixed size records (see CandidateFile) to a .cand file,
+ *     collected into batches of <batch records="4096" interval="1.0"/>:
+ *     a batch is written when it holds that many records or when interval
+ *     seconds have passed since the last write. candidateConvert turns
+ *     the binary files back into text.
+ *
+ *     The beam number recorded is taken from <beam id="0"/>.
  */
 
 class DedispersionDataAnalysisOutput : public AbstractOutputStream
@@ -36,11 +48,23 @@ class DedispersionDataAnalysisOutput : public AbstractOutputStream
         virtual void sendStream(const QString& streamName,
                                 const DataBlob* dataBlob);
 
+    private:
+        // the records for a buffer of candidates
+        void _addRecords( const DedispersionDataAnalysis* data );
+        // write out the records collected
+        void _writeBatch();
+
     private:
         QList<QTextStream*> _streams;
         QList<QIODevice*> _devices;
         time_t _epoch;
         int _indexOfDump;
+        bool _binary;
+        unsigned _beam;
+        unsigned _batchSize;
+        int _batchInterval; // ms
+        QTime _lastWrite;
+        std::vector<CandidateFile::Record> _batch;
         QMutex *_mutex;
 };
 
@@ -26,17 +26,31 @@ class DedispersionEvent
   DedispersionEvent( int dmIndex, unsigned timeIndex, const DedispersionSpectra* data, float mfBinFactor, float mfBinValue );
         ~DedispersionEvent();
         unsigned timeBin() const;
+        int dmIndex() const { return _dm; }
         double getTime() const;
         float dm() const;
         float amplitude() const;
         float mfValue() const;
         float mfBinning() const;
 
+        /// record the extent of the cluster this event is the peak of
+        void setCluster( int dmLow, int dmHigh, unsigned timeLow,
+                         unsigned timeHigh, unsigned members );
+        /// the number of events merged into this one (1 if not clustered)
+        unsigned members() const { return _members; }
+        float dmLow() const;
+        float dmHigh() const;
+        unsigned timeBinLow() const { return _timeLow; }
+        unsigned timeBinHigh() const { return _timeHigh; }
+
     private:
         int _dm;
         unsigned _time;
         const DedispersionSpectra* _data;
         float _mfBinFactor, _mfBinValue;
+        int _dmLow, _dmHigh;
+        unsigned _timeLow, _timeHigh;
+        unsigned _members;
 };
 
 } // namespace ampp
@@ -3,6 +3,7 @@
 #include <assert.h>
 #include <iostream>
 #include "stdio.h"
+#include <cfloat>
 #include "DedispersionParameters.h"
 
 // Stores temporary shift values
@@ -85,4 +86,191 @@ extern "C" void cacheDedisperseLoop( float *outbuff, long outbufSize, float *buf
                 mstartdm, mdmstep, dmShift, numSamples, maxshift, i_nchans );
 }
 
+//{{{ dedispersion of quantised input
+// As cache_dedisperse_loop, but the input is stored as integers
+// (value * scale). The sum over channels is exact in int32 and is
+// only scaled back to float when written out.
+template<typename T>
+__global__ void cache_dedisperse_loop_quantised(float *outbuff, const T *buff, float mstartdm,
+                                      float mdmstep, const float* dm_shifts,
+                                      const int i_nsamp, const int i_maxshift,
+                                      const int i_nchans, const float inv_scale )
+{
+
+    int   shift;
+    int   local_kernel_t[NUMREG];
+
+    int t  = blockIdx.x * NUMREG * DIVINT  + threadIdx.x;
+
+    for(int i = 0; i < NUMREG; i++) local_kernel_t[i] = 0;
+
+    float shift_temp = mstartdm + ((blockIdx.y * DIVINDM + threadIdx.y) * mdmstep);
+
+    for(int c = 0; c < i_nchans; c++) {
+        shift = (c * i_nsamp + t) + __float2int_rz (dm_shifts[c] * shift_temp);
+
+        #pragma unroll
+        for(int i = 0; i < NUMREG; i++) {
+            local_kernel_t[i] += buff[shift + (i * DIVINT) ];
+        }
+    }
+
+    #pragma unroll
+    for(int i = 0; i < NUMREG; i++) {
+        outbuff[((blockIdx.y * DIVINDM) + threadIdx.y)* (i_nsamp-i_maxshift) + (i * DIVINT) + (NUMREG * DIVINT * blockIdx.x) + threadIdx.x] = local_kernel_t[i] * inv_scale;
+    }
+}
+
+/// C Wrapper for quantised input (bits = 8 or 16)
+extern "C" void cacheDedisperseLoopQuantised( float *outbuff, long outbufSize, const void *buff,
+                                     int bits, float scale, float mstartdm,
+                                     float mdmstep, int tdms, int numSamples,
+                                     const float* dmShift,
+                                     const int maxshift,
+                                     const int i_nchans ) {
+
+    cudaMemset(outbuff, 0, outbufSize );
+    int divisions_in_t  = DIVINT;
+    int divisions_in_dm = DIVINDM - (tdms%DIVINDM);
+    int num_reg = NUMREG;
+    int num_blocks_t = (numSamples - maxshift)/(divisions_in_t * num_reg);
+    int num_blocks_dm = tdms/divisions_in_dm;
+
+    dim3 threads_per_block(divisions_in_t, divisions_in_dm);
+    dim3 num_blocks(num_blocks_t,num_blocks_dm);
+
+    if( bits == 8 ) {
+        cache_dedisperse_loop_quantised<signed char><<< num_blocks, threads_per_block >>>( outbuff,
+                (const signed char*)buff, mstartdm, mdmstep, dmShift, numSamples, maxshift,
+                i_nchans, 1.0f / scale );
+    } else {
+        cache_dedisperse_loop_quantised<short><<< num_blocks, threads_per_block >>>( outbuff,
+                (const short*)buff, mstartdm, mdmstep, dmShift, numSamples, maxshift,
+                i_nchans, 1.0f / scale );
+    }
+}
+
+//{{{ peak detection on the dedispersed data
+
+#define PEAK_THREADS 256
+
+// mean and rms of each DM trial (one block per trial)
+__global__ void dm_trial_stats( const float* plane, const int nsamp, float* stats )
+{
+    __shared__ float s_sum[PEAK_THREADS];
+    __shared__ float s_sq[PEAK_THREADS];
+
+    const float* trial = plane + (long)blockIdx.x * nsamp;
+    float sum = 0.0f;
+    float sq = 0.0f;
+    for(int t = threadIdx.x; t < nsamp; t += blockDim.x) {
+        float v = trial[t];
+        sum += v;
+        sq += v * v;
+    }
+    s_sum[threadIdx.x] = sum;
+    s_sq[threadIdx.x] = sq;
+    __syncthreads();
+    for(int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if( threadIdx.x < s ) {
+            s_sum[threadIdx.x] += s_sum[threadIdx.x + s];
+            s_sq[threadIdx.x] += s_sq[threadIdx.x + s];
+        }
+        __syncthreads();
+    }
+    if( threadIdx.x == 0 ) {
+        float mean = s_sum[0] / nsamp;
+        float var = s_sq[0] / nsamp - mean * mean;
+        stats[2 * blockIdx.x] = mean;
+        stats[2 * blockIdx.x + 1] = sqrtf( fmaxf( var, 1e-12f ) );
+    }
+}
+
+// best power of two boxcar in each summary block of each DM trial
+// grid is (summary blocks, DM trials). Each peak is stored as
+// [ S/N, start sample, width ] with samples scaled by sampleScale
+__global__ void boxcar_peaks( const float* plane, const int nsamp, const int blockSamples,
+                              const int maxWidth, const float* stats, float* peaks,
+                              const int sampleScale )
+{
+    __shared__ float s_snr[PEAK_THREADS];
+    __shared__ int s_time[PEAK_THREADS];
+    __shared__ int s_width[PEAK_THREADS];
+
+    int dm = blockIdx.y;
+    const float* trial = plane + (long)dm * nsamp;
+    float mean = stats[2 * dm];
+    float rms = stats[2 * dm + 1];
+
+    float best = -FLT_MAX;
+    int bestTime = 0;
+    int bestWidth = 1;
+    int end = min( (blockIdx.x + 1) * blockSamples, nsamp );
+    for(int t = blockIdx.x * blockSamples + threadIdx.x; t < end; t += blockDim.x) {
+        float sum = 0.0f;
+        int w = 0;
+        for(int width = 1; width <= maxWidth && t + width <= nsamp; width *= 2) {
+            for( ; w < width; ++w ) sum += trial[t + w];
+            float snr = (sum - width * mean) * rsqrtf( (float)width ) / rms;
+            if( snr > best ) {
+                best = snr;
+                bestTime = t;
+                bestWidth = width;
+            }
+        }
+    }
+    s_snr[threadIdx.x] = best;
+    s_time[threadIdx.x] = bestTime;
+    s_width[threadIdx.x] = bestWidth;
+    __syncthreads();
+    for(int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if( threadIdx.x < s && s_snr[threadIdx.x + s] > s_snr[threadIdx.x] ) {
+            s_snr[threadIdx.x] = s_snr[threadIdx.x + s];
+            s_time[threadIdx.x] = s_time[threadIdx.x + s];
+            s_width[threadIdx.x] = s_width[threadIdx.x + s];
+        }
+        __syncthreads();
+    }
+    if( threadIdx.x == 0 ) {
+        float* p = peaks + 3 * ((long)dm * gridDim.x + blockIdx.x);
+        p[0] = s_snr[0];
+        p[1] = (float)(s_time[0] * sampleScale);
+        p[2] = (float)(s_width[0] * sampleScale);
+    }
+}
+
+// the maximum S/N over all peaks (single block)
+__global__ void max_peak( const float* peaks, const long nPeaks, float* result )
+{
+    __shared__ float s_max[PEAK_THREADS];
+    float best = -FLT_MAX;
+    for(long i = threadIdx.x; i < nPeaks; i += blockDim.x) {
+        best = fmaxf( best, peaks[3 * i] );
+    }
+    s_max[threadIdx.x] = best;
+    __syncthreads();
+    for(int s = blockDim.x / 2; s > 0; s >>= 1) {
+        if( threadIdx.x < s ) s_max[threadIdx.x] = fmaxf( s_max[threadIdx.x], s_max[threadIdx.x + s] );
+        __syncthreads();
+    }
+    if( threadIdx.x == 0 ) *result = s_max[0];
+}
+
+/// C Wrapper for the peak finder. Returns the highest S/N found.
+//  maxSNR is a single float of device scratch memory
+extern "C" float dedispersedPeakFind( const float* plane, int tdms, int nsamp,
+                                      int blockSamples, int maxWidth, int sampleScale,
+                                      float* stats, float* peaks, float* maxSNR )
+{
+    int nBlocks = (nsamp + blockSamples - 1) / blockSamples;
+    dm_trial_stats<<< tdms, PEAK_THREADS >>>( plane, nsamp, stats );
+    dim3 num_blocks( nBlocks, tdms );
+    boxcar_peaks<<< num_blocks, PEAK_THREADS >>>( plane, nsamp, blockSamples,
+                                                  maxWidth, stats, peaks, sampleScale );
+    max_peak<<< 1, PEAK_THREADS >>>( peaks, (long)nBlocks * tdms, maxSNR );
+    float result;
+    cudaMemcpy( &result, maxSNR, sizeof(float), cudaMemcpyDeviceToHost );
+    return result;
+}
+
 #endif
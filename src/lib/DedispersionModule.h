@@ -5,18 +5,21 @@
 #include "boost/function.hpp"
 #include <QVector>
 #include <QList>
+#include <QMutex>
+#include <QWaitCondition>
 #include "pelican/core/AbstractModule.h"
 #include "pelican/utility/LockingCircularBuffer.hpp"
 #include "LockingContainer.hpp"
 #include "LockingPtrContainer.hpp"
 #include "DedispersionSpectra.h"
+#include "DedispersionPlan.h"
 #include "AsyncronousModule.h"
 #include "GPU_Kernel.h"
 #include "GPU_MemoryMap.h"
 #include "SpectrumDataSet.h"
 #include "timer.h"
+#include "TimerData.h"
 
-#ifdef CUDA_FOUND
 /**
  * @file DedispersionModule.h
  */
@@ -31,6 +34,7 @@ class GPU_Job;
 class GPU_Param;
 class GPU_NVidia;
 class DedispersionBuffer;
+class CPU_Resource;
 class LockingBuffer;
 
 /**
@@ -47,24 +51,40 @@ class DedispersionModule : public AsyncronousModule
    private:
         // the nvidia kernel description
         class DedispersionKernel : public GPU_Kernel {
-              float _startdm;
-              float _dmstep;
+              DedispersionPlan _plan;
               float _tsamp;
-              unsigned _tdms;
-              unsigned _totalNumberOfChannels;
               unsigned _nChans;
               unsigned _maxshift;
               unsigned _nsamples;
-              GPU_MemoryMapOutput _outputBuffer;
-              GPU_MemoryMap _inputBuffer;
+              QList<unsigned> _downsampleFactors; // distinct factors used by the plan
+              std::vector<std::vector<float> > _downsampled; // host buffers for each factor > 1
+              QList<GPU_MemoryMap> _inputBuffers; // one for each downsample factor
+              QList<GPU_MemoryMapOutput> _outputBuffers; // one for each segment
               GPU_MemoryMapConst _dmShift;
+              unsigned _inputBits; // 32 for float input
+              float _inputScale;
+              const std::vector<float>* _hostInput; // full resolution float data
+              // peak detection
+              unsigned _decimation; // 0 = export the full plane
+              unsigned _maxWidth;
+              float _triggerThreshold;
+              bool _planeExport; // false = never retrieve the full plane
+              DedispersionSpectra* _output;
+              QList<GPU_MemoryMap> _planeScratch; // device only dedispersed data
+              QList<GPU_MemoryMapOutput> _statsBuffers;
+              QList<GPU_MemoryMapOutput> _peakBuffers;
+              GPU_MemoryMap _maxSNR;
 
            public:
-              DedispersionKernel( float, float, float, float, unsigned, unsigned, unsigned );
+              DedispersionKernel( const DedispersionPlan&, float, unsigned, unsigned, unsigned );
               void setDMShift( std::vector<float>& );
-              void setOutputBuffer( std::vector<float>& );
-              void setInputBuffer( std::vector<float>&, GPU_MemoryMap::CallBackT );
+              void setPeakDetection( unsigned decimation, unsigned maxWidth, float trigger );
+              void setPlaneExport( bool e ) { _planeExport = e; }
+              void setOutputBuffer( DedispersionSpectra* );
+              void setInputBuffer( DedispersionBuffer*, GPU_MemoryMap::CallBackT );
               void run( GPU_NVidia& );
+              bool hasHostImplementation() const { return true; }
+              void runOnHost( CPU_Resource& );
               void cleanUp();
         };
 
@@ -75,8 +95,13 @@ class DedispersionModule : public AsyncronousModule
         /// read LO frequency from the redis database
         void getLOFreqFromRedis();
 
-        /// wait for all asyncronous tasks that have been launched to complete
-        void waitForJobCompletion();
+        /// wait for all asyncronous tasks that have been launched to complete,
+        //  or until timeout ms have passed. Returns false on timeout.
+        //  The time taken is recorded in drainTimer()
+        bool waitForJobCompletion( unsigned long timeout = ULONG_MAX );
+
+        /// timing of the waitForJobCompletion calls
+        const TimerData& drainTimer() const { return _drainTimer; }
 
         /// processing the incoming data, generating a new DedispersedSpectra in
         /// the process
@@ -106,8 +131,33 @@ class DedispersionModule : public AsyncronousModule
         /// deprecated
         int maxshift() const { return _maxshift; }
 
+        /// return the DM trials currently being searched
+        const DedispersionPlan& plan() const { return _plan; }
+
+        /// the frequency of the first channel and the channel width (MHz)
+        double fch1() const { return _fch1; }
+        double foff() const { return _foff; }
+
+        /// load shedding: if false the full dedispersed plane is not
+        //  retrieved from the device even when a peak exceeds the trigger
+        //  (peak detection only). Applies to buffers launched afterwards
+        void setPlaneExport( bool e ) { QMutexLocker lock(&_sheddingMutex); _planeExport = e; }
+        bool planeExport() const { QMutexLocker lock(&_sheddingMutex); return _planeExport; }
+
+        /// true if the peaks are searched on the device, i.e. the plane
+        //  export can be skipped
+        bool peakDetection() const { return _peakDecimation != 0; }
+
+        /// load shedding: search only the DM trials below dm, rounded up
+        //  to whole kernel blocks (at least one block is always searched).
+        //  Applies to buffers launched afterwards. 0 removes the limit
+        void setDMLimit( float dm ) { QMutexLocker lock(&_sheddingMutex); _dmLimit = dm; }
+        float dmLimit() const { QMutexLocker lock(&_sheddingMutex); return _dmLimit; }
+
      protected:
         void dedisperse( DedispersionBuffer* buffer, DedispersionSpectra* dataOut );
+        /// the part of the plan to search under the current DM limit
+        DedispersionPlan _activePlan() const;
         void _cleanBuffers();
 
     private:
@@ -119,6 +169,17 @@ class DedispersionModule : public AsyncronousModule
         unsigned _numSamplesBuffer;
         float _dmStep;
         float _dmLow;
+        float _dmHigh;
+        bool _autoPlan; // generate the DM trials from the observation parameters
+        DedispersionPlan _plan;
+        unsigned _inputBits; // storage of the full resolution input (8, 16 or 32)
+        float _inputScale;
+        unsigned _peakDecimation; // samples per peak summary block (0 = no peak detection)
+        unsigned _peakMaxWidth;
+        float _peakTrigger; // S/N above which the full plane is retrieved
+        mutable QMutex _sheddingMutex; // set by the pipeline, read on launch
+        bool _planeExport;
+        float _dmLimit;
         double _LOFreq;
         double _fch1;
         double _foff;
@@ -142,6 +203,12 @@ class DedispersionModule : public AsyncronousModule
         QList<DedispersionKernel*> _kernelList; // collection of pre-configured kernels
         LockingPtrContainer<DedispersionKernel> _kernels;
 
+        // buffers launched and not yet returned by the GPU
+        QMutex _inFlightMutex;
+        QWaitCondition _inFlightDone;
+        int _inFlight;
+        TimerData _drainTimer;
+
         // Timers
         DEFINE_TIMER( _copyTimer )
         DEFINE_TIMER( _bufferTimer )
@@ -153,5 +220,4 @@ class DedispersionModule : public AsyncronousModule
 PELICAN_DECLARE_MODULE(DedispersionModule)
 } // namespace ampp
 } // namespace pelican
-#endif // CUDA_FOUND
 #endif // DEDISPERSIONMODULE_H
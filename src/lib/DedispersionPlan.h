@@ -0,0 +1,112 @@
+#ifndef DEDISPERSIONPLAN_H
+#define DEDISPERSIONPLAN_H
+
+#include <QList>
+
+/**
+ * @file DedispersionPlan.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class DedispersionPlan
+ *
+ * @brief
+ *    Describes the DM trials to search as a series of segments,
+ *    each with its own DM step and time downsampling factor
+ * @details
+ *    At low DM the DM step is set by the sampling time. At high DM the
+ *    intra-channel dispersion smearing dominates, so both the DM step and
+ *    the time resolution can be relaxed without losing sensitivity.
+ *    generate() follows the DDplan approach: for each power of two
+ *    downsampling factor it chooses the largest DM step that keeps the
+ *    extra smearing within the requested tolerance, and moves on to the next
+ *    factor once the channel smearing exceeds the downsampled resolution.
+ *
+ *    Each segment is dedispersed in its own pass.
+ */
+
+class DedispersionPlan
+{
+    public:
+        class Segment {
+            public:
+                Segment( float dmLow = 0.0, float dmStep = 0.0,
+                         unsigned numberOfDMs = 0, unsigned downsample = 1 )
+                    : _dmLow(dmLow), _dmStep(dmStep), _numberOfDMs(numberOfDMs),
+                      _downsample(downsample) {}
+
+                /// the DM of the first trial
+                inline float dmLow() const { return _dmLow; }
+                /// the DM of the last trial
+                inline float dmHigh() const { return _dmLow + _dmStep * (_numberOfDMs - 1); }
+                inline float dmStep() const { return _dmStep; }
+                inline unsigned numberOfDMs() const { return _numberOfDMs; }
+                /// the number of input samples summed into each sample of this pass
+                inline unsigned downsample() const { return _downsample; }
+
+            private:
+                float _dmLow;
+                float _dmStep;
+                unsigned _numberOfDMs;
+                unsigned _downsample;
+        };
+
+    public:
+        DedispersionPlan();
+        ~DedispersionPlan();
+
+        /// replace the plan with a single full resolution segment
+        void setSingleSegment( float dmLow, float dmStep, unsigned numberOfDMs );
+
+        /// append a segment to the end of the plan
+        void addSegment( const Segment& segment ) { _segments.append( segment ); }
+
+        /// generate a plan covering dmLow to dmHigh for the given observation
+        //  parameters (frequencies in MHz, tsamp in seconds)
+        void generate( double fch1, double foff, unsigned nChannels, double tsamp,
+                       float dmLow, float dmHigh );
+
+        /// the acceptable ratio of the total smearing to the
+        //  smearing of an ideal search (must be > 1)
+        void setTolerance( float tolerance ) { _tolerance = tolerance; }
+        /// the intrinsic pulse width (in microseconds) assumed when planning
+        void setPulseWidth( float width ) { _pulseWidth = width; }
+        /// the largest time downsampling factor to use (a power of 2)
+        void setMaxDownsample( unsigned ds ) { _maxDownsample = ds; }
+        /// round the number of DMs in each segment up to a multiple of this
+        void setDMMultiple( unsigned m ) { _dmMultiple = m; }
+
+        /// return the segments in order of increasing DM
+        const QList<Segment>& segments() const { return _segments; }
+
+        /// return the total number of DM trials over all segments
+        unsigned numberOfDMs() const;
+
+        /// return the DM of the last trial in the plan
+        float dmHigh() const;
+
+        /// return the largest downsampling factor used in the plan
+        unsigned maxDownsample() const;
+
+        /// return the number of trial x sample operations needed
+        //  to dedisperse nSamples full resolution samples
+        double cost( unsigned nSamples ) const;
+
+        /// print the plan to stdout
+        void report() const;
+
+    private:
+        QList<Segment> _segments;
+        float _tolerance;
+        float _pulseWidth;
+        unsigned _maxDownsample;
+        unsigned _dmMultiple;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // DEDISPERSIONPLAN_H
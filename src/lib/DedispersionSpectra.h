@@ -3,9 +3,10 @@
 
 
 #include "pelican/data/DataBlob.h"
-#include "BinMap.h"
+#include "DedispersionPlan.h"
 #include <vector>
 #include <QList>
+#include <QVector>
 
 /**
  * @file DedispersionSpectra.h
@@ -15,6 +16,7 @@ namespace pelican {
 
 namespace ampp {
 class SpectrumDataSetStokes;
+class ChunkCompressor;
 
 /**
  * @class DedispersionSpectra
@@ -25,6 +27,10 @@ class SpectrumDataSetStokes;
  *    The dm spectra is a function of DM value vs. the total integral 
  *    of the power output at that dm.
  *    This class reprepesnts a collection of these spectra, one for each time slice
+ *
+ *    The DM trials may be split into segments (see DedispersionPlan), each
+ *    stored at its own time resolution. Within a segment the data for each
+ *    DM trial is contiguous, timeSamples()/downsampling() samples long.
  */
 
 class DedispersionSpectra : public DataBlob
@@ -33,6 +39,7 @@ class DedispersionSpectra : public DataBlob
         DedispersionSpectra();
         void resize( unsigned timebins, unsigned dedispersionBins, 
                      float dedispersionBinStart, float dedispersionBinWidth );
+        void resize( unsigned timebins, const DedispersionPlan& plan );
         ~DedispersionSpectra();
 
         /// return the Dedispersion (dm vs. integrated power from freq-time data)
@@ -49,6 +56,21 @@ class DedispersionSpectra : public DataBlob
         float dmAmplitude( unsigned timeSlice, float dm ) const;
         float dmAmplitude( unsigned timeSlice, int dm ) const;
 
+        /// return the samples for the specified DM trial
+        //  (timeSamples(dm) values)
+        const float* dmTrial( int dm ) const;
+        float* dmTrial( int dm );
+
+        /// return the number of samples stored for the specified DM trial
+        int timeSamples( int dm ) const;
+
+        /// return the number of full resolution samples summed into each
+        //  sample of the specified DM trial
+        unsigned downsampling( int dm ) const;
+
+        /// return the plan describing the DM trials
+        const DedispersionPlan& plan() const { return _plan; }
+
         /// return the index of the bin for a given dm value
         int dmIndex( float dm ) const;
         float dm( unsigned dm ) const;
@@ -61,10 +83,10 @@ class DedispersionSpectra : public DataBlob
         void setFirstSample( unsigned int sampleNumber );
 
         /// return the start of the maximum DM that can be represented in the data
-        float dmMax() const { return _dmBin.lastBinValue(); }
+        float dmMax() const { return _plan.dmHigh(); }
 
         /// return the number of dm bins
-        int dmBins() const { return _dmBin.numberBins(); }
+        int dmBins() const { return _dedispersionBins; }
         inline int timeSamples() const { return _timeBins; }
 
         double getTime( unsigned int sampleNumber ) const;
@@ -74,18 +96,59 @@ class DedispersionSpectra : public DataBlob
         /// Set the rms of the data;
         void setRMS(float rms) { _rms = rms; }
 
+        /// set up the compact peak summary, one entry per DM trial per
+        //  decimation full resolution samples. 0 disables the summary
+        void setPeakSummary( unsigned decimation );
+        bool hasPeakSummary() const { return _decimation > 0; }
+        unsigned decimation() const { return _decimation; }
+
+        /// return the number of summary blocks per DM trial
+        int summaryBlocks() const { return _summaryBlocks; }
+
+        /// return the best boxcar in the summary block as
+        //  [ S/N, first sample, width ] (in full resolution samples)
+        const float* peak( int dm, int block ) const {
+            return &_peaks[ 3 * ( (size_t)dm * _summaryBlocks + block ) ]; }
+        std::vector<float>& peaks() { return _peaks; }
+
+        /// return the mean and rms of each DM trial as measured
+        //  by the peak finder
+        float dmMean( int dm ) const { return _dmStats[ 2 * dm ]; }
+        float dmRMS( int dm ) const { return _dmStats[ 2 * dm + 1 ]; }
+        std::vector<float>& dmStatistics() { return _dmStats; }
+
+        /// true if data() holds the full DM-time plane.
+        //  With a peak summary the plane is only retrieved when triggered
+        bool hasFullPlane() const { return _fullPlane; }
+        void setFullPlane( bool full ) { _fullPlane = full; }
+
         /// Set flag for lost data;
 
         void setLost(unsigned int lost) { _lost = lost; }
         unsigned int getLost() const { return _lost; }
+
+        /// write data() to a file as floats in the byte order of this
+        //  machine, compressed in chunks by an active compressor
+        //  (see ChunkCompressor.h)
+        void dumpbin( const QString& fileName, ChunkCompressor* compressor = 0 ) const;
+    private:
+        int _segment( int dm ) const;
+
     private:
-        BinMap _dmBin;
+        DedispersionPlan _plan;
+        QVector<unsigned> _segmentFirstDM; // index of the first trial in each segment
+        QVector<size_t> _segmentOffset; // start of each segment in _data
         unsigned _timeBins;
         unsigned _dedispersionBins;
         unsigned _firstSampleNumber;
         float _rms;
         unsigned int _lost;
         std::vector<float> _data;
+        unsigned _decimation;
+        unsigned _summaryBlocks;
+        bool _fullPlane;
+        std::vector<float> _peaks;
+        std::vector<float> _dmStats;
         QList<SpectrumDataSetStokes* > _inputBlobs;
 };
 PELICAN_DECLARE_DATABLOB( DedispersionSpectra )
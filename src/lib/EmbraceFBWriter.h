@@ -8,23 +8,36 @@
 #include "pelican/output/AbstractOutputStream.h"
 #include "pelican/utility/ConfigNode.h"
 #include "pelican/data/DataBlob.h"
+#include "FileRotation.h"
+#include "ChunkCompressor.h"
 
 #include <QtCore/QDataStream>
 #include <QtCore/QFile>
 #include <fstream>
+#include <vector>
 
 namespace pelican {
 namespace ampp {
 
 class SpectrumDataSetStokes;
+class Quantiser;
 
 /**
  * @class EmbraceFBWriter
  *
  * @brief
- *
+ *    Writes the two polarisations of SpectrumDataSetStokes blobs to
+ *    separate SIGPROC filterbank files
  * @details
+ *    The output can be split into segments by size or duration, each
+ *    with its own headers (see FileRotation.h).
+ *
+ *    With <dataBits value="8|4|2|1"/> the samples are quantised and
+ *    packed by a Quantiser (see Quantiser.h for the scaling options).
  *
+ *    With <compression active="true" .../> the data following the headers
+ *    is compressed in chunks (see ChunkCompressor.h), and a z is added to
+ *    the file suffix.
  */
 
 class EmbraceFBWriter : public AbstractOutputStream
@@ -53,20 +66,29 @@ class EmbraceFBWriter : public AbstractOutputStream
         void WriteLong(QString name, long value);
         void writeHeader(SpectrumDataSetStokes* stokes);
         // Data helpers
+        void _openFiles();
+        void _nextSegment();
+        // data for polarisation p, through its compressor if active
+        void _writeData(unsigned p, const char* data, size_t size);
     protected:
         // buffer and write data in blocks
         void _write(char*,size_t);
-        inline void _float2int(const float *f, int *i);
 
     private:
         bool              _first;
+        bool              _writeHeader;
         QString           _filepath;
+        QString           _fileName1, _fileName2; // the current segment
+        FileRotation      _rotation;
+        ChunkCompressor   _compressor1, _compressor2;
         std::ofstream     _file1,_file2, _file;
         std::vector<char>  _buffer;
+        std::vector<float> _spectrum; // one spectrum in file order
+        std::vector<unsigned char> _packed;
+        Quantiser*    _quantiser;
         QString       _sourceNameX, _raStringX, _decStringX;
         QString       _sourceNameY, _raStringY, _decStringY;
         float         _fch1, _foff, _tsamp, _refdm, _clock, _raX, _decX, _raY, _decY;
-        float         _cropMin, _cropMax, _scaleDelta, _nRange; // for scaling floats to lesser values
         int           _nchans, _nTotalSubbands;
         int           _buffSize, _cur;
         unsigned int  _nRawPols, _nChannels, _nSubbands, _integration, _nPols;
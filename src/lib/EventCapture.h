@@ -0,0 +1,152 @@
+#ifndef EVENTCAPTURE_H
+#define EVENTCAPTURE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <vector>
+
+/**
+ * @file EventCapture.h
+ */
+
+namespace pelican {
+class ConfigNode;
+
+namespace ampp {
+class SpectrumDataSetStokes;
+class Quantiser;
+
+/**
+ * @class EventCapture
+ *
+ * @brief
+ *    Keeps the last few seconds of Stokes data in memory and writes out
+ *    the data around each trigger
+ * @details
+ *    add() copies the first polarisation of each blob into a ring of
+ *    spectra, in SIGPROC channel order and optionally quantised.
+ *    trigger() queues a window around an event. The window is widened by
+ *    the dispersion sweep across the band, so it holds the whole pulse at
+ *    every frequency. A writer thread saves each window to its own
+ *    SIGPROC filterbank file once the data after the event has arrived.
+ *
+ *    Configured with
+ *    <capture active="true" seconds="20" pre="0.5" post="0.5" dataBits="32"
+ *             directory="." maxPending="8" telescope="0" machine="9"/>
+ *    where seconds is the length of the ring and pre and post the data
+ *    kept either side of the event. With dataBits of 8, 4, 2 or 1 the
+ *    spectra are quantised with per channel adaptive scaling (see
+ *    Quantiser), which makes the ring that much longer for the same
+ *    memory.
+ *
+ *    Neither call waits for the disk. The writer copies the window out of
+ *    the ring a block at a time, holding the lock only for each copy. If
+ *    it falls so far behind that part of a window has been overwritten,
+ *    those spectra are skipped and counted as lost. Overlapping windows
+ *    are merged into one file, and triggers beyond maxPending waiting
+ *    windows are dropped.
+ */
+
+class EventCapture
+{
+    public:
+        /// capture performance
+        struct Statistics {
+            unsigned triggers;
+            unsigned merged;   // triggers added to a window already pending
+            unsigned dropped;  // triggers refused with maxPending waiting
+            unsigned files;
+            unsigned long long lost; // spectra overwritten before they were written
+            double bytes;
+        };
+
+    public:
+        EventCapture( const ConfigNode& config );
+        ~EventCapture();
+
+        /// return true if capturing has been configured
+        bool active() const { return _active; }
+
+        /// set the frequency of the first channel and the channel width
+        //  (MHz) used to calculate the dispersion sweep
+        void setBand( double fch1, double foff );
+
+        /// add a blob to the ring, overwriting the oldest data if full
+        void add( const SpectrumDataSetStokes* stokes );
+
+        /// capture the data around an event seen in the first channel
+        //  between start and end (data time, s) at dispersion measures up to dm
+        void trigger( double start, double end, float dm );
+
+        /// the dispersion delay (s) across the band at the given dm
+        double sweep( float dm ) const;
+
+        /// the time span (s) of data the ring can hold (0 before the first blob)
+        double length() const;
+
+        /// write out the pending windows now, with whatever data has
+        //  arrived, and wait until they are done
+        void flush();
+
+        /// the names of the files written
+        QStringList files() const;
+
+        Statistics statistics() const;
+
+        /// print the statistics to stdout
+        void report() const;
+
+    private:
+        struct Window {
+            double start;
+            double end;
+            float dm;
+        };
+        class Worker;
+        friend class Worker;
+        void _run();
+        void _resize( const SpectrumDataSetStokes* stokes );
+        bool _ready( const Window& w ) const;
+        unsigned long long _find( double time ) const;
+        void _write( const Window& w );
+
+    private:
+        bool _active;
+        double _seconds, _pre, _post;
+        unsigned _nBits;
+        int _maxPending;
+        int _telescope, _machine;
+        QString _directory;
+        double _fch1, _foff;
+
+        // written by add() only
+        Quantiser* _quantiser;
+        std::vector<float> _spectrum;
+        std::vector<unsigned char> _staging;
+
+        mutable QMutex _mutex;
+        QWaitCondition _changed;
+        QWaitCondition _idle;
+        std::vector<unsigned char> _ring;
+        std::vector<double> _times;    // of each spectrum in the ring
+        size_t _slots;
+        size_t _spectrumBytes;
+        unsigned _nChannels;
+        double _tsamp;
+        unsigned long long _count;     // spectra added since the start
+        unsigned _resets;              // times the ring has been resized
+        QList<Window> _pending;
+        bool _writing;
+        int _flushing;
+        bool _stop;
+        Worker* _thread;
+        QStringList _files;
+        Statistics _stats;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // EVENTCAPTURE_H
@@ -0,0 +1,74 @@
+#ifndef FILEROTATION_H
+#define FILEROTATION_H
+
+#include <QString>
+#include <fstream>
+#include <cstddef>
+
+/**
+ * @file FileRotation.h
+ */
+
+namespace pelican {
+class ConfigNode;
+
+namespace ampp {
+
+/**
+ * @class FileRotation
+ *
+ * @brief
+ *    Splits a writer's output into a series of segment files
+ * @details
+ *    Configured in the writer's config node with
+ *    <rotate size="4096" duration="3600" preallocate="true"/>
+ *    where size is in MB and duration in seconds of data. A new segment
+ *    is started before any blob that would take the current one past
+ *    either limit, so segments always hold whole blobs and each can be
+ *    given its own header. Every segment but the newest is complete and
+ *    can be processed while recording continues.
+ *
+ *    With a size limit each segment is preallocated to that size when it
+ *    is created and trimmed back to the data written when it is closed.
+ *
+ *    Without either limit a single file is written, named as before.
+ */
+
+class FileRotation
+{
+    public:
+        FileRotation( const ConfigNode& config );
+        ~FileRotation();
+
+        /// return true if the output is split into segments
+        bool active() const { return _maxBytes > 0 || _duration > 0.0; }
+
+        /// account for a blob of the given size, starting at the given
+        //  data time (s), and return true if it must start a new segment
+        bool next( double dataTime, size_t bytes );
+
+        /// the base file name (without suffix) for the next segment
+        QString nextName( const QString& prefix );
+
+        /// create a segment file and open the stream on it
+        void open( std::ofstream& file, const QString& filename );
+
+        /// close a segment file, trimming any unused preallocation
+        void close( std::ofstream& file, const QString& filename );
+
+        /// the number of segments started
+        int segments() const { return _segment; }
+
+    private:
+        size_t _maxBytes;
+        double _duration;
+        bool _preallocate;
+        int _segment;
+        bool _started;
+        double _startTime;
+        size_t _bytes;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // FILEROTATION_H
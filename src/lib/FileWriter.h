@@ -2,7 +2,8 @@
 #define FILEWRITER_H
 
 #include "LockingPtrContainer.hpp"
-#include <QMutex>
+#include <QList>
+#include <cstddef>
 
 /**
  * @file FileWriter.h
@@ -21,12 +22,21 @@ namespace ampp {
  * @details
  *     avoid overhead of ofstream for fast binary data
  *     output
+ *
+ *     Data is collected in page aligned blocks of blockSize bytes. Each
+ *     full block is written at its own offset in the background, so up
+ *     to buffers - 1 blocks can be in flight before write() waits.
+ *
+ *     With setDirect(true) the file is opened with O_DIRECT, bypassing the
+ *     page cache. flush() then writes the aligned part of the current
+ *     block directly and only the remainder through the page cache; the
+ *     remainder is written again once its block is full.
  */
 
 class FileWriter
 {
     public:
-        FileWriter(  );
+        FileWriter( size_t blockSize = 32768, int buffers = 3 );
         ~FileWriter();
         void write();
         void flush();
@@ -35,18 +45,29 @@ class FileWriter
         void write( const char* buffer, size_t length );
         void close();
 
+        /// use O_DIRECT from the next open(), where the file system allows
+        void setDirect( bool direct ) { _direct = direct; }
+        /// return true if the open file is being written with O_DIRECT
+        bool isDirect() const { return _isDirect; }
+        /// the size of each block written
+        size_t blockSize() const { return _bufSize; }
+
     private:
-        void _swap( char* buffer, size_t size);
-        void _flush( char* buffer, size_t size );
+        void _swap( char* buffer, size_t size, long offset );
+        void _flush( int handle, const char* buffer, size_t size, long offset );
+        void _wait();
 
     private:
         int _fileHandle;
-        int _pos;
-        int _bufSize;
+        int _tailHandle; // without O_DIRECT, for partial blocks
+        size_t _pos;
+        size_t _bufSize;
+        long _offset;    // file offset of the current buffer
+        bool _direct;
+        bool _isDirect;
         char* _currentBuffer;
         QList<char*> _buffersList;
         LockingPtrContainer<char> _buffers;
-        QMutex _mutex;
 };
 
 } // namespace ampp
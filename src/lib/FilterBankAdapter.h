@@ -4,6 +4,7 @@
 
 #include "pelican/core/AbstractStreamAdapter.h"
 #include "FilterBankHeader.h"
+#include <QByteArray>
 
 /**
  * @file FilterBankAdapter.h
@@ -21,7 +22,10 @@ class SpectrumDataSetStokes;
  *    Adapt a SigProc Filterbank Format stream
  *    into a StreamDataStokes data format
  * @details
- * 
+ *    Data compressed by the writers (see ChunkCompressor.h) is recognised
+ *    after the header. Each call then takes the next compressed chunk,
+ *    whatever the chunk size, and any partial spectrum at the end of the
+ *    chunk is kept for the next call.
  */
 
 class FilterBankAdapter : public AbstractStreamAdapter
@@ -40,6 +44,7 @@ class FilterBankAdapter : public AbstractStreamAdapter
 
     private:
         FilterBankHeader _header;
+        QByteArray _pending; // uncompressed data not yet adapted
         unsigned int _nSamplesPerTimeBlock;
         unsigned int _nPolarisations;
         unsigned int _nSubbands;
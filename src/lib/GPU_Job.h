@@ -4,6 +4,7 @@
 #include <QtCore/QList>
 #include <QtCore/QMutex>
 #include <QtCore/QWaitCondition>
+#include <QtCore/QString>
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 #include "GPU_MemoryMap.h"
@@ -52,6 +53,18 @@ class GPU_Job
         const QList<boost::function0<void> >& callBacks() const { return _callbacks; };
         void reset();
 
+        /// jobs of higher priority are run first
+        void setPriority( int priority ) { _priority = priority; }
+        int priority() const { return _priority; }
+
+        /// the name under which job timing statistics are collected
+        void setType( const QString& type ) { _type = type; }
+        const QString& type() const { return _type; }
+
+        /// times (monotonic clock, seconds) set by the GPU_Manager
+        void setQueuedTime( double t ) { _queuedTime = t; }
+        double queuedTime() const { return _queuedTime; }
+
     private:
         std::string _errorMsg;
         QList<GPU_Kernel*> _kernels;
@@ -61,6 +74,9 @@ class GPU_Job
         mutable QWaitCondition* _waitCondition;
         QList<boost::function0<void> > _callbacks;
         JobStatus _status;
+        int _priority;
+        QString _type;
+        double _queuedTime;
 };
 
 } // namespace ampp
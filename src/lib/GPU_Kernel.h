@@ -1,6 +1,7 @@
 #ifndef GPU_KERNEL_H
 #define GPU_KERNEL_H
 #include <QList>
+#include <QString>
 #include <GPU_Param.h>
 
 /**
@@ -11,6 +12,7 @@ namespace pelican {
 
 namespace ampp {
 class GPU_NVidia;
+class CPU_Resource;
 
 /**
  * @class GPU_Kernel
@@ -29,6 +31,13 @@ class GPU_Kernel
         // implement this method to run the nvidia kernel
         // using GPU_MemoryMap type to transfer data
         virtual void run( GPU_NVidia& ) = 0;
+        // reimplement these to allow the kernel to be run
+        // on a CPU_Resource. The host version reads and writes
+        // the host side of its GPU_MemoryMaps directly
+        virtual bool hasHostImplementation() const { return false; }
+        virtual void runOnHost( CPU_Resource& ) {
+            throw QString("GPU_Kernel: no host implementation");
+        }
         // this method will be called when something
         // goes wrong and the run is abandoned.
         // call any callbacks for the MemoryMap from here
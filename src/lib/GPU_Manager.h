@@ -3,8 +3,10 @@
 
 
 #include <QtCore/QList>
+#include <QtCore/QMap>
 #include <QtCore/QSet>
 #include <QtCore/QMutex>
+#include <QtCore/QString>
 #include "GPU_Resource.h"
 
 /**
@@ -26,17 +28,49 @@ class GPU_Job;
  *    As the resource becomes available, the next item from the queue
  *    is taken and executed.
  *
- *    Use the @code addResource() method to add GPU cards to be managed. Note that
- *    all the resources should be compatible with the types of jobs to be
- *    submitted - there is no checking of job suitability.
+ *    Use the @code addResource() method to add GPU cards (or CPU_Resources)
+ *    to be managed. A job is only given to a resource that reports it can
+ *    run it (GPU_Resource::canRun()).
  *
  *    call @code submit() to add a job to be processed. All job status 
  *    information/callbacks etc can be found through the GPU_Job interface.
+ *    Jobs are taken in order of GPU_Job::priority(), first come first
+ *    served within the same priority.
+ *
+ *    Each resource has its own dispatcher thread which runs the jobs and
+ *    their callbacks. The time each job spends queued and running is
+ *    collected for each GPU_Job::type().
  *
  */
 
 class GPU_Manager
 {
+    public:
+        /// counts of times in power of two bins
+        //  bin i counts times in [2^i, 2^(i+1)) microseconds
+        class TimeHistogram {
+            public:
+                static const int Bins = 32;
+                TimeHistogram();
+                void add( double seconds );
+                unsigned long bin( int i ) const { return _bins[i]; }
+                unsigned long count() const { return _count; }
+                double mean() const { return _count ? _sum / _count : 0.0; }
+                double max() const { return _max; }
+                /// return the time (seconds) below which the fraction f of times fall
+                double percentile( double f ) const;
+
+            private:
+                unsigned long _bins[Bins];
+                unsigned long _count;
+                double _sum;
+                double _max;
+        };
+
+        struct JobStatistics {
+            TimeHistogram queueWait;
+            TimeHistogram execution;
+        };
 
     public:
         GPU_Manager();
@@ -59,18 +93,30 @@ class GPU_Manager
         /// return number of resources managed
         int resources() const;
 
+        /// return the timing statistics for each job type
+        QMap<QString, JobStatistics> statistics() const;
+
+        /// print a summary of the timing statistics
+        void reportStatistics() const;
+
     private:
+        class Dispatcher;
+        friend class Dispatcher;
         void _matchResources();
+        void _dispatch( Dispatcher* );
         void _runJob( GPU_Resource*, GPU_Job* );
-        void _resourceFree( GPU_Resource* );
+        GPU_Job* _takeJob( GPU_Resource* );
 
     private:
         mutable QMutex _resourceMutex;
-        QList<GPU_Job*> _queue;
+        QMap<int, QList<GPU_Job*> > _queue; // by priority
         QList<GPU_Resource*> _resources;
-        QList<GPU_Resource*> _freeResource;
+        QList<Dispatcher*> _dispatchers;
+        QList<Dispatcher*> _idle;
         bool _destructor;
 
+        mutable QMutex _statsMutex;
+        QMap<QString, JobStatistics> _statistics;
 };
 
 } // namespace ampp
@@ -29,6 +29,10 @@ class GPU_Resource
         virtual ~GPU_Resource();
         void exec(GPU_Job*);
 
+        /// return true if the resource is able to run all the
+        //  kernels in the job
+        virtual bool canRun( GPU_Job* ) const { return true; }
+
     protected:
         virtual void run( GPU_Job* job) = 0;
 
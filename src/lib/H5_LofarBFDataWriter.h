@@ -94,6 +94,9 @@ class H5_LofarBFDataWriter : public AbstractOutputStream
         inline void _float2int(const float *f, int *i);
         void _setChannels( unsigned n );
         void _setPolsToWrite(unsigned p);
+        /// set how the raw data files are written (see FileWriter);
+        //  takes effect for files created by later calls to _setPolsToWrite
+        void _setFileOptions( bool direct, size_t blockSize, int buffers );
         inline unsigned polsToWrite() const { return _nPols; }
 
     protected:
@@ -106,6 +109,12 @@ class H5_LofarBFDataWriter : public AbstractOutputStream
         StokesType        _stokesType;
 
     private:
+        fileType* _newFile() const;
+
+    private:
+        bool          _directIO;
+        size_t        _blockSize;
+        int           _nBuffers;
         QString           _filePath;
         QString           _label;
         QString           _observationID;
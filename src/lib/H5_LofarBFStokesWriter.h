@@ -5,6 +5,7 @@
 #ifdef LOFAR_DAL_FOUND
 
 #include "H5_LofarBFDataWriter.h"
+#include <vector>
 
 /**
  * @file H5_LofarBFStokesWriter.h
@@ -13,6 +14,7 @@
 namespace pelican {
 
 namespace ampp {
+class Quantiser;
 
 /**
  * @class H5_LofarBFStokesWriter
@@ -30,6 +32,9 @@ namespace ampp {
  *    </H5_LofarBFStokesWriter>
  *
  *   other html tags from the base class should also be set
+ *
+ *   With <dataBits value="8|4|2|1"/> the samples are quantised and
+ *   packed by a Quantiser (see Quantiser.h for the scaling options).
  */
 
 class H5_LofarBFStokesWriter : public H5_LofarBFDataWriter
@@ -41,6 +46,11 @@ class H5_LofarBFStokesWriter : public H5_LofarBFDataWriter
     private:
         virtual void _writeData( const SpectrumDataSetBase* d );
 
+    private:
+        Quantiser* _quantiser;
+        std::vector<float> _spectrum; // one spectrum in file order
+        std::vector<unsigned char> _packed;
+
 };
 
 PELICAN_DECLARE(AbstractOutputStream, H5_LofarBFStokesWriter)
@@ -5,6 +5,7 @@
 #ifdef LOFAR_DAL_FOUND
 
 #include "H5_LofarBFDataWriter.h"
+#include <vector>
 
 /**
  * @file H5_LofarBFVoltageWriter.h
@@ -21,7 +22,10 @@ class SpectrumDataSetC32;
  * @brief
  *    Class to write out h5 Lofar data format voltages
  * @details
- *
+ *    The real and imaginary parts of each polarisation are split out for
+ *    a whole blob at a time and written in large blocks, by default with
+ *    O_DIRECT:
+ *    <directIO enabled="true" blockSize="4194304" buffers="4"/>
  */
 
 class H5_LofarBFVoltageWriter : public H5_LofarBFDataWriter
@@ -34,6 +38,8 @@ class H5_LofarBFVoltageWriter : public H5_LofarBFDataWriter
         void _writeData(const SpectrumDataSetBase* data);
 
     private:
+        std::vector<float> _real;
+        std::vector<float> _imag;
 };
 
 PELICAN_DECLARE(AbstractOutputStream, H5_LofarBFVoltageWriter)
@@ -0,0 +1,216 @@
+#ifndef LOCKFREEPOOL_H
+#define LOCKFREEPOOL_H
+#include <QList>
+#include <QVector>
+#include <QAtomicInt>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+
+/**
+ * @file LockFreePool.hpp
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class LockFreePool
+ *
+ * @brief
+ *    Bounded multi-producer multi-consumer pool of pointers to resources
+ * @details
+ *    The free objects are kept in a fixed size ring (a Vyukov style bounded
+ *    queue), each cell carrying a sequence number that tells producers and
+ *    consumers whether it is ready for them. next() and unlock() only touch
+ *    the mutex when a consumer has to sleep because the pool is empty.
+ *
+ *    Wait policy: a thread that finds the pool empty retries spinCount()
+ *    times (yielding between attempts) before parking on a wait condition.
+ *    The default of 0 parks straight away, which suits resources that are
+ *    held for a long time (GPU kernels, jobs).
+ *
+ *    Objects are handed out in the order they were returned, as with the
+ *    mutex based containers.
+ */
+
+template<typename T>
+class LockFreePool
+{
+    public:
+        /// counts of the events that indicate contention on the pool
+        struct Statistics {
+            int casRetries; // failed compare-and-swaps on the ring indices
+            int spins;      // empty-pool retries before parking
+            int parks;      // times a thread went to sleep waiting
+            int wakes;      // wake ups issued by unlock()
+        };
+
+    public:
+        LockFreePool() : _mask(0), _size(0), _spinCount(0) { _clearStatistics(); };
+        LockFreePool( const QList<T*>& objects ) : _spinCount(0) { reset(objects); };
+        ~LockFreePool() { QMutexLocker lock(&_mutex); _waitCondition.wakeAll(); };
+
+        /// set the objects to manage, all of which are marked as available.
+        //  Not thread safe with respect to the other methods
+        void reset( const QList<T*>& objects ) {
+             unsigned capacity = 2;
+             while( capacity < (unsigned)objects.size() ) capacity <<= 1;
+             _cells = QVector<Cell>( capacity );
+             _mask = capacity - 1;
+             for( unsigned i = 0; i < capacity; ++i ) {
+                 _cells[i].sequence = i;
+                 _cells[i].data = 0;
+             }
+             _enqueuePos = 0;
+             _dequeuePos = 0;
+             _waiting = 0;
+             _size = objects.size();
+             _clearStatistics();
+             for( int i = 0; i < objects.size(); ++i ) {
+                 _push( objects[i] );
+             }
+        }
+
+        /// return the next free resource, blocking until one becomes available
+        T* next() {
+            T* data;
+            for( int i = 0; i < _spinCount; ++i ) {
+                if( ( data = tryNext() ) ) return data;
+                _spins.fetchAndAddRelaxed(1);
+                QThread::yieldCurrentThread();
+            }
+            if( ( data = tryNext() ) ) return data;
+            QMutexLocker lock(&_mutex);
+            _waiting.fetchAndAddOrdered(1);
+            while( ! ( data = tryNext() ) ) {
+                _parks.fetchAndAddRelaxed(1);
+                _waitCondition.wait(&_mutex);
+            }
+            _waiting.fetchAndAddOrdered(-1);
+            return data;
+        }
+
+        /// return the next free resource, or 0 if none is available
+        T* tryNext() {
+            unsigned pos = (unsigned)(int)_dequeuePos;
+            forever {
+                Cell& cell = _cells[pos & _mask];
+                int dif = (int)( (unsigned)(int)cell.sequence - ( pos + 1 ) );
+                if( dif == 0 ) {
+                    if( _dequeuePos.testAndSetOrdered( (int)pos, (int)( pos + 1 ) ) ) {
+                        T* data = cell.data;
+                        cell.sequence.fetchAndStoreRelease( (int)( pos + _mask + 1 ) );
+                        return data;
+                    }
+                    _casRetries.fetchAndAddRelaxed(1);
+                }
+                else if( dif < 0 ) {
+                    return 0; // empty
+                }
+                pos = (unsigned)(int)_dequeuePos;
+            }
+        }
+
+        /// return a resource obtained with next() to the pool
+        void unlock( const T* data ) {
+            _push( const_cast<T*>(data) );
+            if( (int)_waiting > 0 ) {
+                QMutexLocker lock(&_mutex);
+                _wakes.fetchAndAddRelaxed(1);
+                _waitCondition.wakeOne();
+            }
+        }
+
+        /// the number of objects currently in the pool
+        int numberAvailable() const {
+            int n = (int)( (unsigned)(int)_enqueuePos - (unsigned)(int)_dequeuePos );
+            return ( n < 0 ) ? 0 : n;
+        }
+
+        /// return true only if there are no objects checked out
+        bool allAvailable() const {
+            return numberAvailable() == _size;
+        }
+
+        /// the number of objects managed
+        int size() const { return _size; }
+
+        /// the number of times to retry an empty pool before sleeping
+        void setSpinCount( int count ) { _spinCount = count; }
+        int spinCount() const { return _spinCount; }
+
+        /// return the contention counters accumulated since the last reset()
+        Statistics statistics() const {
+            Statistics s;
+            s.casRetries = (int)_casRetries;
+            s.spins = (int)_spins;
+            s.parks = (int)_parks;
+            s.wakes = (int)_wakes;
+            return s;
+        }
+
+    private:
+        struct Cell {
+            QAtomicInt sequence;
+            T* data;
+            Cell() : sequence(0), data(0) {}
+            Cell( const Cell& c ) : sequence((int)c.sequence), data(c.data) {}
+            Cell& operator=( const Cell& c ) { sequence = (int)c.sequence; data = c.data; return *this; }
+        };
+
+        void _push( T* data ) {
+            unsigned pos = (unsigned)(int)_enqueuePos;
+            forever {
+                Cell& cell = _cells[pos & _mask];
+                int dif = (int)( (unsigned)(int)cell.sequence - pos );
+                if( dif == 0 ) {
+                    if( _enqueuePos.testAndSetOrdered( (int)pos, (int)( pos + 1 ) ) ) {
+                        cell.data = data;
+                        // full barrier: the push must be visible before
+                        // unlock() looks for sleeping consumers
+                        cell.sequence.fetchAndStoreOrdered( (int)( pos + 1 ) );
+                        return;
+                    }
+                    _casRetries.fetchAndAddRelaxed(1);
+                }
+                else if( dif < 0 ) {
+                    // only objects handed out by this pool may be returned,
+                    // so the ring can never be full
+                    Q_ASSERT( false );
+                    return;
+                }
+                pos = (unsigned)(int)_enqueuePos;
+            }
+        }
+
+        void _clearStatistics() {
+            _casRetries = 0; _spins = 0; _parks = 0; _wakes = 0;
+        }
+
+    private:
+        QVector<Cell> _cells;
+        unsigned _mask;
+        int _size;
+        int _spinCount;
+        // keep the producer and consumer indices on separate cache lines
+        char _pad0[64];
+        QAtomicInt _enqueuePos;
+        char _pad1[64];
+        QAtomicInt _dequeuePos;
+        char _pad2[64];
+        QAtomicInt _waiting;
+        QAtomicInt _casRetries;
+        QAtomicInt _spins;
+        QAtomicInt _parks;
+        QAtomicInt _wakes;
+        QWaitCondition _waitCondition;
+        QMutex _mutex;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // LOCKFREEPOOL_H
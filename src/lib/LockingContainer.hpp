@@ -1,9 +1,7 @@
 #ifndef LOCKINGCONTAINER_H
 #define LOCKINGCONTAINER_H
 #include <QList>
-#include <QWaitCondition>
-#include <QMutex>
-#include <QMutexLocker>
+#include "LockFreePool.hpp"
 
 
 /**
@@ -20,53 +18,47 @@ namespace ampp {
  * @brief
  *    Template class to provide locks to a container of resources
  * @details
- * 
+ *    The free list is a LockFreePool of pointers into the managed QList.
  */
 
 template<typename T>
 class LockingContainer
 {
     public:
-        LockingContainer() : _size(0) {};
+        LockingContainer() {};
         LockingContainer( QList<T>* dataBuffer ) { reset(dataBuffer); };
         ~LockingContainer() {};
 
         /// set the dataBuffer to manage
         void reset(QList<T>* dataBuffer ) {
-             _available.clear();
-             _size = dataBuffer->size();
+             QList<T*> objects;
              for(int i=0; i < dataBuffer->size(); ++i ) {
-                _available.append( &((*dataBuffer)[i]) );
+                objects.append( &((*dataBuffer)[i]) );
              }
+             _pool.reset( objects );
         }
 
         /// return a reference to the next free resource
         //  This will block until a resource becomes available
         T* next() {
-           QMutexLocker lock(&_mutex);
-           while( ! _available.size() ) {
-               _waitCondition.wait(&_mutex);
-           }
-           return _available.takeFirst();
+           return _pool.next();
         }
 
         // unlock the specified data
         void unlock(T* data) {
-           QMutexLocker lock(&_mutex);
-           _available.append(data);
-           _waitCondition.wakeOne();
+           _pool.unlock(data);
         }
 
         // return true only if there are no locked objects
         bool allAvailable() const {
-               return _available.size() == _size;
+           return _pool.allAvailable();
         }
 
+        /// the underlying pool (wait policy and contention counters)
+        LockFreePool<T>& pool() { return _pool; }
+
     private:
-        QWaitCondition _waitCondition;
-        QMutex _mutex;
-        int _size;
-        QList<T*> _available; // array of available objects
+        LockFreePool<T> _pool;
 };
 
 } // namespace ampp
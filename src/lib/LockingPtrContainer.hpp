@@ -1,9 +1,7 @@
 #ifndef LOCKINGPTRCONTAINER_H
 #define LOCKINGPTRCONTAINER_H
 #include <QList>
-#include <QWaitCondition>
-#include <QMutex>
-#include <QMutexLocker>
+#include "LockFreePool.hpp"
 
 
 /**
@@ -20,7 +18,8 @@ namespace ampp {
  * @brief
  *    Template class to provide locks to a container of pointers to resources
  * @details
- * 
+ *    The free list is a LockFreePool, so next() and unlock() only take a
+ *    lock when a caller has to wait for an object to be returned.
  */
 
 template<typename T>
@@ -29,33 +28,23 @@ class LockingPtrContainer
     public:
         LockingPtrContainer() : _dataBuffer(0) {};
         LockingPtrContainer( QList<T*>* dataBuffer ) { reset(dataBuffer); };
-        ~LockingPtrContainer() { _waitCondition.wakeAll(); };
+        ~LockingPtrContainer() {};
 
         /// set the dataBuffer to manage
         void reset(QList<T*>* dataBuffer ) {
              _dataBuffer = dataBuffer;
-             _available.clear();
-             for(int i=0; i < dataBuffer->size(); ++i ) {
-                _available.append( (*dataBuffer)[i] );
-             }
+             _pool.reset( *dataBuffer );
         }
 
         /// return a reference to the next free resource
         //  This will block until a resource becomes available
         T* next() {
-           QMutexLocker lock(&_mutex);
-           while( ! _available.size() ) {
-               _waitCondition.wait(&_mutex);
-           }
-           return const_cast<T*>(_available.takeFirst());
+           return _pool.next();
         }
 
         // unlock the specified data
         void unlock( const T* data ) {
-           QMutexLocker lock(&_mutex);
-           Q_ASSERT( ! _available.contains(data) );
-           _available.append(data);
-           _waitCondition.wakeOne();
+           _pool.unlock(data);
         }
 
         QList<T*>* rawBuffer() const {
@@ -63,21 +52,21 @@ class LockingPtrContainer
         }
 
         int numberAvailable() const {
-           QMutexLocker lock(&_mutex);
-           return _available.size();
+           return _pool.numberAvailable();
         }
 
         bool allAvailable() const {
            if( _dataBuffer )
-               return _available.size() == _dataBuffer->size();
+               return _pool.allAvailable();
            return true;
         }
 
+        /// the underlying pool (wait policy and contention counters)
+        LockFreePool<T>& pool() { return _pool; }
+
     private:
         QList<T*>* _dataBuffer;
-        QWaitCondition _waitCondition;
-        mutable QMutex _mutex;
-        QList<const T*> _available; // array of available pointers
+        LockFreePool<T> _pool;
 };
 
 } // namespace ampp
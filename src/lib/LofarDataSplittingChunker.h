@@ -93,6 +93,8 @@ class LofarDataSplittingChunker : public AbstractChunker
         UDPPacket _emptyPacket1;
         UDPPacket _emptyPacket2;
 
+        bool _placed; // capture thread pinned (see Affinity)
+
         friend class LofarDataSplittingChunkerTest;
 };
 
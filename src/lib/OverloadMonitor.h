@@ -0,0 +1,101 @@
+#ifndef OVERLOADMONITOR_H
+#define OVERLOADMONITOR_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+
+/**
+ * @file OverloadMonitor.h
+ */
+
+namespace pelican {
+class ConfigNode;
+
+namespace ampp {
+
+/**
+ * @class OverloadMonitor
+ *
+ * @brief
+ *    Measures how far a pipeline has fallen behind its data and chooses
+ *    a load shedding level
+ * @details
+ *    update() is called once per chunk with the timestamp of the data (s).
+ *    The lag is the growth of (wall clock - data time) since the least
+ *    value seen, i.e. how much longer processing has taken than the data
+ *    it processed; time spent ahead of the data is not banked.
+ *
+ *    Configured with e.g.
+ *    <overload active="true" lag="1,2,4" recover="0.5"
+ *              actions="export,threshold,dmrange"/>
+ *    The level rises to n when the lag exceeds the nth threshold (s), and
+ *    falls back when the lag drops below recover times the threshold of
+ *    the current level. At level n the first n actions are in force.
+ *
+ *    Each interval spent above level 0 is recorded, with the highest level
+ *    reached, in data time.
+ */
+
+class OverloadMonitor
+{
+    public:
+        /// a period of degraded processing (data time, s)
+        struct Interval {
+            double start;
+            double end;
+            int level;
+        };
+
+    public:
+        OverloadMonitor( const ConfigNode& config );
+        ~OverloadMonitor();
+
+        /// return true if load shedding has been configured
+        bool active() const { return _active; }
+
+        /// record the processing of data with the given timestamp (s)
+        //  and return the load shedding level
+        int update( double dataTime );
+
+        /// the current load shedding level (0 = full processing)
+        int level() const;
+
+        /// the current lag behind the data (s)
+        double lag() const;
+
+        /// the number of levels available
+        int levels() const { return _thresholds.size(); }
+
+        /// return true if the named action is in force at the given level
+        bool shedding( const QString& action, int level ) const;
+        bool shedding( const QString& action ) const { return shedding( action, level() ); }
+
+        /// the completed degraded intervals, and the current one if any
+        QList<Interval> intervals() const;
+
+        /// print the degraded intervals to stdout
+        void report() const;
+
+    private:
+        static double _wallTime();
+
+    private:
+        bool _active;
+        QList<double> _thresholds;
+        double _recover;
+        QStringList _actions;
+
+        mutable QMutex _mutex;
+        bool _started;
+        double _minOffset; // least (wall - data) seen
+        double _lag;
+        int _level;
+        QList<Interval> _intervals;
+        Interval _current;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // OVERLOADMONITOR_H
@@ -0,0 +1,109 @@
+#ifndef PIPELINESTAGE_H
+#define PIPELINESTAGE_H
+#include <QThread>
+#include <QString>
+#include <QTime>
+#include <boost/function.hpp>
+#include "BlockingQueue.hpp"
+#include "TimerData.h"
+#include "Affinity.h"
+#include <iostream>
+
+
+/**
+ * @file PipelineStage.hpp
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class PipelineStage
+ *  
+ * @brief
+ *    A thread running one step of a software pipeline
+ * @details
+ *    Items pushed to the stage are passed to the task in order by a single
+ *    thread, so stateful modules see their data in sequence. stop() queues
+ *    an end marker (a null item) behind any outstanding work.
+ *
+ *    report() shows the fraction of time the stage was busy, and how full
+ *    its input queue was. The stage limiting throughput is the one that is
+ *    busy nearly all the time with a full input queue.
+ */
+
+template<typename T>
+class PipelineStage : public QThread
+{
+    public:
+        typedef boost::function1<void, T*> TaskT;
+
+    public:
+        PipelineStage( const QString& name, const TaskT& task, int queueLength = 1 )
+            : _name(name), _task(task), _input(queueLength), _items(0), _stopped(false) {};
+        ~PipelineStage() { stop(); wait(); };
+
+        /// queue data for the task, blocking while the input queue is full
+        void push( T* data ) { _input.push( data ); }
+
+        /// finish the queued work and end the thread
+        void stop() {
+            if( ! _stopped && isRunning() ) {
+                _stopped = true;
+                _input.push( 0 );
+            }
+        }
+
+        void run() {
+            Affinity::instance().pinCurrentThread( Affinity::Compute, _name );
+            _wallTime.start();
+            forever {
+                T* data = _input.pop();
+                if( ! data ) return;
+                _busyTime.tick();
+                _task( data );
+                _busyTime.tock();
+                ++_items;
+            }
+        }
+
+        const QString& name() const { return _name; }
+
+        /// the number of items processed
+        unsigned items() const { return _items; }
+
+        /// the fraction of the time since the stage started spent in the task
+        double busyFraction() const {
+            double wall = _wallTime.elapsed() * 1e-3;
+            return ( wall > 0.0 ) ? _busyTime.timeAverage * _busyTime.counter / wall : 0.0;
+        }
+
+        /// statistics of the input queue
+        typename BlockingQueue<T*>::Statistics queueStatistics() const {
+            return _input.statistics();
+        }
+
+        /// print the stage statistics to stdout
+        void report() const {
+            typename BlockingQueue<T*>::Statistics s = queueStatistics();
+            std::cout << "Stage " << _name.toStdString() << ": " << _items << " items, busy "
+                      << 100.0 * busyFraction() << "%, mean time " << _busyTime.timeAverage
+                      << " s, input queue mean " << s.meanOccupancy << " max " << s.maxOccupancy
+                      << " of " << _input.capacity() << ", waited " << s.popBlocked << " s"
+                      << std::endl;
+        }
+
+    private:
+        QString _name;
+        TaskT _task;
+        BlockingQueue<T*> _input;
+        unsigned _items;
+        bool _stopped;
+        QTime _wallTime;
+        TimerData _busyTime;
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // PIPELINESTAGE_H 
@@ -1,7 +1,9 @@
 #ifndef PROCESSINGCHAIN_H
 #define PROCESSINGCHAIN_H
 #include <QMutex>
+#include <QWaitCondition>
 #include <QHash>
+#include <climits>
 #include <boost/function.hpp> 
 
 
@@ -31,8 +33,9 @@ class ProcessingChain
         ProcessingChain();
         ~ProcessingChain();
 
-        /// block thread until all tasks are complete
-        void waitTaskCompletion() const;
+        /// block thread until all tasks are complete, or until
+        //  timeout ms have passed. Returns false on timeout
+        bool waitTaskCompletion( unsigned long timeout = ULONG_MAX ) const;
 
         /// execute the chain, starting with the parallel tasks
         //  and then the post completion task (sequential)
@@ -42,7 +45,8 @@ class ProcessingChain
     private:
         void _runTask( const CallBackT& functor, unsigned taskId, const QList<CallBackT>& postTasks );
         void _finished( const QList<CallBackT>& postProcessingTasks ); // call completion callbacks
-        QMutex _mutex;
+        mutable QMutex _mutex;
+        mutable QWaitCondition _idle; // signalled when no tasks remain
         QHash<unsigned, unsigned> _processCount; // keep a track of threads per _taskId
         unsigned _taskId; // unique identifier for each call to exec()
 };
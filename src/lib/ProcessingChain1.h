@@ -1,9 +1,14 @@
 #ifndef PROCESSINGCHAIN1_H
 #define PROCESSINGCHAIN1_H
 #include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QTime>
 #include <QHash>
+#include <climits>
 #include <boost/function.hpp> 
 #include <QtConcurrentRun>
+#include "Affinity.h"
 
 
 /**
@@ -21,7 +26,9 @@ namespace ampp {
  *    A container to launch and monitor processing stages
  *    Functors for the Parrallel stages to take a single argument
  * @details
- * 
+ *    waitTaskCompletion() sleeps on a wait condition that is signalled
+ *    when the last outstanding task finishes. The time taken by the most
+ *    recent wait is available from lastDrainTime().
  */
 
 template<typename argT>
@@ -32,15 +39,43 @@ class ProcessingChain1
         typedef boost::function0<void> PostCallBackT;
 
     public:
-        ProcessingChain1() : _taskId(0) {};
+        ProcessingChain1() : _taskId(0), _lastDrainTime(0) {};
         ~ProcessingChain1() {
             waitTaskCompletion();
         };
 
-        void waitTaskCompletion() const {
+        /// block the thread until all tasks are complete, or until
+        //  timeout ms have passed. Returns false on timeout
+        bool waitTaskCompletion( unsigned long timeout = ULONG_MAX ) const {
+            QTime timer;
+            timer.start();
+            QMutexLocker lock(&_mutex);
             while( _processCount.size() ) {
-                usleep(10);
+                if( timeout == ULONG_MAX ) {
+                    _idle.wait(&_mutex);
+                    continue;
+                }
+                unsigned long elapsed = (unsigned long)timer.elapsed();
+                if( elapsed >= timeout ) {
+                    _lastDrainTime = elapsed;
+                    return false;
+                }
+                _idle.wait(&_mutex, timeout - elapsed);
             }
+            _lastDrainTime = timer.elapsed();
+            return true;
+        }
+
+        /// the time taken by the last call to waitTaskCompletion (ms)
+        int lastDrainTime() const {
+            QMutexLocker lock(&_mutex);
+            return _lastDrainTime;
+        }
+
+        /// the number of exec() calls with tasks still running
+        int tasksRunning() const {
+            QMutexLocker lock(&_mutex);
+            return _processCount.size();
         }
 
         /// execute the chain, starting with the parallel tasks
@@ -69,12 +104,17 @@ class ProcessingChain1
         void _runTask( const CallBackT& functor, unsigned taskId, 
                        const QList<PostCallBackT>& postTasks, const argT& arg )
         {
+             // tasks run on the shared pool threads
+             Affinity::instance().pinCurrentThread( Affinity::Compute, "ProcessingChain" );
              functor( arg );
              QMutexLocker lock(&_mutex);
              if( --_processCount[taskId] == 0) {
-                _processCount.remove(taskId);
                 lock.unlock(); // allow other tasks to launch
                 _finished( postTasks );
+                // only report the chain as idle once the post tasks are done
+                lock.relock();
+                _processCount.remove(taskId);
+                if( ! _processCount.size() ) _idle.wakeAll();
              }
         }
 
@@ -87,9 +127,11 @@ class ProcessingChain1
         }
 
      private:
-        QMutex _mutex;
+        mutable QMutex _mutex;
+        mutable QWaitCondition _idle; // signalled when no tasks remain
         QHash<unsigned, unsigned> _processCount; // keep a track of threads per _taskId
         unsigned _taskId; // unique identifier for each call to exec()
+        mutable int _lastDrainTime;
 };
 
 } // namespace ampp
@@ -1,8 +1,9 @@
 #ifndef PUMAOUTPUT_H
 #define PUMAOUTPUT_H
 #include <QString>
-#include <QMap>
-#include <QPair>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
 #include <vector>
 
 #include "pelican/output/AbstractOutputStream.h"
@@ -30,13 +31,38 @@ class DedispersedTimeSeriesF32;
  <PumaOutput>
    <connection host="somehost" port="someport" />
   <file name="somefilename" />
+  <queue depth="64" maxBuffered="4194304" />
+  <reconnect timeout="1.0" minDelay="0.5" maxDelay="30" />
  </PumaOutput>
 @endverbatim
- * 
+ *
+ * Data for the servers is handed to a sender thread, so a slow or dead
+ * server never holds up the caller. Each server has a queue of up to
+ * depth messages; a message that finds the queue full is dropped and
+ * counted. The sender only passes a message to the socket while less
+ * than maxBuffered bytes are waiting to go out, and never waits for a
+ * write to complete.
+ *
+ * A server that cannot be reached, or that drops the connection, is
+ * retried in the background, waiting minDelay seconds after the first
+ * failure and doubling the wait after each further one up to maxDelay.
+ * Each connection attempt waits at most timeout seconds.
+ *
+ * Files are written by the caller, as before.
  */
 
 class PumaOutput : public AbstractOutputStream
 {
+    public:
+        /// sender performance, summed over the servers
+        struct Statistics {
+            unsigned long queued;
+            unsigned long sent;
+            unsigned long dropped;
+            unsigned connects;  // successful connections
+            unsigned failures;  // failed connection attempts and lost connections
+        };
+
     public:
         PumaOutput( const ConfigNode& configNode  );
         ~PumaOutput();
@@ -48,20 +74,51 @@ class PumaOutput : public AbstractOutputStream
         // add a file to which to send data
         void addFile( const QString& filename );
 
+        /// wait up to timeout seconds for the queues to empty, returning
+        //  true if they did
+        bool flush( double timeout = 5.0 );
+
+        Statistics statistics() const;
+
+        /// print the statistics for each server to stdout
+        void report() const;
+
     protected:
         virtual void sendStream(const QString& streamName, const DataBlob* dataBlob);
 
     private:
+        struct Receiver;
+        class Sender;
+        friend class Sender;
         void _convertToPuma( const SpectrumDataSetStokes* );
         void _convertToPuma( const DedispersedTimeSeriesF32* );
-        void _connect(QTcpSocket*, const QString&, quint16 port);
 	    void _send(const char* puma, size_t size);
+        // the sender thread
+        void _run();
+        // try to connect a receiver, scheduling the next attempt on failure
+        void _connect( Receiver* r, double now );
+        // pass queued messages on to a receiver's socket
+        void _transmit( Receiver* r );
+        void _disconnected( Receiver* r, double now );
+        static double _now();
 
     private:
-        QMap<QTcpSocket*, QPair<QString,quint16> > _sockets;
         QList<QIODevice*> _devices;
 	
 	    std::vector<float>  _dmValues;
+        std::vector<float>  _puma; // reused for each blob
+
+        // shared with the sender thread
+        mutable QMutex _mutex;
+        QWaitCondition _wake;
+        QWaitCondition _drained;
+        QList<Receiver*> _receivers;
+        Sender* _sender;
+        bool _stop;
+        int _depth;
+        qint64 _maxBuffered;
+        int _connectTimeout; // ms
+        double _minDelay, _maxDelay;
 };
 
 PELICAN_DECLARE(AbstractOutputStream, PumaOutput )
@@ -0,0 +1,101 @@
+#ifndef QUANTISER_H
+#define QUANTISER_H
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * @file Quantiser.h
+ */
+
+namespace pelican {
+class ConfigNode;
+
+namespace ampp {
+
+/**
+ * @class Quantiser
+ *
+ * @brief
+ *    Converts floating point spectra to 8, 4, 2 or 1 bit samples packed
+ *    in SIGPROC order
+ * @details
+ *    Samples are packed with the first sample of each byte in the least
+ *    significant bits, the order unpacked by FilterBankAdapter.
+ *
+ *    Configured from the writer's config node:
+ *    <dataBits value="8"/>
+ *    <scale min="0" max="255"/>
+ *    <quantisation adaptive="false" sigma="3" timeConstant="1024"/>
+ *
+ *    Static scaling maps [min, max] linearly onto the output levels, as
+ *    the writers have always done. With adaptive="true" each channel keeps
+ *    an exponentially weighted running mean and RMS (over timeConstant
+ *    spectra) and mean +/- sigma*RMS is mapped onto the output levels, so
+ *    that the mean falls in the middle of the range.
+ *
+ *    The conversion and packing loops are branch free over contiguous
+ *    arrays so that the compiler can vectorise them.
+ */
+
+class Quantiser
+{
+    public:
+        Quantiser( const ConfigNode& config );
+        Quantiser( unsigned nBits, float min, float max );
+        ~Quantiser();
+
+        /// the number of bits per output sample
+        unsigned bits() const { return _nBits; }
+
+        /// return true if the scaling follows the running channel statistics
+        bool adaptive() const { return _adaptive; }
+
+        /// use the statistics of each channel to scale its samples
+        void setAdaptive( float sigma, unsigned timeConstant );
+
+        /// the number of bytes needed to hold n packed samples
+        size_t packedSize( unsigned n ) const { return ( (size_t)n * _nBits + 7 ) / 8; }
+
+        /// quantise n samples and pack them into out. The samples are
+        //  the channels starting at the given channel of the spectrum,
+        //  which selects the running statistics to use and update.
+        //  n must be a multiple of the number of samples per byte.
+        void pack( const float* in, unsigned n, unsigned char* out, unsigned channel = 0 );
+
+        /// forget the running channel statistics
+        void reset();
+
+        /// the running mean and RMS of a channel
+        float mean( unsigned channel ) const;
+        float rms( unsigned channel ) const;
+
+    private:
+        void _init( unsigned nBits, float min, float max );
+        void _resize( unsigned nChannels );
+        void _update( const float* in, unsigned n, unsigned channel );
+        void _pack( const unsigned char* levels, unsigned n, unsigned char* out ) const;
+
+    private:
+        unsigned _nBits;
+        float _top;          // the highest output level
+        float _min, _max;    // static scaling range
+        bool _adaptive;
+        float _sigma;
+        float _minAlpha;     // weight of a new spectrum once warmed up
+
+        // per channel scaling: level = ( x - centre ) * scale + mid
+        float _mid;
+        std::vector<float> _centre;
+        std::vector<float> _scale;
+        // per channel running statistics
+        std::vector<float> _mean;
+        std::vector<float> _var;
+        std::vector<float> _count;
+
+        std::vector<unsigned char> _levels; // scratch
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // QUANTISER_H
@@ -48,6 +48,7 @@ class RFI_Clipper : public AbstractModule
         QVector<float> _history, _historyMean, _historyRMS, _historyNewSum;
         int _current; // history pointer
         int _badSpectra;
+        unsigned _nThreads; // OpenMP threads, within the core budget
         int _num, _numChunks;// number of values in history
         int _maxHistory; // max size of history buffer
 // flag for removing median from each spectrum, equivalent to the zero-DMing technique
@@ -8,23 +8,53 @@
 #include "pelican/output/AbstractOutputStream.h"
 #include "pelican/utility/ConfigNode.h"
 #include "pelican/data/DataBlob.h"
+#include "TimerData.h"
+#include "FileRotation.h"
+#include "ChunkCompressor.h"
 
 #include <QtCore/QDataStream>
 #include <QtCore/QFile>
+#include <QtCore/QTime>
 #include <fstream>
+#include <vector>
 
 namespace pelican {
 namespace ampp {
 
 class SpectrumDataSetStokes;
+class Quantiser;
 
 /**
  * @class SigprocStokesWriter
  *
  * @brief
- *
+ *    Writes SpectrumDataSetStokes blobs to a SIGPROC filterbank file
  * @details
+ *    Each blob is reordered into the SIGPROC channel order in a staging
+ *    buffer and passed on to the file in blocks of
+ *    <params bufferSize="1048576"/> bytes (rounded up to a multiple of
+ *    4096). The header goes through the same buffer, so while only whole
+ *    blocks are written every write is a multiple of the block size at an
+ *    aligned offset.
+ *
+ *    <flush policy="blob" interval="1.0"/> sets when a partly filled block
+ *    is written out:
+ *      blob     - after every blob (the default)
+ *      interval - when interval seconds have passed since the last flush
+ *      block    - only when the writer is destroyed
+ *
+ *    The output can be split into segments by size or duration, each
+ *    with its own header (see FileRotation.h).
+ *
+ *    With <dataBits value="8|4|2|1"/> the samples are quantised and
+ *    packed by a Quantiser (see Quantiser.h for the scaling options).
  *
+ *    With <compression active="true" .../> the data following the header
+ *    is compressed in chunks (see ChunkCompressor.h) and the files are
+ *    named .filz. The data then reaches the file a chunk at a time,
+ *    whatever the flush policy. FilterBankAdapter reads either form.
+ *
+ *    The write rate is reported on destruction.
  */
 
 class SigprocStokesWriter : public AbstractOutputStream
@@ -52,25 +82,45 @@ class SigprocStokesWriter : public AbstractOutputStream
         void WriteLong(QString name, long value);
         void writeHeader(SpectrumDataSetStokes* stokes);
         // Data helpers
+        void _stage32(const SpectrumDataSetStokes* stokes);
+        void _stagePacked(const SpectrumDataSetStokes* stokes);
     protected:
         // buffer and write data in blocks
-        void _write(char*,size_t);
-        inline void _float2int(const float *f, int *i);
+        void _write(const char*,size_t);
+        // write out any partly filled block
+        void _flush();
+        // close the current segment and open the next
+        void _nextSegment();
+        QString _suffix() const;
+
+    public:
+        enum FlushPolicy { FlushBlob, FlushInterval, FlushBlock };
 
     private:
         bool              _first;
+        bool              _writeHeader;
         QString           _filepath;
+        QString           _fileName;   // the current segment
+        FileRotation      _rotation;
+        ChunkCompressor   _compressor;
         std::ofstream     _file;
         std::vector<char>  _buffer;
+        std::vector<char>  _staging; // one blob in file order
+        std::vector<float> _spectrum; // one spectrum in file order
+        Quantiser*    _quantiser;
         QString       _sourceName, _raString, _decString;
         double _LOFreq;
         float         _fch1, _foff, _tsamp, _refdm, _clock, _ra, _dec;
-        float         _cropMin, _cropMax, _scaleDelta, _nRange; // for scaling floats to lesser values
         int           _nchans, _nTotalSubbands;
         int           _buffSize, _cur;
         unsigned int  _nRawPols, _nChannels, _nSubbands, _integration, _nPols;
         unsigned int  _nSubbandsToStore, _topsubband, _lbahba, _site, _machine;
         unsigned int  _nBits, _integrationFreq;
+        FlushPolicy   _flushPolicy;
+        int           _flushInterval; // ms
+        QTime         _lastFlush;
+        TimerData     _writeTime;
+        double        _bytesWritten;
 };
 
 PELICAN_DECLARE(AbstractOutputStream, SigprocStokesWriter)
@@ -6,6 +6,7 @@
  */
 
 #include "pelican/data/DataBlob.h"
+#include "DataBlobLockCounter.h"
 
 #include <QtCore/QIODevice>
 #include <QtCore/QSysInfo>
@@ -25,7 +26,7 @@ namespace ampp {
  *
  * @details
  */
-class SpectrumDataSetBase : public DataBlob
+class SpectrumDataSetBase : public DataBlob, public DataBlobLockCounter
 {
     public:
         SpectrumDataSetBase(const QString& type);
@@ -49,6 +49,7 @@ class StokesGenerator : public AbstractModule
     private:
         float _sqr(float x) { return x * x; }
         unsigned _numberOfStokes;
+        unsigned _nThreads;
 };
 
 // Declare this class as a pelican module.
@@ -1,8 +1,11 @@
 #ifndef TRIGGEROUTPUT_H
 #define TRIGGEROUTPUT_H
 #include <QString>
+#include <QByteArray>
 #include <QMap>
 #include <QPair>
+#include <QMutex>
+#include <QAtomicInt>
 #include <QtNetwork/QHostAddress>
 #include <vector>
 
@@ -32,11 +35,32 @@ class DedispersionDataAnalysis;
    <receiver host="somehost" port="someport" />
  </TriggerOutput>
 @endverbatim
- * 
+ *
+ * trigger() is the low latency path: the DedispersionPipeline calls it
+ * directly as soon as a buffer has been searched (and clustered), rather
+ * than sending the result through the output streams. The best candidate
+ * at or above the snr threshold is sent at once; the message is built in
+ * a reused buffer.
+ *
+ * dataArrived() records when the data with each timestamp reached the
+ * pipeline. A trigger then carries the time from the arrival of the data
+ * holding the end of the candidate to the send (##latencyMs), and the
+ * latencies are collected in a histogram of doubling bins from 1 ms,
+ * printed by report().
  */
 
 class TriggerOutput : public AbstractOutputStream
 {
+    public:
+        /// triggers sent and their latencies (ms)
+        struct Statistics {
+            unsigned triggers;
+            unsigned stamped;    // triggers with a known latency
+            double minLatency;
+            double maxLatency;
+            double meanLatency;
+        };
+
     public:
         TriggerOutput( const ConfigNode& configNode  );
         ~TriggerOutput();
@@ -46,13 +70,36 @@ class TriggerOutput : public AbstractOutputStream
 	
         // add a local logfile 
         void addFile( const QString& filename );
+
+        /// note that the data with the given timestamp has just arrived
+        void dataArrived( double timestamp );
+
+        /// send a trigger for the best candidate, if it qualifies,
+        //  returning true if one was sent
+        bool trigger( const DedispersionDataAnalysis* data );
+
+        Statistics statistics() const;
+
+        /// the number of triggers with latencies below 1, 2, 4, ... ms
+        //  (the last bin holds all the longer ones)
+        std::vector<unsigned> latencyHistogram() const;
+
+        /// print the statistics and latency histogram to stdout
+        void report() const;
 	
     protected:
         virtual void sendStream(const QString& streamName, const DataBlob* dataBlob);
 
     private:
-        void _convertToTrigger_FRATS( const DedispersionDataAnalysis* ); 
-	void _send(QString message);
+        bool _convertToTrigger_FRATS( const DedispersionDataAnalysis* ); 
+	void _send( const QByteArray& message );
+        // append text to the message right justified in width with leading zeros
+        static void _append( QByteArray& message, const char* text, int width );
+        static void _append( QByteArray& message, const QString& text, int width );
+        // the arrival time of the data holding timestamp, or -1 if unknown
+        double _arrival( double timestamp ) const;
+        void _recordLatency( double ms );
+        static double _now();
 
     private:
         QMap<QUdpSocket*, QPair<QHostAddress,quint16> > _sockets;
@@ -60,16 +107,25 @@ class TriggerOutput : public AbstractOutputStream
         /*
 	std::vector<float>  _dmValues;
 	*/
-	QString _idroot;
+	QByteArray _idroot;
 	QString _format;
 	int _min_events;
 	float _snr_threshold;
-	int _message_counter;
+	QAtomicInt _message_counter; // triggers are built concurrently
 	QString _beamRA, _beamDec, _beamAz, _beamAlt;
         QString _station;
 	QString _cfreq_MHz;
 	void _set_RA_Dec(void);
-	
+
+        // (data timestamp, arrival) of recent data, oldest first from _head
+        mutable QMutex _mutex;
+        QMutex _sendMutex; // keeps whole messages together on each device
+        std::vector< QPair<double,double> > _arrivals;
+        unsigned _head, _count;
+        std::vector<unsigned> _histogram;
+        unsigned _triggers, _stamped;
+        double _minLatency, _maxLatency, _sumLatency;
+
 };
 
 PELICAN_DECLARE(AbstractOutputStream, TriggerOutput )
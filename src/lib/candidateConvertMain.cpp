@@ -0,0 +1,60 @@
+#include "CandidateFile.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <QtCore/QString>
+#include <iostream>
+#include <vector>
+
+using namespace pelican;
+using namespace pelican::ampp;
+
+/*
+ * Converts a binary candidate file written by DedispersionDataAnalysisOutput
+ * into its text format.
+ *
+ * usage: candidateConvert <file.cand> [file.dat]
+ * The text goes to standard output if no output file is given.
+ */
+int main(int argc, char** argv)
+{
+    if( argc < 2 || argc > 3 ) {
+        std::cerr << "usage: " << argv[0] << " <file.cand> [file.dat]" << std::endl;
+        return 1;
+    }
+    QFile in( argv[1] );
+    if( ! in.open( QIODevice::ReadOnly ) ) {
+        std::cerr << "unable to open " << argv[1] << std::endl;
+        return 1;
+    }
+    QFile out;
+    if( argc == 3 ) {
+        out.setFileName( argv[2] );
+        if( ! out.open( QIODevice::WriteOnly ) ) {
+            std::cerr << "unable to open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    else {
+        out.open( stdout, QIODevice::WriteOnly );
+    }
+
+    try {
+        CandidateFile::readHeader( in );
+        QTextStream text( &out );
+        CandidateFile::writeTextHeader( text );
+        std::vector<CandidateFile::Record> records( 4096 );
+        qint64 n;
+        while( ( n = CandidateFile::readRecords( in, &records[0], records.size() ) ) > 0 ) {
+            for( qint64 i = 0; i < n; ++i ) {
+                CandidateFile::writeText( text, records[i] );
+            }
+        }
+        text.flush();
+    }
+    catch( const QString& e ) {
+        std::cerr << argv[1] << ": " << e.toStdString() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -2,11 +2,11 @@
 #include <QtNetwork/QUdpSocket>
 #include <sys/time.h>
 #include <sys/resource.h>
-#include <sched.h>
 #include <stdio.h>
 #include <iostream>
 
 #include "ABChunker.h"
+#include "Affinity.h"
 
 namespace pelican {
 namespace ampp {
@@ -38,21 +38,11 @@ ABChunker::ABChunker(const ConfigNode& config) : AbstractChunker(config)
     // Allocate memory for the saved packet
     _pktSaved = new char[_pktSize];
 
-    /* set the CPU affinity of the main thread that reads data off the NIC */
-#if 0
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    CPU_SET(5, &cpuset);
-    if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) > 0)
-    {
-        std::cerr << "ERROR: Setting affinity failed!" << std::endl;
-    }
-    if (setpriority(PRIO_PROCESS, 0, -20) < 0)
-    {
-        std::cerr << "ERROR: Setting priority failed!" << std::endl;
-        perror("setpriority");
-    }
-#endif
+    // the thread that reads data off the NIC is placed by the <Affinity>
+    // capture cores when it first calls next()
+    Affinity::instance().configure(config);
+    _priority = config.getOption("Affinity", "capturePriority", "0").toInt();
+    _placed = false;
 }
 
 // Destructor.
@@ -93,10 +83,25 @@ void ABChunker::next(QIODevice* device)
     char pktMissed[_pktSize];
     char fakeHdr[_hdrSize];
 
+    if (!_placed)
+    {
+        Affinity::instance().pinCurrentThread(Affinity::Capture, "ABChunker");
+        if (_priority && setpriority(PRIO_PROCESS, 0, _priority) < 0)
+        {
+            std::cerr << "ERROR: Setting priority failed!" << std::endl;
+            perror("setpriority");
+        }
+        _placed = true;
+    }
+
     // Get writable buffer space for the chunk.
     WritableData writableData = getDataStorage(_chunkSize);
     if (writableData.isValid())
     {
+        // keep the chunk buffer on the node of the capture thread
+        Affinity::instance().bind(writableData.ptr(), _chunkSize,
+                Affinity::Capture, "ABChunker chunk");
+
         // Get pointer to start of writable memory.
         //char *ptr = (char *) (writableData.ptr());
 
@@ -0,0 +1,198 @@
+#include "Affinity.h"
+#include "CPU_Resource.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QDir>
+#include <QMutexLocker>
+#include <iostream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+
+namespace pelican {
+
+namespace ampp {
+
+namespace {
+// the placement of the calling thread
+__thread int threadRole = -1;
+__thread unsigned threadGeneration = 0;
+__thread bool threadPinned = false;
+
+QString coreString( const QList<int>& cores )
+{
+    QStringList list;
+    foreach( int c, cores ) list.append( QString::number(c) );
+    return list.join(",");
+}
+} // namespace
+
+/**
+ *@details Affinity
+ */
+Affinity::Affinity()
+    : _generation(1)
+{
+    for( int r = 0; r < Roles; ++r ) _nodes[r] = -1;
+}
+
+Affinity& Affinity::instance()
+{
+    static Affinity affinity;
+    return affinity;
+}
+
+QString Affinity::roleName( Role role )
+{
+    switch( role ) {
+        case Capture: return "capture";
+        case Compute: return "compute";
+        case IO: return "io";
+        default: return "";
+    }
+}
+
+void Affinity::configure( const ConfigNode& config )
+{
+    for( int r = 0; r < Roles; ++r ) {
+        QString name = roleName( (Role)r );
+        QString cores = config.getOption("Affinity", name, "");
+        if( cores.isEmpty() ) continue;
+        bool ok = true;
+        int node = config.getOption("Affinity", name + "Node", "-1").toInt(&ok);
+        if( ! ok ) throw QString("Affinity: bad %1Node").arg(name);
+        setCores( (Role)r, CPU_Resource::parseCpuList( cores ), node );
+    }
+}
+
+void Affinity::setCores( Role role, const QList<int>& cores, int node )
+{
+    if( node < 0 && ! cores.isEmpty() ) node = nodeOfCore( cores[0] );
+    QMutexLocker lock(&_mutex);
+    if( _cores[role] == cores && _nodes[role] == node ) return;
+    _cores[role] = cores;
+    _nodes[role] = node;
+    ++_generation;
+}
+
+QList<int> Affinity::cores( Role role ) const
+{
+    QMutexLocker lock(&_mutex);
+    return _cores[role];
+}
+
+int Affinity::node( Role role ) const
+{
+    QMutexLocker lock(&_mutex);
+    return _nodes[role];
+}
+
+int Affinity::nodeOfCore( int core )
+{
+    // the cpu directory holds a link to its node
+    QDir dir( QString("/sys/devices/system/cpu/cpu%1").arg(core) );
+    QStringList nodes = dir.entryList( QStringList() << "node*", QDir::Dirs | QDir::System );
+    if( nodes.isEmpty() ) return -1;
+    bool ok;
+    int node = nodes[0].mid(4).toInt(&ok);
+    return ok ? node : -1;
+}
+
+bool Affinity::pinCurrentThread( Role role, const QString& name )
+{
+    QList<int> cores;
+    int node;
+    {
+        QMutexLocker lock(&_mutex);
+        if( threadRole == role && threadGeneration == _generation ) return threadPinned;
+        threadRole = role;
+        threadGeneration = _generation;
+        threadPinned = false;
+        cores = _cores[role];
+        node = _nodes[role];
+    }
+    if( cores.isEmpty() ) return false;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    foreach( int c, cores ) CPU_SET( c, &set );
+    if( pthread_setaffinity_np( pthread_self(), sizeof(set), &set ) ) {
+        std::cerr << "Affinity: unable to pin " << name.toStdString() << " to cores "
+                  << coreString(cores).toStdString() << std::endl;
+        return false;
+    }
+    if( node >= 0 ) {
+        unsigned long mask = 1UL << node;
+        if( syscall( SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8 ) )
+            std::cerr << "Affinity: unable to prefer node " << node << " for "
+                      << name.toStdString() << std::endl;
+    }
+    threadPinned = true;
+    _record( QString("thread %1 (%2, tid %3) cores %4 node %5 running on cpu %6")
+             .arg(name).arg(roleName(role)).arg(syscall(SYS_gettid))
+             .arg(coreString(cores)).arg(node).arg(sched_getcpu()) );
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Affinity::bind( const void* address, size_t bytes, Role role, const QString& name )
+{
+    int node;
+    {
+        QMutexLocker lock(&_mutex);
+        node = _nodes[role];
+        if( node < 0 || ! address || ! bytes ) return false;
+        if( _bound.contains(address) ) return true;
+        _bound.insert(address);
+    }
+#ifdef __linux__
+    // mbind works on whole pages
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned long start = (unsigned long)address & ~( page - 1 );
+    unsigned long length = (unsigned long)address + bytes - start;
+    unsigned long mask = 1UL << node;
+    if( syscall( SYS_mbind, start, length, MPOL_BIND, &mask, sizeof(mask) * 8, MPOL_MF_MOVE ) ) {
+        std::cerr << "Affinity: unable to bind " << name.toStdString() << " to node "
+                  << node << std::endl;
+        return false;
+    }
+    // check where the first page is now
+    int actual = -1;
+    syscall( SYS_get_mempolicy, &actual, 0, 0, start, MPOL_F_NODE | MPOL_F_ADDR );
+    _record( QString("buffer %1 (%2, %3 bytes) node %4 on node %5")
+             .arg(name).arg(roleName(role)).arg(bytes).arg(node).arg(actual) );
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Affinity::_record( const QString& line )
+{
+    std::cout << "Affinity: " << line.toStdString() << std::endl;
+    QMutexLocker lock(&_mutex);
+    _placements.append( line );
+}
+
+void Affinity::report() const
+{
+    QMutexLocker lock(&_mutex);
+    std::cout << "Affinity:" << std::endl;
+    for( int r = 0; r < Roles; ++r ) {
+        std::cout << "    " << roleName((Role)r).toStdString() << ": cores "
+                  << ( _cores[r].isEmpty() ? QString("any") : coreString(_cores[r]) ).toStdString()
+                  << " node " << _nodes[r] << std::endl;
+    }
+    foreach( const QString& line, _placements ) {
+        std::cout << "    " << line.toStdString() << std::endl;
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,17 @@
+#include "AsyncOutputStream.h"
+#include "H5_LofarBFStokesWriter.h"
+#include "H5_LofarBFVoltageWriter.h"
+
+
+namespace pelican {
+
+namespace ampp {
+
+// the DAL writers are only built when the DAL is available
+typedef AsyncOutput<H5_LofarBFStokesWriter> AsyncH5_LofarBFStokesWriter;
+typedef AsyncOutput<H5_LofarBFVoltageWriter> AsyncH5_LofarBFVoltageWriter;
+PELICAN_DECLARE(AbstractOutputStream, AsyncH5_LofarBFStokesWriter)
+PELICAN_DECLARE(AbstractOutputStream, AsyncH5_LofarBFVoltageWriter)
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,225 @@
+#include "AsyncOutputStream.h"
+#include "Affinity.h"
+#include "SpectrumDataSet.h"
+#include "TimeSeriesDataSet.h"
+#include "SigprocStokesWriter.h"
+#include "EmbraceFBWriter.h"
+#include "PumaOutput.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <time.h>
+#include <algorithm>
+#include <iostream>
+
+
+namespace pelican {
+
+namespace ampp {
+
+class AsyncOutputStream::Worker : public QThread
+{
+    public:
+        Worker( AsyncOutputStream* stream ) : _stream(stream) {}
+
+    protected:
+        void run() {
+            Affinity::instance().pinCurrentThread( Affinity::IO, "AsyncOutputStream" );
+            _stream->_run();
+        }
+
+    private:
+        AsyncOutputStream* _stream;
+};
+
+/**
+ *@details AsyncOutputStream
+ */
+AsyncOutputStream::AsyncOutputStream( const ConfigNode& config, AbstractOutputStream* writer )
+    : AbstractOutputStream( config ), _writer(writer), _warned(false), _pending(0),
+      _queued(0), _written(0), _dropped(0), _spilled(0), _maxDepth(0),
+      _latencySum(0.0), _maxLatency(0.0), _writeSum(0.0), _maxWrite(0.0)
+{
+    _depth = config.getOption("asyncOutput", "depth", "8").toInt();
+    if( _depth < 1 ) {
+        delete _writer;
+        throw QString("AsyncOutputStream: depth must be at least 1");
+    }
+    _spill = config.getOption("asyncOutput", "spill", QString::number(4 * _depth)).toInt();
+    _warnDepth = std::max( 1, (int)( _depth * config.getOption("asyncOutput", "warn", "0.75").toFloat() ) );
+    QString policy = config.getOption("asyncOutput", "policy", "block").toLower();
+    if( policy == "block" ) _policy = Block;
+    else if( policy == "drop" ) _policy = Drop;
+    else if( policy == "spill" ) _policy = Spill;
+    else {
+        delete _writer;
+        throw QString("AsyncOutputStream: unknown policy \"%1\"").arg(policy);
+    }
+    _queue.setCapacity( _depth );
+    _thread = new Worker( this );
+    _thread->start();
+}
+
+/**
+ *@details
+ */
+AsyncOutputStream::~AsyncOutputStream()
+{
+    // write everything queued before stopping
+    Item stop = { QString(), 0, 0.0 };
+    _queue.forcePush( stop );
+    _thread->wait();
+    delete _thread;
+    report();
+    delete _writer;
+}
+
+double AsyncOutputStream::_now()
+{
+    struct timespec tp;
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    return tp.tv_sec + tp.tv_nsec * 1.0e-9;
+}
+
+DataBlob* AsyncOutputStream::copyBlob( const DataBlob* blob )
+{
+    if( blob->type() == "SpectrumDataSetStokes" )
+        return new SpectrumDataSetStokes( *static_cast<const SpectrumDataSetStokes*>(blob) );
+    if( blob->type() == "SpectrumDataSetC32" )
+        return new SpectrumDataSetC32( *static_cast<const SpectrumDataSetC32*>(blob) );
+    if( blob->type() == "TimeSeriesDataSetC32" )
+        return new TimeSeriesDataSetC32( *static_cast<const TimeSeriesDataSetC32*>(blob) );
+    return 0;
+}
+
+void AsyncOutputStream::sendStream( const QString& streamName, const DataBlob* dataBlob )
+{
+    DataBlob* copy = copyBlob( dataBlob );
+    if( ! copy ) {
+        // must be written before the caller reuses it
+        flush();
+        _write( streamName, dataBlob, _now() );
+        return;
+    }
+    Item item = { streamName, copy, _now() };
+    {
+        QMutexLocker lock(&_flushMutex);
+        ++_pending;
+    }
+    bool queued = _queue.tryPush( item );
+    if( ! queued ) {
+        switch( _policy ) {
+            case Drop:
+                delete copy;
+                {
+                    QMutexLocker lock(&_flushMutex);
+                    if( --_pending == 0 ) _drained.wakeAll();
+                }
+                {
+                    QMutexLocker lock(&_mutex);
+                    ++_dropped;
+                }
+                return;
+            case Spill:
+                if( _queue.size() < _depth + _spill ) {
+                    _queue.forcePush( item );
+                    QMutexLocker lock(&_mutex);
+                    ++_spilled;
+                    break;
+                }
+                // the spill is full too, so block
+                // fall through
+            case Block:
+                _queue.push( item );
+                break;
+        }
+    }
+    int depth = _queue.size();
+    QMutexLocker lock(&_mutex);
+    ++_queued;
+    _maxDepth = std::max( _maxDepth, depth );
+    if( depth >= _warnDepth && ! _warned ) {
+        _warned = true;
+        std::cout << "AsyncOutputStream: warning, " << depth << " blobs waiting to be written (depth "
+                  << _depth << "), mean write " << ( _written ? _writeSum / _written : 0.0 ) * 1000.0 << " ms" << std::endl;
+    }
+    else if( depth <= 1 ) {
+        // caught up, warn again next time
+        _warned = false;
+    }
+}
+
+void AsyncOutputStream::_run()
+{
+    forever {
+        Item item = _queue.pop();
+        if( ! item.blob ) return;
+        _write( item.stream, item.blob, item.queued );
+        delete item.blob;
+        QMutexLocker lock(&_flushMutex);
+        if( --_pending == 0 ) _drained.wakeAll();
+    }
+}
+
+void AsyncOutputStream::_write( const QString& stream, const DataBlob* blob, double queued )
+{
+    QMutexLocker writerLock(&_writerMutex);
+    double start = _now();
+    try {
+        _writer->send( stream, blob );
+    }
+    catch( const QString& e ) {
+        std::cerr << "AsyncOutputStream: " << e.toStdString() << std::endl;
+    }
+    double end = _now();
+    QMutexLocker lock(&_mutex);
+    _writeSum += end - start;
+    _maxWrite = std::max( _maxWrite, end - start );
+    double latency = end - queued;
+    _latencySum += latency;
+    _maxLatency = std::max( _maxLatency, latency );
+    ++_written;
+}
+
+void AsyncOutputStream::flush()
+{
+    QMutexLocker lock(&_flushMutex);
+    while( _pending ) _drained.wait(&_flushMutex);
+}
+
+AsyncOutputStream::Statistics AsyncOutputStream::statistics() const
+{
+    Statistics s;
+    s.depth = _queue.size();
+    s.blocked = _queue.statistics().pushBlocked;
+    QMutexLocker lock(&_mutex);
+    s.queued = _queued;
+    s.written = _written;
+    s.dropped = _dropped;
+    s.spilled = _spilled;
+    s.maxDepth = _maxDepth;
+    s.meanLatency = _written ? _latencySum / _written : 0.0;
+    s.maxLatency = _maxLatency;
+    s.meanWrite = _written ? _writeSum / _written : 0.0;
+    s.maxWrite = _maxWrite;
+    return s;
+}
+
+void AsyncOutputStream::report() const
+{
+    Statistics s = statistics();
+    std::cout << "AsyncOutputStream: " << s.written << " written, " << s.dropped << " dropped, "
+              << s.spilled << " spilled, max depth " << s.maxDepth << "/" << _depth
+              << ", latency mean " << s.meanLatency * 1000.0 << " ms max " << s.maxLatency * 1000.0
+              << " ms, write mean " << s.meanWrite * 1000.0 << " ms max " << s.maxWrite * 1000.0
+              << " ms, blocked " << s.blocked << " s" << std::endl;
+}
+
+typedef AsyncOutput<SigprocStokesWriter> AsyncSigprocStokesWriter;
+typedef AsyncOutput<EmbraceFBWriter> AsyncEmbraceFBWriter;
+typedef AsyncOutput<PumaOutput> AsyncPumaOutput;
+PELICAN_DECLARE(AbstractOutputStream, AsyncSigprocStokesWriter)
+PELICAN_DECLARE(AbstractOutputStream, AsyncEmbraceFBWriter)
+PELICAN_DECLARE(AbstractOutputStream, AsyncPumaOutput)
+
+} // namespace ampp
+} // namespace pelican
@@ -1,7 +1,13 @@
 #include "AsyncronousModule.h"
 #include <QtConcurrentRun>
 #include "GPU_Manager.h"
+#include "GPU_Job.h"
+#ifdef CUDA_FOUND
 #include "GPU_NVidia.h"
+#endif
+#include "CPU_Resource.h"
+#include "CoreBudget.h"
+#include <QThread>
 #include <boost/bind.hpp>
 #include <iostream>
 
@@ -10,6 +16,29 @@ namespace pelican {
 
 namespace ampp {
 
+namespace {
+// DataBlobLockCounter slots in use by the live modules
+QMutex lockSlotMutex;
+unsigned lockSlotsUsed = 0;
+
+int takeLockSlot() {
+    QMutexLocker lock( &lockSlotMutex );
+    for( int i = 0; i < DataBlobLockCounter::Slots; ++i ) {
+        if( ! ( lockSlotsUsed & ( 1U << i ) ) ) {
+            lockSlotsUsed |= ( 1U << i );
+            return i;
+        }
+    }
+    return -1;
+}
+
+void releaseLockSlot( int slot ) {
+    if( slot < 0 ) return;
+    QMutexLocker lock( &lockSlotMutex );
+    lockSlotsUsed &= ~( 1U << slot );
+}
+} // namespace
+
 
 /**
  *@details AsyncronousModule 
@@ -18,6 +47,9 @@ AsyncronousModule::AsyncronousModule( const ConfigNode& config )
     : AbstractModule( config )
 {
    _chain = new ProcessingChain1<DataBlob*>;
+   _priority = config.getOption("priority", "value", "0").toInt();
+   _jobType = config.type();
+   _lockSlot = takeLockSlot();
    // initialise the GPU manager if required
    // for now we share the mamanger between all instances
    // and hog all the cards. We could refine this by removing
@@ -25,7 +57,17 @@ AsyncronousModule::AsyncronousModule( const ConfigNode& config )
    // down an appropriately configured gpuManager in the 
    // constructor.
    if( gpuManager()->resources() == 0 ) {
+#ifdef CUDA_FOUND
        GPU_NVidia::initialiseResources( gpuManager() );
+#endif
+       // host worker pools, alongside the cards or in their absence
+       unsigned hostResources = config.getOption("hostResources", "count",
+                                  gpuManager()->resources() ? "0" : "1" ).toUInt();
+       unsigned hostThreads = config.getOption("hostResources", "threads",
+                                  QString::number( CoreBudget::instance().threads() ) ).toUInt();
+       QList<int> cpus = CPU_Resource::parseCpuList(
+                                  config.getOption("hostResources", "cpus", "") );
+       CPU_Resource::initialiseResources( gpuManager(), hostResources, hostThreads, cpus );
    }
 }
 
@@ -43,10 +85,15 @@ AsyncronousModule::~AsyncronousModule()
     // outstanding jobs
     // are finished before removing the rest of the object
     delete _chain;
+    releaseLockSlot( _lockSlot );
 }
 
-void AsyncronousModule::waitForJobCompletion() const {
-    _chain->waitTaskCompletion();
+bool AsyncronousModule::waitForJobCompletion( unsigned long timeout ) const {
+    return _chain->waitTaskCompletion( timeout );
+}
+
+int AsyncronousModule::lastDrainTime() const {
+    return _chain->lastDrainTime();
 }
 
 void AsyncronousModule::connect( const boost::function1<void, DataBlob*>& functor ) {
@@ -58,6 +105,8 @@ void AsyncronousModule::unlockCallback( const UnlockCallBackT& callback ) {
 }
 
 GPU_Job* AsyncronousModule::submit(GPU_Job* job) {
+    job->setPriority( _priority );
+    job->setType( _jobType );
     return gpuManager()->submit(job);
 }
 
@@ -75,14 +124,21 @@ void AsyncronousModule::_exportComplete( DataBlob* blob ) {
      // allow derived class space to unlock
      QMutexLocker lock( &lockerMutex );
      exportComplete( blob );
-     // call unlocked triggers
-     foreach( const UnlockCallBackT& functor, _unlockTriggers ) { 
-        functor( _recentUnlocked );
+     // call unlocked triggers with the blobs that are now free
+     if( _recentUnlocked.size() ) {
+         foreach( const UnlockCallBackT& functor, _unlockTriggers ) { 
+            functor( _recentUnlocked );
+         }
+         _recentUnlocked.clear();
      }
-     _recentUnlocked.clear();
 }
 
 void AsyncronousModule::lock( const DataBlob* data ) {
+    const DataBlobLockCounter* counter = lockCounter(data);
+    if( counter ) {
+        counter->addLock( _lockSlot );
+        return;
+    }
     QMutexLocker lock(&lockerMutex);
     ++_dataLocker[data];
 //std::cout << "locking blob:" << data << " : " << _dataLocker[data] << std::endl;
@@ -90,6 +146,8 @@ void AsyncronousModule::lock( const DataBlob* data ) {
 
 int AsyncronousModule::lockNumber( const DataBlob* data ) const
 {
+    const DataBlobLockCounter* counter = lockCounter(data);
+    if( counter ) return counter->lockCount( _lockSlot );
     QMutexLocker lock(&lockerMutex);
     if( _dataLocker.contains( data ) )
         return _dataLocker.value(data);
@@ -98,12 +156,23 @@ int AsyncronousModule::lockNumber( const DataBlob* data ) const
 
 int AsyncronousModule::unlock( DataBlob* data ) {
     Q_ASSERT( ! lockerMutex.tryLock() ); // must be locked before entry
-    Q_ASSERT( _dataLocker[data] > 0 );
-    if( --_dataLocker[data] == 0 ) {
+    int remaining;
+    const DataBlobLockCounter* counter = lockCounter(data);
+    if( counter ) {
+        remaining = counter->removeLock( _lockSlot );
+        Q_ASSERT( remaining >= 0 );
+    }
+    else {
+        Q_ASSERT( _dataLocker[data] > 0 );
+        remaining = --_dataLocker[data];
+        if( remaining == 0 ) _dataLocker.remove(data);
+    }
+    // only the caller that releases the last lock reports it
+    if( remaining == 0 ) {
         _recentUnlocked.append(data);
     }
-//std::cout << "unlocking blob:" << data << " : " << _dataLocker[data] << std::endl;
-    return _dataLocker[data];
+//std::cout << "unlocking blob:" << data << " : " << remaining << std::endl;
+    return remaining;
 }
 
 } // namespace ampp
@@ -1,64 +1,106 @@
 #include "BufferingAgent.h"
+#include "Affinity.h"
+#include <QMutexLocker>
 #include <iostream>
 
 namespace pelican {
 namespace ampp {
 
-BufferingAgent::BufferingAgent(const DataFetchFunction& fn)
+BufferingAgent::BufferingAgent(const DataFetchFunction& fn, unsigned int queueLength)
     : QThread()
-    , _max_queue_length(3)
+    , _max_queue_length(queueLength)
     , _halt(false)
     , _fn(fn)
+    , _fetches(0)
+    , _occupancySum(0)
+    , _maxOccupancy(0)
 {
-    std::cout << "in ba constructor" << std::endl;
+    if( _max_queue_length == 0 )
+        throw QString("BufferingAgent: queue length must be at least 1");
     // create some objects to fill
     for(unsigned int i=0; i < _max_queue_length; ++i ) {
         _buffer_objects.push_back(DataBlobHash());
     }
-    // assign then to the buffer locking manager
-    _buffer.reset(&_buffer_objects);
+    for(int i=0; i < _buffer_objects.size(); ++i ) {
+        _free.append( &_buffer_objects[i] );
+    }
 }
 
 BufferingAgent::~BufferingAgent()
 {
-    _halt = true;
-    if(!_queue.empty()) _buffer.unlock(_queue.front()); // ensure to remove any block 
+    stop();
+    wait();
 }
 
 void BufferingAgent::run() {
-    _halt = false;
-    while(1) {
-        if(_halt) return;
-        DataBlobHash& hash = *(_buffer.next()); // blocks until ready
-        std::cout << "got next buffer!" << std::endl;
-        if(_halt) {
-            std::cout << "blah" << std::endl;
-            return;
+    Affinity::instance().pinCurrentThread( Affinity::IO, "BufferingAgent" );
+    forever {
+        DataBlobHash* hash;
+        {
+            QMutexLocker lock(&_mutex);
+            if( _free.isEmpty() && ! _halt ) {
+                _producerWait.tick();
+                while( _free.isEmpty() && ! _halt ) {
+                    _spaceReady.wait(&_mutex);
+                }
+                _producerWait.tock();
+            }
+            if( _halt ) return;
+            hash = _free.takeFirst();
         }
-        _fn(hash);
-        std::cout << "pushing to the queue" << std::endl;
-        _queue.push_back(&hash);
+        _fn(*hash); // fill outside the lock
+        QMutexLocker lock(&_mutex);
+        _queue.append(hash);
+        _dataReady.wakeOne();
     }
 }
 
 void BufferingAgent::stop()
 {
+    QMutexLocker lock(&_mutex);
     _halt = true;
-    quit();
+    _dataReady.wakeAll();
+    _spaceReady.wakeAll();
 }
 
 void BufferingAgent::getData(BufferingAgent::DataBlobHash& hash) {
-    // spin until we have data
-    std::cout << "a" << std::endl;
-    do{
-    } // TODO verify empty() is thread safe (and _queue.pop_front() call later on particularly when the _buffer is still filling slots)
-    while(_queue.empty());
-    std::cout << "b" << std::endl;
+    QMutexLocker lock(&_mutex);
+    unsigned occupancy = _queue.size();
+    if( _queue.isEmpty() && ! _halt ) {
+        _consumerWait.tick();
+        while( _queue.isEmpty() && ! _halt ) {
+            _dataReady.wait(&_mutex);
+        }
+        _consumerWait.tock();
+    }
+    if( _queue.isEmpty() ) return; // stopped
+    DataBlobHash* tmp = _queue.takeFirst();
+    hash.swap(*tmp);
+    _free.append(tmp);
+    ++_fetches;
+    _occupancySum += occupancy;
+    if( occupancy > _maxOccupancy ) _maxOccupancy = occupancy;
+    _spaceReady.wakeOne();
+}
+
+BufferingAgent::Statistics BufferingAgent::statistics() const {
+    QMutexLocker lock(&_mutex);
+    Statistics s;
+    s.fetches = _fetches;
+    s.meanOccupancy = _fetches ? (double)_occupancySum / _fetches : 0.0;
+    s.maxOccupancy = _maxOccupancy;
+    s.producerBlocked = _producerWait.timeAverage * _producerWait.counter;
+    s.consumerBlocked = _consumerWait.timeAverage * _consumerWait.counter;
+    return s;
+}
 
-    DataBlobHash* tmp = _queue.front();
-    hash.swap(*tmp); // TODO verify this is doing what we think its doing
-    _queue.pop_front(); // remove from queue before unblocking the other thread to reduce conflicts
-    _buffer.unlock(tmp);
+void BufferingAgent::report() const {
+    Statistics s = statistics();
+    std::cout << "BufferingAgent: " << s.fetches << " objects served from a queue of "
+              << _max_queue_length << "\n"
+              << "    occupancy mean " << s.meanOccupancy << " max " << s.maxOccupancy << "\n"
+              << "    blocked: agent " << s.producerBlocked << " s, consumer "
+              << s.consumerBlocked << " s" << std::endl;
 }
 
 } // namespace ampp
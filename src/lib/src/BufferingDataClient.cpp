@@ -8,13 +8,12 @@ namespace ampp {
 template<class DataClientType>
 BufferingDataClient<DataClientType>::BufferingDataClient(const ConfigNode& configNode, const DataTypes& types, const Config* config)
     : DataClientType(configNode, types, config)
-    , _agent(boost::bind(&DataClientType::getData, this, _1))
+    , _agent(boost::bind(&BufferingDataClient<DataClientType>::_fetch, this, _1),
+             configNode.getOption("prefetch", "depth", "3").toUInt())
 //    , _halt(false)
 {
     // start the thread running that collects data
-    std::cout << "starting agent..." << std::endl;
     _agent.start();
-    std::cout << "done..." << std::endl;
 
     // dedicate a thread to running the event loop of the agent to ensure messages are delivered to the agent
     //QtConcurrent::run(boost::bind(&BufferingDataClient<DataClientType>::exec, this));   
@@ -24,9 +23,9 @@ template<class DataClientType>
 BufferingDataClient<DataClientType>::~BufferingDataClient()
 {
     // stop the thread running
-    std::cout << "stopping agent..." << std::endl;
     _agent.stop();
-    std::cout << "done..." << std::endl;
+    _agent.wait();
+    _agent.report();
     //_halt = true;
 }
 
@@ -43,11 +42,17 @@ void BufferingDataClient<DataClientType>::exec()
 template<class DataClientType>
 pelican::AbstractDataClient::DataBlobHash BufferingDataClient<DataClientType>::getData(pelican::AbstractDataClient::DataBlobHash& hash)
 {
-    std::cout << "getting data..." << std::endl;
     _agent.getData(hash);
-    std::cout << "done..." << std::endl;
     return hash;
 }
 
+template<class DataClientType>
+void BufferingDataClient<DataClientType>::_fetch(pelican::AbstractDataClient::DataBlobHash& hash)
+{
+    // qualified call: binding &DataClientType::getData directly would
+    // dispatch virtually back to our own getData()
+    DataClientType::getData(hash);
+}
+
 } // namespace ampp
 } // namespace pelican
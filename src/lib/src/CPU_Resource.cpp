@@ -0,0 +1,180 @@
+#include "CPU_Resource.h"
+#include "GPU_Manager.h"
+#include "GPU_Job.h"
+#include "GPU_Kernel.h"
+#include "Affinity.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QStringList>
+#include <iostream>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace pelican {
+
+namespace ampp {
+
+class CPU_Resource::Worker : public QThread
+{
+    public:
+        Worker( CPU_Resource* resource, unsigned id, int cpu )
+            : _resource(resource), _id(id), _cpu(cpu) {}
+
+    protected:
+        void run() {
+            if( _cpu < 0 ) {
+                // no cpu of its own: use the compute cores if there are any
+                Affinity::instance().pinCurrentThread( Affinity::Compute, "CPU_Resource" );
+            }
+#ifdef __linux__
+            else {
+                cpu_set_t set;
+                CPU_ZERO( &set );
+                CPU_SET( _cpu, &set );
+                if( pthread_setaffinity_np( pthread_self(), sizeof(set), &set ) )
+                    std::cerr << "CPU_Resource: unable to pin worker to cpu " << _cpu << std::endl;
+            }
+#endif
+            _resource->_work( _id );
+        }
+
+    private:
+        CPU_Resource* _resource;
+        unsigned _id;
+        int _cpu;
+};
+
+/**
+ *@details CPU_Resource 
+ */
+CPU_Resource::CPU_Resource( unsigned threads, const QList<int>& cpus )
+    : _task(0), _items(0), _generation(0), _busy(0), _exit(false)
+{
+    if( threads == 0 ) threads = 1;
+    _scratch.resize( threads );
+    for( unsigned i = 0; i < threads; ++i ) {
+        int cpu = cpus.isEmpty() ? -1 : cpus[ i % cpus.size() ];
+        _workers.append( new Worker( this, i, cpu ) );
+        _workers.last()->start();
+    }
+}
+
+/**
+ *@details
+ */
+CPU_Resource::~CPU_Resource()
+{
+    {
+        QMutexLocker lock(&_mutex);
+        _exit = true;
+        _start.wakeAll();
+    }
+    foreach( Worker* w, _workers ) {
+        w->wait();
+        delete w;
+    }
+}
+
+bool CPU_Resource::canRun( GPU_Job* job ) const
+{
+    foreach( const GPU_Kernel* kernel, job->kernels() ) {
+        if( ! kernel->hasHostImplementation() ) return false;
+    }
+    return true;
+}
+
+void CPU_Resource::run( GPU_Job* job )
+{
+    foreach( GPU_Kernel* kernel, job->kernels() ) {
+        try {
+            kernel->runOnHost( *this );
+        }
+        catch( ... ) {
+            kernel->cleanUp();
+            throw;
+        }
+    }
+}
+
+void CPU_Resource::parallelFor( int n, const TaskT& task )
+{
+    if( n <= 0 ) return;
+    QMutexLocker lock(&_mutex);
+    _task = &task;
+    _items = n;
+    _next = 0;
+    _error.clear();
+    _busy = _workers.size();
+    ++_generation;
+    _start.wakeAll();
+    while( _busy ) _done.wait(&_mutex);
+    _task = 0;
+    if( ! _error.isEmpty() ) throw _error;
+}
+
+void CPU_Resource::_work( unsigned worker )
+{
+    unsigned generation = 0;
+    _mutex.lock();
+    forever {
+        while( generation == _generation && ! _exit ) _start.wait(&_mutex);
+        if( _exit ) break;
+        generation = _generation;
+        _mutex.unlock();
+        // take items until there are none left
+        try {
+            for( int i = _next.fetchAndAddOrdered(1); i < _items;
+                     i = _next.fetchAndAddOrdered(1) ) {
+                (*_task)( i, worker );
+            }
+        }
+        catch( const QString& e ) {
+            QMutexLocker lock(&_mutex);
+            _error = e;
+            _next = _items; // abandon the remaining items
+        }
+        catch( ... ) {
+            QMutexLocker lock(&_mutex);
+            _error = "CPU_Resource: unknown exception in worker";
+            _next = _items;
+        }
+        _mutex.lock();
+        if( --_busy == 0 ) _done.wakeAll();
+    }
+    _mutex.unlock();
+}
+
+void CPU_Resource::initialiseResources( GPU_Manager* manager, unsigned resources,
+                                        unsigned threadsPerResource,
+                                        const QList<int>& cpus )
+{
+    for( unsigned r = 0; r < resources; ++r ) {
+        // give each resource its own slice of the cpu list
+        QList<int> slice;
+        for( unsigned i = 0; i < threadsPerResource && ! cpus.isEmpty(); ++i ) {
+            slice.append( cpus[ ( r * threadsPerResource + i ) % cpus.size() ] );
+        }
+        manager->addResource( new CPU_Resource( threadsPerResource, slice ) );
+    }
+}
+
+QList<int> CPU_Resource::parseCpuList( const QString& list )
+{
+    QList<int> cpus;
+    foreach( const QString& item, list.split(",", QString::SkipEmptyParts) ) {
+        QStringList range = item.trimmed().split("-");
+        bool ok1 = true, ok2 = true;
+        int first = range[0].toInt(&ok1);
+        int last = ( range.size() > 1 ) ? range[1].toInt(&ok2) : first;
+        if( ! ok1 || ! ok2 || range.size() > 2 || last < first )
+            throw QString("CPU_Resource: bad cpu list \"%1\"").arg(list);
+        for( int c = first; c <= last; ++c ) cpus.append( c );
+    }
+    return cpus;
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,78 @@
+#include "CandidateFile.h"
+#include <QIODevice>
+#include <QTextStream>
+#include <QString>
+#include <cstring>
+#include <time.h>
+
+
+namespace pelican {
+
+namespace ampp {
+
+namespace {
+
+const char magic[8] = { 'A', 'M', 'P', 'P', 'C', 'A', 'N', 'D' };
+const quint32 byteOrder = 0x01020304;
+
+} // namespace
+
+CandidateFile::Header CandidateFile::header( unsigned beam )
+{
+    Header h;
+    std::memset( &h, 0, sizeof(h) );
+    std::memcpy( h.magic, magic, sizeof(magic) );
+    h.version = version;
+    h.recordSize = sizeof(Record);
+    h.byteOrder = byteOrder;
+    h.beam = beam;
+    h.created = (double)time(0);
+    return h;
+}
+
+CandidateFile::Header CandidateFile::readHeader( QIODevice& device )
+{
+    Header h;
+    if( device.read( reinterpret_cast<char*>(&h), sizeof(h) ) != sizeof(h) ||
+        std::memcmp( h.magic, magic, sizeof(magic) ) != 0 )
+        throw QString("CandidateFile: not a candidate file");
+    if( h.byteOrder != byteOrder )
+        throw QString("CandidateFile: written with a different byte order");
+    if( h.version > version || h.recordSize != sizeof(Record) )
+        throw QString("CandidateFile: unsupported version %1 (record size %2)")
+                      .arg(h.version).arg(h.recordSize);
+    return h;
+}
+
+qint64 CandidateFile::readRecords( QIODevice& device, Record* records, qint64 n )
+{
+    qint64 bytes = device.read( reinterpret_cast<char*>(records), n * sizeof(Record) );
+    return ( bytes < 0 ) ? 0 : bytes / (qint64)sizeof(Record);
+}
+
+void CandidateFile::writeTextHeader( QTextStream& out )
+{
+    out << "# Generated by DedispersionDataAnalysisOutput\n"
+        << "# Events\n"
+        << "# ------\n"
+        << "# Time|Dm|Amplitude|BinFactor\n"
+        << "# ------\n";
+    out.setRealNumberPrecision( 14 );
+}
+
+void CandidateFile::writeText( QTextStream& out, const Record& r )
+{
+    if( r.type == Event ) {
+        out << left << r.mjd << ",   " << r.dm << ", " << r.snr << ", " << (int)r.width << "\n";
+        return;
+    }
+    out << "# Written buffer :" << r.buffer << " | MJDstart: " << r.mjd
+        << " | Best DM: " << r.dm << " | Max SNR: " << r.snr;
+    if( r.degradation ) {
+        out << " | Degraded: level " << (int)r.degradation;
+    }
+    out << "  Done\n";
+}
+
+} // namespace ampp
+} // namespace pelican
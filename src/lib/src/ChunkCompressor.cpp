@@ -0,0 +1,315 @@
+#include "ChunkCompressor.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QIODevice>
+#include <QString>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <time.h>
+#include <omp.h>
+
+
+namespace pelican {
+
+namespace ampp {
+
+namespace {
+
+const char chunkMagic[8] = { 'A', 'M', 'P', 'Z', 'C', 'H', 'N', 'K' };
+const char indexMagic[8] = { 'A', 'M', 'P', 'Z', 'I', 'N', 'D', 'X' };
+const char trailerMagic[8] = { 'A', 'M', 'P', 'Z', 'T', 'A', 'I', 'L' };
+
+// transpose the 8x8 bit matrix held one row per byte, so that bit j of
+// byte k becomes bit k of byte j (Hacker's Delight 7-3)
+inline quint64 transpose8( quint64 x )
+{
+    quint64 t;
+    t = ( x ^ ( x >> 7 ) ) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ ( t << 7 );
+    t = ( x ^ ( x >> 14 ) ) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ ( t << 14 );
+    t = ( x ^ ( x >> 28 ) ) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ ( t << 28 );
+    return x;
+}
+
+} // namespace
+
+
+/**
+ *@details ChunkCompressor
+ */
+ChunkCompressor::ChunkCompressor( const ConfigNode& config )
+    : _elementSize(4), _out(0), _offset(0), _rawOffset(0), _fill(0)
+{
+    _active = config.getOption("compression", "active", "false").toLower() == "true";
+    // whole groups of 8 elements of up to 8 bytes
+    _chunkSize = config.getOption("compression", "chunkSize", "4194304").toUInt();
+    _chunkSize = std::min( (size_t)1 << 30, std::max( (size_t)4096, ( _chunkSize + 63 ) & ~(size_t)63 ) );
+    _level = config.getOption("compression", "level", "1").toInt();
+    if( _level < 0 || _level > 9 )
+        throw QString("ChunkCompressor: level must be 0 to 9, not %1").arg(_level);
+    _threads = std::max( 1, config.getOption("compression", "threads", "2").toInt() );
+    _shuffle = config.getOption("compression", "shuffle", "true").toLower() == "true";
+    std::memset( &_statistics, 0, sizeof(_statistics) );
+}
+
+/**
+ *@details
+ */
+ChunkCompressor::~ChunkCompressor()
+{
+}
+
+double ChunkCompressor::_now()
+{
+    struct timespec tp;
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    return tp.tv_sec + tp.tv_nsec * 1.0e-9;
+}
+
+double ChunkCompressor::_cpuTime()
+{
+    struct timespec tp;
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &tp );
+    return tp.tv_sec + tp.tv_nsec * 1.0e-9;
+}
+
+void ChunkCompressor::setElementSize( unsigned bytes )
+{
+    if( bytes < 1 || bytes > 8 )
+        throw QString("ChunkCompressor: element size must be 1 to 8 bytes, not %1").arg(bytes);
+    _elementSize = bytes;
+}
+
+void ChunkCompressor::start( std::ostream& out )
+{
+    if( ! _active ) return;
+    _out = &out;
+    std::streamoff position = out.tellp();
+    _offset = ( position > 0 ) ? position : 0;
+    _rawOffset = 0;
+    _fill = 0;
+    _index.clear();
+    _raw.resize( _chunkSize * _threads );
+    _shuffled.resize( _threads );
+    _compressed.resize( _threads );
+    _cpu.resize( _threads );
+}
+
+void ChunkCompressor::write( const char* data, size_t size )
+{
+    while( size ) {
+        size_t n = std::min( size, _raw.size() - _fill );
+        std::memcpy( &_raw[_fill], data, n );
+        _fill += n; data += n; size -= n;
+        if( _fill == _raw.size() ) {
+            _compress( _threads, _chunkSize );
+            _fill = 0;
+        }
+    }
+}
+
+void ChunkCompressor::finish()
+{
+    if( ! _out ) return;
+    if( _fill ) {
+        int n = ( _fill + _chunkSize - 1 ) / _chunkSize;
+        _compress( n, _fill - ( n - 1 ) * _chunkSize );
+        _fill = 0;
+    }
+    Trailer trailer;
+    std::memcpy( trailer.magic, trailerMagic, sizeof(trailerMagic) );
+    trailer.chunks = _index.size();
+    trailer.indexOffset = _offset;
+    _out->write( indexMagic, sizeof(indexMagic) );
+    if( ! _index.empty() ) {
+        _out->write( reinterpret_cast<const char*>(&_index[0]), _index.size() * sizeof(IndexEntry) );
+    }
+    _out->write( reinterpret_cast<const char*>(&trailer), sizeof(trailer) );
+    _out->flush();
+    _out = 0;
+}
+
+void ChunkCompressor::_compress( int n, size_t lastSize )
+{
+    double start = _now();
+    // the chunks are independent, so compress them side by side
+    #pragma omp parallel for schedule(dynamic) num_threads(_threads)
+    for( int i = 0; i < n; ++i ) {
+        double cpu = _cpuTime();
+        size_t size = ( i == n - 1 ) ? lastSize : _chunkSize;
+        const char* source = &_raw[ i * _chunkSize ];
+        if( _shuffle ) {
+            _shuffled[i].resize( size );
+            shuffle( source, &_shuffled[i][0], size, _elementSize );
+            source = &_shuffled[i][0];
+        }
+        _compressed[i] = ( _level > 0 )
+                ? qCompress( reinterpret_cast<const uchar*>(source), (int)size, _level )
+                : QByteArray();
+        _cpu[i] = _cpuTime() - cpu;
+    }
+
+    // and write them out in order
+    for( int i = 0; i < n; ++i ) {
+        size_t size = ( i == n - 1 ) ? lastSize : _chunkSize;
+        bool deflated = ! _compressed[i].isEmpty() && (size_t)_compressed[i].size() < size;
+        ChunkHeader header;
+        std::memcpy( header.magic, chunkMagic, sizeof(chunkMagic) );
+        header.rawSize = size;
+        header.elementSize = _elementSize;
+        header.reserved = 0;
+        const char* data;
+        if( deflated ) {
+            header.compressedSize = _compressed[i].size();
+            header.flags = Deflated | ( _shuffle ? Shuffled : 0 );
+            data = _compressed[i].constData();
+        }
+        else {
+            // stored as it came
+            header.compressedSize = size;
+            header.flags = 0;
+            data = &_raw[ i * _chunkSize ];
+        }
+        _out->write( reinterpret_cast<const char*>(&header), sizeof(header) );
+        _out->write( data, header.compressedSize );
+
+        IndexEntry entry;
+        entry.offset = _offset;
+        entry.rawOffset = _rawOffset;
+        entry.rawSize = header.rawSize;
+        entry.compressedSize = header.compressedSize;
+        entry.ratio = (float)header.rawSize / header.compressedSize;
+        entry.cpu = _cpu[i];
+        _index.push_back( entry );
+        _offset += sizeof(header) + header.compressedSize;
+        _rawOffset += size;
+        ++_statistics.chunks;
+        _statistics.rawBytes += size;
+        _statistics.compressedBytes += sizeof(header) + header.compressedSize;
+        _statistics.cpu += _cpu[i];
+    }
+    _statistics.wall += _now() - start;
+}
+
+void ChunkCompressor::report( const char* name ) const
+{
+    if( _statistics.chunks == 0 ) return;
+    std::cout << name << ": compressed " << _statistics.rawBytes / 1.0e6 << " MB to "
+              << _statistics.compressedBytes / 1.0e6 << " MB (ratio "
+              << _statistics.rawBytes / _statistics.compressedBytes << ") in "
+              << _statistics.chunks << " chunks, "
+              << _statistics.rawBytes / 1.0e6 / std::max( _statistics.cpu, 1e-9 )
+              << " MB per CPU second, " << _statistics.wall << " s" << std::endl;
+}
+
+bool ChunkCompressor::isCompressed( QIODevice* in )
+{
+    QByteArray magic = in->peek( sizeof(chunkMagic) );
+    return magic == QByteArray( chunkMagic, sizeof(chunkMagic) )
+        || magic == QByteArray( indexMagic, sizeof(indexMagic) );
+}
+
+QByteArray ChunkCompressor::readChunk( QIODevice* in )
+{
+    if( in->peek( sizeof(chunkMagic) ) != QByteArray( chunkMagic, sizeof(chunkMagic) ) )
+        return QByteArray();
+    ChunkHeader header;
+    if( in->read( reinterpret_cast<char*>(&header), sizeof(header) ) != sizeof(header) )
+        throw QString("ChunkCompressor: truncated chunk header");
+    QByteArray data = in->read( header.compressedSize );
+    if( data.size() != (int)header.compressedSize )
+        throw QString("ChunkCompressor: truncated chunk");
+    if( header.flags & Deflated ) {
+        data = qUncompress( data );
+        if( data.size() != (int)header.rawSize )
+            throw QString("ChunkCompressor: damaged chunk");
+    }
+    else if( data.size() != (int)header.rawSize ) {
+        throw QString("ChunkCompressor: damaged chunk");
+    }
+    if( header.flags & Shuffled ) {
+        QByteArray raw( header.rawSize, 0 );
+        unshuffle( data.constData(), raw.data(), header.rawSize, header.elementSize );
+        return raw;
+    }
+    return data;
+}
+
+QList<ChunkCompressor::IndexEntry> ChunkCompressor::readIndex( QIODevice* in )
+{
+    Trailer trailer;
+    char marker[8];
+    if( in->size() < (qint64)( sizeof(trailer) + sizeof(marker) ) ||
+        ! in->seek( in->size() - sizeof(trailer) ) ||
+        in->read( reinterpret_cast<char*>(&trailer), sizeof(trailer) ) != sizeof(trailer) ||
+        std::memcmp( trailer.magic, trailerMagic, sizeof(trailerMagic) ) != 0 )
+        throw QString("ChunkCompressor: no index found");
+    if( ! in->seek( trailer.indexOffset ) ||
+        in->read( marker, sizeof(marker) ) != sizeof(marker) ||
+        std::memcmp( marker, indexMagic, sizeof(indexMagic) ) != 0 )
+        throw QString("ChunkCompressor: damaged index");
+    QList<IndexEntry> index;
+    for( quint64 i = 0; i < trailer.chunks; ++i ) {
+        IndexEntry entry;
+        if( in->read( reinterpret_cast<char*>(&entry), sizeof(entry) ) != sizeof(entry) )
+            throw QString("ChunkCompressor: truncated index");
+        index.append( entry );
+    }
+    return index;
+}
+
+/**
+ * @details
+ * Each group of 8 elements gives one byte to each of the 8 * elementSize
+ * bit planes; plane p holds bit p % 8 of byte p / 8 of every element.
+ */
+void ChunkCompressor::shuffle( const char* in, char* out, size_t size, unsigned elementSize )
+{
+    size_t groups = size / elementSize / 8;
+    size_t shuffled = groups * 8 * elementSize;
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+    for( size_t g = 0; g < groups; ++g ) {
+        const unsigned char* group = src + g * 8 * elementSize;
+        for( unsigned b = 0; b < elementSize; ++b ) {
+            quint64 x = 0;
+            for( unsigned k = 0; k < 8; ++k ) {
+                x |= (quint64)group[ k * elementSize + b ] << ( 8 * k );
+            }
+            x = transpose8( x );
+            unsigned char* plane = dst + (size_t)b * 8 * groups + g;
+            for( unsigned j = 0; j < 8; ++j ) {
+                plane[ j * groups ] = (unsigned char)( x >> ( 8 * j ) );
+            }
+        }
+    }
+    std::memcpy( out + shuffled, in + shuffled, size - shuffled );
+}
+
+void ChunkCompressor::unshuffle( const char* in, char* out, size_t size, unsigned elementSize )
+{
+    size_t groups = size / elementSize / 8;
+    size_t shuffled = groups * 8 * elementSize;
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(in);
+    unsigned char* dst = reinterpret_cast<unsigned char*>(out);
+    for( size_t g = 0; g < groups; ++g ) {
+        unsigned char* group = dst + g * 8 * elementSize;
+        for( unsigned b = 0; b < elementSize; ++b ) {
+            const unsigned char* plane = src + (size_t)b * 8 * groups + g;
+            quint64 x = 0;
+            for( unsigned j = 0; j < 8; ++j ) {
+                x |= (quint64)plane[ j * groups ] << ( 8 * j );
+            }
+            x = transpose8( x );
+            for( unsigned k = 0; k < 8; ++k ) {
+                group[ k * elementSize + b ] = (unsigned char)( x >> ( 8 * k ) );
+            }
+        }
+    }
+    std::memcpy( out + shuffled, in + shuffled, size - shuffled );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,92 @@
+#include "CoreBudget.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QMutexLocker>
+#include <algorithm>
+
+
+namespace pelican {
+
+namespace ampp {
+
+
+/**
+ *@details CoreBudget
+ */
+CoreBudget::CoreBudget()
+    : _cores( std::max( 1, QThread::idealThreadCount() ) ), _streams(1), _localStreams(0)
+{
+}
+
+CoreBudget& CoreBudget::instance()
+{
+    static CoreBudget budget;
+    return budget;
+}
+
+void CoreBudget::configure( const ConfigNode& config )
+{
+    unsigned c = config.getOption("coreBudget", "cores", QString::number(cores()) ).toUInt();
+    unsigned s = config.getOption("coreBudget", "streams", QString::number(streams()) ).toUInt();
+    configure( c, s );
+}
+
+void CoreBudget::configure( unsigned cores, unsigned streams )
+{
+    if( cores == 0 || streams == 0 )
+        throw QString("CoreBudget: cores and streams must be at least 1");
+    QMutexLocker lock(&_mutex);
+    _cores = cores;
+    _streams = streams;
+    _updatePool();
+}
+
+unsigned CoreBudget::cores() const
+{
+    QMutexLocker lock(&_mutex);
+    return _cores;
+}
+
+unsigned CoreBudget::streams() const
+{
+    QMutexLocker lock(&_mutex);
+    return _streams;
+}
+
+unsigned CoreBudget::share() const
+{
+    QMutexLocker lock(&_mutex);
+    return std::max( 1U, _cores / _streams );
+}
+
+unsigned CoreBudget::threads( unsigned requested ) const
+{
+    unsigned s = share();
+    if( requested == 0 ) return s;
+    return std::min( requested, s );
+}
+
+void CoreBudget::registerStream()
+{
+    QMutexLocker lock(&_mutex);
+    ++_localStreams;
+    _updatePool();
+}
+
+QThreadPool* CoreBudget::pool() const
+{
+    return QThreadPool::globalInstance();
+}
+
+void CoreBudget::_updatePool()
+{
+    // called with the mutex locked
+    unsigned share = std::max( 1U, _cores / _streams );
+    unsigned local = std::max( 1U, _localStreams );
+    unsigned threads = std::min( _cores, share * local );
+    QThreadPool::globalInstance()->setMaxThreadCount( (int)threads );
+}
+
+} // namespace ampp
+} // namespace pelican
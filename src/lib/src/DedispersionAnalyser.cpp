@@ -2,7 +2,12 @@
 #include "DedispersionSpectra.h"
 #include "DedispersionDataAnalysis.h"
 #include "SpectrumDataSet.h"
+#include "CoreBudget.h"
 #include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <omp.h>
 
 
 namespace pelican {
@@ -14,194 +19,161 @@ namespace ampp {
  *@details DedispersionAnalyser
  */
 DedispersionAnalyser::DedispersionAnalyser( const ConfigNode& config )
-    : AbstractModule( config )
+    : AbstractModule( config ), _thresholdOffset(0.0), _analysisTime("DedispersionAnalyser")
 {
     // Get configuration options
     //unsigned int nChannels = config.getOption("outputChannelsPerSubband", "value", "512").toUInt();
     _detectionThreshold = config.getOption("detectionThreshold", "in_sigma", "6.0").toFloat();
     _binPow2 = config.getOption("power2ForBinning", "value", "6").toUInt();
     _useStokesStats = config.getOption("useStokesStats", "0_or_1").toUInt();
+
+    // boxcar widths (in full resolution samples) to search. By default
+    // the powers of two up to 2^power2ForBinning
+    QString widths = config.getOption("boxcarWidths", "value", "");
+    foreach( const QString& w, widths.split(",", QString::SkipEmptyParts) ) {
+        unsigned width = w.trimmed().toUInt();
+        if( width == 0 ) throw(QString("DedispersionAnalyser: bad boxcar width \"%1\"").arg(w));
+        _widths.append( width );
+    }
+    if( _widths.isEmpty() ) {
+        for( unsigned n = 0; n <= _binPow2; ++n ) _widths.append( 1U << n );
+    }
+    qSort( _widths );
 }
 
 DedispersionAnalyser::~DedispersionAnalyser()
 {
+    // the timer prints its own report as it is destroyed
+    if( (int)_buffers ) {
+        std::cout << "DedispersionAnalyser: " << (int)_events << " events found in "
+                  << (int)_buffers << " buffers" << std::endl;
+    }
 }
 
 int DedispersionAnalyser::analyse( DedispersionSpectra* data, 
                                     DedispersionDataAnalysis* result ) {
 
+    _analysisTime.tick();
     result->reset(data);
     const QList<SpectrumDataSetStokes* >& d = data->inputDataBlobs(); 
+    if( d.isEmpty() ) {
+        _analysisTime.tock();
+        return 0;
+    }
     int nChannels = d[0]->nChannels();
     int nSubbands = d[0]->nSubbands();
 
     float rms = std::sqrt((float)nChannels*(float)nSubbands);
     result->setRMS(rms);
 
-    // Calculate the mean
-    //double mean = 0.0, stddev = 0.0;
-    double total = 0.0;
-
-    std::vector<float> dataVector = data->data();
-    /*
-    int vals=dataVector.size();
-    for( int j = 0; j < vals; ++j ) {
-        total += dataVector[j];
-    }
-    mean = total/vals;  // Mean for entire array
-    std::cout << "Mean: " << mean << std::endl;
-
-    // Calculate standard deviation
-    total = 0;
-    for(int j=0; j < vals; ++j ) {
-        total += pow(dataVector[j] - mean, 2);
-    }
-    stddev = sqrt(total / vals); // Stddev for entire dedispersion array
-    std::cout << "Stddev: " << stddev << std::endl;
-    // Subtract dm mean from all samples and apply threshold
-    */
     int tdms = data->dmBins();
-    int nsamp = data->timeSamples();
-
-    // Check if the buffer is lost
+    float threshold = _detectionThreshold + _thresholdOffset;
 
     // Add a dummy event to get the timestamp of the first bin in the blob
     result->addEvent( 0, 0, 1, 0.0 );
 
-    // Compute 2^_binPowerOf2
-    unsigned int maxPow2 = pow(2,_binPow2);
-    unsigned int numberOfwidestBins = nsamp/maxPow2;
-    // Attempt at tidying up the stuff below
-    // Define a vector of _binPowerOf2 vectors
-    QVector < QVector <float> > binnedOutput;
-    binnedOutput.resize(_binPow2 + 1);
-    // resize in the other direction
-    // 1 bin for highest index, 2 for next, 4, 8 etc.
-    unsigned int currentPow2 = maxPow2;
-    for (int n = _binPow2 ; n > -1 ; --n){
-      binnedOutput[n].resize(maxPow2 / currentPow2);
-      currentPow2 /= 2;
-    }
-    // 
-    unsigned int numberOfWidestBins = nsamp / maxPow2;
-    for(int dm_count = 0; dm_count < tdms; ++dm_count) {
-
-      /*
-      QVector<float> outputBin1;
-      QVector<float> outputBin2;
-      QVector<float> outputBin4;
-      QVector<float> outputBin8;
-      QVector<float> outputBin16;
-      float outputBin32;
-
-      outputBin1.resize(32);
-      outputBin2.resize(16);
-      outputBin4.resize(8);
-      outputBin8.resize(4);
-      outputBin16.resize(2);
-      */
-      //    outputBin8.resize(1);
-      
-      for (int i=0; i < numberOfWidestBins; ++i) {
-        currentPow2 = maxPow2;
-        // fill the bin1 Vector first and check
-        for (int j=0; j<maxPow2; ++j){
-	  int index = i*maxPow2 + j;
-	  //          int index = i*32 + j;
-          binnedOutput[0][j]= dataVector[dm_count*nsamp + index]; 
-          float detection = _detectionThreshold * rms;// * sqrt((float)indexJ);
-          if (binnedOutput[0][j] >= detection){
-            result->addEvent( dm_count, index, 1, binnedOutput[0][j] );
-          }
-        }
-        for (int n = 1 ; n < _binPow2 + 1; ++n){
-          currentPow2 /= 2;
-          for (int j = 0; j < currentPow2; ++j){
-            int binFactor = maxPow2/currentPow2;
-            float detection = _detectionThreshold * rms * sqrt((float)binFactor);
-            int index = i*maxPow2 + binFactor * j;
-            binnedOutput[n][j] = binnedOutput[n-1][2*j] + binnedOutput[n-1][2*j+1];
-            if (binnedOutput[n][j] >= detection){
-              result->addEvent( dm_count, index, binFactor, binnedOutput[n][j] );
+    // the dedispersion has already searched the data on the device
+    // and returned the best boxcar in each summary block
+    if( data->hasPeakSummary() ) {
+        int blocks = data->summaryBlocks();
+        for(int dm_count = 0; dm_count < tdms; ++dm_count) {
+            for(int b = 0; b < blocks; ++b) {
+                const float* peak = data->peak( dm_count, b );
+                if( peak[0] >= threshold ) {
+                    // scale so that the reported amplitude gives the
+                    // same S/N as the boxcars below
+                    result->addEvent( dm_count, (unsigned)peak[1], peak[2],
+                                      peak[0] * rms * std::sqrt( peak[2] ) );
+                }
             }
-          }
         }
-      }
+        _analysisTime.tock();
+        _buffers.fetchAndAddRelaxed( 1 );
+        _events.fetchAndAddRelaxed( result->eventsFound() );
+        std::cout << "Found " << result->eventsFound() << " events in "
+                  << _analysisTime.timeElapsed * 1000.0 << " ms" << std::endl;
+        return result->eventsFound();
     }
-        /*
-      for(int i=0; i < nsamp/32; ++i) {
-        for(int j=0; j < 32; ++j) {
-          int index = i*32 + j;
-          outputBin1[j]= dataVector[dm_count*nsamp + index]; 
-          if (outputBin1[j] >= _detectionThreshold * rms){
-            result->addEvent( dm_count, index, 1, outputBin1[j] );
-            //                std::cout << outputBin1[j] << std::endl;
-          }
-        }
-        for(int j=0; j < 16; ++j) {
-          int index = i*32 + 2*j;
-          outputBin2[j]= outputBin1[2*j] + outputBin1[2*j+1];
-          if (outputBin2[j] >= _detectionThreshold * rms * 1.4142){
-            result->addEvent( dm_count, index, 2, outputBin2[j] );
-            //                std::cout << "2 " <<outputBin2[j] << std::endl;
-          }
-        }
-        for(int j=0; j < 8; ++j) {
-          int index = i*32 + 4*j;
-          outputBin4[j]= outputBin2[2*j] + outputBin2[2*j+1];
-          if (outputBin4[j] >= _detectionThreshold * rms * 2){
-            result->addEvent( dm_count, index, 4, outputBin4[j] );
-            //                std::cout << "4 " <<outputBin4[j] << std::endl;
-            //            result->addEvent( dm_count, index );
-          }
+
+    // Search each DM trial in place, in parallel. Events are collected
+    // per thread and merged in DM order afterwards.
+    int nThreads = CoreBudget::instance().threads();
+    std::vector< std::vector<Event> > threadEvents( nThreads );
+    #pragma omp parallel num_threads(nThreads)
+    {
+        std::vector<Event>& events = threadEvents[ omp_get_thread_num() ];
+        std::vector<double> cumulative;
+        std::vector<float> boxcar;
+        #pragma omp for schedule(static)
+        for(int dm_count = 0; dm_count < tdms; ++dm_count) {
+            // trials at high DM may be stored downsampled, each sample
+            // already being the sum of ds full resolution samples
+            _search( data->dmTrial(dm_count), data->timeSamples(dm_count),
+                     data->downsampling(dm_count), dm_count, rms, threshold,
+                     cumulative, boxcar, events );
         }
-        for(int j=0; j < 4; ++j) {
-          int index = i*32 + 8*j;
-          outputBin8[j]= outputBin4[2*j] + outputBin4[2*j+1];
-          if (outputBin8[j] >= _detectionThreshold * rms * 2.8284){
-            result->addEvent( dm_count, index, 8, outputBin8[j] );
-            //              std::cout <<"8 " << outputBin8[j] << std::endl;
-            //            result->addEvent( dm_count, index );
-          }
+    }
+    for( int i = 0; i < nThreads; ++i ) {
+        foreach( const Event& e, threadEvents[i] ) {
+            result->addEvent( e.dm, e.sample, e.width, e.value );
         }
-        for(int j=0; j < 2; ++j) {
-          int index = i*32 + 16*j;
-          outputBin16[j]= outputBin8[2*j] + outputBin8[2*j+1];
-          //          if (outputBin16[j] >= _detectionThreshold * rms * 4){
-          if (outputBin16[j] >= _detectionThreshold * rms * 4.0){
-            //            result->addEvent( dm_count, index );
-            //              std::cout << "16 " <<outputBin16[j] << std::endl;
-            result->addEvent( dm_count, index, 16, outputBin16[j] );
-            
-          }
+    }
+    _analysisTime.tock();
+    _buffers.fetchAndAddRelaxed( 1 );
+    _events.fetchAndAddRelaxed( result->eventsFound() );
+    std::cout << "Found " << result->eventsFound() << " events in "
+              << _analysisTime.timeElapsed * 1000.0 << " ms" << std::endl;
+    return result->eventsFound();
+}
+
+/**
+ * @details
+ * Boxcar sums of any width are differences of the running sum of the trial.
+ * Every start sample is tested and each one above threshold is reported;
+ * merging neighbouring events is left to the DedispersionClusterer.
+ */
+void DedispersionAnalyser::_search( const float* trial, int nSamples, unsigned ds,
+                                    int dm, float rms, float threshold,
+                                    std::vector<double>& cumulative,
+                                    std::vector<float>& boxcar,
+                                    std::vector<Event>& events ) const
+{
+    cumulative.resize( nSamples + 1 );
+    boxcar.resize( nSamples );
+    cumulative[0] = 0.0;
+    for( int i = 0; i < nSamples; ++i ) {
+        cumulative[i + 1] = cumulative[i] + trial[i];
+    }
+
+    unsigned lastWidth = 0;
+    foreach( unsigned fullWidth, _widths ) {
+        unsigned width = std::max( 1U, fullWidth / ds );
+        if( width == lastWidth ) continue; // same boxcar at this resolution
+        lastWidth = width;
+        int n = nSamples - (int)width + 1;
+        if( n <= 0 ) break;
+
+        // branch free loops so the compiler can vectorise them
+        const double* lo = &cumulative[0];
+        const double* hi = &cumulative[width];
+        float* sum = &boxcar[0];
+        for( int t = 0; t < n; ++t ) {
+            sum[t] = (float)( hi[t] - lo[t] );
         }
-        int index = i*32;
-        outputBin32 = outputBin16[0] + outputBin16[1];
-        //        if (outputBin32 >= _detectionThreshold * rms * 5.657){
-        if (outputBin32 >= _detectionThreshold * rms * 5.67){
-          //          result->addEvent( dm_count, index );
-          //              std::cout << "32 " << outputBin32 << std::endl;
-          result->addEvent( dm_count, index, 32, outputBin32);
-          
+        float detection = threshold * rms * std::sqrt( (float)( width * ds ) );
+        int hits = 0;
+        for( int t = 0; t < n; ++t ) {
+            hits += ( sum[t] >= detection );
         }
-      }
-      }
-        */
-
-    /*
-    for(int dm_count = 0; dm_count < tdms; ++dm_count) {
-        for(int j=0; j < nsamp; ++j) {
-            total = dataVector[dm_count*nsamp + j];
-            if (total >= _detectionThreshold * rms){
-                result->addEvent( dm_count, j );
-            }
+        if( hits == 0 ) continue;
+
+        for( int t = 0; t < n; ++t ) {
+            if( sum[t] < detection ) continue;
+            Event e = { dm, (unsigned)t * ds, (float)( width * ds ), sum[t] };
+            events.push_back( e );
         }
     }
-    */
-    std::cout << "Found " << result->eventsFound() << " events" << std::endl;
-    return result->eventsFound();
 }
 
-
 } // namespace ampp
 } // namespace pelican
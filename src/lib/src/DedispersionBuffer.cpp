@@ -6,6 +6,7 @@
 #include <algorithm>
 #include "SpectrumDataSet.h"
 #include "WeightedSpectrumDataSet.h"
+#include "CoreBudget.h"
 #include <omp.h>
 
 namespace pelican {
@@ -18,7 +19,8 @@ namespace ampp {
  */
 DedispersionBuffer::DedispersionBuffer( unsigned int size, unsigned int sampleSize,
                                         bool invertChannels )
-   : _sampleSize(sampleSize), _invertChannels(invertChannels)
+   : _bits(32), _scale(1.0), _sampleSize(sampleSize), _invertChannels(invertChannels),
+     _threads( CoreBudget::instance().threads() )
 {
     setSampleCapacity(size);
     clear();
@@ -35,6 +37,20 @@ void DedispersionBuffer::setSampleCapacity(unsigned int maxSamples)
 {
     _nsamp = maxSamples;
     _timedata.resize( maxSamples * _sampleSize );
+    if( _bits != 32 ) _quantised.resize( _timedata.size() * _bits / 8 );
+}
+
+void DedispersionBuffer::setQuantisation( unsigned bits, float scale )
+{
+    if( bits != 8 && bits != 16 && bits != 32 )
+        throw QString("DedispersionBuffer: unsupported quantisation %1 bits").arg(bits);
+    _bits = bits;
+    _scale = scale;
+    if( bits == 32 ) {
+        std::vector<char>().swap( _quantised );
+    } else {
+        _quantised.resize( _timedata.size() * _bits / 8 );
+    }
 }
 
 void DedispersionBuffer::dump( const QString& fileName ) const {
@@ -135,7 +151,7 @@ void DedispersionBuffer::dumpbin( const QString& fileName ) const {
         //        omp_set_num_threads(6);
         int s, c;
         int localSampleCount = _sampleCount - start;    // create a copy for omp to lock
-#pragma omp parallel for private(s,c) schedule(dynamic)
+#pragma omp parallel for private(s,c) schedule(dynamic) num_threads(_threads)
         for(int t = start; t < (int)maxSamples; ++t ) {
             for (s = 0; s < (int)nSubbands; ++s ) {
                 int bsize = s*nChannels*_nsamp + localSampleCount + t;
@@ -150,14 +166,14 @@ void DedispersionBuffer::dumpbin( const QString& fileName ) const {
                   // that obbey the distribution that the RFI clipper
                   // forces
                   data[nChannelsMinusOne - c]  = data[nChannelsMinusOne - c] - (weightData[nChannelsMinusOne - c] - 1) * noiseTemplate[(bsize + (c * _nsamp))]; // change the data
-                  _timedata[(bsize + (c * _nsamp))] = data[nChannelsMinusOne - c];
+                  _set( bsize + (c * _nsamp), data[nChannelsMinusOne - c] );
                 }
             }
         }
     } else {
         int s, c;
         int localSampleCount = _sampleCount - start;    // create a copy for omp to lock
-#pragma omp parallel for private(s,c) schedule(dynamic)
+#pragma omp parallel for private(s,c) schedule(dynamic) num_threads(_threads)
         for(int t = start; t < (int)maxSamples; ++t) {
             int sampleOffset = localSampleCount + t;
             for ( s = 0; s < (int)nSubbands; ++s) {
@@ -167,7 +183,7 @@ void DedispersionBuffer::dumpbin( const QString& fileName ) const {
                 for ( c = 0; c < (int)nChannels; ++c) {
                   //                    _timedata[ bsize + ( c * _nsamp ) ] = data[c];
                   data[c] = data[c] - (weightData[c] - 1) * noiseTemplate[bsize + (c * _nsamp)];
-                  _timedata[ bsize + (c * _nsamp)] = data[c];
+                  _set( bsize + (c * _nsamp), data[c] );
                     }
             }
         }
@@ -205,7 +221,7 @@ void DedispersionBuffer::dumpbin( const QString& fileName ) const {
         //        omp_set_num_threads(6);
         int s, c;
         int localSampleCount = _sampleCount - start;    // create a copy for omp to lock
-#pragma omp parallel for private(s,c) schedule(dynamic)
+#pragma omp parallel for private(s,c) schedule(dynamic) num_threads(_threads)
         for(int t = start; t < (int)(start + maxSamples); ++t ) {
             for (s = 0; s < (int)nSubbands; ++s ) {
                 int bsize = s*nChannels*_nsamp + localSampleCount + t;
@@ -218,21 +234,21 @@ void DedispersionBuffer::dumpbin( const QString& fileName ) const {
                   // clipper to values from a template noise buffer
                   // that obbey the distribution that the RFI clipper
                   // forces
-                  _timedata[(bsize + (c * _nsamp))] = data[nChannelsMinusOne - c];
+                  _set( bsize + (c * _nsamp), data[nChannelsMinusOne - c] );
                 }
             }
         }
     } else {
         int s, c;
         int localSampleCount = _sampleCount - start;    // create a copy for omp to lock
-#pragma omp parallel for private(s,c) schedule(dynamic)
+#pragma omp parallel for private(s,c) schedule(dynamic) num_threads(_threads)
         for(int t = start; t < (int)(start + maxSamples); ++t) {
             int sampleOffset = localSampleCount + t;
             for ( s = 0; s < (int)nSubbands; ++s) {
                 float* data = streamData->spectrumData(t, s, 0);
                 int bsize = s*nChannels * _nsamp + sampleOffset;
                 for ( c = 0; c < (int)nChannels; ++c) {
-                  _timedata[ bsize + (c * _nsamp)] = data[c];
+                  _set( bsize + (c * _nsamp), data[c] );
                     }
             }
         }
@@ -244,6 +260,28 @@ void DedispersionBuffer::dumpbin( const QString& fileName ) const {
     return spaceRemaining();
 }
 
+void DedispersionBuffer::downsample( const std::vector<float>& in, unsigned nSamples,
+                                     unsigned factor, std::vector<float>& out )
+{
+    int nChannels = in.size() / nSamples;
+    unsigned outSamples = nSamples / factor;
+    out.resize( nChannels * outSamples );
+    // no buffer here to carry a thread count, so ask the budget directly
+    unsigned threads = CoreBudget::instance().threads();
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for( int c = 0; c < nChannels; ++c ) {
+        const float* src = &in[ c * nSamples ];
+        float* dest = &out[ c * outSamples ];
+        for( unsigned t = 0; t < outSamples; ++t ) {
+            float sum = 0.0;
+            for( unsigned j = 0; j < factor; ++j ) {
+                sum += src[ t * factor + j ];
+            }
+            dest[t] = sum;
+        }
+    }
+}
+
 void DedispersionBuffer::clear() {
     _sampleCount = 0;
     _inputBlobs.clear();
@@ -0,0 +1,136 @@
+#include "DedispersionClusterer.h"
+#include "DedispersionDataAnalysis.h"
+#include "DedispersionEvent.h"
+#include "CoreBudget.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <omp.h>
+
+
+namespace pelican {
+
+namespace ampp {
+
+namespace {
+// order the event indices by start time
+class EarlierEvent {
+    public:
+        EarlierEvent( const QList<DedispersionEvent>& events ) : _events(events) {}
+        bool operator()( int a, int b ) const {
+            return _events[a].timeBin() < _events[b].timeBin();
+        }
+    private:
+        const QList<DedispersionEvent>& _events;
+};
+} // namespace
+
+
+/**
+ *@details DedispersionClusterer
+ */
+DedispersionClusterer::DedispersionClusterer( const ConfigNode& config )
+    : AbstractModule( config ), _clusterTime("DedispersionClusterer")
+{
+    _dmLink = config.getOption("link", "dm", "2").toInt();
+    _timeLink = config.getOption("link", "time", "4").toUInt();
+    _minMembers = config.getOption("minMembers", "value", "1").toUInt();
+}
+
+/**
+ *@details
+ */
+DedispersionClusterer::~DedispersionClusterer()
+{
+}
+
+int DedispersionClusterer::_find( std::vector<int>& parent, int i ) const
+{
+    while( parent[i] != i ) {
+        parent[i] = parent[ parent[i] ]; // path halving
+        i = parent[i];
+    }
+    return i;
+}
+
+int DedispersionClusterer::cluster( const DedispersionDataAnalysis* input,
+                                    DedispersionDataAnalysis* result )
+{
+    result->reset( input->data() );
+    result->setRMS( input->getRMS() );
+    const QList<DedispersionEvent>& events = input->events();
+    if( events.isEmpty() ) return 0;
+    _clusterTime.tick();
+
+    // the first event only marks the timestamp of the blob
+    result->addEvent( events[0] );
+    int n = events.size() - 1;
+    std::vector<int> order( n );
+    for( int i = 0; i < n; ++i ) order[i] = i + 1;
+    std::stable_sort( order.begin(), order.end(), EarlierEvent( events ) );
+
+    // split into groups that no link can cross
+    std::vector<int> groupStart;
+    unsigned reach = 0;
+    for( int i = 0; i < n; ++i ) {
+        const DedispersionEvent& e = events[ order[i] ];
+        if( i == 0 || e.timeBin() > reach ) groupStart.push_back( i );
+        reach = std::max( reach, e.timeBinHigh() + _timeLink );
+    }
+    groupStart.push_back( n );
+    int nGroups = groupStart.size() - 1;
+
+    // friends-of-friends within each group
+    std::vector<int> parent( n );
+    for( int i = 0; i < n; ++i ) parent[i] = i;
+    #pragma omp parallel for schedule(dynamic) num_threads(CoreBudget::instance().threads())
+    for( int g = 0; g < nGroups; ++g ) {
+        for( int i = groupStart[g]; i < groupStart[g + 1]; ++i ) {
+            const DedispersionEvent& a = events[ order[i] ];
+            unsigned end = a.timeBinHigh() + _timeLink;
+            for( int j = i + 1; j < groupStart[g + 1]; ++j ) {
+                const DedispersionEvent& b = events[ order[j] ];
+                if( b.timeBin() > end ) break;
+                if( std::abs( a.dmIndex() - b.dmIndex() ) > _dmLink ) continue;
+                int ra = _find( parent, i );
+                int rb = _find( parent, j );
+                if( ra != rb ) parent[ std::max(ra, rb) ] = std::min(ra, rb);
+            }
+        }
+    }
+
+    // reduce each cluster to its peak. Roots are the earliest member
+    // so candidates come out in time order
+    float rms = input->getRMS();
+    std::vector<int> peak( n, -1 );
+    std::vector<int> dmLow( n ), dmHigh( n );
+    std::vector<unsigned> tLow( n ), tHigh( n ), members( n, 0 );
+    std::vector<float> bestSNR( n );
+    for( int i = 0; i < n; ++i ) {
+        const DedispersionEvent& e = events[ order[i] ];
+        int r = _find( parent, i );
+        float snr = e.mfValue() / ( rms * std::sqrt( e.mfBinning() ) );
+        if( members[r]++ == 0 ) {
+            peak[r] = i; bestSNR[r] = snr;
+            dmLow[r] = dmHigh[r] = e.dmIndex();
+            tLow[r] = e.timeBinLow(); tHigh[r] = e.timeBinHigh();
+            continue;
+        }
+        if( snr > bestSNR[r] ) { peak[r] = i; bestSNR[r] = snr; }
+        dmLow[r] = std::min( dmLow[r], e.dmIndex() );
+        dmHigh[r] = std::max( dmHigh[r], e.dmIndex() );
+        tLow[r] = std::min( tLow[r], e.timeBinLow() );
+        tHigh[r] = std::max( tHigh[r], e.timeBinHigh() );
+    }
+    for( int r = 0; r < n; ++r ) {
+        if( members[r] == 0 || members[r] < _minMembers ) continue;
+        DedispersionEvent candidate = events[ order[ peak[r] ] ];
+        candidate.setCluster( dmLow[r], dmHigh[r], tLow[r], tHigh[r], members[r] );
+        result->addEvent( candidate );
+    }
+    _clusterTime.tock();
+    return result->eventsFound() - 1;
+}
+
+} // namespace ampp
+} // namespace pelican
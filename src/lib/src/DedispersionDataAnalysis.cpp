@@ -11,7 +11,7 @@ namespace ampp {
  *@details DedispersionDataAnalysis 
  */
 DedispersionDataAnalysis::DedispersionDataAnalysis()
-    : DataBlob("DedispersionDataAnalysis"), _data(0)
+    : DataBlob("DedispersionDataAnalysis"), _data(0), _degradation(0)
 {
 }
 
@@ -24,6 +24,7 @@ DedispersionDataAnalysis::~DedispersionDataAnalysis() {
 void DedispersionDataAnalysis::reset( const DedispersionSpectra* data ) {
     _data = data;
     _eventIndex.clear();
+    _degradation = 0;
 }
 
 int DedispersionDataAnalysis::eventsFound() const {
@@ -38,5 +39,9 @@ const QList<DedispersionEvent>& DedispersionDataAnalysis::events() const {
     _eventIndex.append( DedispersionEvent(dmIndex, timeIndex, _data, mfBinFactor, mfBinValue ) ); //mf=matched filtering
 }
 
+void DedispersionDataAnalysis::addEvent( const DedispersionEvent& event ) {
+    _eventIndex.append( event );
+}
+
 } // namespace ampp
 } // namespace pelican
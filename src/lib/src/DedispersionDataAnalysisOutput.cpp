@@ -5,6 +5,8 @@
 #include "pelican/utility/ConfigNode.h"
 #include "pelican/data/DataBlob.h"
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <time.h>
 namespace pelican {
@@ -16,8 +18,18 @@ namespace ampp {
  *@details DedispersionDataAnalysisOutput 
  */
 DedispersionDataAnalysisOutput::DedispersionDataAnalysisOutput( const ConfigNode& configNode )
-    : AbstractOutputStream(configNode)
+    : AbstractOutputStream(configNode), _indexOfDump(0)
 {
+    QString format = configNode.getOption("format", "value", "text").toLower();
+    if( format != "text" && format != "binary" )
+        throw QString("DedispersionDataAnalysisOutput: unknown format \"%1\"").arg(format);
+    _binary = ( format == "binary" );
+    _beam = configNode.getOption("beam", "id", "0").toUInt();
+    _batchSize = std::max( 1U, configNode.getOption("batch", "records", "4096").toUInt() );
+    _batchInterval = (int)( 1000 * configNode.getOption("batch", "interval", "1.0").toFloat() );
+    _batch.reserve( _batchSize );
+    _lastWrite.start();
+
     QString filepath = configNode.getOption("file", "name");
     char timestr[22];
     time_t     now = time(0);
@@ -25,7 +37,7 @@ DedispersionDataAnalysisOutput::DedispersionDataAnalysisOutput( const ConfigNode
     tstruct = *localtime(&now);
     strftime(timestr, sizeof timestr, "D%Y%m%dT%H%M%S", &tstruct );
     QString filename;
-    filename = filepath + QString("_") + timestr + QString(".dat");
+    filename = filepath + QString("_") + timestr + QString( _binary ? ".cand" : ".dat" );
     if( filename != "" )
     {
         addFile( filename );
@@ -38,7 +50,6 @@ DedispersionDataAnalysisOutput::DedispersionDataAnalysisOutput( const ConfigNode
     else {
         throw( QString("SigprocStokesWriter: unable to set epoch.") );
     }
-    _indexOfDump = 0;
 }
 
 /**
@@ -46,6 +57,7 @@ DedispersionDataAnalysisOutput::DedispersionDataAnalysisOutput( const ConfigNode
  */
 DedispersionDataAnalysisOutput::~DedispersionDataAnalysisOutput()
 {
+    _writeBatch();
     foreach( QTextStream* stream, _streams) {
         stream->flush();
         delete stream;
@@ -61,14 +73,15 @@ void DedispersionDataAnalysisOutput::addFile(const QString& filename)
     if( file->open( QIODevice::WriteOnly ) )
     {
          _devices.append( file );
+         if( _binary ) {
+             CandidateFile::Header header = CandidateFile::header( _beam );
+             file->write( reinterpret_cast<const char*>(&header), sizeof(header) );
+             file->flush();
+             return;
+         }
          QTextStream* out = new QTextStream(file);
          _streams.append(out);
-         *out << "# Generated by DedispersionDataAnalysisOutput\n"
-              << "# Events\n"
-              << "# ------\n"
-              << "# Time|Dm|Amplitude|BinFactor\n"
-              << "# ------\n";
-         out->setRealNumberPrecision( 14 );
+         CandidateFile::writeTextHeader( *out );
          out->flush();
     }
     else {
@@ -80,37 +93,70 @@ void DedispersionDataAnalysisOutput::addFile(const QString& filename)
 void DedispersionDataAnalysisOutput::sendStream(const QString& /*streamName*/, const DataBlob* dataBlob)
 {
   if( dataBlob->type() == "DedispersionDataAnalysis" ) {
-    const DedispersionDataAnalysis* data = static_cast<const DedispersionDataAnalysis*>(dataBlob);
-    float rms = data->getRMS();
-    //QMutexLocker lock(_mutex);
+    _addRecords( static_cast<const DedispersionDataAnalysis*>(dataBlob) );
+    // text is written a buffer at a time, binary in batches
+    if( ! _binary || _batch.size() >= _batchSize || _lastWrite.elapsed() >= _batchInterval ) {
+      _writeBatch();
+    }
+  }
+}
+
+void DedispersionDataAnalysisOutput::_addRecords( const DedispersionDataAnalysis* data )
+{
+  CandidateFile::Record r;
+  std::memset( &r, 0, sizeof(r) );
+  r.buffer = ++_indexOfDump;
+  r.beam = _beam;
+  r.degradation = data->degradation();
+  r.type = CandidateFile::Event;
+  float rms = data->getRMS();
+  float SNRmax = 0.0, DMthis = 0.0;
+  // Avoid writing the first event, which is only used for the timestamp
+  const QList<DedispersionEvent>& events = data->events();
+  for (int i=1; i<events.size(); ++i){
+    const DedispersionEvent& e = events[i];
+    r.mjd = (e.getTime() / 86400) + 40587;
+    r.dm = e.dm();
+    r.snr = e.mfValue() / (rms * std::sqrt((double)e.mfBinning()));
+    r.width = (quint32)e.mfBinning();
+    if (r.snr > SNRmax){
+      DMthis = r.dm;
+      SNRmax = r.snr;
+    }
+    _batch.push_back( r );
+  }
+  r.type = CandidateFile::Buffer;
+  r.mjd = events.isEmpty() ? 0.0 : (events[0].getTime() / 86400) + 40587;
+  r.dm = DMthis;
+  r.snr = SNRmax;
+  r.width = 0;
+  _batch.push_back( r );
+}
+
+void DedispersionDataAnalysisOutput::_writeBatch()
+{
+  _lastWrite.restart();
+  if( _batch.empty() ) return;
+  if( _binary ) {
+    const char* records = reinterpret_cast<const char*>( &_batch[0] );
+    qint64 bytes = _batch.size() * sizeof(CandidateFile::Record);
+    foreach( QIODevice* device, _devices ) {
+      if( device->write( records, bytes ) != bytes ) {
+        std::cerr << "DedispersionDataAnalysisOutput: write failed" << std::endl;
+      }
+      static_cast<QFile*>(device)->flush();
+    }
+  }
+  else {
     foreach( QTextStream* out, _streams ) {
-      float SNRmax, DMthis;
-      SNRmax = 0.0;
-      //        foreach( const DedispersionEvent& e, data->events() ) {
-      // Avoid printing the first event, which is only used for the timestampi
-      for (unsigned i=1; i<data->eventsFound(); ++i){
-        const DedispersionEvent& e = data->events()[i];
-        //std::cout << e.getTime() << ", " << _epoch << std::endl;
-        //double mjdStamp = (e.getTime()-_epoch)/86400 + 55562.0;
-        double mjdStamp = (e.getTime() / 86400) + 40587;
-        //                    float SNR = e.amplitude()/rms;
-        float SNR = e.mfValue()/(rms * sqrt(e.mfBinning()));
-        if (SNR > SNRmax){
-          DMthis = e.dm();
-          SNRmax = SNR;
-        }
-        int bf = (int)e.mfBinning();
-        *out << left << mjdStamp << ",   " << e.dm() << ", " << SNR << ", " << bf << "\n";
+      for( unsigned i = 0; i < _batch.size(); ++i ) {
+        CandidateFile::writeText( *out, _batch[i] );
       }
-      //double mjdBlock = (data->events()[0].getTime()-_epoch)/86400 + 55562.0;
-      double mjdBlock = (data->events()[0].getTime() / 86400) + 40587;
-      ++_indexOfDump;
-      *out << "# Written buffer :" << _indexOfDump << " | MJDstart: " << mjdBlock <<
-        " | Best DM: "<< DMthis << " | Max SNR: " << SNRmax << "  Done\n";
       out->flush();
     }
   }
+  _batch.clear();
 }
-  
+
 } // namespace ampp
 } // namespace pelican
@@ -11,7 +11,9 @@ namespace ampp {
  *@details DedispersionEvent 
  */
   DedispersionEvent::DedispersionEvent( int dmIndex, unsigned timeIndex, const DedispersionSpectra* d, float mfBinFactor, float mfBinValue )
-  : _dm(dmIndex), _time(timeIndex), _data(d), _mfBinFactor(mfBinFactor), _mfBinValue(mfBinValue)
+  : _dm(dmIndex), _time(timeIndex), _data(d), _mfBinFactor(mfBinFactor), _mfBinValue(mfBinValue),
+    _dmLow(dmIndex), _dmHigh(dmIndex), _timeLow(timeIndex),
+    _timeHigh(timeIndex + (unsigned)mfBinFactor), _members(1)
 {
 }
 
@@ -46,6 +48,26 @@ float DedispersionEvent::dm() const
     return  _data->dm( _dm ); 
 }
 
+void DedispersionEvent::setCluster( int dmLow, int dmHigh, unsigned timeLow,
+                                    unsigned timeHigh, unsigned members )
+{
+    _dmLow = dmLow;
+    _dmHigh = dmHigh;
+    _timeLow = timeLow;
+    _timeHigh = timeHigh;
+    _members = members;
+}
+
+float DedispersionEvent::dmLow() const
+{
+    return  _data->dm( _dmLow );
+}
+
+float DedispersionEvent::dmHigh() const
+{
+    return  _data->dm( _dmHigh );
+}
+
 float DedispersionEvent::amplitude() const
 {
     return _data->dmAmplitude( _time, _dm );
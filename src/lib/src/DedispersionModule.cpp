@@ -1,5 +1,6 @@
 #include <QDebug>
 #include <QList>
+#include <QTime>
 #include "DedispersionModule.h"
 #include "DedispersionParameters.h"
 #include <boost/shared_ptr.hpp>
@@ -9,20 +10,37 @@
 #include "WeightedSpectrumDataSet.h"
 #include "GPU_Job.h"
 #include "GPU_Kernel.h"
+#include "GPU_Manager.h"
+#include "CPU_Resource.h"
+#include "Affinity.h"
+#ifdef CUDA_FOUND
 #include "GPU_Param.h"
 #include "GPU_NVidia.h"
-#include "GPU_Manager.h"
+#endif
 #include <fstream>
+#include <cfloat>
+#include <algorithm>
+#include <cmath>
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/math/distributions/chi_squared.hpp>
 #include <boost/random/variate_generator.hpp>
 #include <hiredis/hiredis.h>
 
+#ifdef CUDA_FOUND
+extern "C" float dedispersedPeakFind( const float* plane, int tdms, int nsamp,
+                                      int blockSamples, int maxWidth, int sampleScale,
+                                      float* stats, float* peaks, float* maxSNR );
+extern "C" void cacheDedisperseLoopQuantised( float *outbuff, long outbufSize, const void *buff,
+                                     int bits, float scale, float mstartdm,
+                                     float mdmstep, int tdms, int numSamples,
+                                     const float* dmShift, const int maxshift,
+                                     const int i_nchans );
 extern "C" void cacheDedisperseLoop( float *outbuff, long outbufSize, float *buff, float mstartdm,
                                      float mdmstep, int tdms, const int numSamples,
                                      const float* dmShift, const int i_maxshift,
                                      const int i_nchans );
+#endif // CUDA_FOUND
 
 
 namespace pelican {
@@ -43,10 +61,38 @@ namespace ampp {
  *    <channelBandwidth MHz="-0.03">
  *       The width of each frequency channel.
  *    </channelBandwidth>
+ *    <dedispersionMinimum value="0.0" />
+ *    <dedispersionStepSize value="0.1" />
+ *    <dedispersionSamples value="1984">
+ *       A single pass of dedispersionSamples trials from
+ *       dedispersionMinimum at full time resolution.
+ *    </dedispersionSamples>
+ *    <dedispersionPlan active="true" dmMaximum="1000.0" tolerance="1.25"
+ *                      pulseWidth="40" maxDownsample="16">
+ *       If active, the DM trials are generated from the observation
+ *       parameters instead (see DedispersionPlan), with the DM step and time
+ *       downsampling increasing with DM up to dmMaximum. pulseWidth is in
+ *       microseconds. dedispersionStepSize and dedispersionSamples are
+ *       then ignored.
+ *    </dedispersionPlan>
+ *    <inputPrecision bits="8" scale="16">
+ *       Send the full resolution data to the GPU as 8 or 16 bit integers
+ *       (value * scale, saturating) instead of floats. The input is
+ *       expected to be normalised (zero mean, unit rms) by the RFI clipper.
+ *       Defaults: 32 bits (float), scale 16 for 8 bits, 2048 for 16 bits.
+ *    </inputPrecision>
+ *    <peakDetection active="true" decimation="1024" maxWidth="64" trigger="8.0">
+ *       If active, the per DM mean/rms and the best boxcar (widths up to
+ *       maxWidth samples) in each block of decimation samples are found on
+ *       the device while the dedispersed data is still resident. Only this
+ *       summary is returned, unless a peak reaches trigger S/N in which
+ *       case the full DM-time plane is retrieved as well.
+ *    </peakDetection>
  * </DedispersionModule>
  */
 DedispersionModule::DedispersionModule( const ConfigNode& config )
-    : AsyncronousModule(config)
+    : AsyncronousModule(config), _planeExport(true), _dmLimit(0.0),
+      _inFlight(0), _drainTimer("DedispersionModule drain")
 {
     // Get configuration options
     //unsigned int nChannels = config.getOption("outputChannelsPerSubband", "value", "512").toUInt();
@@ -56,6 +102,28 @@ DedispersionModule::DedispersionModule( const ConfigNode& config )
     _dmStep = config.getOption("dedispersionStepSize", "value", "0.0").toFloat();
     _dmLow = config.getOption("dedispersionMinimum", "value", "0.0").toFloat();
     if( _dmLow < 0.0 ) { _dmLow = 0.0; }
+    _autoPlan = config.getOption("dedispersionPlan", "active", "false").toLower() == "true";
+    _dmHigh = config.getOption("dedispersionPlan", "dmMaximum",
+                  QString::number( _dmLow + _dmStep * (_tdms - 1) ) ).toFloat();
+    _plan.setTolerance( config.getOption("dedispersionPlan", "tolerance", "1.25").toFloat() );
+    _plan.setPulseWidth( config.getOption("dedispersionPlan", "pulseWidth", "40").toFloat() );
+    _plan.setMaxDownsample( config.getOption("dedispersionPlan", "maxDownsample", "16").toUInt() );
+    _plan.setDMMultiple( DIVINDM ); // each pass must fill whole kernel blocks
+    _inputBits = config.getOption("inputPrecision", "bits", "32").toUInt();
+    if( _inputBits != 8 && _inputBits != 16 && _inputBits != 32 )
+        throw(QString("DedispersionModule: inputPrecision must be 8, 16 or 32 bits"));
+    _inputScale = config.getOption("inputPrecision", "scale",
+                                   _inputBits == 8 ? "16" : "2048" ).toFloat();
+    _peakDecimation = 0;
+    if( config.getOption("peakDetection", "active", "false").toLower() == "true" ) {
+        _peakDecimation = config.getOption("peakDetection", "decimation", "1024").toUInt();
+        if( _peakDecimation == 0 ) throw(QString("DedispersionModule: peakDetection decimation must be > 0"));
+    }
+    _peakMaxWidth = config.getOption("peakDetection", "maxWidth", "64").toUInt();
+    _peakTrigger = config.getOption("peakDetection", "trigger", "8.0").toFloat();
+    if( _autoPlan && _dmHigh <= _dmLow ) {
+        throw(QString("DedispersionModule: dedispersionPlan dmMaximum must exceed dedispersionMinimum"));
+    }
     _foff = config.getOption("channelBandwidth", "MHz", "1.0").toDouble();
     _invert = ( _foff >= 0 )?1:0;
 
@@ -77,6 +145,7 @@ DedispersionModule::DedispersionModule( const ConfigNode& config )
     // setup the data buffers and objects required for each job
     for( unsigned int i=0; i < maxBuffers; ++i ) {
         _buffersList.append( new DedispersionBuffer(_numSamplesBuffer, 1, _invert) );
+        _buffersList.last()->setQuantisation( _inputBits, _inputScale );
         GPU_Job tmp;
         _jobs.append( tmp );
         DedispersionSpectra tmp2;
@@ -119,11 +188,35 @@ void DedispersionModule::getLOFreqFromRedis()
     return;
 }
 
-void DedispersionModule::waitForJobCompletion() {
-    while( ! ( _kernels.allAvailable() && _jobBuffer.allAvailable() ) ) {
-        usleep(10);
+bool DedispersionModule::waitForJobCompletion( unsigned long timeout ) {
+    QTime timer;
+    timer.start();
+    _drainTimer.tick();
+    bool drained = true;
+    {
+        // wait for the GPU to return all the launched buffers
+        QMutexLocker lock(&_inFlightMutex);
+        while( _inFlight ) {
+            if( timeout == ULONG_MAX ) {
+                _inFlightDone.wait(&_inFlightMutex);
+                continue;
+            }
+            unsigned long elapsed = (unsigned long)timer.elapsed();
+            if( elapsed >= timeout ) { drained = false; break; }
+            _inFlightDone.wait(&_inFlightMutex, timeout - elapsed);
+        }
+    }
+    // then for the asynchronous tasks to process the results
+    if( drained ) {
+        unsigned long elapsed = (unsigned long)timer.elapsed();
+        if( timeout == ULONG_MAX )
+            drained = AsyncronousModule::waitForJobCompletion();
+        else
+            drained = elapsed < timeout
+                      && AsyncronousModule::waitForJobCompletion( timeout - elapsed );
     }
-    AsyncronousModule::waitForJobCompletion();
+    _drainTimer.tock();
+    return drained;
 }
 
 void DedispersionModule::_cleanBuffers() {
@@ -155,6 +248,11 @@ void DedispersionModule::resize( const SpectrumDataSet<float>* streamData ) {
         // set up the time/freq buffers
         for( unsigned int i=0; i < maxBuffers; ++i ) {
             _buffersList.append( new DedispersionBuffer(maxSamples, sampleSize, _invert) );
+            _buffersList.last()->setQuantisation( _inputBits, _inputScale );
+            // filled by the pipeline thread, so keep them on its node
+            std::vector<float>& data = _buffersList.last()->getData();
+            Affinity::instance().bind( &data[0], data.size() * sizeof(float),
+                                       Affinity::Compute, "DedispersionBuffer" );
         }
         _buffers.reset( &_buffersList );
         _currentBuffer = _buffers.next();
@@ -190,10 +288,26 @@ void DedispersionModule::resize( const SpectrumDataSet<float>* streamData ) {
             (_invert)?_dmshifts.insert(_dmshifts.begin(), 1, val):_dmshifts.push_back(val);
         }
         _tsamp = streamData->getBlockRate();
-        _maxshift = (_invert)? -((_dmLow + _dmStep * (_tdms - 1)) * _dmshifts[0])/_tsamp:((_dmLow + _dmStep * (_tdms - 1)) * _dmshifts[_nChannels - 1])/_tsamp;
+        // set up the DM trials for each pass
+        if( _autoPlan ) {
+            _plan.generate( _fch1, _foff, _nChannels, _tsamp, _dmLow, _dmHigh );
+        }
+        else {
+            _plan.setSingleSegment( _dmLow, _dmStep, _tdms );
+        }
+        _tdms = _plan.numberOfDMs();
+        float maxDM = _plan.dmHigh();
+        _maxshift = (_invert)? -(maxDM * _dmshifts[0])/_tsamp:(maxDM * _dmshifts[_nChannels - 1])/_tsamp;
         // Calculate the remaining number of samples between the full
-        // buffer minus maxshift and what is being dedispersed:
-        _remainingSamples = (_numSamplesBuffer-_maxshift)%(NUMREG*DIVINT);
+        // buffer minus maxshift and what is being dedispersed.
+        // The number dedispersed must fill whole kernel blocks at
+        // every downsampling factor in the plan
+        _remainingSamples = (_numSamplesBuffer-_maxshift)%(NUMREG*DIVINT*_plan.maxDownsample());
+        _plan.report();
+        // peak summary blocks must hold whole samples at every resolution
+        if( _peakDecimation % _plan.maxDownsample() ) {
+            _peakDecimation += _plan.maxDownsample() - (_peakDecimation % _plan.maxDownsample());
+        }
         std::cout << "resize: maxSamples = " << maxSamples << std::endl;
         std::cout << "resize: dmLow = " << _dmLow << std::endl;
         //        std::cout << "resize: mshift = " << _dmLow + _dmStep * (_tdms - 1) * _dmshifts[_nChannels - 1] << std::endl;
@@ -212,12 +326,11 @@ void DedispersionModule::resize( const SpectrumDataSet<float>* streamData ) {
         }
         // reset kernels
         for( unsigned int i=0; i < maxBuffers; ++i ) {
-            DedispersionKernel* kernel = new DedispersionKernel( _dmLow, _dmStep,
-                                _tsamp, _tdms,
-//                                _nChannels, _maxshift, _numSamplesBuffer );
+            DedispersionKernel* kernel = new DedispersionKernel( _plan, _tsamp,
                                 _nChannels, _maxshift + _remainingSamples, _numSamplesBuffer );
             _kernelList.append( kernel ); 
             kernel->setDMShift( _dmshifts );
+            kernel->setPeakDetection( _peakDecimation, _peakMaxWidth, _peakTrigger );
         }
         _kernels.reset( &_kernelList );
     }
@@ -261,26 +374,23 @@ void DedispersionModule::dedisperse( WeightedSpectrumDataSet* weightedData )
       DedispersionBuffer* next = _buffers.next();
       next->clear();
       //timerUpdate(&_bufferTimer);
-      {   // lock mutex scope
-        // lock here to ensure there is just a single hit on the 
-        // lock mutex for each buffer
-        QMutexLocker l( &lockerMutex );
-        lockAllUnprotected( _blobs );
-        //timerStart(&_copyTimer);
-        //        std::cout << "maxshift to be copied" << std::endl;
-	//        lockAllUnprotected( _currentBuffer->copy( next, _noiseTemplate, _maxshift ) );
-        lockAllUnprotected( _currentBuffer->copy( next, _noiseTemplate, _maxshift + _remainingSamples, sampleNumber ) );
-//        lockAllUnprotected( _currentBuffer->copy( next, _noiseTemplate, _maxshift, sampleNumber ) );
-        //        std::cout << "maxshift copied" << std::endl;
-        
-        //timerUpdate( &_copyTimer );
-        // ensure lock is maintianed for the next buffer
-        // if not already marked by the maxshift copy
-        if( sampleNumber != maxSamples && ! next->inputDataBlobs().contains(streamData) )
-          lockUnprotected( streamData );
-      }
+      // lock the blobs in use by the buffer being launched and those
+      // copied to the next. Spectrum blobs carry their own atomic lock
+      // count so this does not touch the lock mutex.
+      lockAll( _blobs );
+      //timerStart(&_copyTimer);
+      lockAll( _currentBuffer->copy( next, _noiseTemplate, _maxshift + _remainingSamples, sampleNumber ) );
+      //timerUpdate( &_copyTimer );
+      // ensure lock is maintianed for the next buffer
+      // if not already marked by the maxshift copy
+      if( sampleNumber != maxSamples && ! next->inputDataBlobs().contains(streamData) )
+        lock( streamData );
       _blobs.clear();
       //timerStart( &_dedisperseTimer );
+      {
+          QMutexLocker lock(&_inFlightMutex);
+          ++_inFlight;
+      }
       QtConcurrent::run( this, &DedispersionModule::dedisperse, _currentBuffer, _dedispersionDataBuffer.next() );
       //timerUpdate( &_dedisperseTimer );
       _currentBuffer = next;
@@ -296,6 +406,8 @@ void DedispersionModule::dedisperse( WeightedSpectrumDataSet* weightedData )
 
 void DedispersionModule::dedisperse( DedispersionBuffer* buffer, DedispersionSpectra* dataOut )
 {
+    // launched on the shared pool threads
+    Affinity::instance().pinCurrentThread( Affinity::Compute, "DedispersionModule" );
     // prepare the output data datablob
   /*
     float lostData = (float)buffer->numZeros()/(float)buffer->elements();
@@ -315,12 +427,15 @@ void DedispersionModule::dedisperse( DedispersionBuffer* buffer, DedispersionSpe
       dataOut << " " << 
       std::endl;
     */
-    dataOut->resize( nsamp, _tdms, _dmLow, _dmStep );
+    dataOut->resize( nsamp, _activePlan() );
+    dataOut->setPeakSummary( _peakDecimation );
+    dataOut->setFullPlane( _peakDecimation == 0 );
     // Set up a job for the GPU processing kernel
     GPU_Job* job = _jobBuffer.next();
     DedispersionKernel* kernelPtr = _kernels.next();
-    kernelPtr->setOutputBuffer( dataOut->data() );
-    kernelPtr->setInputBuffer( buffer->getData(),
+    kernelPtr->setPlaneExport( planeExport() );
+    kernelPtr->setOutputBuffer( dataOut );
+    kernelPtr->setInputBuffer( buffer,
                    boost::bind( &DedispersionModule::gpuDataUploaded, this, buffer ) );
     job->addKernel( kernelPtr );
     job->addCallBack( boost::bind( &DedispersionModule::gpuJobFinished, this, job, kernelPtr, dataOut ) );
@@ -330,6 +445,28 @@ void DedispersionModule::dedisperse( DedispersionBuffer* buffer, DedispersionSpe
     //    std::cout << "dedispersionModule: current jobs = " << gpuManager()->jobsQueued() << std::endl;
 }
 
+DedispersionPlan DedispersionModule::_activePlan() const
+{
+    float limit = dmLimit();
+    if( limit <= 0.0 ) return _plan;
+    // the segments are in order of increasing DM, so the reduced
+    // plan is a prefix of the full one, with the last segment cut
+    // short at the limit. The kernels follow the plan of their output
+    DedispersionPlan plan;
+    foreach( const DedispersionPlan::Segment& seg, _plan.segments() ) {
+        if( ! plan.segments().isEmpty() && seg.dmLow() >= limit ) break;
+        unsigned n = seg.numberOfDMs();
+        if( seg.dmHigh() >= limit && seg.dmStep() > 0.0 ) {
+            n = (unsigned)std::ceil( ( limit - seg.dmLow() ) / seg.dmStep() );
+            if( n % DIVINDM ) n += DIVINDM - ( n % DIVINDM );
+            n = std::min( std::max( n, (unsigned)DIVINDM ), seg.numberOfDMs() );
+        }
+        plan.addSegment( DedispersionPlan::Segment( seg.dmLow(), seg.dmStep(), n, seg.downsample() ) );
+        if( n < seg.numberOfDMs() ) break;
+    }
+    return plan;
+}
+
 void DedispersionModule::gpuJobFinished( GPU_Job* job, DedispersionKernel* kernel, DedispersionSpectra* dataOut ) {
      _kernels.unlock( kernel ); // give up the kernel
      if( job->status() != GPU_Job::Failed ) {
@@ -342,6 +479,9 @@ void DedispersionModule::gpuJobFinished( GPU_Job* job, DedispersionKernel* kerne
          _jobBuffer.unlock(job); // return the job to the pool, ready for the next
          exportCancel( dataOut );
      }
+     // the results are now with the asyncronous chain
+     QMutexLocker lock(&_inFlightMutex);
+     if( --_inFlight == 0 ) _inFlightDone.wakeAll();
 }
 
 void DedispersionModule::gpuDataUploaded( DedispersionBuffer* buffer ) {
@@ -358,48 +498,262 @@ void DedispersionModule::exportComplete( DataBlob* datablob ) {
     _dedispersionDataBuffer.unlock(data);
 }
 
-DedispersionModule::DedispersionKernel::DedispersionKernel( float start, float step, float tsamp, float tdms , unsigned nChans, unsigned maxshift, unsigned nsamples )
-   : _startdm( start ), _dmstep( step ), _tsamp(tsamp), _tdms(tdms), _nChans(nChans),
-     _maxshift(maxshift), _nsamples(nsamples)
+DedispersionModule::DedispersionKernel::DedispersionKernel( const DedispersionPlan& plan, float tsamp, unsigned nChans, unsigned maxshift, unsigned nsamples )
+   : _plan( plan ), _tsamp(tsamp), _nChans(nChans),
+     _maxshift(maxshift), _nsamples(nsamples), _inputBits(32), _inputScale(1.0), _hostInput(0),
+     _decimation(0), _maxWidth(1), _triggerThreshold(0.0), _planeExport(true), _output(0),
+     _maxSNR( 0, sizeof(float) )
 {
+    foreach( const DedispersionPlan::Segment& seg, _plan.segments() ) {
+        if( ! _downsampleFactors.contains( seg.downsample() ) )
+            _downsampleFactors.append( seg.downsample() );
+    }
+    qSort( _downsampleFactors );
+    _downsampled.resize( _downsampleFactors.size() );
+    for( int i = 0; i < _downsampleFactors.size(); ++i ) {
+        if( _downsampleFactors[i] > 1 )
+            _downsampled[i].resize( _nChans * ( _nsamples / _downsampleFactors[i] ) );
+    }
 }
 
 void DedispersionModule::DedispersionKernel::setDMShift( std::vector<float>& buffer ) {
     _dmShift = GPU_MemoryMap(buffer);
 }
 
+void DedispersionModule::DedispersionKernel::setPeakDetection( unsigned decimation,
+                                            unsigned maxWidth, float trigger ) {
+    _decimation = decimation;
+    _maxWidth = maxWidth;
+    _triggerThreshold = trigger;
+}
+
 void DedispersionModule::DedispersionKernel::cleanUp() {
-    _inputBuffer.runCallBacks();
+    foreach( const GPU_MemoryMap& map, _inputBuffers ) {
+        map.runCallBacks();
+    }
 }
 
-//void DedispersionModule::DedispersionKernel::setOutputBuffer( QVector<float>& buffer )
-void DedispersionModule::DedispersionKernel::setOutputBuffer( std::vector<float>& buffer )
+void DedispersionModule::DedispersionKernel::setOutputBuffer( DedispersionSpectra* data )
 {
-    _outputBuffer = GPU_MemoryMap(buffer);
+    // each segment writes into its own block of the output. The data may
+    // hold only the first few segments of the plan (see setDMLimit)
+    _output = data;
+    _outputBuffers.clear();
+    _planeScratch.clear();
+    _statsBuffers.clear();
+    _peakBuffers.clear();
+    int firstDM = 0;
+    foreach( const DedispersionPlan::Segment& seg, data->plan().segments() ) {
+        unsigned long bytes = seg.numberOfDMs() * data->timeSamples( firstDM ) * sizeof(float);
+        _outputBuffers.append( GPU_MemoryMapOutput( data->dmTrial( firstDM ), bytes ) );
+        if( _decimation ) {
+            // no host pointer: the plane stays on the device
+            _planeScratch.append( GPU_MemoryMap( 0, bytes ) );
+            _statsBuffers.append( GPU_MemoryMapOutput( &data->dmStatistics()[ 2 * firstDM ],
+                                  2 * seg.numberOfDMs() * sizeof(float) ) );
+            _peakBuffers.append( GPU_MemoryMapOutput(
+                                  &data->peaks()[ 3 * (size_t)firstDM * data->summaryBlocks() ],
+                                  3 * seg.numberOfDMs() * data->summaryBlocks() * sizeof(float) ) );
+        }
+        firstDM += seg.numberOfDMs();
+    }
 }
 
-//void DedispersionModule::DedispersionKernel::setInputBuffer( QVector<float>& buffer, GPU_MemoryMap::CallBackT callback ) {
-void DedispersionModule::DedispersionKernel::setInputBuffer( std::vector<float>& buffer, GPU_MemoryMap::CallBackT callback ) {
-    _inputBuffer = GPU_MemoryMap(buffer);
-    _inputBuffer.addCallBack( callback );
+void DedispersionModule::DedispersionKernel::setInputBuffer( DedispersionBuffer* inputBuffer, GPU_MemoryMap::CallBackT callback ) {
+    std::vector<float>& buffer = inputBuffer->getData();
+    _hostInput = &buffer;
+    _inputBits = inputBuffer->quantisationBits();
+    _inputScale = inputBuffer->quantisationScale();
+    // generate the downsampled copies on the host, each from the
+    // next highest resolution
+    _inputBuffers.clear();
+    const std::vector<float>* previous = &buffer;
+    unsigned previousFactor = 1;
+    for( int i = 0; i < _downsampleFactors.size(); ++i ) {
+        unsigned factor = _downsampleFactors[i];
+        if( factor == 1 ) {
+            // only the full resolution data is sent reduced precision
+            if( _inputBits == 32 )
+                _inputBuffers.append( GPU_MemoryMap(buffer) );
+            else
+                _inputBuffers.append( GPU_MemoryMap(inputBuffer->getQuantisedData()) );
+            continue;
+        }
+        DedispersionBuffer::downsample( *previous, _nsamples / previousFactor,
+                                        factor / previousFactor, _downsampled[i] );
+        _inputBuffers.append( GPU_MemoryMap(_downsampled[i]) );
+        previous = &_downsampled[i];
+        previousFactor = factor;
+    }
+    if( _downsampleFactors[0] == 1 ) {
+        // the buffer is released once it has been uploaded
+        _inputBuffers[0].addCallBack( callback );
+    }
+    else {
+        // the buffer is no longer required
+        callback();
+    }
 }
 
+#ifdef CUDA_FOUND
 void DedispersionModule::DedispersionKernel::run( GPU_NVidia& gpu ) {
-     //cache_dedisperse_loop( float *outbuff, float *buff, float mstartdm, float mdmstep )
-//std::cout << " maxShift =" << _maxshift << std::endl;
-//std::cout << " nchans =" << _nChans << std::endl;
-//std::cout << " tsamp =" << _tsamp << std::endl;
-//std::cout << " input buffer (" << gpu.devicePtr(_inputBuffer) << " ) size=" << _inputBuffer.size() << std::endl;
-//std::cout << " output buffer (" << gpu.devicePtr(_outputBuffer) << ") size=" << _outputBuffer.size() << std::endl;
-//std::cout << " dmShift size =" << _dmShift.size() << std::endl;
-//std::cout << " nSamples =" << _nsamples << std::endl;
-     cacheDedisperseLoop( (float*)gpu.devicePtr(_outputBuffer) , _outputBuffer.size(),
-                          (float*)gpu.devicePtr(_inputBuffer), (_startdm/_tsamp),
-                          (_dmstep/_tsamp), _tdms, _nsamples,
-                          (const float*)gpu.devicePtr(_dmShift),
-                          _maxshift,
-                          _nChans
-                        );
+     const float* dmShift = (const float*)gpu.devicePtr(_dmShift);
+     // upload each input once, in a fixed order so that the
+     // device configuration can be reused between runs
+     QList<float*> inputs;
+     foreach( const GPU_MemoryMap& map, _inputBuffers ) {
+         inputs.append( (float*)gpu.devicePtr( map ) );
+     }
+     const QList<DedispersionPlan::Segment>& segments = _output->plan().segments();
+     QList<float*> planes;
+     for( int i = 0; i < _outputBuffers.size(); ++i ) {
+         const DedispersionPlan::Segment& seg = segments[i];
+         unsigned ds = seg.downsample();
+         float tsamp = _tsamp * ds;
+         float* plane = (float*)( _decimation ? gpu.devicePtr(_planeScratch[i])
+                                              : gpu.devicePtr(_outputBuffers[i]) );
+         planes.append( plane );
+         if( ds == 1 && _inputBits != 32 ) {
+             cacheDedisperseLoopQuantised( plane, _outputBuffers[i].size(),
+                              inputs[0], _inputBits, _inputScale, (seg.dmLow()/tsamp),
+                              (seg.dmStep()/tsamp), seg.numberOfDMs(), _nsamples,
+                              dmShift,
+                              _maxshift,
+                              _nChans
+                            );
+             continue;
+         }
+         cacheDedisperseLoop( plane, _outputBuffers[i].size(),
+                              inputs[ _downsampleFactors.indexOf(ds) ], (seg.dmLow()/tsamp),
+                              (seg.dmStep()/tsamp), seg.numberOfDMs(), _nsamples / ds,
+                              dmShift,
+                              _maxshift / ds,
+                              _nChans
+                            );
+     }
+     if( ! _decimation ) return;
+
+     // search the dedispersed data while it is still on the device
+     float* maxSNR = (float*)gpu.devicePtr(_maxSNR);
+     float best = -FLT_MAX;
+     for( int i = 0; i < _outputBuffers.size(); ++i ) {
+         unsigned ds = segments[i].downsample();
+         float snr = dedispersedPeakFind( planes[i], segments[i].numberOfDMs(),
+                              ( _nsamples - _maxshift ) / ds, _decimation / ds,
+                              std::max( 1U, _maxWidth / ds ), ds,
+                              (float*)gpu.devicePtr(_statsBuffers[i]),
+                              (float*)gpu.devicePtr(_peakBuffers[i]),
+                              maxSNR );
+         best = std::max( best, snr );
+     }
+     // retrieve the full plane only if something worth keeping was found
+     bool triggered = _planeExport && ( best >= _triggerThreshold );
+     if( triggered ) {
+         for( int i = 0; i < _outputBuffers.size(); ++i ) {
+             cudaMemcpy( _outputBuffers[i].hostPtr(), planes[i],
+                         _outputBuffers[i].size(), cudaMemcpyDeviceToHost );
+         }
+     }
+     _output->setFullPlane( triggered );
+}
+#else
+void DedispersionModule::DedispersionKernel::run( GPU_NVidia& ) {
+     // without CUDA only the host resources are available, and
+     // hasHostImplementation() sends every job to them
+     throw QString("DedispersionKernel: built without CUDA support");
+}
+#endif // CUDA_FOUND
+
+namespace {
+// host version of cache_dedisperse_loop for a single DM trial
+void hostDedisperseTrial( const float* in, float* out, const float* dmShift,
+                          float startdm, float dmstep, int nsamp, int maxshift,
+                          unsigned nChans, int dm )
+{
+    int outSamples = nsamp - maxshift;
+    float* trial = out + (long)dm * outSamples;
+    std::fill( trial, trial + outSamples, 0.0f );
+    float shiftTemp = startdm + dm * dmstep;
+    for( unsigned c = 0; c < nChans; ++c ) {
+        // truncate as __float2int_rz
+        const float* channel = in + (long)c * nsamp + (int)( dmShift[c] * shiftTemp );
+        for( int t = 0; t < outSamples; ++t ) {
+            trial[t] += channel[t];
+        }
+    }
+}
+
+// host version of dm_trial_stats and boxcar_peaks for a single DM trial
+void hostPeakFind( const float* plane, int nsamp, int blockSamples, int maxWidth,
+                   int sampleScale, float* stats, float* peaks, int dm )
+{
+    const float* trial = plane + (long)dm * nsamp;
+    double sum = 0.0, sq = 0.0;
+    for( int t = 0; t < nsamp; ++t ) {
+        sum += trial[t];
+        sq += trial[t] * trial[t];
+    }
+    float mean = sum / nsamp;
+    float rms = std::sqrt( std::max( sq / nsamp - (double)mean * mean, 1e-12 ) );
+    stats[2 * dm] = mean;
+    stats[2 * dm + 1] = rms;
+
+    int nBlocks = ( nsamp + blockSamples - 1 ) / blockSamples;
+    for( int b = 0; b < nBlocks; ++b ) {
+        float best = -FLT_MAX;
+        int bestTime = 0, bestWidth = 1;
+        int end = std::min( ( b + 1 ) * blockSamples, nsamp );
+        for( int t = b * blockSamples; t < end; ++t ) {
+            float boxcar = 0.0f;
+            int w = 0;
+            for( int width = 1; width <= maxWidth && t + width <= nsamp; width *= 2 ) {
+                for( ; w < width; ++w ) boxcar += trial[t + w];
+                float snr = ( boxcar - width * mean ) / ( std::sqrt( (float)width ) * rms );
+                if( snr > best ) {
+                    best = snr;
+                    bestTime = t;
+                    bestWidth = width;
+                }
+            }
+        }
+        float* p = peaks + 3 * ( (long)dm * nBlocks + b );
+        p[0] = best;
+        p[1] = (float)( bestTime * sampleScale );
+        p[2] = (float)( bestWidth * sampleScale );
+    }
+}
+} // namespace
+
+void DedispersionModule::DedispersionKernel::runOnHost( CPU_Resource& cpu ) {
+     // the host always works on the float data and writes straight into
+     // the output blob, so the whole plane is always available
+     const float* dmShift = (const float*)_dmShift.hostPtr();
+     const QList<DedispersionPlan::Segment>& segments = _output->plan().segments();
+     for( int i = 0; i < _outputBuffers.size(); ++i ) {
+         const DedispersionPlan::Segment& seg = segments[i];
+         unsigned ds = seg.downsample();
+         float tsamp = _tsamp * ds;
+         int index = _downsampleFactors.indexOf(ds);
+         const float* in = ( ds == 1 ) ? &(*_hostInput)[0] : &_downsampled[index][0];
+         float* plane = (float*)_outputBuffers[i].hostPtr();
+         int nsamp = _nsamples / ds;
+         int maxshift = _maxshift / ds;
+         cpu.parallelFor( seg.numberOfDMs(), boost::bind( &hostDedisperseTrial, in, plane,
+                          dmShift, seg.dmLow()/tsamp, seg.dmStep()/tsamp, nsamp, maxshift,
+                          _nChans, _1 ) );
+         if( _decimation ) {
+             cpu.parallelFor( seg.numberOfDMs(), boost::bind( &hostPeakFind, plane,
+                              nsamp - maxshift, _decimation / ds,
+                              std::max( 1U, _maxWidth / ds ), ds,
+                              (float*)_statsBuffers[i].hostPtr(),
+                              (float*)_peakBuffers[i].hostPtr(), _1 ) );
+         }
+     }
+     if( _output ) _output->setFullPlane( true );
+     // release the input buffers
+     foreach( const GPU_MemoryMap& map, _inputBuffers ) {
+         map.runCallBacks();
+     }
 }
 
 } // namespace ampp
@@ -0,0 +1,128 @@
+#include "DedispersionPlan.h"
+#include <QString>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+
+namespace pelican {
+
+namespace ampp {
+
+
+/**
+ *@details DedispersionPlan
+ */
+DedispersionPlan::DedispersionPlan()
+    : _tolerance(1.25), _pulseWidth(40.0), _maxDownsample(16), _dmMultiple(1)
+{
+}
+
+/**
+ *@details
+ */
+DedispersionPlan::~DedispersionPlan()
+{
+}
+
+void DedispersionPlan::setSingleSegment( float dmLow, float dmStep, unsigned numberOfDMs )
+{
+    _segments.clear();
+    _segments.append( Segment( dmLow, dmStep, numberOfDMs, 1 ) );
+}
+
+void DedispersionPlan::generate( double fch1, double foff, unsigned nChannels, double tsamp,
+                                 float dmLow, float dmHigh )
+{
+    if( _tolerance <= 1.0 )
+        throw QString("DedispersionPlan: tolerance must be greater than 1 (%1)").arg(_tolerance);
+    if( nChannels == 0 || tsamp <= 0.0 )
+        throw QString("DedispersionPlan: invalid observation parameters");
+
+    double flo = std::min( fch1, fch1 + foff * (nChannels - 1) );
+    double fhi = std::max( fch1, fch1 + foff * (nChannels - 1) );
+    double fctr = 0.001 * 0.5 * ( flo + fhi ); // GHz
+
+    // intra-channel smearing per unit DM (s)
+    double chanSmearPerDM = 8.3e-6 * std::fabs(foff) / ( fctr * fctr * fctr );
+    // delay across the whole band per unit DM (s)
+    double bandDelayPerDM = 4148.741601 * ( 1.0 / (flo * flo) - 1.0 / (fhi * fhi) );
+    double width = _pulseWidth * 1e-6;
+    double tolFactor = std::sqrt( _tolerance * _tolerance - 1.0 );
+
+    _segments.clear();
+    unsigned ds = 1;
+    double dm = dmLow;
+    do {
+        double sampleTime = ds * tsamp;
+        // this resolution is used until the channel smearing
+        // reaches the resolution of the next downsampling factor
+        double dmEnd = dmHigh;
+        if( ds < _maxDownsample && chanSmearPerDM > 0.0 ) {
+            dmEnd = std::min( (double)dmHigh, 2.0 * sampleTime / chanSmearPerDM );
+            if( dmEnd <= dm ) {
+                ds *= 2;
+                continue;
+            }
+        }
+        // choose the step such that the worst case DM error (half a step)
+        // keeps the total smearing within tolerance
+        double chanSmear = chanSmearPerDM * dm;
+        double tEff = std::sqrt( sampleTime * sampleTime + chanSmear * chanSmear + width * width );
+        double step = 2.0 * tEff * tolFactor / bandDelayPerDM;
+        unsigned n = (unsigned)std::ceil( ( dmEnd - dm ) / step );
+        if( n == 0 ) n = 1;
+        if( n % _dmMultiple ) n += _dmMultiple - ( n % _dmMultiple );
+        _segments.append( Segment( dm, step, n, ds ) );
+        dm += n * step;
+        if( ds < _maxDownsample ) ds *= 2;
+    } while( dm < dmHigh );
+}
+
+unsigned DedispersionPlan::numberOfDMs() const
+{
+    unsigned n = 0;
+    foreach( const Segment& s, _segments ) {
+        n += s.numberOfDMs();
+    }
+    return n;
+}
+
+float DedispersionPlan::dmHigh() const
+{
+    if( _segments.isEmpty() ) return 0.0;
+    return _segments.last().dmHigh();
+}
+
+unsigned DedispersionPlan::maxDownsample() const
+{
+    unsigned ds = 1;
+    foreach( const Segment& s, _segments ) {
+        ds = std::max( ds, s.downsample() );
+    }
+    return ds;
+}
+
+double DedispersionPlan::cost( unsigned nSamples ) const
+{
+    double c = 0.0;
+    foreach( const Segment& s, _segments ) {
+        c += (double)s.numberOfDMs() * ( nSamples / s.downsample() );
+    }
+    return c;
+}
+
+void DedispersionPlan::report() const
+{
+    std::cout << "DedispersionPlan: " << _segments.size() << " segments, "
+              << numberOfDMs() << " DM trials" << std::endl;
+    foreach( const Segment& s, _segments ) {
+        std::cout << "    DM " << s.dmLow() << " - " << s.dmHigh()
+                  << " step " << s.dmStep()
+                  << " trials " << s.numberOfDMs()
+                  << " downsample " << s.downsample() << std::endl;
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -1,5 +1,7 @@
 #include "DedispersionSpectra.h"
 #include "SpectrumDataSet.h"
+#include "ChunkCompressor.h"
+#include <fstream>
 
 
 namespace pelican {
@@ -11,7 +13,8 @@ namespace ampp {
  *@details DedispersionSpectra 
  */
 DedispersionSpectra::DedispersionSpectra()
-    : DataBlob("DedispersionSpectra"), _timeBins(0)
+    : DataBlob("DedispersionSpectra"), _timeBins(0), _dedispersionBins(0),
+      _decimation(0), _summaryBlocks(0), _fullPlane(true)
 {
 }
 
@@ -24,11 +27,66 @@ DedispersionSpectra::~DedispersionSpectra()
 
 void DedispersionSpectra::resize( unsigned timebins, unsigned dedispersionBins,
                                   float dedispersionBinStart, float dedispersionBinWidth ) { 
+    DedispersionPlan plan;
+    plan.setSingleSegment( dedispersionBinStart, dedispersionBinWidth, dedispersionBins );
+    resize( timebins, plan );
+}
+
+void DedispersionSpectra::resize( unsigned timebins, const DedispersionPlan& plan ) {
+    _plan = plan;
     _timeBins = timebins;
-    _dmBin.reset( dedispersionBins );
-    _dmBin.setStart( dedispersionBinStart );
-    _dmBin.setBinWidth( dedispersionBinWidth );
-    _data.resize( timebins*dedispersionBins ); 
+    _dedispersionBins = plan.numberOfDMs();
+    const QList<DedispersionPlan::Segment>& segments = plan.segments();
+    _segmentFirstDM.resize( segments.size() );
+    _segmentOffset.resize( segments.size() );
+    unsigned firstDM = 0;
+    size_t offset = 0;
+    for( int i = 0; i < segments.size(); ++i ) {
+        _segmentFirstDM[i] = firstDM;
+        _segmentOffset[i] = offset;
+        firstDM += segments[i].numberOfDMs();
+        offset += (size_t)segments[i].numberOfDMs() * ( timebins / segments[i].downsample() );
+    }
+    _data.resize( offset );
+    setPeakSummary( _decimation );
+}
+
+void DedispersionSpectra::setPeakSummary( unsigned decimation ) {
+    _decimation = decimation;
+    if( decimation == 0 ) {
+        _summaryBlocks = 0;
+        _peaks.clear();
+        _dmStats.clear();
+        return;
+    }
+    _summaryBlocks = ( _timeBins + decimation - 1 ) / decimation;
+    _peaks.resize( 3 * (size_t)_dedispersionBins * _summaryBlocks );
+    _dmStats.resize( 2 * _dedispersionBins );
+}
+
+int DedispersionSpectra::_segment( int dm ) const {
+    int s = _segmentFirstDM.size() - 1;
+    while( s > 0 && (int)_segmentFirstDM[s] > dm ) --s;
+    return s;
+}
+
+const float* DedispersionSpectra::dmTrial( int dm ) const {
+    return const_cast<DedispersionSpectra*>(this)->dmTrial( dm );
+}
+
+float* DedispersionSpectra::dmTrial( int dm ) {
+    Q_ASSERT( dm < dmBins() );
+    int s = _segment( dm );
+    return &_data[ _segmentOffset[s] + (size_t)( dm - _segmentFirstDM[s] ) * 
+                   ( _timeBins / _plan.segments()[s].downsample() ) ];
+}
+
+int DedispersionSpectra::timeSamples( int dm ) const {
+    return _timeBins / downsampling( dm );
+}
+
+unsigned DedispersionSpectra::downsampling( int dm ) const {
+    return _plan.segments()[ _segment( dm ) ].downsample();
 }
 
 float DedispersionSpectra::dmAmplitude( unsigned timeSlice, float dm ) const {
@@ -38,17 +96,25 @@ float DedispersionSpectra::dmAmplitude( unsigned timeSlice, float dm ) const {
 
 float DedispersionSpectra::dmAmplitude( unsigned timeSlice, int dm ) const {
     Q_ASSERT( (int)dm < dmBins() );
-    int index = timeSlice + _timeBins * dm;
-    Q_ASSERT( index < _data.size() );
-    return _data[index];
+    Q_ASSERT( timeSlice < _timeBins );
+    return dmTrial( dm )[ timeSlice / downsampling( dm ) ];
 }
 
 int DedispersionSpectra::dmIndex( float dm ) const {
-    return _dmBin.binIndex(dm);
+    const QList<DedispersionPlan::Segment>& segments = _plan.segments();
+    for( int s = 0; s < segments.size(); ++s ) {
+        const DedispersionPlan::Segment& seg = segments[s];
+        if( s == segments.size() - 1 || dm < seg.dmHigh() + 0.5 * seg.dmStep() ) {
+            return _segmentFirstDM[s] + (int)( 0.5 + ( dm - seg.dmLow() ) / seg.dmStep() );
+        }
+    }
+    return 0;
 }
 
 float DedispersionSpectra::dm( unsigned dm ) const {
-    return _dmBin.binAssignmentNumber( dm );
+    int s = _segment( dm );
+    const DedispersionPlan::Segment& seg = _plan.segments()[s];
+    return seg.dmLow() + seg.dmStep() * ( dm - _segmentFirstDM[s] );
 }
 
 void DedispersionSpectra::setInputDataBlobs( const QList<SpectrumDataSetStokes*>& blobs ) {
@@ -66,5 +132,22 @@ double DedispersionSpectra::getTime( unsigned int sampleNumber ) const {
     return _inputBlobs[0]->getTime( sampleNumber + _firstSampleNumber );
 }
 
+void DedispersionSpectra::dumpbin( const QString& fileName, ChunkCompressor* compressor ) const {
+    std::ofstream file( fileName.toUtf8().data(), std::ios::out | std::ios::trunc | std::ios::binary );
+    if( ! file.is_open() )
+        throw QString("DedispersionSpectra: unable to open %1").arg(fileName);
+    const char* data = reinterpret_cast<const char*>( _data.empty() ? 0 : &_data[0] );
+    size_t size = _data.size() * sizeof(float);
+    if( compressor && compressor->active() ) {
+        compressor->setElementSize( sizeof(float) );
+        compressor->start( file );
+        compressor->write( data, size );
+        compressor->finish();
+    }
+    else {
+        file.write( data, size );
+    }
+}
+
 } // namespace ampp
 } // namespace pelican
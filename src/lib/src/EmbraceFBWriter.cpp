@@ -1,5 +1,6 @@
 #include "SpectrumDataSet.h"
 #include "EmbraceFBWriter.h"
+#include "Quantiser.h"
 #include "time.h"
 #include <string>
 #include <cstring>
@@ -13,7 +14,8 @@ namespace ampp {
 // Constructor
 // TODO: For now we write in 32-bit format...
 EmbraceFBWriter::EmbraceFBWriter(const ConfigNode& configNode )
-  : AbstractOutputStream(configNode), _first(true)
+  : AbstractOutputStream(configNode), _first(true), _rotation(configNode),
+    _compressor1(configNode), _compressor2(configNode), _quantiser(0)
 {
     _nSubbands = configNode.getOption("subbandsPerPacket", "value", "1").toUInt();
     _nTotalSubbands = configNode.getOption("totalComplexSubbands", "value", "1").toUInt();
@@ -22,14 +24,10 @@ EmbraceFBWriter::EmbraceFBWriter(const ConfigNode& configNode )
     _nChannels = configNode.getOption("outputChannelsPerSubband", "value", "128").toUInt();
     _nRawPols = configNode.getOption("nRawPolarisations", "value", "2").toUInt();
     _nBits = configNode.getOption("dataBits", "value", "32").toUInt();
-    _nRange = (int) pow(2.0,(double) _nBits)-1.0;
-    _cropMin = configNode.getOption("scale", "min", "0.0" ).toFloat();
-    bool goodConversion=false;
-    _cropMax = configNode.getOption("scale", "max", "X" ).toFloat(&goodConversion);
-    if( ! goodConversion ) {
-        _cropMax=_nRange;
-    }
-    _scaleDelta = _cropMax - _cropMin;
+    if( _nBits != 32 ) _quantiser = new Quantiser( configNode );
+    // shuffle whole samples; packed samples share bytes
+    _compressor1.setElementSize( ( _nBits >= 8 ) ? _nBits / 8 : 1 );
+    _compressor2.setElementSize( ( _nBits >= 8 ) ? _nBits / 8 : 1 );
 
     // Initliase connection manager thread
     _filepath = configNode.getOption("file", "filepath");
@@ -67,7 +65,8 @@ EmbraceFBWriter::EmbraceFBWriter(const ConfigNode& configNode )
     _nchans   = _nChannels * _nSubbands;
     _buffSize = configNode.getOption("params", "bufferSize", "5120").toUInt();
     _cur = 0;
-    _first = (configNode.hasAttribute("writeHeader") && configNode.getAttribute("writeHeader").toLower() == "true" );
+    _writeHeader = (configNode.hasAttribute("writeHeader") && configNode.getAttribute("writeHeader").toLower() == "true" );
+    _first = _writeHeader;
     _site = configNode.getOption("TelescopeID", "value", "0").toUInt();
     _machine = configNode.getOption("MachineID", "value", "9").toUInt();
 
@@ -98,17 +97,27 @@ EmbraceFBWriter::EmbraceFBWriter(const ConfigNode& configNode )
 
     _buffer.resize(_buffSize);
 
-    char timestr[22];
-    time_t     now = time(0);
-    struct tm  tstruct;
-    tstruct = *localtime(&now);
-    strftime(timestr, sizeof timestr, "D%Y%m%dT%H%M%S", &tstruct );
-    QString fileName;
-    fileName = _filepath + QString("_") + timestr + QString("_X.dat");
-    _file1.open(fileName.toUtf8().data(), std::ios::out | std::ios::binary);
-
-    fileName = _filepath + QString("_") + timestr + QString("_Y.dat");
-    _file2.open(fileName.toUtf8().data(), std::ios::out | std::ios::binary);
+    _openFiles();
+}
+
+void EmbraceFBWriter::_openFiles()
+{
+    QString name = _rotation.nextName(_filepath);
+    QString suffix = _compressor1.active() ? QString(".datz") : QString(".dat");
+    _fileName1 = name + QString("_X") + suffix;
+    _rotation.open(_file1, _fileName1);
+    _fileName2 = name + QString("_Y") + suffix;
+    _rotation.open(_file2, _fileName2);
+}
+
+void EmbraceFBWriter::_nextSegment()
+{
+    _compressor1.finish();
+    _compressor2.finish();
+    _rotation.close(_file1, _fileName1);
+    _rotation.close(_file2, _fileName2);
+    _openFiles();
+    _first = _writeHeader;
 }
 
 void EmbraceFBWriter::writeHeader(SpectrumDataSetStokes* stokes){
@@ -152,8 +161,25 @@ void EmbraceFBWriter::writeHeader(SpectrumDataSetStokes* stokes){
 // Destructor
 EmbraceFBWriter::~EmbraceFBWriter()
 {
-    _file1.close();
-    _file2.close();
+    _compressor1.finish();
+    _compressor2.finish();
+    _rotation.close(_file1, _fileName1);
+    _rotation.close(_file2, _fileName2);
+    delete _quantiser;
+    _compressor1.report("EmbraceFBWriter X");
+    _compressor2.report("EmbraceFBWriter Y");
+}
+
+void EmbraceFBWriter::_writeData(unsigned p, const char* data, size_t size)
+{
+    ChunkCompressor& compressor = ( p == 0 ) ? _compressor1 : _compressor2;
+    if( compressor.active() ) {
+        compressor.write( data, size );
+    }
+    else {
+        std::ofstream& file = ( p == 0 ) ? _file1 : _file2;
+        file.write( data, size );
+    }
 }
 
 // ---------------------------- Header helpers --------------------------
@@ -219,17 +245,28 @@ void EmbraceFBWriter::sendStream(const QString& /*streamName*/, const DataBlob*
 
     if( (stokes = (SpectrumDataSetStokes*) dynamic_cast<SpectrumDataSetStokes*>(blob))){
 
-        if (_first){
-            _first = false;
-            writeHeader(stokes);
-        }
-
         unsigned nSamples = stokes->nTimeBlocks();
         unsigned nSubbands = stokes->nSubbands();
         unsigned nChannels = stokes->nChannels();
         unsigned nPolarisations = stokes->nPolarisations();
         float const * data = stokes->data();
 
+        // segments start on a blob boundary
+        size_t spectrumBytes = ( _nBits == 32 ) ? nSubbands * nChannels * sizeof(float)
+                                                : _quantiser->packedSize( nSubbands * nChannels );
+        if( _rotation.next( stokes->getLofarTimestamp(), nSamples * spectrumBytes ) ) {
+            _nextSegment();
+        }
+        if (_first){
+            _first = false;
+            writeHeader(stokes);
+        }
+        // the headers stay as they are, ahead of the chunks
+        if( _compressor1.active() && ! _compressor1.started() ) {
+            _compressor1.start(_file1);
+            _compressor2.start(_file2);
+        }
+
         switch (_nBits) {
 	case 32: {
 	  for (unsigned t = 0; t < nSamples; ++t) {
@@ -237,7 +274,7 @@ void EmbraceFBWriter::sendStream(const QString& /*streamName*/, const DataBlob*
 	      long index = stokes->index(s, nSubbands, 
 					 0, nPolarisations, t, nChannels );
 	      for(int i = nChannels - 1; i >= 0 ; --i) {
-		_file1.write(reinterpret_cast<const char*>(&data[index + i]), 
+		_writeData(0, reinterpret_cast<const char*>(&data[index + i]), 
 			     sizeof(float));
 	      }
 	    }
@@ -245,16 +282,35 @@ void EmbraceFBWriter::sendStream(const QString& /*streamName*/, const DataBlob*
 	      long index = stokes->index(s, nSubbands, 
 					 1, nPolarisations, t, nChannels );
 	      for(int i = nChannels - 1; i >= 0 ; --i) {
-		_file2.write(reinterpret_cast<const char*>(&data[index + i]), 
+		_writeData(1, reinterpret_cast<const char*>(&data[index + i]), 
 			     sizeof(float));
 	      }
 	    }
 	  }
 	  break;
 	}
-	default:
-	  throw(QString("EmbraceFBWriter: %1 bit datafiles not yet supported"));
+	default: {
+	  // each spectrum in the same order as above, quantised and packed
+	  unsigned nSpectrum = nSubbands * nChannels;
+	  _spectrum.resize( nSpectrum );
+	  _packed.resize( spectrumBytes );
+	  for (unsigned t = 0; t < nSamples; ++t) {
+	    for (unsigned p = 0; p < 2; ++p) {
+	      float* spectrum = &_spectrum[0];
+	      for (int s = nSubbands - 1; s >= 0 ; --s) {
+		long index = stokes->index(s, nSubbands, 
+					 p, nPolarisations, t, nChannels );
+		for(unsigned i = 0; i < nChannels; ++i) {
+		  spectrum[i] = data[index + nChannels - 1 - i];
+		}
+		spectrum += nChannels;
+	      }
+	      _quantiser->pack( &_spectrum[0], nSpectrum, &_packed[0], p * nSpectrum );
+	      _writeData( p, reinterpret_cast<const char*>(&_packed[0]), spectrumBytes );
+	    }
+	  }
 	  break;
+	}
         }
 	_file1.flush();
 	_file2.flush();
@@ -285,12 +341,5 @@ void EmbraceFBWriter::_write(char* data, size_t size)
     _cur=ptr;
 }
 
-void EmbraceFBWriter::_float2int(const float *f, int *i)
-{
-    float ftmp;
-    ftmp = (*f>_cropMax)? (_cropMax) : *f;
-    *i = (ftmp<_cropMin) ? 0 : (int)rint((ftmp-_cropMin)*_nRange/_scaleDelta);
-}
-
 } // namepsace lofar
 } // namepsace pelican
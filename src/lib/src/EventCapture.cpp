@@ -0,0 +1,399 @@
+#include "EventCapture.h"
+#include "SpectrumDataSet.h"
+#include "Quantiser.h"
+#include "Affinity.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <time.h>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+
+namespace pelican {
+
+namespace ampp {
+
+namespace {
+
+// the largest block copied out of the ring under the lock
+const size_t copyBlock = 1048576;
+
+// SIGPROC header helpers
+void writeString( std::ofstream& file, const QString& string )
+{
+    QByteArray text = string.toUtf8();
+    int len = text.size();
+    file.write( reinterpret_cast<const char*>(&len), sizeof(int) );
+    file.write( text.constData(), len );
+}
+
+void writeInt( std::ofstream& file, const QString& name, int value )
+{
+    writeString( file, name );
+    file.write( reinterpret_cast<const char*>(&value), sizeof(int) );
+}
+
+void writeDouble( std::ofstream& file, const QString& name, double value )
+{
+    writeString( file, name );
+    file.write( reinterpret_cast<const char*>(&value), sizeof(double) );
+}
+
+} // namespace
+
+class EventCapture::Worker : public QThread
+{
+    public:
+        Worker( EventCapture* capture ) : _capture(capture) {}
+
+    protected:
+        void run() {
+            Affinity::instance().pinCurrentThread( Affinity::IO, "EventCapture" );
+            _capture->_run();
+        }
+
+    private:
+        EventCapture* _capture;
+};
+
+/**
+ *@details EventCapture
+ */
+EventCapture::EventCapture( const ConfigNode& config )
+    : _fch1(0.0), _foff(0.0), _quantiser(0), _slots(0), _spectrumBytes(0),
+      _nChannels(0), _tsamp(0.0), _count(0), _resets(0), _writing(false), _flushing(0),
+      _stop(false), _thread(0)
+{
+    std::memset( &_stats, 0, sizeof(_stats) );
+    _active = config.getOption("capture", "active", "false").toLower() == "true";
+    _seconds = config.getOption("capture", "seconds", "20").toDouble();
+    _pre = config.getOption("capture", "pre", "0.5").toDouble();
+    _post = config.getOption("capture", "post", "0.5").toDouble();
+    _nBits = config.getOption("capture", "dataBits", "32").toUInt();
+    _maxPending = config.getOption("capture", "maxPending", "8").toInt();
+    _directory = config.getOption("capture", "directory", ".");
+    _telescope = config.getOption("capture", "telescope", "0").toInt();
+    _machine = config.getOption("capture", "machine", "9").toInt();
+    if( ! _active ) return;
+
+    if( _seconds <= 0.0 )
+        throw QString("EventCapture: seconds must be positive (%1)").arg(_seconds);
+    if( _pre < 0.0 || _post < 0.0 )
+        throw QString("EventCapture: pre and post must not be negative");
+    if( _maxPending < 1 )
+        throw QString("EventCapture: maxPending must be at least 1");
+    if( _nBits != 32 ) {
+        // the Quantiser checks the number of bits
+        _quantiser = new Quantiser( _nBits, 0.0, 1.0 );
+        _quantiser->setAdaptive( 3.0, 1024 );
+    }
+    _thread = new Worker( this );
+    _thread->start();
+}
+
+/**
+ *@details
+ */
+EventCapture::~EventCapture()
+{
+    if( _thread ) {
+        {
+            // the writer saves whatever it can of the pending windows
+            QMutexLocker lock(&_mutex);
+            _stop = true;
+            _changed.wakeAll();
+        }
+        _thread->wait();
+        delete _thread;
+        report();
+    }
+    delete _quantiser;
+}
+
+void EventCapture::setBand( double fch1, double foff )
+{
+    QMutexLocker lock(&_mutex);
+    _fch1 = fch1;
+    _foff = foff;
+}
+
+double EventCapture::sweep( float dm ) const
+{
+    if( _nChannels < 2 || _fch1 <= 0.0 ) return 0.0;
+    double f1 = _fch1;
+    double f2 = _fch1 + _foff * ( _nChannels - 1 );
+    if( f2 <= 0.0 ) return 0.0;
+    return 4148.741601 * dm * std::fabs( 1.0 / ( f1 * f1 ) - 1.0 / ( f2 * f2 ) );
+}
+
+double EventCapture::length() const
+{
+    QMutexLocker lock(&_mutex);
+    return _slots * _tsamp;
+}
+
+void EventCapture::_resize( const SpectrumDataSetStokes* stokes )
+{
+    // called with the lock held
+    _nChannels = stokes->nSubbands() * stokes->nChannels();
+    _tsamp = stokes->getBlockRate();
+    _spectrumBytes = _quantiser ? _quantiser->packedSize( _nChannels )
+                                : _nChannels * sizeof(float);
+    _slots = std::max( (size_t)1, (size_t)( _seconds / _tsamp ) );
+    _ring.resize( _slots * _spectrumBytes );
+    _times.resize( _slots );
+    _count = 0;
+    ++_resets;
+    if( _quantiser ) _quantiser->reset();
+    std::cout << "EventCapture: " << _slots * _tsamp << " s of data in "
+              << _ring.size() / 1.0e6 << " MB" << std::endl;
+}
+
+void EventCapture::add( const SpectrumDataSetStokes* stokes )
+{
+    if( ! _active ) return;
+    unsigned nSamples = stokes->nTimeBlocks();
+    unsigned nSubbands = stokes->nSubbands();
+    unsigned nChannels = stokes->nChannels();
+    if( nSubbands * nChannels != _nChannels || stokes->getBlockRate() != _tsamp ) {
+        QMutexLocker lock(&_mutex);
+        _resize( stokes );
+    }
+
+    // stage the spectra in file order without the lock: the subbands
+    // from the top down, each with its channels in descending order
+    float const * data = stokes->data();
+    _spectrum.resize( _nChannels );
+    _staging.resize( nSamples * _spectrumBytes );
+    for( unsigned t = 0; t < nSamples; ++t ) {
+        float* spectrum = &_spectrum[0];
+        for( int s = nSubbands - 1; s >= 0; --s ) {
+            long index = stokes->index( s, nSubbands, 0, stokes->nPolarisations(),
+                                        t, nChannels );
+            const float* in = &data[index + nChannels - 1];
+            for( unsigned i = 0; i < nChannels; ++i ) {
+                spectrum[i] = *(in - i);
+            }
+            spectrum += nChannels;
+        }
+        unsigned char* out = &_staging[t * _spectrumBytes];
+        if( _quantiser ) {
+            _quantiser->pack( &_spectrum[0], _nChannels, out );
+        }
+        else {
+            std::memcpy( out, &_spectrum[0], _spectrumBytes );
+        }
+    }
+
+    QMutexLocker lock(&_mutex);
+    for( unsigned t = 0; t < nSamples; ++t ) {
+        size_t slot = _count % _slots;
+        std::memcpy( &_ring[slot * _spectrumBytes], &_staging[t * _spectrumBytes], _spectrumBytes );
+        _times[slot] = stokes->getTime( t );
+        ++_count;
+    }
+    if( ! _pending.isEmpty() ) _changed.wakeAll();
+}
+
+void EventCapture::trigger( double start, double end, float dm )
+{
+    if( ! _active ) return;
+    QMutexLocker lock(&_mutex);
+    ++_stats.triggers;
+    // the pulse reaches the other channels after the first when
+    // the channels descend in frequency, before it when they ascend
+    double delay = sweep( dm );
+    Window w;
+    w.start = start - _pre - ( _foff > 0.0 ? delay : 0.0 );
+    w.end = end + _post + ( _foff > 0.0 ? 0.0 : delay );
+    w.dm = dm;
+    double span = _slots * _tsamp;
+    if( span > 0.0 && w.end - w.start > span ) w.end = w.start + span;
+
+    for( int i = 0; i < _pending.size(); ++i ) {
+        Window& p = _pending[i];
+        if( w.start <= p.end && w.end >= p.start ) {
+            p.start = std::min( p.start, w.start );
+            p.end = std::max( p.end, w.end );
+            p.dm = std::max( p.dm, w.dm );
+            ++_stats.merged;
+            return;
+        }
+    }
+    if( _pending.size() >= _maxPending ) {
+        ++_stats.dropped;
+        return;
+    }
+    _pending.append( w );
+    _changed.wakeAll();
+}
+
+void EventCapture::flush()
+{
+    if( ! _thread ) return;
+    QMutexLocker lock(&_mutex);
+    ++_flushing;
+    _changed.wakeAll();
+    while( ! _pending.isEmpty() || _writing ) {
+        _idle.wait( &_mutex );
+    }
+    --_flushing;
+}
+
+// called with the lock held
+bool EventCapture::_ready( const Window& w ) const
+{
+    if( _stop || _flushing ) return true;
+    if( _count == 0 ) return false;
+    return _times[( _count - 1 ) % _slots] >= w.end;
+}
+
+// the first spectrum in the ring at or after the given time
+// (_count if there is none). Called with the lock held
+unsigned long long EventCapture::_find( double time ) const
+{
+    unsigned long long low = ( _count > _slots ) ? _count - _slots : 0;
+    unsigned long long high = _count;
+    while( low < high ) {
+        unsigned long long mid = low + ( high - low ) / 2;
+        if( _times[mid % _slots] < time ) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+void EventCapture::_run()
+{
+    QMutexLocker lock(&_mutex);
+    forever {
+        while( ! _stop && ( _pending.isEmpty() || ! _ready( _pending.first() ) ) ) {
+            _changed.wait( &_mutex );
+        }
+        if( _pending.isEmpty() ) break; // stopped
+        Window w = _pending.takeFirst();
+        _writing = true;
+        lock.unlock();
+        _write( w );
+        lock.relock();
+        _writing = false;
+        if( _pending.isEmpty() ) _idle.wakeAll();
+    }
+    _idle.wakeAll();
+}
+
+void EventCapture::_write( const Window& w )
+{
+    QMutexLocker lock(&_mutex);
+    if( _count == 0 ) return;
+    unsigned long long seq = _find( w.start );
+    unsigned long long last = _find( w.end + 0.5 * _tsamp );
+    if( seq >= last ) return;
+    size_t spectrumBytes = _spectrumBytes;
+    unsigned resets = _resets;
+    double tstart = _times[seq % _slots];
+    int nChannels = _nChannels;
+    double tsamp = _tsamp;
+    double fch1 = _fch1, foff = _foff;
+    int fileNumber = _stats.files++;
+    lock.unlock();
+
+    char timestr[22];
+    time_t seconds = (time_t)tstart;
+    struct tm tstruct;
+    gmtime_r( &seconds, &tstruct );
+    strftime( timestr, sizeof timestr, "D%Y%m%dT%H%M%S", &tstruct );
+    QString filename = QString("%1/capture_%2_%3.fil").arg(_directory).arg(timestr)
+                               .arg(fileNumber, 4, 10, QChar('0'));
+    std::ofstream file( filename.toUtf8().data(), std::ios::out | std::ios::binary );
+    if( ! file.is_open() ) {
+        std::cerr << "EventCapture: unable to open " << filename.toStdString() << std::endl;
+        return;
+    }
+    writeString( file, "HEADER_START" );
+    writeInt( file, "machine_id", _machine );
+    writeInt( file, "telescope_id", _telescope );
+    writeInt( file, "data_type", 1 );
+    writeString( file, "source_name" );
+    writeString( file, "capture" );
+    writeDouble( file, "fch1", fch1 );
+    writeDouble( file, "foff", foff );
+    writeInt( file, "nchans", nChannels );
+    writeDouble( file, "tsamp", tsamp );
+    writeInt( file, "nbits", _nBits );
+    writeDouble( file, "tstart", tstart / 86400.0 + 40587.0 );
+    writeDouble( file, "refdm", w.dm );
+    writeInt( file, "nifs", 1 );
+    writeString( file, "HEADER_END" );
+
+    size_t perBlock = std::max( (size_t)1, copyBlock / spectrumBytes );
+    std::vector<char> buffer( perBlock * spectrumBytes );
+    unsigned long long lost = 0;
+    double bytes = 0.0;
+    while( seq < last ) {
+        lock.relock();
+        if( _resets != resets ) {
+            // the ring was resized under us
+            lost += last - seq;
+            lock.unlock();
+            break;
+        }
+        unsigned long long oldest = ( _count > _slots ) ? _count - _slots : 0;
+        if( seq < oldest ) {
+            lost += std::min( oldest, last ) - seq;
+            seq = oldest;
+            if( seq >= last ) {
+                lock.unlock();
+                break;
+            }
+        }
+        size_t n = std::min( (unsigned long long)perBlock, last - seq );
+        size_t slot = seq % _slots;
+        size_t first = std::min( n, _slots - slot ); // up to the end of the ring
+        std::memcpy( &buffer[0], &_ring[slot * spectrumBytes], first * spectrumBytes );
+        if( n > first ) {
+            std::memcpy( &buffer[first * spectrumBytes], &_ring[0], ( n - first ) * spectrumBytes );
+        }
+        lock.unlock();
+        file.write( &buffer[0], n * spectrumBytes );
+        bytes += n * spectrumBytes;
+        seq += n;
+    }
+    file.close();
+
+    lock.relock();
+    _stats.lost += lost;
+    _stats.bytes += bytes;
+    _files.append( filename );
+    if( lost ) {
+        std::cout << "EventCapture: " << lost << " spectra of "
+                  << filename.toStdString() << " were overwritten before they were written"
+                  << std::endl;
+    }
+}
+
+QStringList EventCapture::files() const
+{
+    QMutexLocker lock(&_mutex);
+    return _files;
+}
+
+EventCapture::Statistics EventCapture::statistics() const
+{
+    QMutexLocker lock(&_mutex);
+    return _stats;
+}
+
+void EventCapture::report() const
+{
+    Statistics s = statistics();
+    std::cout << "EventCapture: " << s.triggers << " triggers (" << s.merged << " merged, "
+              << s.dropped << " dropped), " << s.files << " files, "
+              << s.bytes / 1.0e6 << " MB, " << s.lost << " spectra lost" << std::endl;
+}
+
+} // namespace ampp
+} // namespace pelican
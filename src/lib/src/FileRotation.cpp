@@ -0,0 +1,99 @@
+#include "FileRotation.h"
+#include "pelican/utility/ConfigNode.h"
+#include <fcntl.h>   // open, fallocate
+#include <unistd.h>  // close, truncate
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <iostream>
+
+
+namespace pelican {
+
+namespace ampp {
+
+
+/**
+ *@details FileRotation
+ */
+FileRotation::FileRotation( const ConfigNode& config )
+    : _segment(0), _started(false), _startTime(0.0), _bytes(0)
+{
+    _maxBytes = (size_t)( config.getOption("rotate", "size", "0").toDouble() * 1048576.0 );
+    _duration = config.getOption("rotate", "duration", "0").toDouble();
+    _preallocate = _maxBytes > 0 &&
+                   config.getOption("rotate", "preallocate", "true").toLower() == "true";
+}
+
+/**
+ *@details
+ */
+FileRotation::~FileRotation()
+{
+}
+
+bool FileRotation::next( double dataTime, size_t bytes )
+{
+    // a segment always gets at least one blob
+    bool rotate = _started && _bytes > 0 &&
+                  ( ( _maxBytes > 0 && _bytes + bytes > _maxBytes ) ||
+                    ( _duration > 0.0 && dataTime - _startTime >= _duration ) );
+    if( rotate || ! _started ) {
+        _started = true;
+        _startTime = dataTime;
+        _bytes = 0;
+    }
+    _bytes += bytes;
+    return rotate;
+}
+
+QString FileRotation::nextName( const QString& prefix )
+{
+    char timestr[22];
+    time_t     now = time(0);
+    struct tm  tstruct;
+    tstruct = *localtime(&now);
+    strftime(timestr, sizeof timestr, "D%Y%m%dT%H%M%S", &tstruct );
+    QString name = prefix + QString("_") + timestr;
+    if( active() ) {
+        // segments can be started within the same second
+        name += QString("_%1").arg( _segment, 4, 10, QChar('0') );
+    }
+    ++_segment;
+    return name;
+}
+
+void FileRotation::open( std::ofstream& file, const QString& filename )
+{
+    QByteArray name = filename.toUtf8();
+    int fd = ::open( name.data(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 )
+        throw QString("FileRotation: unable to create %1: %2").arg(filename).arg(strerror(errno));
+    if( _preallocate && ::fallocate( fd, 0, 0, _maxBytes ) != 0 ) {
+        std::cout << "FileRotation: unable to preallocate " << name.data() << " ("
+                  << strerror(errno) << "), continuing without preallocation" << std::endl;
+        _preallocate = false;
+    }
+    ::close( fd );
+    // in|out so that the preallocated blocks are not truncated away
+    file.open( name.data(), std::ios::in | std::ios::out | std::ios::binary );
+    if( ! file.is_open() )
+        throw QString("FileRotation: unable to open %1").arg(filename);
+}
+
+void FileRotation::close( std::ofstream& file, const QString& filename )
+{
+    if( ! file.is_open() ) return;
+    file.flush();
+    std::streamoff end = file.tellp();
+    file.close();
+    if( _preallocate && end >= 0 ) {
+        if( ::truncate( filename.toUtf8().data(), end ) != 0 ) {
+            std::cout << "FileRotation: unable to trim " << filename.toStdString()
+                      << ": " << strerror(errno) << std::endl;
+        }
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -1,27 +1,37 @@
 #include "FileWriter.h"
+#include "Affinity.h"
 #include <QtConcurrentRun>
+#include <QString>
 #include <fcntl.h>   // open
-#include <unistd.h>  // read, write, close
-#include <cstdio>    // BUFSIZ
+#include <unistd.h>  // pwrite, close
+#include <cstdlib>   // posix_memalign
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
 #include <iostream>
-#include <QMutexLocker>
 
 
 namespace pelican {
 
 namespace ampp {
 
+// O_DIRECT transfers must be aligned to the logical block size of the
+// device; a page covers all the devices we use
+static const size_t alignment = 4096;
 
 /**
  *@details FileWriter 
  */
-FileWriter::FileWriter()
-     : _fileHandle(0),_pos(0)
+FileWriter::FileWriter( size_t blockSize, int buffers )
+     : _fileHandle(-1), _tailHandle(-1), _pos(0), _offset(0),
+       _direct(false), _isDirect(false)
 {
-    int maxBuffers = 3;
-    _bufSize = 32768;
-    for( int i=0; i < maxBuffers; ++i ) {
-        _buffersList.append( new char[_bufSize] );
+    _bufSize = std::max( alignment, ( blockSize + alignment - 1 ) & ~( alignment - 1 ) );
+    for( int i=0; i < std::max( 2, buffers ); ++i ) {
+        void* b;
+        if( posix_memalign( &b, alignment, _bufSize ) )
+            throw QString("FileWriter: unable to allocate %1 byte buffers").arg(_bufSize);
+        _buffersList.append( (char*)b );
     }
     _buffers.reset( &_buffersList );
     _currentBuffer = _buffers.next();
@@ -32,54 +42,114 @@ FileWriter::FileWriter()
  */
 FileWriter::~FileWriter()
 {
-   if( _fileHandle ) {
-       _flush( _currentBuffer, _pos );
-       ::close(_fileHandle);
-   }
+   close();
    foreach( char* b, _buffersList ) {
-       delete[] b;
+       free( b );
    }
 }
 
 void FileWriter::open( const char* filename ) {
-    _fileHandle = ::open( filename, O_WRONLY | O_CREAT , 0644);
+    close();
+    _offset = 0;
+    _pos = 0;
+    _isDirect = false;
+    if( _direct ) {
+        _fileHandle = ::open( filename, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if( _fileHandle >= 0 ) {
+            _tailHandle = ::open( filename, O_WRONLY );
+            _isDirect = ( _tailHandle >= 0 );
+        }
+        if( ! _isDirect ) {
+            std::cerr << "FileWriter: O_DIRECT unavailable for " << filename
+                      << " (" << strerror(errno) << "), using the page cache" << std::endl;
+            if( _fileHandle >= 0 ) ::close(_fileHandle);
+        }
+    }
+    if( ! _isDirect ) {
+        _fileHandle = ::open( filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if( _fileHandle < 0 )
+        throw QString("FileWriter: unable to open %1: %2").arg(filename).arg(strerror(errno));
 }
 
 void FileWriter::close() {
-   if( _fileHandle ) ::close(_fileHandle);
+   if( _fileHandle < 0 ) return;
+   flush();
+   ::close(_fileHandle);
+   _fileHandle = -1;
+   if( _tailHandle >= 0 ) ::close(_tailHandle);
+   _tailHandle = -1;
 }
 
 void FileWriter::write( const char* buffer, size_t length ) {
-   if( (_bufSize - _pos) < (int)length ) {
-       Q_ASSERT( (int)length < _bufSize );
-       // launch a thread to handle device comms
-       QtConcurrent::run(this, &FileWriter::_swap, _currentBuffer, _pos);
-       _currentBuffer = _buffers.next();
-       _pos = 0;
+   while( length ) {
+       size_t n = std::min( length, _bufSize - _pos );
+       memcpy( &_currentBuffer[_pos], buffer, n );
+       _pos += n; buffer += n; length -= n;
+       if( _pos == _bufSize ) {
+           // launch a thread to handle device comms
+           QtConcurrent::run(this, &FileWriter::_swap, _currentBuffer, _pos, _offset);
+           _offset += _pos;
+           _currentBuffer = _buffers.next();
+           _pos = 0;
+       }
    }
-   memcpy( &_currentBuffer[_pos], buffer, length );
-   _pos += length;
 }
 
-void FileWriter::_swap( char* buffer, size_t size) {
-   _flush(buffer, size);
+void FileWriter::_swap( char* buffer, size_t size, long offset ) {
+   Affinity::instance().pinCurrentThread( Affinity::IO, "FileWriter" );
+   _flush(_fileHandle, buffer, size, offset);
    _buffers.unlock(buffer);
 }
 
 long FileWriter::tellp() {
-   QMutexLocker lock( &_mutex);
-   return lseek(_fileHandle, 0, SEEK_CUR);
+   return _offset + _pos;
 }
 
 void FileWriter::flush() {
-   if( _fileHandle ) _flush( _currentBuffer, _pos );
-   _pos=0;
+   if( _fileHandle < 0 ) return;
+   _wait();
+   if( _isDirect ) {
+       size_t aligned = _pos & ~( alignment - 1 );
+       size_t tail = _pos - aligned;
+       if( aligned ) _flush( _fileHandle, _currentBuffer, aligned, _offset );
+       if( tail ) {
+           _flush( _tailHandle, _currentBuffer + aligned, tail, _offset + aligned );
+           memmove( _currentBuffer, _currentBuffer + aligned, tail );
+       }
+       _offset += aligned;
+       _pos = tail;
+   }
+   else {
+       _flush( _fileHandle, _currentBuffer, _pos, _offset );
+       _offset += _pos;
+       _pos = 0;
+   }
+}
+
+// wait for the blocks in flight by taking each of the other buffers
+void FileWriter::_wait() {
+   QList<char*> held;
+   for( int i=1; i < _buffersList.size(); ++i ) {
+       held.append( _buffers.next() );
+   }
+   foreach( char* b, held ) {
+       _buffers.unlock( b );
+   }
 }
 
-void FileWriter::_flush( char* buffer, size_t size ) {
-   // write buffer
-   QMutexLocker lock( &_mutex);
-   ::write( _fileHandle, buffer, size );
+void FileWriter::_flush( int handle, const char* buffer, size_t size, long offset ) {
+   // each block has its own offset, so the order they complete in
+   // does not matter
+   while( size ) {
+       ssize_t n = ::pwrite( handle, buffer, size, offset );
+       if( n < 0 ) {
+           if( errno == EINTR ) continue;
+           std::cerr << "FileWriter: write failed: " << strerror(errno) << std::endl;
+           return;
+       }
+       buffer += n; size -= n; offset += n;
+   }
 }
 
 } // namespace ampp
@@ -1,5 +1,7 @@
 #include "FilterBankAdapter.h"
 #include "SpectrumDataSet.h"
+#include "ChunkCompressor.h"
+#include <QBuffer>
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -40,7 +42,20 @@ void FilterBankAdapter::deserialise(QIODevice* in)
         if( nSubbands == 0 ) { nSubbands = _nSubbands; }
         unsigned int nSamplesPerTimeBlock = _header.numberChannels();
         if( nSamplesPerTimeBlock == 0 ) { nSamplesPerTimeBlock = _nSamplesPerTimeBlock; }
-        unsigned long nBlocks = (chunkSize() - bytes)/( nSubbands*polarisations*nSamplesPerTimeBlock);
+        // samples may be packed several to a byte (see Quantiser)
+        unsigned long blockBits = (unsigned long)nSubbands*polarisations*nSamplesPerTimeBlock*_header.nbits();
+        if( blockBits == 0 ) throw QString("FilterBankAdapter: incomplete header");
+        unsigned long nBlocks = 8 * (unsigned long)(chunkSize() - bytes)/blockBits;
+
+        // compressed data is adapted from the uncompressed chunk
+        QBuffer raw;
+        if( ! _pending.isEmpty() || ChunkCompressor::isCompressed(in) ) {
+            _pending.append( ChunkCompressor::readChunk(in) );
+            nBlocks = 8 * (unsigned long)_pending.size()/blockBits;
+            raw.setBuffer( &_pending );
+            raw.open( QIODevice::ReadOnly );
+            in = &raw;
+        }
 
         // get the object we need to fill
         SpectrumDataSetStokes* blob = (SpectrumDataSetStokes*) dataBlob();
@@ -56,6 +71,10 @@ void FilterBankAdapter::deserialise(QIODevice* in)
                 }
            }
         }
+        if( raw.isOpen() ) {
+            raw.close();
+            _pending.remove( 0, nBlocks * blockBits / 8 );
+        }
 }
 
 void FilterBankAdapter::_readBlock(QIODevice *in, float* block, unsigned long nread)
@@ -145,7 +164,7 @@ void FilterBankAdapter::_readBlock(QIODevice *in, float* block, unsigned long nr
           break;
 
       default:
-          std::cerr << "read_block - nbits can only be 4, 8, 16 or 32!";
+          std::cerr << "read_block - nbits can only be 1, 2, 4, 8, 16 or 32!";
   }
 
 }
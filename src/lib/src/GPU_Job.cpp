@@ -11,7 +11,7 @@ namespace ampp {
  *@details GPU_Job 
  */
 GPU_Job::GPU_Job()
-    : _processing(false), _waitCondition(0)
+    : _processing(false), _waitCondition(0), _priority(0), _queuedTime(0.0)
 {
     setStatus( GPU_Job::None );
 }
@@ -19,7 +19,7 @@ GPU_Job::GPU_Job()
 // limited copy
 // no status information
 GPU_Job::GPU_Job( const GPU_Job& job )
-    : _processing(false), _waitCondition(0)
+    : _processing(false), _waitCondition(0), _priority(0), _queuedTime(0.0)
 {
      *this=job;
 }
@@ -27,6 +27,8 @@ GPU_Job::GPU_Job( const GPU_Job& job )
 const GPU_Job& GPU_Job::operator=( const GPU_Job& job ) {
     _callbacks = job._callbacks;
     _kernels = job._kernels;
+    _priority = job._priority;
+    _type = job._type;
     setStatus( GPU_Job::None );
     return *this;
 }
@@ -1,15 +1,81 @@
 #include "GPU_Manager.h"
 #include <QMutexLocker>
-#include <QtConcurrentRun>
+#include <QThread>
+#include <QWaitCondition>
 #include <boost/bind.hpp>
 #include "GPU_Resource.h"
 #include "GPU_Job.h"
-#include "GPU_NVidia.h"
+#include "Affinity.h"
 #include <iostream>
+#include <cmath>
+#include <ctime>
 
 namespace pelican {
 namespace ampp {
 
+namespace {
+double monotonicTime() {
+    struct timespec tp;
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    return tp.tv_sec + tp.tv_nsec * 1.0e-9;
+}
+} // namespace
+
+/**
+ * @details
+ * A long lived thread to run the jobs assigned to a single resource
+ */
+class GPU_Manager::Dispatcher : public QThread
+{
+    public:
+        Dispatcher( GPU_Manager* manager, GPU_Resource* resource )
+            : job(0), resource(resource), _manager(manager) {}
+        GPU_Job* job; // the job assigned, protected by the managers mutex
+        GPU_Resource* resource;
+        QWaitCondition wake;
+
+    protected:
+        void run() {
+            Affinity::instance().pinCurrentThread( Affinity::Compute, "GPU_Manager" );
+            _manager->_dispatch( this );
+        }
+
+    private:
+        GPU_Manager* _manager;
+};
+
+GPU_Manager::TimeHistogram::TimeHistogram()
+    : _count(0), _sum(0.0), _max(0.0)
+{
+    for( int i = 0; i < Bins; ++i ) _bins[i] = 0;
+}
+
+void GPU_Manager::TimeHistogram::add( double seconds )
+{
+    double us = seconds * 1.0e6;
+    int i = 0;
+    if( us >= 1.0 ) {
+        int exponent;
+        std::frexp( us, &exponent ); // us = m * 2^exponent, 0.5 <= m < 1
+        i = exponent - 1;
+    }
+    if( i >= Bins ) i = Bins - 1;
+    ++_bins[i];
+    ++_count;
+    _sum += seconds;
+    if( seconds > _max ) _max = seconds;
+}
+
+double GPU_Manager::TimeHistogram::percentile( double f ) const
+{
+    unsigned long n = 0;
+    for( int i = 0; i < Bins; ++i ) {
+        n += _bins[i];
+        if( n >= f * _count ) return std::ldexp( 1.0, i + 1 ) * 1.0e-6;
+    }
+    return _max;
+}
+
 /**
  *@details GPU_Manager 
  */
@@ -23,39 +89,92 @@ GPU_Manager::GPU_Manager()
  */
 GPU_Manager::~GPU_Manager()
 {
-    _destructor = true;
-    QMutexLocker lock(&_resourceMutex);
+    {
+        QMutexLocker lock(&_resourceMutex);
+        _destructor = true;
+        _queue.clear();
+        foreach( Dispatcher* d, _dispatchers ) {
+            d->wake.wakeAll();
+        }
+    }
+    // allow any running jobs to finish
+    foreach( Dispatcher* d, _dispatchers ) {
+        d->wait();
+        delete d;
+    }
     // clean up the resources
     foreach(GPU_Resource* r, _resources) {
         delete r;
     }
     _resources.clear();
-    _freeResource.clear();
-    _queue.clear();
+    _dispatchers.clear();
+    _idle.clear();
+    if( ! _statistics.isEmpty() ) reportStatistics();
 }
 
 void GPU_Manager::addResource(GPU_Resource* r) {
     QMutexLocker lock(&_resourceMutex);
     _resources.append(r);
-    _freeResource.append(r);
+    Dispatcher* d = new Dispatcher( this, r );
+    _dispatchers.append(d);
+    _idle.append(d);
+    d->start();
     _matchResources();
 }
 
 int GPU_Manager::resources() const {
+    QMutexLocker lock(&_resourceMutex);
     return _resources.size();
 }
 
+GPU_Job* GPU_Manager::_takeJob( GPU_Resource* r ) {
+    // highest priority first
+    QMap<int, QList<GPU_Job*> >::iterator it = _queue.end();
+    while( it != _queue.begin() ) {
+        --it;
+        QList<GPU_Job*>& jobs = it.value();
+        for( int j = 0; j < jobs.size(); ++j ) {
+            if( r->canRun( jobs[j] ) ) {
+                GPU_Job* job = jobs.takeAt(j);
+                if( jobs.isEmpty() ) _queue.erase(it);
+                return job;
+            }
+        }
+    }
+    return 0;
+}
+
 void GPU_Manager::_matchResources() {
      // ensure _resourceMutex is locked before calling this 
      // function
-     if( _queue.size() > 0 ) {
-        if( _freeResource.size() > 0 ) {
-            QtConcurrent::run( this, &GPU_Manager::_runJob, _freeResource.takeFirst(), _queue.takeFirst() );
-        }
+     for( int i = 0; i < _idle.size() && ! _queue.isEmpty(); ) {
+        Dispatcher* d = _idle[i];
+        GPU_Job* job = _takeJob( d->resource );
+        if( ! job ) { ++i; continue; }
+        _idle.removeAt(i);
+        d->job = job;
+        d->wake.wakeOne();
      }
 }
 
+void GPU_Manager::_dispatch( Dispatcher* d ) {
+    QMutexLocker lock(&_resourceMutex);
+    forever {
+        while( ! d->job && ! _destructor ) d->wake.wait(&_resourceMutex);
+        if( ! d->job ) break;
+        GPU_Job* job = d->job;
+        lock.unlock();
+        _runJob( d->resource, job );
+        lock.relock();
+        d->job = 0;
+        if( _destructor ) break;
+        _idle.append(d);
+        _matchResources();
+    }
+}
+
 void GPU_Manager::_runJob( GPU_Resource* r, GPU_Job* job ) {
+    double start = monotonicTime();
     job->setStatus( GPU_Job::Running );
     try {
         r->exec(job);
@@ -77,38 +196,65 @@ void GPU_Manager::_runJob( GPU_Resource* r, GPU_Job* job ) {
         job->setError( "GPU_Manager: caught unknown error whilst running a job" );
         job->setStatus( GPU_Job::Failed );
     }
+    double end = monotonicTime();
+    {
+        QMutexLocker lock(&_statsMutex);
+        JobStatistics& stats = _statistics[ job->type() ];
+        stats.queueWait.add( start - job->queuedTime() );
+        stats.execution.add( end - start );
+    }
+    // copy the callbacks as the job may be reused from within them
+    QList<boost::function0<void> > callbacks = job->callBacks();
     job->emitFinished();
-    _resourceFree( r );
     // execute any job callbacks
-    foreach( const boost::function0<void>& fn, job->callBacks() ) {
+    foreach( const boost::function0<void>& fn, callbacks ) {
         fn();
     }
 }
 
 int GPU_Manager::freeResources() const {
     QMutexLocker lock(&_resourceMutex);
-    return _freeResource.size();
+    return _idle.size();
 }
 
 int GPU_Manager::jobsQueued() const {
     QMutexLocker lock(&_resourceMutex);
-    return _queue.size();
+    int n = 0;
+    foreach( const QList<GPU_Job*>& jobs, _queue ) {
+        n += jobs.size();
+    }
+    return n;
 }
 
 GPU_Job* GPU_Manager::submit( GPU_Job* job) {
     job->setStatus( GPU_Job::Queued );
     job->setAsRunning(); // mark job as being dealt with
+    job->setQueuedTime( monotonicTime() );
     QMutexLocker lock(&_resourceMutex);
-    _queue.append(job);
+    _queue[ job->priority() ].append(job);
     _matchResources();
     return job;
 } 
 
-void GPU_Manager::_resourceFree( GPU_Resource* res) {
-    if( ! _destructor ) {
-        QMutexLocker lock(&_resourceMutex);
-        _freeResource.append(res);
-        _matchResources();
+QMap<QString, GPU_Manager::JobStatistics> GPU_Manager::statistics() const {
+    QMutexLocker lock(&_statsMutex);
+    return _statistics;
+}
+
+void GPU_Manager::reportStatistics() const {
+    QMap<QString, JobStatistics> stats = statistics();
+    QMapIterator<QString, JobStatistics> it( stats );
+    while( it.hasNext() ) {
+        it.next();
+        const JobStatistics& s = it.value();
+        std::cout << "GPU_Manager: jobs \"" << it.key().toStdString() << "\" : "
+                  << s.execution.count() << " run\n"
+                  << "    queue wait (s): mean " << s.queueWait.mean()
+                  << " 99% < " << s.queueWait.percentile(0.99)
+                  << " max " << s.queueWait.max() << "\n"
+                  << "    execution (s) : mean " << s.execution.mean()
+                  << " 99% < " << s.execution.percentile(0.99)
+                  << " max " << s.execution.max() << std::endl;
     }
 }
 
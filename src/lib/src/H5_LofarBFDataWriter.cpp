@@ -21,8 +21,8 @@ namespace ampp {
 // Constructor
 // TODO: For now we write in 32-bit format...
 H5_LofarBFDataWriter::H5_LofarBFDataWriter(const ConfigNode& configNode )
-  : AbstractOutputStream(configNode), _beamNr(0), _sapNr(0),
-        _nChannels(0), _nSubbands(0), _nPols(0)
+  : AbstractOutputStream(configNode), _directIO(false), _blockSize(32768), _nBuffers(3),
+        _beamNr(0), _sapNr(0), _nChannels(0), _nSubbands(0), _nPols(0)
 {
     _filePath = configNode.getOption("file", "filepath", ".");
     _label = _clean( configNode.getOption("file", "label", "") );
@@ -132,12 +132,12 @@ void H5_LofarBFDataWriter::_setPolsToWrite( unsigned n ) {
     _file.resize(n);
     if( _separateFiles ) {
         for(int i=0; i<_file.size(); ++i ) {
-           _file[i] = new fileType;
+           _file[i] = _newFile();
         }
     }
     else {
         // redirect all ofstreams to the same file
-        _file[0] = new fileType;
+        _file[0] = _newFile();
         for(int i=1; i<_file.size(); ++i ) {
             _file[i] = _file[0];
         }
@@ -148,6 +148,18 @@ void H5_LofarBFDataWriter::_setPolsToWrite( unsigned n ) {
     _count = 0;
 }
 
+void H5_LofarBFDataWriter::_setFileOptions( bool direct, size_t blockSize, int buffers ) {
+    _directIO = direct;
+    _blockSize = blockSize;
+    _nBuffers = buffers;
+}
+
+H5_LofarBFDataWriter::fileType* H5_LofarBFDataWriter::_newFile() const {
+    fileType* file = new fileType( _blockSize, _nBuffers );
+    file->setDirect( _directIO );
+    return file;
+}
+
 void H5_LofarBFDataWriter::_writeHeader(SpectrumDataSetBase* stokes){
     time_t _timeStampLabel = stokes->getLofarTimestamp();
     double _timeStamp = stokes->getLofarTimestamp();
@@ -1,5 +1,6 @@
 #include "H5_LofarBFStokesWriter.h"
 #include "SpectrumDataSet.h"
+#include "Quantiser.h"
 
 
 namespace pelican {
@@ -11,7 +12,7 @@ namespace ampp {
  *@details H5_LofarBFStokesWriter 
  */
 H5_LofarBFStokesWriter::H5_LofarBFStokesWriter( const ConfigNode& config )
-    : H5_LofarBFDataWriter( config )
+    : H5_LofarBFDataWriter( config ), _quantiser(0)
 {
     _complexVoltages=false;
     if( _separateFiles ) {
@@ -22,6 +23,8 @@ H5_LofarBFStokesWriter::H5_LofarBFStokesWriter( const ConfigNode& config )
 
     // Number of polarisations components to write out, 1 - 4
     _setPolsToWrite(config.getOption("params", "nPolsToWrite", "1").toUInt());
+
+    if( _nBits != 32 ) _quantiser = new Quantiser( config );
 }
 
 /**
@@ -29,6 +32,7 @@ H5_LofarBFStokesWriter::H5_LofarBFStokesWriter( const ConfigNode& config )
  */
 H5_LofarBFStokesWriter::~H5_LofarBFStokesWriter()
 {
+    delete _quantiser;
 }
 
 void H5_LofarBFStokesWriter::_writeData( const SpectrumDataSetBase* d )
@@ -58,25 +62,29 @@ void H5_LofarBFStokesWriter::_writeData( const SpectrumDataSetBase* d )
              }
                  }
                  break;
-        case 8: {
+        default: {
+                // channels in the same order as above, quantised and packed
+                unsigned nSpectrum = nSubbands * nChannels;
+                size_t spectrumBytes = _quantiser->packedSize( nSpectrum );
+                _spectrum.resize( nSpectrum );
+                _packed.resize( spectrumBytes );
                 for (unsigned t = 0; t < nSamples; ++t) {
                     for (unsigned p = 0; p < polsToWrite(); ++p) {
+                        float* spectrum = &_spectrum[0];
                         for (int s = nSubbands - 1; s >= 0 ; --s) {
                             long index = stokes->index(s, nSubbands, 
                                     p, nPolarisations, t, nChannels );
-                            for(int i = nChannels - 1; i >= 0 ; --i) {
-                                int ci;
-                                _float2int(&data[index + i],&ci);
-                                _file[p]->write((const char*)&ci,sizeof(unsigned char));
+                            for(unsigned i = 0; i < nChannels; ++i) {
+                                spectrum[i] = data[index + nChannels - 1 - i];
                             }
+                            spectrum += nChannels;
                         }
+                        _quantiser->pack( &_spectrum[0], nSpectrum, &_packed[0], p * nSpectrum );
+                        _file[p]->write( reinterpret_cast<const char*>(&_packed[0]), spectrumBytes );
                     }
                 }
             }
             break;
-        default:
-            throw(QString("H5_LofarStokesWriter: %1 bit datafiles not yet supported"));
-            break;
     }
 }
 
@@ -6,6 +6,19 @@ namespace pelican {
 
 namespace ampp {
 
+namespace {
+
+// split interleaved complex values into their real and imaginary parts
+void deinterleave( const float* __restrict__ in, float* __restrict__ re,
+                   float* __restrict__ im, unsigned n )
+{
+    for( unsigned i = 0; i < n; ++i ) {
+        re[i] = in[2 * i];
+        im[i] = in[2 * i + 1];
+    }
+}
+
+} // namespace
 
 /**
  *@details H5_LofarBFVoltageWriter 
@@ -23,6 +36,10 @@ H5_LofarBFVoltageWriter::H5_LofarBFVoltageWriter( const ConfigNode& config )
     */
     _stokesType = STOKES_XXYY; // always the case for complex volts (Chris, we need to talk about this)
     
+    // voltages are our biggest output, so bypass the page cache by default
+    _setFileOptions( config.getOption("directIO", "enabled", "true").toLower() == "true",
+                     config.getOption("directIO", "blockSize", "4194304").toUInt(),
+                     config.getOption("directIO", "buffers", "4").toInt() );
     _setPolsToWrite(4); // only support writing all 4 pols
                         // as _writeData() assumes this to work
 }
@@ -50,24 +67,26 @@ void H5_LofarBFVoltageWriter::_writeData(const SpectrumDataSetBase* d ) {
 
     switch (_nBits) {
         case 32: {
-             for (unsigned t = 0; t < nSamples; ++t) {
-                 for (unsigned p = 0; p < nPolarisations; ++p ) {
-                     int pindex=p*2;
-                     for (int s = 0; s < nSubbands; ++s) {
+             // each file gets the whole blob in one write
+             size_t nValues = (size_t)nSamples * nSubbands * nChannels;
+             _real.resize( nValues );
+             _imag.resize( nValues );
+             for (unsigned p = 0; p < nPolarisations; ++p ) {
+                 int pindex=p*2;
+                 float* re = &_real[0];
+                 float* im = &_imag[0];
+                 for (unsigned t = 0; t < nSamples; ++t) {
+                     for (unsigned s = 0; s < nSubbands; ++s) {
                          long index = spec->index(s, nSubbands, 
-                                                  p, nPolarisations, t, nChannels );// * 2;
+                                                  p, nPolarisations, t, nChannels );
                          dataPol = &data[index];
-                         for(int i = 0; i < nChannels ; ++i) {
-                           /*
-                             _file[pindex]->write(reinterpret_cast<const char*>(&data[index + i]), sizeof(float));
-                             _file[pindex+1]->write(reinterpret_cast<const char*>(&data[index + i + 1]), sizeof(float));
-                           */                             
-
-                           _file[pindex]->write(reinterpret_cast<const char*>(&dataPol[i].real()), sizeof(float));
-                           _file[pindex+1]->write(reinterpret_cast<const char*>(&dataPol[i].imag()), sizeof(float));
-                         }
+                         deinterleave( reinterpret_cast<const float*>(dataPol), re, im, nChannels );
+                         re += nChannels;
+                         im += nChannels;
                      }
                  }
+                 _file[pindex]->write(reinterpret_cast<const char*>(&_real[0]), nValues * sizeof(float));
+                 _file[pindex+1]->write(reinterpret_cast<const char*>(&_imag[0]), nValues * sizeof(float));
              }
                  }
                  break;
@@ -2,6 +2,7 @@
 
 #include "LofarUdpHeader.h"
 #include "LofarTypes.h"
+#include "Affinity.h"
 
 #include <QtNetwork/QUdpSocket>
 
@@ -131,6 +132,10 @@ LofarDataSplittingChunker::LofarDataSplittingChunker(const ConfigNode& config)
     memset((void*)_emptyPacket2.data, 0, _bytesStream2);
     _emptyPacket2.header.nrBeamlets = _stream2Subbands;
     _emptyPacket2.header.nrBlocks = _nSamples;
+
+    // the receiving thread is placed when it first calls next()
+    Affinity::instance().configure(config);
+    _placed = false;
 }
 
 
@@ -171,10 +176,21 @@ void LofarDataSplittingChunker::next(QIODevice* device)
     UDPPacket _emptyPacket1;
     UDPPacket _emptyPacket2;
 
+    if (!_placed) {
+        Affinity::instance().pinCurrentThread(Affinity::Capture,
+                "LofarDataSplittingChunker");
+        _placed = true;
+    }
+
     WritableData writableData1 = getDataStorage(_nPackets * _packetSizeStream1,
             chunkTypes().at(0));
     WritableData writableData2 = getDataStorage(_nPackets * _packetSizeStream2,
             chunkTypes().at(1));
+    // keep the chunk buffers on the node of the capture thread
+    Affinity::instance().bind(writableData1.ptr(), _nPackets * _packetSizeStream1,
+            Affinity::Capture, "LofarDataSplittingChunker chunk");
+    Affinity::instance().bind(writableData2.ptr(), _nPackets * _packetSizeStream2,
+            Affinity::Capture, "LofarDataSplittingChunker chunk");
 
     unsigned seqid, blockid;
     unsigned totBlocks, lostPackets, diff;
@@ -0,0 +1,137 @@
+#include "OverloadMonitor.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QMutexLocker>
+#include <time.h>
+#include <algorithm>
+#include <iostream>
+
+
+namespace pelican {
+
+namespace ampp {
+
+
+/**
+ *@details OverloadMonitor
+ */
+OverloadMonitor::OverloadMonitor( const ConfigNode& config )
+    : _started(false), _minOffset(0.0), _lag(0.0), _level(0)
+{
+    _active = config.getOption("overload", "active", "false").toLower() == "true";
+    foreach( const QString& t, config.getOption("overload", "lag", "1,2,4")
+                                     .split(",", QString::SkipEmptyParts) ) {
+        _thresholds.append( t.trimmed().toDouble() );
+    }
+    qSort( _thresholds );
+    _recover = config.getOption("overload", "recover", "0.5").toDouble();
+    foreach( const QString& a, config.getOption("overload", "actions", "export,threshold,dmrange")
+                                     .split(",", QString::SkipEmptyParts) ) {
+        _actions.append( a.trimmed().toLower() );
+    }
+    if( _recover <= 0.0 || _recover > 1.0 )
+        throw QString("OverloadMonitor: recover must be in (0,1]");
+    if( _thresholds.size() > _actions.size() )
+        throw QString("OverloadMonitor: %1 lag thresholds but only %2 actions")
+                      .arg(_thresholds.size()).arg(_actions.size());
+    _current.start = _current.end = 0.0;
+    _current.level = 0;
+}
+
+/**
+ *@details
+ */
+OverloadMonitor::~OverloadMonitor()
+{
+}
+
+double OverloadMonitor::_wallTime()
+{
+    struct timespec tp;
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    return tp.tv_sec + tp.tv_nsec * 1.0e-9;
+}
+
+int OverloadMonitor::update( double dataTime )
+{
+    QMutexLocker lock(&_mutex);
+    if( ! _active ) return 0;
+    double offset = _wallTime() - dataTime;
+    if( ! _started || offset < _minOffset ) {
+        _minOffset = offset;
+        _started = true;
+    }
+    _lag = offset - _minOffset;
+
+    int level = _level;
+    while( level < _thresholds.size() && _lag > _thresholds[level] ) {
+        ++level;
+    }
+    while( level > 0 && _lag < _recover * _thresholds[level - 1] ) {
+        --level;
+    }
+
+    if( level && ! _level ) {
+        // start of a degraded interval
+        _current.start = dataTime;
+        _current.level = level;
+        std::cout << "OverloadMonitor: " << _lag << " s behind, shedding load (level "
+                  << level << ")" << std::endl;
+    }
+    if( level ) {
+        _current.end = dataTime;
+        _current.level = std::max( _current.level, level );
+    }
+    else if( _level ) {
+        _current.end = dataTime;
+        _intervals.append( _current );
+        std::ios::fmtflags flags = std::cout.flags();
+        std::cout << "OverloadMonitor: recovered, degraded from " << std::fixed
+                  << _current.start << " to " << _current.end << " (max level "
+                  << _current.level << ")" << std::endl;
+        std::cout.flags( flags );
+    }
+    _level = level;
+    return _level;
+}
+
+int OverloadMonitor::level() const
+{
+    QMutexLocker lock(&_mutex);
+    return _level;
+}
+
+double OverloadMonitor::lag() const
+{
+    QMutexLocker lock(&_mutex);
+    return _lag;
+}
+
+bool OverloadMonitor::shedding( const QString& action, int level ) const
+{
+    int index = _actions.indexOf( action );
+    return index >= 0 && index < level;
+}
+
+QList<OverloadMonitor::Interval> OverloadMonitor::intervals() const
+{
+    QMutexLocker lock(&_mutex);
+    QList<Interval> intervals = _intervals;
+    if( _level ) intervals.append( _current );
+    return intervals;
+}
+
+void OverloadMonitor::report() const
+{
+    QList<Interval> list = intervals();
+    if( list.isEmpty() ) return;
+    std::cout << "OverloadMonitor: " << list.size() << " degraded intervals" << std::endl;
+    std::ios::fmtflags flags = std::cout.flags();
+    foreach( const Interval& i, list ) {
+        std::cout << "    " << std::fixed << i.start << " - " << i.end
+                  << " level " << i.level << std::endl;
+    }
+    std::cout.flags( flags );
+}
+
+} // namespace ampp
+} // namespace pelican
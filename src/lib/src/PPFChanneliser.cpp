@@ -4,6 +4,7 @@
 
 #include "TimeSeriesDataSet.h"
 #include "SpectrumDataSet.h"
+#include "CoreBudget.h"
 
 #include <QtCore/QString>
 #include <QtCore/QTime>
@@ -31,12 +32,13 @@ PPFChanneliser::PPFChanneliser(const ConfigNode& config)
 {
     // Get options from the XML configuration node.
     _nChannels = config.getOption("outputChannelsPerSubband", "value", "512").toUInt();
-    _nThreads  = config.getOption("processingThreads", "value", "2").toUInt();
+    _nThreads  = CoreBudget::instance().threads(
+                     config.getOption("processingThreads", "value", "2").toUInt() );
     unsigned nTaps = config.getOption("filter", "nTaps", "8").toUInt();
     QString window = config.getOption("filter", "filterWindow", "kaiser").toLower();
 
-    // Set the number of processing threads.
-    omp_set_num_threads(_nThreads);
+    // The number of processing threads is set on the parallel region
+    // rather than globally so as not to affect other modules.
     _iOldestSamples.resize(_nThreads, 0);
 
     // Enforce even number of channels.
@@ -136,7 +138,7 @@ void PPFChanneliser::run(const TimeSeriesDataSetC32* timeSeries,
             _setupWorkBuffers(nSubbands, nPolarisations, _nChannels, nFilterTaps);
 
         // Channeliser processing.
-        #pragma omp parallel \
+        #pragma omp parallel num_threads(_nThreads) \
             shared(nTimeBlocks, nPolarisations, nSubbands, nFilterTaps, coeffs,\
                     timeStart, spectraStart) \
             private(threadId, nThreads, start, end, workBuffer, filteredSamples, \
@@ -1,6 +1,8 @@
 #include "ProcessingChain.h"
 #include <QMutexLocker>
+#include <QTime>
 #include <QtConcurrentRun>
+#include "Affinity.h"
 
 namespace pelican {
 
@@ -24,10 +26,20 @@ ProcessingChain::~ProcessingChain()
     waitTaskCompletion();
 }
 
-void ProcessingChain::waitTaskCompletion() const {
+bool ProcessingChain::waitTaskCompletion( unsigned long timeout ) const {
+    QTime timer;
+    timer.start();
+    QMutexLocker lock(&_mutex);
     while( _processCount.size() ) {
-        usleep(10);
+        if( timeout == ULONG_MAX ) {
+            _idle.wait(&_mutex);
+            continue;
+        }
+        unsigned long elapsed = (unsigned long)timer.elapsed();
+        if( elapsed >= timeout ) return false;
+        _idle.wait(&_mutex, timeout - elapsed);
     }
+    return true;
 }
 
 void ProcessingChain::exec( const QList<CallBackT>& parallelTasks,
@@ -48,11 +60,14 @@ void ProcessingChain::exec( const QList<CallBackT>& parallelTasks,
 }
 
 void ProcessingChain::_runTask( const CallBackT& functor, unsigned taskId, const QList<CallBackT>& postProcessingTasks ) {
+     // tasks run on the shared pool threads
+     Affinity::instance().pinCurrentThread( Affinity::Compute, "ProcessingChain" );
      functor();
      QMutexLocker lock(&_mutex);
      if( --_processCount[taskId] == 0) {
         _finished( postProcessingTasks );
         _processCount.remove(taskId); // mark processing chain complete
+        if( ! _processCount.size() ) _idle.wakeAll();
      }
 }
 
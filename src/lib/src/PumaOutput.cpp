@@ -5,14 +5,18 @@
 
 #include "DedispersedTimeSeries.h"
 #include "SpectrumDataSet.h"
+#include "Affinity.h"
 
 #include <QtNetwork/QTcpSocket>
 #include <QtCore/QIODevice>
-#include <QtCore/QVector>
 #include <QtCore/QFile>
-#include <QtCore/QTimer>
 #include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QMutexLocker>
 
+#include <time.h>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 
 
@@ -20,13 +24,52 @@ namespace pelican {
 
 namespace ampp {
 
+/// a server, with its queue of messages waiting to be sent
+struct PumaOutput::Receiver {
+    QString host;
+    quint16 port;
+    QTcpSocket* socket; // created and used by the sender thread only
+    bool connected;
+    double nextAttempt; // time of the next connection attempt
+    double delay;       // before the next attempt after a failure
+    // a ring of depth messages, whose buffers are reused
+    std::vector< std::vector<char> > messages;
+    int head;
+    int count;
+    std::vector<char> sending;
+    unsigned long queued, sent, dropped;
+    unsigned connects, failures;
+};
+
+class PumaOutput::Sender : public QThread
+{
+    public:
+        Sender( PumaOutput* output ) : _output(output) {}
+
+    protected:
+        void run() {
+            Affinity::instance().pinCurrentThread( Affinity::IO, "PumaOutput" );
+            _output->_run();
+        }
+
+    private:
+        PumaOutput* _output;
+};
 
 /**
  *@details PumaOutput
  */
 PumaOutput::PumaOutput(const ConfigNode& configNode)
-    : AbstractOutputStream( configNode )
+    : AbstractOutputStream( configNode ), _sender(0), _stop(false)
 {
+    _depth = configNode.getOption("queue", "depth", "64").toInt();
+    if( _depth < 1 )
+        throw QString("PumaOutput: queue depth must be at least 1");
+    _maxBuffered = configNode.getOption("queue", "maxBuffered", "4194304").toLongLong();
+    _connectTimeout = (int)( 1000 * configNode.getOption("reconnect", "timeout", "1.0").toDouble() );
+    _minDelay = configNode.getOption("reconnect", "minDelay", "0.5").toDouble();
+    _maxDelay = std::max( _minDelay, configNode.getOption("reconnect", "maxDelay", "30").toDouble() );
+
     // Initliase server connections
     int port = configNode.getOption("connection", "port").toInt();
     QString host = configNode.getOption("connection", "host");
@@ -56,9 +99,19 @@ PumaOutput::PumaOutput(const ConfigNode& configNode)
  */
 PumaOutput::~PumaOutput()
 {
-    foreach( QTcpSocket* device, _sockets.keys() )
+    if( _sender ) {
+        {
+            QMutexLocker lock(&_mutex);
+            _stop = true;
+            _wake.wakeAll();
+        }
+        _sender->wait();
+        delete _sender;
+        report();
+    }
+    foreach( Receiver* r, _receivers )
     {
-        delete device;
+        delete r;
     }
     foreach( QIODevice* device, _devices )
     {
@@ -66,6 +119,13 @@ PumaOutput::~PumaOutput()
     }
 }
 
+double PumaOutput::_now()
+{
+    struct timespec tp;
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    return tp.tv_sec + tp.tv_nsec * 1.0e-9;
+}
+
 void PumaOutput::addFile(const QString& filename)
 {
     QFile* file = new QFile(filename);
@@ -81,21 +141,24 @@ void PumaOutput::addFile(const QString& filename)
 
 void PumaOutput::addServer(const QString& host, quint16 port )
 {
-    QTcpSocket* s = new QTcpSocket;
-    _sockets.insert( s, QPair<QString,quint16>(host,port) );
-    _connect( s, host, port );
-}
-
-void PumaOutput::_connect(QTcpSocket* tcpSocket , const QString& server, quint16 port)
-{
-    while ( tcpSocket->state() == QAbstractSocket::UnconnectedState) {
-        tcpSocket->connectToHost( server, port );
-         if (!tcpSocket -> waitForConnected(5000) || tcpSocket->state() == QAbstractSocket::UnconnectedState) {
-            std::cerr << "Client could not connect to server:" << server.toStdString() << " port:" << port << std::endl;
-            sleep(2);
-            continue;
-        }
+    Receiver* r = new Receiver;
+    r->host = host;
+    r->port = port;
+    r->socket = 0;
+    r->connected = false;
+    r->nextAttempt = 0.0;
+    r->delay = 0.0;
+    r->messages.resize( _depth );
+    r->head = r->count = 0;
+    r->queued = r->sent = r->dropped = 0;
+    r->connects = r->failures = 0;
+    QMutexLocker lock(&_mutex);
+    _receivers.append( r );
+    if( ! _sender ) {
+        _sender = new Sender( this );
+        _sender->start();
     }
+    _wake.wakeAll();
 }
 
 void PumaOutput::sendStream(const QString& /*streamName*/, const DataBlob* dataBlob)
@@ -117,8 +180,7 @@ void PumaOutput::_convertToPuma( const SpectrumDataSetStokes* data )
 	    //
 	    // unwrap the datablob and munge channels and subbands together
 	    //
-	    QVector<float> puma(blocks);
-	    puma.fill(0);
+	    _puma.assign( blocks, 0.0f );
 	    unsigned int polarisation = 0; // only do one polarisation
 
 	    unsigned int nSubbands = data->nSubbands();
@@ -127,21 +189,13 @@ void PumaOutput::_convertToPuma( const SpectrumDataSetStokes* data )
 		    for (unsigned s = 0; s < nSubbands; ++s) {
 			    const float* spectrum = data->spectrumData(t, s, polarisation );
 			    for (unsigned int c = 0; c < nChannels ; ++c) {
-				    puma[t] = spectrum[c];
+				    _puma[t] += spectrum[c];
 			    }
 		    }
 	    }
 
 	    // send out the data to all required devices
-	    foreach( QTcpSocket* sock, _sockets.keys() )
-	    {
-		    _connect( sock, _sockets[sock].first, _sockets[sock].second );
-		    sock->write( (char*)&puma[0], puma.size()*sizeof(float) );
-	    }
-	    foreach( QIODevice* device, _devices )
-	    {
-		    device->write( (char*)&puma[0], puma.size()*sizeof(float) );
-	    }
+	    _send( (const char*)&_puma[0], _puma.size()*sizeof(float) );
     }
 }
 
@@ -162,11 +216,20 @@ void PumaOutput::_convertToPuma( const DedispersedTimeSeriesF32* timeData )
 
 void PumaOutput::_send(const char* puma, size_t size)
 {
-    // send out the data to all required devices
-    foreach( QTcpSocket* sock, _sockets.keys() )
-    {
-        _connect( sock, _sockets[sock].first, _sockets[sock].second );
-        sock->write( puma, size );
+    // queue the data for each server, dropping it for any that is behind
+    if( ! _receivers.isEmpty() ) {
+        QMutexLocker lock(&_mutex);
+        foreach( Receiver* r, _receivers )
+        {
+            if( r->count >= _depth ) {
+                ++r->dropped;
+                continue;
+            }
+            r->messages[( r->head + r->count ) % _depth].assign( puma, puma + size );
+            ++r->count;
+            ++r->queued;
+        }
+        _wake.wakeAll();
     }
     foreach( QIODevice* device, _devices )
     {
@@ -174,5 +237,161 @@ void PumaOutput::_send(const char* puma, size_t size)
     }
 }
 
+void PumaOutput::_run()
+{
+    forever {
+        QList<Receiver*> receivers;
+        {
+            QMutexLocker lock(&_mutex);
+            if( _stop ) break;
+            receivers = _receivers;
+        }
+        bool writing = false; // data still in the socket buffers
+        foreach( Receiver* r, receivers ) {
+            if( ! r->socket ) r->socket = new QTcpSocket;
+            if( ! r->connected ) {
+                double now = _now();
+                if( now < r->nextAttempt ) continue;
+                _connect( r, now );
+                if( ! r->connected ) continue;
+            }
+            _transmit( r );
+            if( r->socket->state() != QAbstractSocket::ConnectedState ) {
+                _disconnected( r, _now() );
+                continue;
+            }
+            if( r->socket->bytesToWrite() > 0 ) writing = true;
+        }
+
+        QMutexLocker lock(&_mutex);
+        if( _stop ) break;
+        bool queued = false;
+        foreach( Receiver* r, _receivers ) {
+            if( r->count ) queued = true;
+        }
+        if( ! queued ) _drained.wakeAll();
+        // poll while the sockets are busy; otherwise wait for data, looking
+        // in now and then for connections to retry
+        if( ! ( queued || writing ) || _receivers.size() != receivers.size() ) {
+            _wake.wait( &_mutex, 100 );
+        }
+        else {
+            _wake.wait( &_mutex, 1 );
+        }
+    }
+
+    // give the connected servers a moment to take what has been sent
+    double deadline = _now() + 1.0;
+    foreach( Receiver* r, _receivers ) {
+        if( r->socket && r->connected ) {
+            _transmit( r );
+            while( r->socket->bytesToWrite() > 0 && _now() < deadline ) {
+                if( ! r->socket->waitForBytesWritten( 100 ) ) break;
+            }
+        }
+        delete r->socket;
+        r->socket = 0;
+    }
+    _drained.wakeAll();
+}
+
+void PumaOutput::_connect( Receiver* r, double now )
+{
+    r->socket->abort();
+    r->socket->connectToHost( r->host, r->port );
+    bool ok = r->socket->waitForConnected( _connectTimeout )
+              && r->socket->state() == QAbstractSocket::ConnectedState;
+    QMutexLocker lock(&_mutex);
+    if( ok ) {
+        r->connected = true;
+        r->delay = 0.0;
+        ++r->connects;
+        std::cout << "PumaOutput: connected to " << r->host.toStdString()
+                  << ":" << r->port << std::endl;
+        return;
+    }
+    r->socket->abort();
+    ++r->failures;
+    r->delay = ( r->delay > 0.0 ) ? std::min( 2.0 * r->delay, _maxDelay ) : _minDelay;
+    r->nextAttempt = now + r->delay;
+    std::cerr << "PumaOutput: could not connect to " << r->host.toStdString()
+              << ":" << r->port << ", retrying in " << r->delay << " s" << std::endl;
+}
+
+void PumaOutput::_disconnected( Receiver* r, double now )
+{
+    r->socket->abort();
+    QMutexLocker lock(&_mutex);
+    r->connected = false;
+    ++r->failures;
+    r->delay = _minDelay;
+    r->nextAttempt = now + r->delay;
+    std::cerr << "PumaOutput: lost connection to " << r->host.toStdString()
+              << ":" << r->port << std::endl;
+}
+
+void PumaOutput::_transmit( Receiver* r )
+{
+    // hand messages to the socket while its buffer has room. The buffers
+    // are swapped, not copied, so none are allocated once all are in use
+    while( r->socket->bytesToWrite() < _maxBuffered ) {
+        {
+            QMutexLocker lock(&_mutex);
+            if( ! r->count ) break;
+            r->sending.swap( r->messages[r->head] );
+            r->head = ( r->head + 1 ) % _depth;
+            --r->count;
+            ++r->sent;
+        }
+        if( ! r->sending.empty() ) {
+            r->socket->write( &r->sending[0], r->sending.size() );
+        }
+    }
+    // writes as much as the socket will take without blocking
+    r->socket->flush();
+}
+
+bool PumaOutput::flush( double timeout )
+{
+    QMutexLocker lock(&_mutex);
+    double deadline = _now() + timeout;
+    forever {
+        bool queued = false;
+        foreach( Receiver* r, _receivers ) {
+            if( r->count ) queued = true;
+        }
+        if( ! queued ) return true;
+        double remaining = deadline - _now();
+        if( remaining <= 0.0 || _stop ) return false;
+        _wake.wakeAll();
+        _drained.wait( &_mutex, (unsigned long)( 1000 * remaining ) + 1 );
+    }
+}
+
+PumaOutput::Statistics PumaOutput::statistics() const
+{
+    QMutexLocker lock(&_mutex);
+    Statistics s = { 0, 0, 0, 0, 0 };
+    foreach( const Receiver* r, _receivers ) {
+        s.queued += r->queued;
+        s.sent += r->sent;
+        s.dropped += r->dropped;
+        s.connects += r->connects;
+        s.failures += r->failures;
+    }
+    return s;
+}
+
+void PumaOutput::report() const
+{
+    QMutexLocker lock(&_mutex);
+    foreach( const Receiver* r, _receivers ) {
+        std::cout << "PumaOutput: " << r->host.toStdString() << ":" << r->port << " "
+                  << r->sent << " sent, " << r->dropped << " dropped, "
+                  << r->connects << " connections, " << r->failures << " failures"
+                  << std::endl;
+    }
+}
+
 } // namespace ampp
 } // namespace pelican
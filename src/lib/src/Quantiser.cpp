@@ -0,0 +1,184 @@
+#include "Quantiser.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QString>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+
+namespace pelican {
+
+namespace ampp {
+
+namespace {
+
+// kept out of the class so that the compiler can rely on the arrays
+// not overlapping and vectorise the loop
+void updateStatistics( const float* in, unsigned n, float* __restrict__ count,
+                       float* __restrict__ mean, float* __restrict__ var,
+                       float* __restrict__ centre, float* __restrict__ scale,
+                       float minAlpha, float width, float top )
+{
+    for( unsigned i = 0; i < n; ++i ) {
+        float c = count[i] + 1.0f;
+        float a = 1.0f / c;
+        a = ( a > minAlpha ) ? a : minAlpha;
+        float d = in[i] - mean[i];
+        count[i] = c;
+        mean[i] += a * d;
+        var[i] = ( 1.0f - a ) * ( var[i] + a * d * d );
+        centre[i] = mean[i];
+        // the floor keeps a constant channel finite
+        scale[i] = top / ( width * std::sqrt( var[i] ) + 1e-6f * std::fabs( mean[i] ) + 1e-20f );
+    }
+}
+
+} // namespace
+
+/**
+ *@details Quantiser
+ */
+Quantiser::Quantiser( const ConfigNode& config )
+{
+    unsigned nBits = config.getOption("dataBits", "value", "8").toUInt();
+    float top = (float)( ( 1 << std::min( nBits, 16u ) ) - 1 );
+    float min = config.getOption("scale", "min", "0.0").toFloat();
+    bool goodConversion = false;
+    float max = config.getOption("scale", "max", "X").toFloat(&goodConversion);
+    if( ! goodConversion ) max = top;
+    _init( nBits, min, max );
+    if( config.getOption("quantisation", "adaptive", "false").toLower() == "true" ) {
+        setAdaptive( config.getOption("quantisation", "sigma", "3.0").toFloat(),
+                     config.getOption("quantisation", "timeConstant", "1024").toUInt() );
+    }
+}
+
+Quantiser::Quantiser( unsigned nBits, float min, float max )
+{
+    _init( nBits, min, max );
+}
+
+/**
+ *@details
+ */
+Quantiser::~Quantiser()
+{
+}
+
+void Quantiser::_init( unsigned nBits, float min, float max )
+{
+    if( nBits != 1 && nBits != 2 && nBits != 4 && nBits != 8 )
+        throw QString("Quantiser: %1 bit samples not supported (use 1, 2, 4 or 8)").arg(nBits);
+    if( max <= min )
+        throw QString("Quantiser: scale max (%1) must be greater than min (%2)").arg(max).arg(min);
+    _nBits = nBits;
+    _top = (float)( ( 1 << nBits ) - 1 );
+    _min = min;
+    _max = max;
+    _adaptive = false;
+    _sigma = 0.0;
+    _minAlpha = 0.0;
+    _mid = 0.0;
+}
+
+void Quantiser::setAdaptive( float sigma, unsigned timeConstant )
+{
+    if( sigma <= 0.0 )
+        throw QString("Quantiser: sigma must be positive (%1)").arg(sigma);
+    if( timeConstant == 0 )
+        throw QString("Quantiser: timeConstant must be at least 1");
+    _adaptive = true;
+    _sigma = sigma;
+    _minAlpha = 1.0f / timeConstant;
+    _mid = 0.5f * _top;
+    reset();
+}
+
+void Quantiser::reset()
+{
+    std::fill( _centre.begin(), _centre.end(), _min );
+    std::fill( _scale.begin(), _scale.end(), _top / ( _max - _min ) );
+    std::fill( _mean.begin(), _mean.end(), 0.0f );
+    std::fill( _var.begin(), _var.end(), 0.0f );
+    std::fill( _count.begin(), _count.end(), 0.0f );
+}
+
+float Quantiser::mean( unsigned channel ) const
+{
+    return ( channel < _mean.size() ) ? _mean[channel] : 0.0f;
+}
+
+float Quantiser::rms( unsigned channel ) const
+{
+    return ( channel < _var.size() ) ? std::sqrt( _var[channel] ) : 0.0f;
+}
+
+void Quantiser::_resize( unsigned nChannels )
+{
+    _centre.resize( nChannels, _min );
+    _scale.resize( nChannels, _top / ( _max - _min ) );
+    _mean.resize( nChannels, 0.0f );
+    _var.resize( nChannels, 0.0f );
+    _count.resize( nChannels, 0.0f );
+}
+
+void Quantiser::pack( const float* in, unsigned n, unsigned char* out, unsigned channel )
+{
+    if( n % ( 8 / _nBits ) )
+        throw QString("Quantiser: %1 samples do not fill whole bytes at %2 bits").arg(n).arg(_nBits);
+    if( channel + n > _centre.size() ) _resize( channel + n );
+    if( _levels.size() < n ) _levels.resize( n );
+    if( _adaptive ) _update( in, n, channel );
+
+    const float* __restrict__ centre = &_centre[channel];
+    const float* __restrict__ scale = &_scale[channel];
+    unsigned char* __restrict__ levels = &_levels[0];
+    const float mid = _mid;
+    const float top = _top;
+    for( unsigned i = 0; i < n; ++i ) {
+        float x = ( in[i] - centre[i] ) * scale[i] + mid;
+        x = std::min( std::max( x, 0.0f ), top );
+        levels[i] = (unsigned char)lrintf( x ); // half to even, as rint
+    }
+    _pack( levels, n, out );
+}
+
+// include the spectrum in the running statistics and rescale the channels.
+// Until a channel has seen timeConstant spectra it uses the plain average.
+void Quantiser::_update( const float* in, unsigned n, unsigned channel )
+{
+    updateStatistics( in, n, &_count[channel], &_mean[channel], &_var[channel],
+                      &_centre[channel], &_scale[channel], _minAlpha, 2.0f * _sigma, _top );
+}
+
+void Quantiser::_pack( const unsigned char* __restrict__ levels, unsigned n,
+                       unsigned char* __restrict__ out ) const
+{
+    switch( _nBits ) {
+        case 8:
+            std::memcpy( out, levels, n );
+            break;
+        case 4:
+            for( unsigned b = 0; b < n / 2; ++b ) {
+                const unsigned char* l = levels + 2 * b;
+                out[b] = l[0] | ( l[1] << 4 );
+            }
+            break;
+        case 2:
+            for( unsigned b = 0; b < n / 4; ++b ) {
+                const unsigned char* l = levels + 4 * b;
+                out[b] = l[0] | ( l[1] << 2 ) | ( l[2] << 4 ) | ( l[3] << 6 );
+            }
+            break;
+        case 1:
+            for( unsigned b = 0; b < n / 8; ++b ) {
+                const unsigned char* l = levels + 8 * b;
+                out[b] = l[0] | ( l[1] << 1 ) | ( l[2] << 2 ) | ( l[3] << 3 )
+                       | ( l[4] << 4 ) | ( l[5] << 5 ) | ( l[6] << 6 ) | ( l[7] << 7 );
+            }
+            break;
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
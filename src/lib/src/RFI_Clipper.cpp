@@ -9,6 +9,7 @@
 #include "pelican/utility/ConfigNode.h"
 #include "pelican/utility/pelicanTimer.h"
 #include "omp.h"
+#include "CoreBudget.h"
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/random/variate_generator.hpp>
@@ -25,6 +26,8 @@ RFI_Clipper::RFI_Clipper( const ConfigNode& config )
     _badSpectra(0)
 {
     _current = 0;
+    // threads within the process core budget
+    _nThreads = CoreBudget::instance().threads( config.getOption("threads", "value", "6").toUInt() );
     if( config.hasAttribute("active") &&
             config.getAttribute("active").toLower() == QString("false") ) {
         _active = false;
@@ -147,14 +150,14 @@ RFI_Clipper::~RFI_Clipper()
    *
    */
 
-static inline void clipSample( SpectrumDataSetStokes* stokesAll, float* W, unsigned t, std::vector<float> lastGoodSpectrum ) {
+static inline void clipSample( SpectrumDataSetStokes* stokesAll, float* W, unsigned t, std::vector<float> lastGoodSpectrum, unsigned nThreads ) {
 
     float* I = stokesAll->data();
     unsigned nSubbands = stokesAll->nSubbands();
     unsigned nPolarisations= stokesAll->nPolarisations();
     unsigned nChannels= stokesAll->nChannels();
     // Clip entire spectrum
-#pragma omp parallel for num_threads(4)
+#pragma omp parallel for num_threads(nThreads)
     for (unsigned s = 0; s < nSubbands; ++s) {
       // The following is for clipping the polarization
       for(unsigned int pol = 0; pol < nPolarisations; ++pol ) {
@@ -240,7 +243,7 @@ void RFI_Clipper::run( WeightedSpectrumDataSet* weightedStokes )
       // create a copy of the data minus the model in order
       // to compute the median. The median is used as a single number
       // to characterise the offset of the data and the model.
-#pragma omp parallel for num_threads(6) shared(copyI, bandPass, nSubbands, nPolarisations, t, nChannels)
+#pragma omp parallel for num_threads(_nThreads) shared(copyI, bandPass, nSubbands, nPolarisations, t, nChannels)
       for (unsigned s = 0; s < nSubbands; ++s) {
         long index = stokesAll->index(s, nSubbands,
                                     0, nPolarisations,
@@ -399,7 +402,7 @@ void RFI_Clipper::run( WeightedSpectrumDataSet* weightedStokes )
 
         // Clip entire spectrum
         //        std::cout << "Clipping sample" << std::endl;
-        clipSample( stokesAll, W, t, _lastGoodSpectrum );
+        clipSample( stokesAll, W, t, _lastGoodSpectrum, _nThreads );
 /*
         for (unsigned s = 0; s < nSubbands; ++s) {
           long index = stokesAll->index(s, nSubbands,
@@ -424,7 +427,7 @@ void RFI_Clipper::run( WeightedSpectrumDataSet* weightedStokes )
         // the data. Problem is, the data have been scaled by the
         // modelRMS, so spectrumSum needs to be scaled too, and a new
         // sum is computed
-//#pragma omp parallel for num_threads(4)
+//#pragma omp parallel for num_threads(_nThreads)
         for (unsigned s = 0; s < nSubbands; ++s) {
           for(unsigned int pol = 0; pol < nPolarisations; ++pol ) {
             long index = stokesAll->index(s, nSubbands,
@@ -470,7 +473,7 @@ void RFI_Clipper::run( WeightedSpectrumDataSet* weightedStokes )
         if (_num != _maxHistory ) {
           //          _runningMedian = (_runningMedian * (float) _num + median)/(float) (_num+1);
           //          std::cout << _num << std::endl;
-          clipSample( stokesAll, W, t, _lastGoodSpectrum );
+          clipSample( stokesAll, W, t, _lastGoodSpectrum, _nThreads );
           _runningMedian = (_runningMedian * (float) _num + medianDelta)/(float) (_num+1);
           _runningRMS = (_runningRMS * (float) _num + spectrumRMS)/(float) (_num+1);
           // store the integral of _historyNewSum and _historyNewSum^2 from the buffer
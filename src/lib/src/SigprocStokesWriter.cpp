@@ -1,8 +1,11 @@
 #include "SpectrumDataSet.h"
 #include "SigprocStokesWriter.h"
+#include "Quantiser.h"
 #include "time.h"
 #include <string>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <hiredis/hiredis.h>
@@ -14,7 +17,8 @@ namespace ampp {
 // Constructor
 // TODO: For now we write in 32-bit format...
 SigprocStokesWriter::SigprocStokesWriter(const ConfigNode& configNode )
-  : AbstractOutputStream(configNode), _first(true)
+  : AbstractOutputStream(configNode), _first(true), _rotation(configNode),
+    _compressor(configNode), _quantiser(0)
 {
     _nSubbands = configNode.getOption("subbandsPerPacket", "value", "1").toUInt();
     _nTotalSubbands = configNode.getOption("totalComplexSubbands", "value", "1").toUInt();
@@ -25,14 +29,9 @@ SigprocStokesWriter::SigprocStokesWriter(const ConfigNode& configNode )
     _nChannels = _nChannels / _integrationFreq;
     _nRawPols = configNode.getOption("nRawPolarisations", "value", "2").toUInt();
     _nBits = configNode.getOption("dataBits", "value", "32").toUInt();
-    _nRange = (int) pow(2.0,(double) _nBits)-1.0;
-    _cropMin = configNode.getOption("scale", "min", "0.0" ).toFloat();
-    bool goodConversion=false;
-    _cropMax = configNode.getOption("scale", "max", "X" ).toFloat(&goodConversion);
-    if( ! goodConversion ) {
-        _cropMax=_nRange;
-    }
-    _scaleDelta = _cropMax - _cropMin;
+    if( _nBits != 32 ) _quantiser = new Quantiser( configNode );
+    // shuffle whole samples; packed samples share bytes
+    _compressor.setElementSize( ( _nBits >= 8 ) ? _nBits / 8 : 1 );
 
     // Initliase connection manager thread
     _filepath = configNode.getOption("file", "filepath");
@@ -69,9 +68,19 @@ SigprocStokesWriter::SigprocStokesWriter(const ConfigNode& configNode )
 
     _nPols    = configNode.getOption("params", "nPolsToWrite", "1").toUInt();
     _nchans   = _nChannels * _nSubbands;
-    _buffSize = configNode.getOption("params", "bufferSize", "5120").toUInt();
+    // whole pages, so that full blocks are aligned in the file
+    _buffSize = configNode.getOption("params", "bufferSize", "1048576").toUInt();
+    _buffSize = std::max( 4096, ( _buffSize + 4095 ) & ~4095 );
     _cur = 0;
-    _first = (configNode.hasAttribute("writeHeader") && configNode.getAttribute("writeHeader").toLower() == "true" );
+    QString policy = configNode.getOption("flush", "policy", "blob").toLower();
+    if( policy == "blob" ) _flushPolicy = FlushBlob;
+    else if( policy == "interval" ) _flushPolicy = FlushInterval;
+    else if( policy == "block" ) _flushPolicy = FlushBlock;
+    else throw( QString("SigprocStokesWriter: unknown flush policy \"%1\"").arg(policy) );
+    _flushInterval = (int)( 1000 * configNode.getOption("flush", "interval", "1.0").toFloat() );
+    _bytesWritten = 0.0;
+    _writeHeader = (configNode.hasAttribute("writeHeader") && configNode.getAttribute("writeHeader").toLower() == "true" );
+    _first = _writeHeader;
     _site = configNode.getOption("TelescopeID", "value", "0").toUInt();
     _machine = configNode.getOption("MachineID", "value", "9").toUInt();
     /*_sourceName = _raString.left(4);
@@ -85,15 +94,12 @@ SigprocStokesWriter::SigprocStokesWriter(const ConfigNode& configNode )
     // Open file
     _buffer.resize(_buffSize);
 
-    char timestr[22];
-    time_t     now = time(0);
-    struct tm  tstruct;
-    tstruct = *localtime(&now);
-    strftime(timestr, sizeof timestr, "D%Y%m%dT%H%M%S", &tstruct );
-    QString fileName;
-    fileName = _filepath + QString("_") + timestr + QString(".fil");
+    _fileName = _rotation.nextName(_filepath) + _suffix();
     //    _file.open(_filepath.toUtf8().data(), std::ios::out | std::ios::binary);
-    _file.open(fileName.toUtf8().data(), std::ios::out | std::ios::binary);
+    // we do our own buffering
+    _file.rdbuf()->pubsetbuf(0, 0);
+    _rotation.open(_file, _fileName);
+    _lastFlush.start();
 }
 
 void SigprocStokesWriter::getLOFreqRADecFromRedis(const ConfigNode& configNode)
@@ -194,41 +200,49 @@ void SigprocStokesWriter::writeHeader(SpectrumDataSetStokes* stokes){
     WriteDouble("tstart", _mjdStamp);      //TODO: Extract start time from first packet
     WriteInt("nifs", int(_nPols));           // Polarisation channels.
     WriteString("HEADER_END");
-    _file.flush();
 
 }
 
 // Destructor
 SigprocStokesWriter::~SigprocStokesWriter()
 {
-    _file.close();
+    _flush();
+    _compressor.finish();
+    _rotation.close(_file, _fileName);
+    delete _quantiser;
+    _compressor.report("SigprocStokesWriter");
+    double seconds = _writeTime.timeAverage * _writeTime.counter;
+    if( seconds > 0.0 ) {
+        std::cout << "SigprocStokesWriter: wrote " << _bytesWritten / 1.0e6 << " MB at "
+                  << _bytesWritten / 1.0e6 / seconds << " MB/s" << std::endl;
+    }
 }
 
 // ---------------------------- Header helpers --------------------------
 void SigprocStokesWriter::WriteString(QString string)
 {
-    int len = string.size();
-    char *text = string.toUtf8().data();
-    _file.write(reinterpret_cast<char *>(&len), sizeof(int));
-    _file.write(reinterpret_cast<char *>(text), len);
+    QByteArray text = string.toUtf8();
+    int len = text.size();
+    _write(reinterpret_cast<const char *>(&len), sizeof(int));
+    _write(text.constData(), len);
 }
 
 void SigprocStokesWriter::WriteInt(QString name, int value)
 {
     WriteString(name);
-    _file.write(reinterpret_cast<char *>(&value), sizeof(int));
+    _write(reinterpret_cast<const char *>(&value), sizeof(int));
 }
 
 void SigprocStokesWriter::WriteDouble(QString name, double value)
 {
     WriteString(name);
-    _file.write(reinterpret_cast<char *>(&value), sizeof(double));
+    _write(reinterpret_cast<const char *>(&value), sizeof(double));
 }
 
 void SigprocStokesWriter::WriteLong(QString name, long value)
 {
     WriteString(name);
-    _file.write(reinterpret_cast<char *>(&value), sizeof(long));
+    _write(reinterpret_cast<const char *>(&value), sizeof(long));
 }
 
 // ---------------------------- Data helpers --------------------------
@@ -240,80 +254,47 @@ void SigprocStokesWriter::sendStream(const QString& /*streamName*/, const DataBl
     DataBlob* blob = const_cast<DataBlob*>(incoming);
 
     if( (stokes = (SpectrumDataSetStokes*) dynamic_cast<SpectrumDataSetStokes*>(blob))){
+        _writeTime.tick();
 
+        switch (_nBits) {
+            case 32:
+                _stage32(stokes);
+                break;
+            default:
+                _stagePacked(stokes);
+                break;
+        }
+
+        // segments start on a blob boundary
+        if( _rotation.next( stokes->getLofarTimestamp(), _staging.size() ) ) {
+            _nextSegment();
+        }
         if (_first){
             _first = false;
             writeHeader(stokes);
         }
+        if( _compressor.active() ) {
+            // the header stays as it is, ahead of the chunks
+            if( ! _compressor.started() ) {
+                _flush();
+                _compressor.start(_file);
+            }
+            if( ! _staging.empty() ) _compressor.write(&_staging[0], _staging.size());
+        }
+        else if( ! _staging.empty() ) _write(&_staging[0], _staging.size());
 
-        unsigned nSamples = stokes->nTimeBlocks();
-        unsigned nSubbands = stokes->nSubbands();
-        unsigned nChannels = stokes->nChannels();
-        unsigned nPolarisations = stokes->nPolarisations();
-        float const * data = stokes->data();
-
-        switch (_nBits) {
-            case 32: {
-                    for (unsigned t = 0; t < nSamples; ++t) {
-                        for (unsigned p = 0; p < _nPols; ++p) {
-                            for (int s = nSubbands - 1; s >= 0 ; --s) {
-                                long index = stokes->index(s, nSubbands, 
-                                          p, nPolarisations, t, nChannels );
-                                //for(int i = nChannels - 1; i >= 0 ; --i) {
-                                for(int i = 0; i < nChannels ; ++i) {
-                                _file.write(reinterpret_cast<const char*>(&data[index + i]), 
-                                            sizeof(float));
-                                }
-                            }
-                        }
-                    }
-                }
+        switch (_flushPolicy) {
+            case FlushBlob:
+                _flush();
                 break;
-            case 8: {
-                    for (unsigned t = 0; t < nSamples; ++t) {
-                        for (unsigned p = 0; p < _nPols; ++p) {
-                            for (int s = nSubbands - 1; s >= 0 ; --s) {
-                                long index = stokes->index(s, nSubbands, 
-                                          p, nPolarisations, t, nChannels );
-                                for(int i = nChannels - 1; i >= 0 ; --i) {
-                                    int ci;
-                                    _float2int(&data[index + i],&ci);
-                                    _file.write((const char*)&ci,sizeof(unsigned char));
-                                }
-                            }
-                        }
-                    }
-                }
+            case FlushInterval:
+                if( _lastFlush.elapsed() >= _flushInterval ) _flush();
                 break;
-            default:
-                throw(QString("SigprocStokesWriter: %1 bit datafiles not yet supported"));
+            case FlushBlock:
                 break;
         }
-/*
-        for (unsigned t = 0; t < nSamples; ++t) {
-            for (unsigned p = 0; p < _nPols; ++p) {
-                for (int s = nSubbands - 1; s >= 0 ; --s) {
-                    data = stokes->spectrumData(t, s, p);
-                    for(int i = nChannels - 1; i >= 0 ; --i) {
-                        switch (_nBits) {
-                            case 32:
-                                _file.write(reinterpret_cast<const char*>(&data[i]), sizeof(float));
-                                break;
-                            case 8:
-                                int ci = ;
-                                _float2int(&data[i],1,8,_scaleMin,_scaleMax,&ci);
-                                _file.write((const char*)&ci,sizeof(unsigned char));
-                                break;
-                            default:
-                                throw(QString("SigprocStokesWriter:"));
-                                break;
-                        }
-                    }
-                }
-            }
-        }
-*/
-        _file.flush();
+        _bytesWritten += _staging.size();
+        _writeTime.tock();
     }
     else {
         std::cerr << "SigprocStokesWriter::send(): "
@@ -322,25 +303,109 @@ void SigprocStokesWriter::sendStream(const QString& /*streamName*/, const DataBl
     }
 }
 
-void SigprocStokesWriter::_write(char* data, size_t size)
+// Reorder a blob into file order: for each sample and polarisation the
+// subbands from the top down, each with its channels in ascending order
+void SigprocStokesWriter::_stage32(const SpectrumDataSetStokes* stokes)
+{
+    unsigned nSamples = stokes->nTimeBlocks();
+    unsigned nSubbands = stokes->nSubbands();
+    unsigned nChannels = stokes->nChannels();
+    unsigned nPolarisations = stokes->nPolarisations();
+    float const * data = stokes->data();
+    size_t spectrumBytes = nChannels * sizeof(float);
+
+    _staging.resize( (size_t)nSamples * _nPols * nSubbands * spectrumBytes );
+    char* out = &_staging[0];
+    for (unsigned t = 0; t < nSamples; ++t) {
+        for (unsigned p = 0; p < _nPols; ++p) {
+            for (int s = nSubbands - 1; s >= 0 ; --s) {
+                long index = stokes->index(s, nSubbands,
+                          p, nPolarisations, t, nChannels );
+                std::memcpy( out, &data[index], spectrumBytes );
+                out += spectrumBytes;
+            }
+        }
+    }
+}
+
+// As _stage32, but with the channels of each subband in descending order
+// and quantised to _nBits
+void SigprocStokesWriter::_stagePacked(const SpectrumDataSetStokes* stokes)
 {
-    int max = _buffer.capacity() -1;
-    int ptr = (_cur + size) % max;
-    if( ptr <= _cur ) {
-        int dsize = max - _cur;
-        std::memcpy(&_buffer[_cur], data, dsize );
-        _file.write(&_buffer[0], max);
-        _cur = 0; size -= dsize; data += dsize * sizeof(char);
+    unsigned nSamples = stokes->nTimeBlocks();
+    unsigned nSubbands = stokes->nSubbands();
+    unsigned nChannels = stokes->nChannels();
+    unsigned nPolarisations = stokes->nPolarisations();
+    float const * data = stokes->data();
+    unsigned nSpectrum = nSubbands * nChannels;
+    size_t spectrumBytes = _quantiser->packedSize( nSpectrum );
+
+    _spectrum.resize( nSpectrum );
+    _staging.resize( (size_t)nSamples * _nPols * spectrumBytes );
+    unsigned char* out = reinterpret_cast<unsigned char*>(&_staging[0]);
+    for (unsigned t = 0; t < nSamples; ++t) {
+        for (unsigned p = 0; p < _nPols; ++p) {
+            float* spectrum = &_spectrum[0];
+            for (int s = nSubbands - 1; s >= 0 ; --s) {
+                long index = stokes->index(s, nSubbands,
+                          p, nPolarisations, t, nChannels );
+                const float* in = &data[index + nChannels - 1];
+                for (unsigned i = 0; i < nChannels; ++i) {
+                    spectrum[i] = *(in - i);
+                }
+                spectrum += nChannels;
+            }
+            _quantiser->pack( &_spectrum[0], nSpectrum, out, p * nSpectrum );
+            out += spectrumBytes;
+        }
     }
-    std::memcpy( &_buffer[_cur], data, size);
-    _cur=ptr;
 }
 
-void SigprocStokesWriter::_float2int(const float *f, int *i)
+void SigprocStokesWriter::_write(const char* data, size_t size)
+{
+    size_t block = _buffSize;
+    // top up a partly filled block first
+    if( _cur ) {
+        size_t n = std::min( size, block - _cur );
+        std::memcpy( &_buffer[_cur], data, n );
+        _cur += n; data += n; size -= n;
+        if( _cur < (int)block ) return;
+        _file.write( &_buffer[0], block );
+        _cur = 0;
+    }
+    // whole blocks go straight to the file
+    size_t whole = size - size % block;
+    if( whole ) {
+        _file.write( data, whole );
+        data += whole; size -= whole;
+    }
+    std::memcpy( &_buffer[0], data, size );
+    _cur = size;
+}
+
+void SigprocStokesWriter::_flush()
+{
+    if( _cur ) {
+        _file.write( &_buffer[0], _cur );
+        _cur = 0;
+    }
+    _file.flush();
+    _lastFlush.restart();
+}
+
+QString SigprocStokesWriter::_suffix() const
+{
+    return _compressor.active() ? QString(".filz") : QString(".fil");
+}
+
+void SigprocStokesWriter::_nextSegment()
 {
-    float ftmp;
-    ftmp = (*f>_cropMax)? (_cropMax) : *f;
-    *i = (ftmp<_cropMin) ? 0 : (int)rint((ftmp-_cropMin)*_nRange/_scaleDelta);
+    _flush();
+    _compressor.finish();
+    _rotation.close(_file, _fileName);
+    _fileName = _rotation.nextName(_filepath) + _suffix();
+    _rotation.open(_file, _fileName);
+    _first = _writeHeader;
 }
 
 } // namepsace lofar
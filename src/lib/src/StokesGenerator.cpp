@@ -1,5 +1,6 @@
 #include "StokesGenerator.h"
 #include "SpectrumDataSet.h"
+#include "CoreBudget.h"
 
 #include "pelican/utility/ConfigNode.h"
 
@@ -23,6 +24,8 @@ StokesGenerator::StokesGenerator(const ConfigNode& config)
     std::cout << "You can either generate 1 or 4 Stokes parameters. Change numberOfStokes in xml file." << std::endl;
     exit (EXIT_FAILURE);
   }
+  // threads within the process core budget
+  _nThreads = CoreBudget::instance().threads( config.getOption("threads", "value", "4").toUInt() );
 }
 
 
@@ -53,7 +56,7 @@ void StokesGenerator::run(const SpectrumDataSetC32* channeliserOutput,
   const Complex* dataPolDataBlock = channeliserOutput->data();
 
   for (unsigned t = 0; t < nSamples; ++t) {
-#pragma omp parallel for num_threads(4)
+#pragma omp parallel for num_threads(_nThreads)
     for (unsigned s = 0; s < nSubbands; ++s) {
       const Complex* dataPolX, *dataPolY;
       float *I, *Q, *U, *V;
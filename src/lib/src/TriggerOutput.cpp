@@ -17,8 +17,13 @@
 #include <QtCore/QTimer>
 #include <QtCore/QStringList>
 #include <QtCore/QDateTime>
-#include <QDebug>
-#include <QtGui/QApplication>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMutexLocker>
+#include <time.h>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 
@@ -26,12 +31,22 @@ namespace pelican {
   
 namespace ampp {
 
+namespace {
+// recent data arrivals kept for stamping triggers
+const unsigned arrivalHistory = 8192;
+// latency histogram bins: < 1 ms, < 2 ms, ... < 2^(bins-2) ms, longer
+const unsigned latencyBins = 18;
+} // namespace
+
 
 /**
  *@details TriggerOutput
  */
 TriggerOutput::TriggerOutput(const ConfigNode& configNode)
-    : AbstractOutputStream( configNode )
+    : AbstractOutputStream( configNode ),
+      _arrivals( arrivalHistory ), _head(0), _count(0),
+      _histogram( latencyBins, 0 ), _triggers(0), _stamped(0),
+      _minLatency(0.0), _maxLatency(0.0), _sumLatency(0.0)
 {
     // Initliase server connections
     int port = configNode.getOption("Receiver", "port").toInt();
@@ -54,9 +69,9 @@ TriggerOutput::TriggerOutput(const ConfigNode& configNode)
 
     // initialize identifier
     _station = configNode.getOption("Telescope", "stationID");
-    _idroot = QString("%1-%2%3");
-    _idroot = _idroot.arg( QDateTime::currentDateTime().toString("yyyyMMddhhmm") );
-    _idroot = _idroot.arg( configNode.getOption("Telescope", "beamID") , 2 , '0');
+    _idroot = QString("%1-%2")
+                  .arg( QDateTime::currentDateTime().toString("yyyyMMddhhmm") )
+                  .arg( configNode.getOption("Telescope", "beamID") , 2 , '0').toAscii();
 
     // initialize beam direction and frequency
     _beamRA = configNode.getOption("RADec", "rajd");
@@ -84,6 +99,7 @@ TriggerOutput::TriggerOutput(const ConfigNode& configNode)
  */
 TriggerOutput::~TriggerOutput()
 {
+    if( _triggers ) report();
     foreach( QUdpSocket* device, _sockets.keys() )
     {
         delete device;
@@ -119,7 +135,8 @@ void TriggerOutput::addFile(const QString& logfile)
 void TriggerOutput::addReceiver(const QString& host, quint16 port )
 {
     QUdpSocket* s = new QUdpSocket;
-    s->moveToThread(QApplication::instance()->thread()) ;
+    if( QCoreApplication::instance() )
+        s->moveToThread(QCoreApplication::instance()->thread()) ;
     _sockets.insert( s, QPair<QHostAddress,quint16>(QHostAddress(host),port) );
     //    _connect( s, host, port );
 }
@@ -140,45 +157,174 @@ void PumaOutput::_connect(QTcpSocket* tcpSocket , const QString& server, quint16
 
 void TriggerOutput::sendStream(const QString& /*streamName*/, const DataBlob* dataBlob)
 {
-    if( _format == "FRATS" ) {
-      _convertToTrigger_FRATS( static_cast<const DedispersionDataAnalysis*>(dataBlob) );
+    trigger( static_cast<const DedispersionDataAnalysis*>(dataBlob) );
+}
+
+double TriggerOutput::_now()
+{
+    struct timespec tp;
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    return tp.tv_sec + tp.tv_nsec * 1.0e-9;
+}
+
+void TriggerOutput::dataArrived( double timestamp )
+{
+    double now = _now();
+    QMutexLocker lock(&_mutex);
+    unsigned size = _arrivals.size();
+    if( _count == size ) {
+        _head = ( _head + 1 ) % size;
+        --_count;
     }
-    else {
-      std::cerr << "Trigger format not recognized / implemented";
+    _arrivals[( _head + _count ) % size] = QPair<double,double>( timestamp, now );
+    ++_count;
+}
+
+double TriggerOutput::_arrival( double timestamp ) const
+{
+    // the latest data starting at or before the timestamp
+    QMutexLocker lock(&_mutex);
+    unsigned size = _arrivals.size();
+    for( unsigned i = _count; i > 0; --i ) {
+        const QPair<double,double>& a = _arrivals[( _head + i - 1 ) % size];
+        if( a.first <= timestamp ) return a.second;
     }
+    return -1.0;
 }
 
-void TriggerOutput::_convertToTrigger_FRATS( const DedispersionDataAnalysis* data )
+void TriggerOutput::_recordLatency( double ms )
 {
-    DedispersionEvent* emax;
-    float SNR, SNRmax;
-    QString message;
+    unsigned bin = 0;
+    for( double limit = 1.0; bin < latencyBins - 1 && ms >= limit; limit *= 2.0 ) ++bin;
+    QMutexLocker lock(&_mutex);
+    ++_histogram[bin];
+    _minLatency = ( _stamped == 0 ) ? ms : std::min( _minLatency, ms );
+    _maxLatency = ( _stamped == 0 ) ? ms : std::max( _maxLatency, ms );
+    _sumLatency += ms;
+    ++_stamped;
+}
 
+bool TriggerOutput::trigger( const DedispersionDataAnalysis* data )
+{
+    if( _format == "FRATS" ) {
+      return _convertToTrigger_FRATS( data );
+    }
+    std::cerr << "Trigger format not recognized / implemented";
+    return false;
+}
+
+void TriggerOutput::_append( QByteArray& message, const char* text, int width )
+{
+    for( int n = width - (int)std::strlen( text ); n > 0; --n ) message.append( '0' );
+    message.append( text );
+}
+
+void TriggerOutput::_append( QByteArray& message, const QString& text, int width )
+{
+    _append( message, text.toAscii().constData(), width );
+}
+
+bool TriggerOutput::_convertToTrigger_FRATS( const DedispersionDataAnalysis* data )
+{
+    if (data->eventsFound() < _min_events) return false;
+
+    // the first event only marks the start of the buffer
+    const QList<DedispersionEvent>& events = data->events();
     float rms = data->getRMS();
-    if (data->eventsFound() >= _min_events) {
-        foreach( const DedispersionEvent& e, data->events() ) {
-	    if ( (SNR = e.mfValue()/(rms * sqrt(e.mfBinning()))) > SNRmax ) {
-	        SNRmax = SNR;
-		emax = const_cast<DedispersionEvent*>(&e);
-	    }
-            
-	}
-	if (emax && SNRmax >= _snr_threshold) {
-	    // set RA and Dec if necessary
-	    if (_beamRA == "") _set_RA_Dec();
-	    // building trigger message
-	    message = "artemis:%1##ID:%2##cFreqMHz:%3##beamRA:%4##beamDec:%5##eTime:%6##eDM:%7##eSNR:%8";
-	    message = message.arg( _station );
-	    message = message.arg( _idroot.arg( QString::number( ++_message_counter ) , 4 , '0' ) );
-	    message = message.arg( _cfreq_MHz , 10 , '0' );
-	    message = message.arg( _beamRA , 10 , '0' );
-	    message = message.arg( _beamDec , 9 , '0' );
-	    message = message.arg( QString::number(emax->getTime(),'f',9) , 20, '0' );
-	    message = message.arg( QString::number(emax->dm(),'f',3) , 9, '0' );
-	    message = message.arg( QString::number(SNRmax,'f',2) , 6 , '0' );
-	    _send( message );
-            qDebug() << "Trigger sent and log written " << _beamDec;
-	}
+    int best = -1;
+    float SNRmax = 0.0;
+    for( int i = 1; i < events.size(); ++i ) {
+        const DedispersionEvent& e = events[i];
+        float SNR = e.mfValue()/(rms * std::sqrt(e.mfBinning()));
+        if( best < 0 || SNR > SNRmax ) {
+            SNRmax = SNR;
+            best = i;
+        }
+    }
+    if( best < 0 || SNRmax < _snr_threshold ) return false;
+    const DedispersionEvent& emax = events[best];
+
+    // set RA and Dec if necessary
+    if (_beamRA == "") _set_RA_Dec();
+    // building trigger message, local as triggers arrive from several tasks
+    char number[64];
+    QByteArray message;
+    message.reserve( 256 );
+    message.append( "artemis:" );
+    message.append( _station.toAscii() );
+    message.append( "##ID:" );
+    message.append( _idroot );
+    std::snprintf( number, sizeof(number), "%d", _message_counter.fetchAndAddOrdered(1) + 1 );
+    _append( message, number, 4 );
+    message.append( "##cFreqMHz:" );
+    _append( message, _cfreq_MHz, 10 );
+    message.append( "##beamRA:" );
+    _append( message, _beamRA, 10 );
+    message.append( "##beamDec:" );
+    _append( message, _beamDec, 9 );
+    message.append( "##eTime:" );
+    std::snprintf( number, sizeof(number), "%.9f", emax.getTime() );
+    _append( message, number, 20 );
+    message.append( "##eDM:" );
+    std::snprintf( number, sizeof(number), "%.3f", emax.dm() );
+    _append( message, number, 9 );
+    message.append( "##eSNR:" );
+    std::snprintf( number, sizeof(number), "%.2f", SNRmax );
+    _append( message, number, 6 );
+
+    // time since the data holding the end of the candidate arrived
+    double arrival = _arrival( data->data()->getTime( emax.timeBinHigh() ) );
+    double latency = -1.0;
+    if( arrival >= 0.0 ) {
+        latency = ( _now() - arrival ) * 1000.0;
+        std::snprintf( number, sizeof(number), "%.3f", latency );
+        message.append( "##latencyMs:" );
+        message.append( number );
+    }
+    _send( message );
+    {
+        QMutexLocker lock(&_mutex);
+        ++_triggers;
+    }
+    if( latency >= 0.0 ) _recordLatency( latency );
+    return true;
+}
+
+TriggerOutput::Statistics TriggerOutput::statistics() const
+{
+    QMutexLocker lock(&_mutex);
+    Statistics s;
+    s.triggers = _triggers;
+    s.stamped = _stamped;
+    s.minLatency = _minLatency;
+    s.maxLatency = _maxLatency;
+    s.meanLatency = _stamped ? _sumLatency / _stamped : 0.0;
+    return s;
+}
+
+std::vector<unsigned> TriggerOutput::latencyHistogram() const
+{
+    QMutexLocker lock(&_mutex);
+    return _histogram;
+}
+
+void TriggerOutput::report() const
+{
+    Statistics s = statistics();
+    std::vector<unsigned> histogram = latencyHistogram();
+    std::cout << "TriggerOutput: " << s.triggers << " triggers sent";
+    if( s.stamped ) {
+        std::cout << ", latency (ms) min " << s.minLatency << " mean " << s.meanLatency
+                  << " max " << s.maxLatency;
+    }
+    std::cout << std::endl;
+    double limit = 1.0;
+    for( unsigned i = 0; i < histogram.size(); ++i, limit *= 2.0 ) {
+        if( histogram[i] == 0 ) continue;
+        if( i == histogram.size() - 1 )
+            std::cout << "    >= " << limit / 2.0 << " ms: " << histogram[i] << std::endl;
+        else
+            std::cout << "    < " << limit << " ms: " << histogram[i] << std::endl;
     }
 }
   
@@ -187,19 +333,20 @@ void TriggerOutput::_set_RA_Dec(void)
   std::cerr << "No RA/Dec found, conversion not yet implemented";
 }
   
-void TriggerOutput::_send(QString message)
+void TriggerOutput::_send( const QByteArray& message )
 {
+  QMutexLocker lock(&_sendMutex);
   // send out the data to all required devices
-  foreach( QUdpSocket* sock, _sockets.keys() )
+  QMap<QUdpSocket*, QPair<QHostAddress,quint16> >::const_iterator it;
+  for( it = _sockets.constBegin(); it != _sockets.constEnd(); ++it )
     {
-      sock->writeDatagram( message.toAscii() , message.size()*sizeof(char), _sockets[sock].first, _sockets[sock].second );
+      it.key()->writeDatagram( message, it.value().first, it.value().second );
     }
-  std::cout << "Datagram written" << std::endl;
   // log the trigger message
-  message.append("\n");
   foreach( QIODevice* device, _devices )
     {
-      device->write( message.toAscii(), message.size()*sizeof(char) );
+      device->write( message );
+      device->write( "\n", 1 );
     }
 }
   
@@ -0,0 +1,48 @@
+#ifndef AFFINITYTEST_H
+#define AFFINITYTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file AffinityTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class AffinityTest
+ *  
+ * @brief
+ *    Unit test for the Affinity placement
+ * @details
+ * 
+ */
+
+class AffinityTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( AffinityTest );
+        CPPUNIT_TEST( test_configure );
+        CPPUNIT_TEST( test_pin );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_configure();
+        void test_pin();
+
+    public:
+        AffinityTest(  );
+        ~AffinityTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // AFFINITYTEST_H 
@@ -0,0 +1,50 @@
+#ifndef ASYNCOUTPUTSTREAMTEST_H
+#define ASYNCOUTPUTSTREAMTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file AsyncOutputStreamTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class AsyncOutputStreamTest
+ *  
+ * @brief
+ *    Unit test for the AsyncOutputStream
+ * @details
+ * 
+ */
+
+class AsyncOutputStreamTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( AsyncOutputStreamTest );
+        CPPUNIT_TEST( test_order );
+        CPPUNIT_TEST( test_drop );
+        CPPUNIT_TEST( test_uncopyable );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_order();
+        void test_drop();
+        void test_uncopyable();
+
+    public:
+        AsyncOutputStreamTest(  );
+        ~AsyncOutputStreamTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // ASYNCOUTPUTSTREAMTEST_H 
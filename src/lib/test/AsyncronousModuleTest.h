@@ -0,0 +1,48 @@
+#ifndef ASYNCRONOUSMODULETEST_H
+#define ASYNCRONOUSMODULETEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file AsyncronousModuleTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class AsyncronousModuleTest
+ *  
+ * @brief
+ *    Unit test for the AsyncronousModule DataBlob locking
+ * @details
+ * 
+ */
+
+class AsyncronousModuleTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( AsyncronousModuleTest );
+        CPPUNIT_TEST( test_sharedBlob );
+        CPPUNIT_TEST( test_slotsExhausted );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_sharedBlob();
+        void test_slotsExhausted();
+
+    public:
+        AsyncronousModuleTest(  );
+        ~AsyncronousModuleTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // ASYNCRONOUSMODULETEST_H 
@@ -0,0 +1,50 @@
+#ifndef BUFFERINGAGENTTEST_H
+#define BUFFERINGAGENTTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file BufferingAgentTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class BufferingAgentTest
+ *  
+ * @brief
+ *    Unit test for the BufferingAgent
+ * @details
+ * 
+ */
+
+class BufferingAgentTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( BufferingAgentTest );
+        CPPUNIT_TEST( test_order );
+        CPPUNIT_TEST( test_depth );
+        CPPUNIT_TEST( test_stop );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_order();
+        void test_depth();
+        void test_stop();
+
+    public:
+        BufferingAgentTest(  );
+        ~BufferingAgentTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // BUFFERINGAGENTTEST_H 
@@ -0,0 +1,50 @@
+#ifndef CPU_RESOURCETEST_H
+#define CPU_RESOURCETEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file CPU_ResourceTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class CPU_ResourceTest
+ *  
+ * @brief
+ *    Unit test for the CPU_Resource
+ * @details
+ * 
+ */
+
+class CPU_ResourceTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( CPU_ResourceTest );
+        CPPUNIT_TEST( test_parallelFor );
+        CPPUNIT_TEST( test_submit );
+        CPPUNIT_TEST( test_parseCpuList );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_parallelFor();
+        void test_submit();
+        void test_parseCpuList();
+
+    public:
+        CPU_ResourceTest(  );
+        ~CPU_ResourceTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // CPU_RESOURCETEST_H 
@@ -0,0 +1,48 @@
+#ifndef CHUNKCOMPRESSORTEST_H
+#define CHUNKCOMPRESSORTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file ChunkCompressorTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class ChunkCompressorTest
+ *  
+ * @brief
+ *    Unit test for the ChunkCompressor
+ * @details
+ * 
+ */
+
+class ChunkCompressorTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( ChunkCompressorTest );
+        CPPUNIT_TEST( test_shuffle );
+        CPPUNIT_TEST( test_chunks );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_shuffle();
+        void test_chunks();
+
+    public:
+        ChunkCompressorTest(  );
+        ~ChunkCompressorTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // CHUNKCOMPRESSORTEST_H 
@@ -0,0 +1,46 @@
+#ifndef COREBUDGETTEST_H
+#define COREBUDGETTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file CoreBudgetTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class CoreBudgetTest
+ *  
+ * @brief
+ *    Unit test for the CoreBudget
+ * @details
+ * 
+ */
+
+class CoreBudgetTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( CoreBudgetTest );
+        CPPUNIT_TEST( test_share );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_share();
+
+    public:
+        CoreBudgetTest(  );
+        ~CoreBudgetTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // COREBUDGETTEST_H 
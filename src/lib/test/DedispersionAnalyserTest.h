@@ -26,6 +26,7 @@ class DedispersionAnalyserTest : public CppUnit::TestFixture
         CPPUNIT_TEST_SUITE( DedispersionAnalyserTest );
         CPPUNIT_TEST( test_noSignificantEvents );
         CPPUNIT_TEST( test_singleEvent );
+        CPPUNIT_TEST( test_boxcarWidth );
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -35,6 +36,7 @@ class DedispersionAnalyserTest : public CppUnit::TestFixture
         // Test Methods
         void test_singleEvent();
         void test_noSignificantEvents();
+        void test_boxcarWidth();
 
     public:
         DedispersionAnalyserTest(  );
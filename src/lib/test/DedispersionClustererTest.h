@@ -0,0 +1,48 @@
+#ifndef DEDISPERSIONCLUSTERERTEST_H
+#define DEDISPERSIONCLUSTERERTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file DedispersionClustererTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class DedispersionClustererTest
+ *  
+ * @brief
+ *    Unit test for the DedispersionClusterer
+ * @details
+ * 
+ */
+
+class DedispersionClustererTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( DedispersionClustererTest );
+        CPPUNIT_TEST( test_noEvents );
+        CPPUNIT_TEST( test_cluster );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_noEvents();
+        void test_cluster();
+
+    public:
+        DedispersionClustererTest(  );
+        ~DedispersionClustererTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // DEDISPERSIONCLUSTERERTEST_H 
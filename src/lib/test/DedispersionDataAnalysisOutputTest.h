@@ -25,6 +25,7 @@ class DedispersionDataAnalysisOutputTest : public CppUnit::TestFixture
     public:
         CPPUNIT_TEST_SUITE( DedispersionDataAnalysisOutputTest );
         CPPUNIT_TEST( test_method );
+        CPPUNIT_TEST( test_binary );
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -33,6 +34,7 @@ class DedispersionDataAnalysisOutputTest : public CppUnit::TestFixture
 
         // Test Methods
         void test_method();
+        void test_binary();
 
     public:
         DedispersionDataAnalysisOutputTest(  );
@@ -2,6 +2,7 @@
 #define DEDISPERSIONMODULETEST_H
 
 #include <cppunit/extensions/HelperMacros.h>
+#include <vector>
 #include <QString>
 #include "pelican/utility/LockingCircularBuffer.hpp"
 #include "LockingPtrContainer.hpp"
@@ -17,6 +18,7 @@ class DataBlob;
 
 namespace ampp {
 class SpectrumDataSetStokes;
+class WeightedSpectrumDataSet;
 
 /**
  * @class DedispersionModuleTest
@@ -36,6 +38,9 @@ class DedispersionModuleTest : public CppUnit::TestFixture
         CPPUNIT_TEST( test_multipleBlobs );
         CPPUNIT_TEST( test_multipleBuffersPerBlob );
         CPPUNIT_TEST( test_multipleBlobsPerBufferUnaligned );
+        CPPUNIT_TEST( test_quantisedInput );
+        CPPUNIT_TEST( test_hostResource );
+        CPPUNIT_TEST( test_dmLimit );
         //CPPUNIT_TEST( test_dataConsistency ); Overkill!
         CPPUNIT_TEST_SUITE_END();
 
@@ -50,6 +55,9 @@ class DedispersionModuleTest : public CppUnit::TestFixture
         void test_multipleBlobsPerBufferUnaligned();
         void test_multipleBuffersPerBlob();
         void test_dataConsistency();
+        void test_quantisedInput();
+        void test_hostResource();
+        void test_dmLimit();
 
         // utility methods
         void connected( DataBlob* dataOut );
@@ -62,6 +70,11 @@ class DedispersionModuleTest : public CppUnit::TestFixture
 
     protected:
         ConfigNode testConfig( unsigned nBufferSamples ) const;
+        /// dedisperse the data with the given input precision and
+        //  return the dedispersed plane
+        std::vector<float> dedisperseWithPrecision( WeightedSpectrumDataSet* data,
+                               unsigned nSamples, float startFrequency,
+                               float channelBandwidth, unsigned bits );
 
     private:
         int _connectCount;
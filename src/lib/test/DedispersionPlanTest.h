@@ -0,0 +1,48 @@
+#ifndef DEDISPERSIONPLANTEST_H
+#define DEDISPERSIONPLANTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file DedispersionPlanTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class DedispersionPlanTest
+ *  
+ * @brief
+ *    Unit test for the DedispersionPlan
+ * @details
+ * 
+ */
+
+class DedispersionPlanTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( DedispersionPlanTest );
+        CPPUNIT_TEST( test_singleSegment );
+        CPPUNIT_TEST( test_generate );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_singleSegment();
+        void test_generate();
+
+    public:
+        DedispersionPlanTest(  );
+        ~DedispersionPlanTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // DEDISPERSIONPLANTEST_H 
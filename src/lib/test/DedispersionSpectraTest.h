@@ -25,6 +25,9 @@ class DedispersionSpectraTest : public CppUnit::TestFixture
     public:
         CPPUNIT_TEST_SUITE( DedispersionSpectraTest );
         CPPUNIT_TEST( test_dmIndex );
+        CPPUNIT_TEST( test_segments );
+        CPPUNIT_TEST( test_peakSummary );
+        CPPUNIT_TEST( test_dump );
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -33,6 +36,9 @@ class DedispersionSpectraTest : public CppUnit::TestFixture
 
         // Test Methods
         void test_dmIndex();
+        void test_segments();
+        void test_peakSummary();
+        void test_dump();
 
     public:
         DedispersionSpectraTest(  );
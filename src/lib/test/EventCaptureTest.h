@@ -0,0 +1,50 @@
+#ifndef EVENTCAPTURETEST_H
+#define EVENTCAPTURETEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file EventCaptureTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class EventCaptureTest
+ *  
+ * @brief
+ *    Unit test for the EventCapture
+ * @details
+ * 
+ */
+
+class EventCaptureTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( EventCaptureTest );
+        CPPUNIT_TEST( test_window );
+        CPPUNIT_TEST( test_triggers );
+        CPPUNIT_TEST( test_sweep );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_window();
+        void test_triggers();
+        void test_sweep();
+
+    public:
+        EventCaptureTest(  );
+        ~EventCaptureTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // EVENTCAPTURETEST_H 
@@ -0,0 +1,48 @@
+#ifndef FILEROTATIONTEST_H
+#define FILEROTATIONTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file FileRotationTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class FileRotationTest
+ *  
+ * @brief
+ *    Unit test for the FileRotation
+ * @details
+ * 
+ */
+
+class FileRotationTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( FileRotationTest );
+        CPPUNIT_TEST( test_next );
+        CPPUNIT_TEST( test_segments );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_next();
+        void test_segments();
+
+    public:
+        FileRotationTest(  );
+        ~FileRotationTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // FILEROTATIONTEST_H 
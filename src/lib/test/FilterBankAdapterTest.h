@@ -17,6 +17,7 @@ class FilterBankAdapterTest : public CppUnit::TestFixture
     public:
         CPPUNIT_TEST_SUITE( FilterBankAdapterTest );
         CPPUNIT_TEST( test_readFile );
+        CPPUNIT_TEST( test_compressed );
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -25,6 +26,7 @@ class FilterBankAdapterTest : public CppUnit::TestFixture
 
         // Test Methods
         void test_readFile();
+        void test_compressed();
 
     public:
         FilterBankAdapterTest(  );
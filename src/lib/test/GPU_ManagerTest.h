@@ -27,6 +27,7 @@ class GPU_ManagerTest : public CppUnit::TestFixture
         CPPUNIT_TEST( test_submit );
         CPPUNIT_TEST( test_submitMultiCards );
         CPPUNIT_TEST( test_throw );
+        CPPUNIT_TEST( test_priority );
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -37,6 +38,7 @@ class GPU_ManagerTest : public CppUnit::TestFixture
         void test_submit();
         void test_submitMultiCards();
         void test_throw();
+        void test_priority();
 
         // test aids
         void callBackTest();
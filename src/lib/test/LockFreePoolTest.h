@@ -0,0 +1,50 @@
+#ifndef LOCKFREEPOOLTEST_H
+#define LOCKFREEPOOLTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file LockFreePoolTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class LockFreePoolTest
+ *  
+ * @brief
+ *    Unit test for the LockFreePool template class
+ * @details
+ * 
+ */
+
+class LockFreePoolTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( LockFreePoolTest );
+        CPPUNIT_TEST( test_order );
+        CPPUNIT_TEST( test_blocking );
+        CPPUNIT_TEST( test_threads );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_order();
+        void test_blocking();
+        void test_threads();
+
+    public:
+        LockFreePoolTest(  );
+        ~LockFreePoolTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // LOCKFREEPOOLTEST_H 
@@ -0,0 +1,48 @@
+#ifndef OVERLOADMONITORTEST_H
+#define OVERLOADMONITORTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file OverloadMonitorTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class OverloadMonitorTest
+ *  
+ * @brief
+ *    Unit test for the OverloadMonitor
+ * @details
+ * 
+ */
+
+class OverloadMonitorTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( OverloadMonitorTest );
+        CPPUNIT_TEST( test_levels );
+        CPPUNIT_TEST( test_config );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_levels();
+        void test_config();
+
+    public:
+        OverloadMonitorTest(  );
+        ~OverloadMonitorTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // OVERLOADMONITORTEST_H 
@@ -0,0 +1,48 @@
+#ifndef PIPELINESTAGETEST_H
+#define PIPELINESTAGETEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file PipelineStageTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class PipelineStageTest
+ *  
+ * @brief
+ *    Unit test for the PipelineStage and BlockingQueue templates
+ * @details
+ * 
+ */
+
+class PipelineStageTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( PipelineStageTest );
+        CPPUNIT_TEST( test_queue );
+        CPPUNIT_TEST( test_stage );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_queue();
+        void test_stage();
+
+    public:
+        PipelineStageTest(  );
+        ~PipelineStageTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // PIPELINESTAGETEST_H 
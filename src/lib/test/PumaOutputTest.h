@@ -28,6 +28,7 @@ class PumaOutputTest : public CppUnit::TestFixture
     public:
         CPPUNIT_TEST_SUITE( PumaOutputTest );
         CPPUNIT_TEST( test_configuration );
+        CPPUNIT_TEST( test_deadServer );
         CPPUNIT_TEST_SUITE_END();
 
     public:
@@ -36,6 +37,7 @@ class PumaOutputTest : public CppUnit::TestFixture
 
         // Test Methods
         void test_configuration();
+        void test_deadServer();
 
     public:
         PumaOutputTest();
@@ -0,0 +1,50 @@
+#ifndef QUANTISERTEST_H
+#define QUANTISERTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file QuantiserTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class QuantiserTest
+ *  
+ * @brief
+ *    Unit test for the Quantiser
+ * @details
+ * 
+ */
+
+class QuantiserTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( QuantiserTest );
+        CPPUNIT_TEST( test_pack );
+        CPPUNIT_TEST( test_adaptive );
+        CPPUNIT_TEST( test_config );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_pack();
+        void test_adaptive();
+        void test_config();
+
+    public:
+        QuantiserTest(  );
+        ~QuantiserTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // QUANTISERTEST_H 
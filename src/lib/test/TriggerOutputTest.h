@@ -0,0 +1,48 @@
+#ifndef TRIGGEROUTPUTTEST_H
+#define TRIGGEROUTPUTTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/**
+ * @file TriggerOutputTest.h
+ */
+
+namespace pelican {
+
+namespace ampp {
+
+/**
+ * @class TriggerOutputTest
+ *  
+ * @brief
+ *    Unit test for the TriggerOutput
+ * @details
+ * 
+ */
+
+class TriggerOutputTest : public CppUnit::TestFixture
+{
+    public:
+        CPPUNIT_TEST_SUITE( TriggerOutputTest );
+        CPPUNIT_TEST( test_trigger );
+        CPPUNIT_TEST( test_latency );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        // Test Methods
+        void test_trigger();
+        void test_latency();
+
+    public:
+        TriggerOutputTest(  );
+        ~TriggerOutputTest();
+
+    private:
+};
+
+} // namespace ampp
+} // namespace pelican
+#endif // TRIGGEROUTPUTTEST_H 
@@ -0,0 +1,124 @@
+#include "AffinityTest.h"
+#include "Affinity.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QThread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AffinityTest );
+
+namespace {
+// pin a thread of its own so the test runner is not moved
+class PinThread : public QThread {
+    public:
+        PinThread() : pinned(false), cpu(-1) {}
+        bool pinned;
+        int cpu;
+    protected:
+        void run() {
+            pinned = Affinity::instance().pinCurrentThread( Affinity::IO, "AffinityTest" );
+            // a second call for the same role has no further effect
+            pinned = pinned && Affinity::instance().pinCurrentThread( Affinity::IO, "AffinityTest" );
+#ifdef __linux__
+            cpu = sched_getcpu();
+#endif
+        }
+};
+} // namespace
+
+/**
+ *@details AffinityTest 
+ */
+AffinityTest::AffinityTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+AffinityTest::~AffinityTest()
+{
+}
+
+void AffinityTest::setUp()
+{
+}
+
+void AffinityTest::tearDown()
+{
+}
+
+void AffinityTest::test_configure()
+{
+    Affinity& affinity = Affinity::instance();
+    QList<int> capture = affinity.cores( Affinity::Capture );
+    int captureNode = affinity.node( Affinity::Capture );
+    {
+        // Use Case:
+        // core lists and nodes for some of the roles
+        // Expect:
+        // those roles set, the others unchanged
+        ConfigNode config;
+        config.setFromString( "<DedispersionPipeline><Affinity capture=\"0-2,5\" captureNode=\"1\"/></DedispersionPipeline>" );
+        affinity.configure( config );
+        QList<int> expected;
+        expected << 0 << 1 << 2 << 5;
+        CPPUNIT_ASSERT( expected == affinity.cores( Affinity::Capture ) );
+        CPPUNIT_ASSERT_EQUAL( 1, affinity.node( Affinity::Capture ) );
+    }
+    try {
+        // Use Case:
+        // bad core list
+        // Expect:
+        // throw
+        ConfigNode config;
+        config.setFromString( "<DedispersionPipeline><Affinity compute=\"4-2\"/></DedispersionPipeline>" );
+        affinity.configure( config );
+        CPPUNIT_FAIL( "expecting an exception" );
+    }
+    catch( const QString& ) {}
+    affinity.setCores( Affinity::Capture, capture, captureNode );
+}
+
+void AffinityTest::test_pin()
+{
+    Affinity& affinity = Affinity::instance();
+    QList<int> io = affinity.cores( Affinity::IO );
+    int ioNode = affinity.node( Affinity::IO );
+    {
+        // Use Case:
+        // role with no cores
+        // Expect:
+        // thread not pinned
+        affinity.setCores( Affinity::IO, QList<int>() );
+        PinThread thread;
+        thread.start();
+        thread.wait();
+        CPPUNIT_ASSERT( ! thread.pinned );
+    }
+#ifdef __linux__
+    {
+        // Use Case:
+        // role on a single core
+        // Expect:
+        // thread runs on that core
+        affinity.setCores( Affinity::IO, QList<int>() << 0 );
+        PinThread thread;
+        thread.start();
+        thread.wait();
+        CPPUNIT_ASSERT( thread.pinned );
+        CPPUNIT_ASSERT_EQUAL( 0, thread.cpu );
+    }
+#endif
+    affinity.setCores( Affinity::IO, io, ioNode );
+}
+
+} // namespace ampp
+} // namespace pelican
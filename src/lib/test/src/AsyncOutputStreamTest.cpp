@@ -0,0 +1,146 @@
+#include "AsyncOutputStreamTest.h"
+#include "AsyncOutputStream.h"
+#include "SpectrumDataSet.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QList>
+#include <unistd.h>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AsyncOutputStreamTest );
+
+namespace {
+// records the first value of each blob, slowly if asked
+class TestWriter : public AbstractOutputStream {
+    public:
+        TestWriter( const ConfigNode& config, unsigned long delay )
+            : AbstractOutputStream(config), _delay(delay) {}
+        QList<float> values() const { QMutexLocker lock(&_mutex); return _values; }
+    protected:
+        void sendStream( const QString&, const DataBlob* blob ) {
+            if( _delay ) ::usleep( _delay );
+            float value = -1.0;
+            if( blob->type() == "SpectrumDataSetStokes" )
+                value = static_cast<const SpectrumDataSetStokes*>(blob)->data()[0];
+            QMutexLocker lock(&_mutex);
+            _values.append( value );
+        }
+    private:
+        unsigned long _delay;
+        mutable QMutex _mutex;
+        QList<float> _values;
+};
+
+ConfigNode asyncConfig( const QString& options )
+{
+    ConfigNode config;
+    config.setFromString( "<AsyncTestWriter><asyncOutput " + options + "/></AsyncTestWriter>" );
+    return config;
+}
+} // namespace
+
+/**
+ *@details AsyncOutputStreamTest 
+ */
+AsyncOutputStreamTest::AsyncOutputStreamTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+AsyncOutputStreamTest::~AsyncOutputStreamTest()
+{
+}
+
+void AsyncOutputStreamTest::setUp()
+{
+}
+
+void AsyncOutputStreamTest::tearDown()
+{
+}
+
+void AsyncOutputStreamTest::test_order()
+{
+    // Use Case:
+    // blobs sent faster than a slow writer with the block policy,
+    // the blob reused by the caller straight after each send
+    // Expect:
+    // every blob written, in order, with the value it had when sent
+    ConfigNode config = asyncConfig( "depth=\"2\" policy=\"block\"" );
+    TestWriter* writer = new TestWriter( config, 2000 );
+    AsyncOutputStream stream( config, writer );
+    SpectrumDataSetStokes blob;
+    blob.resize( 1, 1, 1, 4 );
+    for( int i = 0; i < 20; ++i ) {
+        blob.data()[0] = i;
+        stream.send( "data", &blob );
+    }
+    stream.flush();
+    QList<float> values = writer->values();
+    CPPUNIT_ASSERT_EQUAL( 20, values.size() );
+    for( int i = 0; i < 20; ++i ) {
+        CPPUNIT_ASSERT_EQUAL( (float)i, values[i] );
+    }
+    AsyncOutputStream::Statistics s = stream.statistics();
+    CPPUNIT_ASSERT_EQUAL( 20U, s.written );
+    CPPUNIT_ASSERT_EQUAL( 0U, s.dropped );
+    CPPUNIT_ASSERT( s.maxDepth <= 2 );
+    CPPUNIT_ASSERT( s.meanWrite > 0.0 );
+}
+
+void AsyncOutputStreamTest::test_drop()
+{
+    // Use Case:
+    // blobs sent faster than a slow writer with the drop policy
+    // Expect:
+    // some blobs dropped, the rest written in order
+    ConfigNode config = asyncConfig( "depth=\"1\" policy=\"drop\"" );
+    TestWriter* writer = new TestWriter( config, 20000 );
+    AsyncOutputStream stream( config, writer );
+    SpectrumDataSetStokes blob;
+    blob.resize( 1, 1, 1, 4 );
+    for( int i = 0; i < 10; ++i ) {
+        blob.data()[0] = i;
+        stream.send( "data", &blob );
+    }
+    stream.flush();
+    AsyncOutputStream::Statistics s = stream.statistics();
+    CPPUNIT_ASSERT( s.dropped > 0 );
+    CPPUNIT_ASSERT_EQUAL( 10U, s.dropped + s.written );
+    QList<float> values = writer->values();
+    for( int i = 1; i < values.size(); ++i ) {
+        CPPUNIT_ASSERT( values[i] > values[i - 1] );
+    }
+}
+
+void AsyncOutputStreamTest::test_uncopyable()
+{
+    // Use Case:
+    // a blob type that cannot be copied, after queued blobs
+    // Expect:
+    // written on the calling thread, after the queued blobs
+    ConfigNode config = asyncConfig( "depth=\"4\"" );
+    TestWriter* writer = new TestWriter( config, 1000 );
+    AsyncOutputStream stream( config, writer );
+    SpectrumDataSetStokes blob;
+    blob.resize( 1, 1, 1, 4 );
+    blob.data()[0] = 1.0;
+    stream.send( "data", &blob );
+    stream.send( "data", &blob );
+    DataBlob other( "UnknownBlob" );
+    stream.send( "data", &other );
+    QList<float> values = writer->values();
+    CPPUNIT_ASSERT_EQUAL( 3, values.size() );
+    CPPUNIT_ASSERT_EQUAL( -1.0f, values[2] );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,109 @@
+#include "AsyncronousModuleTest.h"
+#include "AsyncronousModule.h"
+#include "SpectrumDataSet.h"
+#include "pelican/utility/ConfigNode.h"
+#include <boost/bind.hpp>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AsyncronousModuleTest );
+
+namespace {
+// a module that holds a lock on a blob until told to release it
+class HoldingModule : public AsyncronousModule {
+    public:
+        HoldingModule() : AsyncronousModule( ConfigNode() ) {
+            unlockCallback( boost::bind( &HoldingModule::unlocked, this, _1 ) );
+        }
+        void hold( DataBlob* d ) { lock( d ); }
+        void release( DataBlob* d ) { exportCancel( d ); }
+        QList<DataBlob*> freed;
+
+    protected:
+        void exportComplete( DataBlob* d ) { unlock( d ); }
+        void unlocked( const QList<DataBlob*>& data ) { freed << data; }
+};
+} // namespace
+
+/**
+ *@details AsyncronousModuleTest 
+ */
+AsyncronousModuleTest::AsyncronousModuleTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+AsyncronousModuleTest::~AsyncronousModuleTest()
+{
+}
+
+void AsyncronousModuleTest::setUp()
+{
+}
+
+void AsyncronousModuleTest::tearDown()
+{
+}
+
+void AsyncronousModuleTest::test_sharedBlob()
+{
+    // Use Case:
+    // Two modules lock the same counted blob and release it in turn
+    // Expect:
+    // Each module sees only its own lock and reports the blob
+    // when it releases it
+    SpectrumDataSetStokes blob;
+    HoldingModule first;
+    HoldingModule second;
+    first.hold( &blob );
+    second.hold( &blob );
+    CPPUNIT_ASSERT_EQUAL( 1, first.lockNumber( &blob ) );
+    CPPUNIT_ASSERT_EQUAL( 1, second.lockNumber( &blob ) );
+
+    second.release( &blob );
+    CPPUNIT_ASSERT_EQUAL( 0, second.lockNumber( &blob ) );
+    CPPUNIT_ASSERT_EQUAL( 1, second.freed.size() );
+    CPPUNIT_ASSERT( second.freed[0] == &blob );
+    CPPUNIT_ASSERT_EQUAL( 1, first.lockNumber( &blob ) );
+    CPPUNIT_ASSERT_EQUAL( 0, first.freed.size() );
+
+    first.release( &blob );
+    CPPUNIT_ASSERT_EQUAL( 1, first.freed.size() );
+    CPPUNIT_ASSERT( first.freed[0] == &blob );
+}
+
+void AsyncronousModuleTest::test_slotsExhausted()
+{
+    // Use Case:
+    // More modules than the blob has lock count slots
+    // Expect:
+    // The extra module falls back to its lock table and still
+    // counts and reports its own locks
+    SpectrumDataSetStokes blob;
+    QList<HoldingModule*> modules;
+    for( int i = 0; i <= DataBlobLockCounter::Slots; ++i ) {
+        modules.append( new HoldingModule );
+        modules[i]->hold( &blob );
+    }
+    foreach( HoldingModule* module, modules ) {
+        CPPUNIT_ASSERT_EQUAL( 1, module->lockNumber( &blob ) );
+    }
+    HoldingModule* extra = modules.last();
+    extra->release( &blob );
+    CPPUNIT_ASSERT_EQUAL( 1, extra->freed.size() );
+    CPPUNIT_ASSERT_EQUAL( 1, modules[0]->lockNumber( &blob ) );
+    foreach( HoldingModule* module, modules ) {
+        if( module != extra ) module->release( &blob );
+        CPPUNIT_ASSERT_EQUAL( 1, module->freed.size() );
+        delete module;
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
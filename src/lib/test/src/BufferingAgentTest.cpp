@@ -0,0 +1,113 @@
+#include "BufferingAgentTest.h"
+#include "BufferingAgent.h"
+#include <QAtomicInt>
+#include <QTime>
+#include <boost/bind.hpp>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( BufferingAgentTest );
+
+namespace {
+// label each hash with the order in which it was fetched
+void fetch( QAtomicInt* count, BufferingAgent::DataBlobHash& hash ) {
+    hash.clear();
+    hash.insert( QString::number( count->fetchAndAddOrdered(1) ), 0 );
+}
+
+// wait up to a second for the counter to reach the value
+bool waitFor( QAtomicInt* count, int value ) {
+    QTime timer;
+    timer.start();
+    while( (int)*count < value ) {
+        if( timer.elapsed() > 1000 ) return false;
+        QThread::yieldCurrentThread();
+    }
+    return true;
+}
+} // namespace
+
+/**
+ *@details BufferingAgentTest 
+ */
+BufferingAgentTest::BufferingAgentTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+BufferingAgentTest::~BufferingAgentTest()
+{
+}
+
+void BufferingAgentTest::setUp()
+{
+}
+
+void BufferingAgentTest::tearDown()
+{
+}
+
+void BufferingAgentTest::test_order()
+{
+    // Use Case:
+    // read more objects than the queue length
+    // Expect:
+    // objects served in the order they were fetched
+    QAtomicInt count(0);
+    BufferingAgent agent( boost::bind( &fetch, &count, _1 ), 2 );
+    agent.start();
+    for( int i = 0; i < 10; ++i ) {
+        BufferingAgent::DataBlobHash hash;
+        agent.getData( hash );
+        CPPUNIT_ASSERT_EQUAL( 1, hash.size() );
+        CPPUNIT_ASSERT( hash.contains( QString::number(i) ) );
+    }
+    BufferingAgent::Statistics stats = agent.statistics();
+    CPPUNIT_ASSERT_EQUAL( 10U, stats.fetches );
+    CPPUNIT_ASSERT( stats.maxOccupancy <= 2 );
+}
+
+void BufferingAgentTest::test_depth()
+{
+    // Use Case:
+    // nothing is read from the agent
+    // Expect:
+    // the agent fetches queueLength objects ahead and then waits
+    // for one to be read
+    QAtomicInt count(0);
+    BufferingAgent agent( boost::bind( &fetch, &count, _1 ), 3 );
+    CPPUNIT_ASSERT_EQUAL( 3U, agent.queueLength() );
+    agent.start();
+    CPPUNIT_ASSERT( waitFor( &count, 3 ) );
+    QThread::yieldCurrentThread();
+    CPPUNIT_ASSERT_EQUAL( 3, (int)count );
+    BufferingAgent::DataBlobHash hash;
+    agent.getData( hash );
+    CPPUNIT_ASSERT( waitFor( &count, 4 ) );
+}
+
+void BufferingAgentTest::test_stop()
+{
+    // Use Case:
+    // read from an agent that has been stopped
+    // Expect:
+    // getData returns without blocking, the hash unchanged
+    QAtomicInt count(0);
+    BufferingAgent agent( boost::bind( &fetch, &count, _1 ), 1 );
+    agent.stop();
+    agent.start();
+    CPPUNIT_ASSERT( agent.wait( 1000 ) );
+    BufferingAgent::DataBlobHash hash;
+    agent.getData( hash );
+    CPPUNIT_ASSERT_EQUAL( 0, hash.size() );
+    CPPUNIT_ASSERT_EQUAL( 0U, agent.statistics().fetches );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,125 @@
+#include "CPU_ResourceTest.h"
+#include "CPU_Resource.h"
+#include "GPU_Manager.h"
+#include "GPU_Job.h"
+#include "GPU_Kernel.h"
+#include <boost/bind.hpp>
+#include <vector>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CPU_ResourceTest );
+
+namespace {
+void fill( std::vector<int>* data, std::vector<unsigned>* workers, int i, unsigned worker ) {
+    (*data)[i] = i + 1;
+    (*workers)[i] = worker;
+}
+
+// a kernel that can only run on a card
+class DeviceKernel : public GPU_Kernel {
+    public:
+        void run( GPU_NVidia& ) {}
+};
+
+// a kernel with a host implementation
+class HostKernel : public GPU_Kernel {
+    public:
+        HostKernel( int n ) : data(n, 0), workers(n) {}
+        void run( GPU_NVidia& ) {}
+        bool hasHostImplementation() const { return true; }
+        void runOnHost( CPU_Resource& cpu ) {
+            cpu.parallelFor( data.size(), boost::bind( &fill, &data, &workers, _1, _2 ) );
+        }
+        std::vector<int> data;
+        std::vector<unsigned> workers;
+};
+} // namespace
+
+/**
+ *@details CPU_ResourceTest 
+ */
+CPU_ResourceTest::CPU_ResourceTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+CPU_ResourceTest::~CPU_ResourceTest()
+{
+}
+
+void CPU_ResourceTest::setUp()
+{
+}
+
+void CPU_ResourceTest::tearDown()
+{
+}
+
+void CPU_ResourceTest::test_parallelFor()
+{
+    // Use Case:
+    // parallelFor over more items than workers, called repeatedly
+    // Expect:
+    // every item processed once each time, by a valid worker
+    CPU_Resource cpu( 4 );
+    CPPUNIT_ASSERT_EQUAL( 4U, cpu.threads() );
+    for( int repeat = 0; repeat < 10; ++repeat ) {
+        std::vector<int> data( 1000, 0 );
+        std::vector<unsigned> workers( 1000 );
+        cpu.parallelFor( data.size(), boost::bind( &fill, &data, &workers, _1, _2 ) );
+        for( int i = 0; i < (int)data.size(); ++i ) {
+            CPPUNIT_ASSERT_EQUAL( i + 1, data[i] );
+            CPPUNIT_ASSERT( workers[i] < 4 );
+        }
+    }
+}
+
+void CPU_ResourceTest::test_submit()
+{
+    // Use Case:
+    // A manager with only a host resource, a job with a host
+    // implementation and a job that can only run on a card
+    // Expect:
+    // the host job to be run, the card job to be left on the queue
+    GPU_Manager m;
+    m.addResource( new CPU_Resource( 2 ) );
+    DeviceKernel deviceKernel;
+    GPU_Job deviceJob;
+    deviceJob.addKernel( &deviceKernel );
+    m.submit( &deviceJob );
+
+    HostKernel hostKernel( 100 );
+    GPU_Job hostJob;
+    hostJob.addKernel( &hostKernel );
+    m.submit( &hostJob );
+    hostJob.wait();
+    CPPUNIT_ASSERT_EQUAL( GPU_Job::Finished, hostJob.status() );
+    CPPUNIT_ASSERT_EQUAL( 100, hostKernel.data[99] );
+    CPPUNIT_ASSERT_EQUAL( GPU_Job::Queued, deviceJob.status() );
+    CPPUNIT_ASSERT_EQUAL( 1, m.jobsQueued() );
+}
+
+void CPU_ResourceTest::test_parseCpuList()
+{
+    // Use Case:
+    // cpu lists with ranges and single cpus
+    // Expect:
+    // each cpu listed in order, bad lists to throw
+    QList<int> cpus = CPU_Resource::parseCpuList( "0-2, 5,7-8" );
+    CPPUNIT_ASSERT_EQUAL( 6, cpus.size() );
+    CPPUNIT_ASSERT_EQUAL( 2, cpus[2] );
+    CPPUNIT_ASSERT_EQUAL( 5, cpus[3] );
+    CPPUNIT_ASSERT_EQUAL( 8, cpus[5] );
+    CPPUNIT_ASSERT( CPU_Resource::parseCpuList( "" ).isEmpty() );
+    CPPUNIT_ASSERT_THROW( CPU_Resource::parseCpuList( "3-1" ), QString );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,203 @@
+#include "ChunkCompressorTest.h"
+#include "ChunkCompressor.h"
+#include "pelican/utility/ConfigNode.h"
+#include "pelican/utility/test/TestFile.h"
+#include <QFile>
+#include <fstream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ChunkCompressorTest );
+
+namespace {
+
+ConfigNode compressionConfig( const QString& attributes )
+{
+    ConfigNode config;
+    config.setFromString( QString( "<Writer><compression active=\"true\" %1/></Writer>" )
+                                   .arg(attributes) );
+    return config;
+}
+
+} // namespace
+
+/**
+ *@details ChunkCompressorTest
+ */
+ChunkCompressorTest::ChunkCompressorTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+ChunkCompressorTest::~ChunkCompressorTest()
+{
+}
+
+void ChunkCompressorTest::setUp()
+{
+}
+
+void ChunkCompressorTest::tearDown()
+{
+}
+
+void ChunkCompressorTest::test_shuffle()
+{
+    {
+        // Use Case:
+        // 16 one byte elements, alternately 0 and 1
+        // Expect:
+        // the lowest bit plane set in every other position, the rest clear
+        char in[16], out[16];
+        for( int i = 0; i < 16; ++i ) in[i] = i % 2;
+        ChunkCompressor::shuffle( in, out, 16, 1 );
+        CPPUNIT_ASSERT_EQUAL( 0xAA, (int)(unsigned char)out[0] );
+        CPPUNIT_ASSERT_EQUAL( 0xAA, (int)(unsigned char)out[1] );
+        for( int i = 2; i < 16; ++i ) CPPUNIT_ASSERT_EQUAL( 0, (int)out[i] );
+    }
+    {
+        // Use Case:
+        // random data of each element size, including sizes that leave
+        // a partial group at the end
+        // Expect:
+        // unshuffle restores the data
+        unsigned sizes[] = { 1, 2, 4, 8 };
+        size_t lengths[] = { 0, 5, 64, 100, 4099 };
+        std::srand( 1 );
+        for( int s = 0; s < 4; ++s ) {
+            for( int l = 0; l < 5; ++l ) {
+                size_t n = lengths[l];
+                std::vector<char> in( n + 1 ), shuffled( n + 1 ), out( n + 1 );
+                for( size_t i = 0; i < n; ++i ) in[i] = (char)std::rand();
+                ChunkCompressor::shuffle( &in[0], &shuffled[0], n, sizes[s] );
+                ChunkCompressor::unshuffle( &shuffled[0], &out[0], n, sizes[s] );
+                CPPUNIT_ASSERT( std::memcmp( &in[0], &out[0], n ) == 0 );
+            }
+        }
+    }
+}
+
+void ChunkCompressorTest::test_chunks()
+{
+    // slowly varying floats, as in a filterbank, in 3.5 chunks of 4096
+    // bytes, compressed two at a time
+    std::vector<float> data( 3584 );
+    for( size_t i = 0; i < data.size(); ++i ) data[i] = 100.0f + ( i / 64 ) % 7;
+    const char* raw = reinterpret_cast<const char*>(&data[0]);
+    size_t size = data.size() * sizeof(float);
+
+    {
+        // Use Case:
+        // compression not configured
+        // Expect:
+        // inactive
+        ConfigNode config;
+        ChunkCompressor compressor( config );
+        CPPUNIT_ASSERT( ! compressor.active() );
+    }
+
+    test::TestFile file(true);
+    {
+        std::ofstream out( file.filename().toUtf8().data(), std::ios::out | std::ios::binary );
+        out.write( "header", 6 );
+        ChunkCompressor compressor( compressionConfig( "chunkSize=\"4096\" threads=\"2\"" ) );
+        CPPUNIT_ASSERT( compressor.active() );
+        compressor.start( out );
+        // in pieces that do not line up with the chunks
+        for( size_t done = 0; done < size; done += 1000 ) {
+            compressor.write( raw + done, std::min( (size_t)1000, size - done ) );
+        }
+        compressor.finish();
+        ChunkCompressor::Statistics s = compressor.statistics();
+        CPPUNIT_ASSERT_EQUAL( 4UL, s.chunks );
+        CPPUNIT_ASSERT_EQUAL( (double)size, s.rawBytes );
+        CPPUNIT_ASSERT( s.compressedBytes < s.rawBytes / 4 );
+    }
+
+    QFile in( file.filename() );
+    CPPUNIT_ASSERT( in.open( QIODevice::ReadOnly ) );
+    {
+        // Use Case:
+        // read the index
+        // Expect:
+        // one entry per chunk, contiguous in the file and the data, with
+        // the ratio of each
+        QList<ChunkCompressor::IndexEntry> index = ChunkCompressor::readIndex( &in );
+        CPPUNIT_ASSERT_EQUAL( 4, index.size() );
+        CPPUNIT_ASSERT_EQUAL( (quint64)6, index[0].offset );
+        for( int i = 0; i < 4; ++i ) {
+            CPPUNIT_ASSERT_EQUAL( (quint64)( i * 4096 ), index[i].rawOffset );
+            CPPUNIT_ASSERT_EQUAL( i < 3 ? 4096U : 2048U, (unsigned)index[i].rawSize );
+            CPPUNIT_ASSERT( index[i].ratio > 1.0 );
+            CPPUNIT_ASSERT( index[i].cpu >= 0.0 );
+            if( i ) CPPUNIT_ASSERT_EQUAL( index[i - 1].offset + 24 + index[i - 1].compressedSize,
+                                          index[i].offset );
+        }
+
+        // Use Case:
+        // seek to a chunk through the index
+        // Expect:
+        // its data
+        CPPUNIT_ASSERT( in.seek( index[2].offset ) );
+        QByteArray chunk = ChunkCompressor::readChunk( &in );
+        CPPUNIT_ASSERT_EQUAL( 4096, chunk.size() );
+        CPPUNIT_ASSERT( std::memcmp( chunk.constData(), raw + 2 * 4096, 4096 ) == 0 );
+    }
+    {
+        // Use Case:
+        // read the chunks in turn from the start of the data
+        // Expect:
+        // the data as written, then an empty chunk at the index
+        CPPUNIT_ASSERT( in.seek( 6 ) );
+        CPPUNIT_ASSERT( ChunkCompressor::isCompressed( &in ) );
+        QByteArray all;
+        QByteArray chunk;
+        while( ! ( chunk = ChunkCompressor::readChunk( &in ) ).isEmpty() ) all.append( chunk );
+        CPPUNIT_ASSERT_EQUAL( (int)size, all.size() );
+        CPPUNIT_ASSERT( std::memcmp( all.constData(), raw, size ) == 0 );
+        CPPUNIT_ASSERT( ChunkCompressor::isCompressed( &in ) );
+    }
+    {
+        // Use Case:
+        // a file without an index
+        // Expect:
+        // throw
+        CPPUNIT_ASSERT( in.seek( 0 ) );
+        CPPUNIT_ASSERT( ! ChunkCompressor::isCompressed( &in ) );
+        test::TestFile plain(true);
+        QFile p( plain.filename() );
+        p.open( QIODevice::WriteOnly );
+        p.write( raw, size );
+        p.close();
+        p.open( QIODevice::ReadOnly );
+        CPPUNIT_ASSERT_THROW( ChunkCompressor::readIndex( &p ), QString );
+    }
+    {
+        // Use Case:
+        // plain data that happens to start with the first bytes of the
+        // chunk marker
+        // Expect:
+        // not taken for compressed data
+        test::TestFile plain(true);
+        QFile p( plain.filename() );
+        p.open( QIODevice::WriteOnly );
+        p.write( "AMPZ", 4 );
+        p.write( raw, size );
+        p.close();
+        p.open( QIODevice::ReadOnly );
+        CPPUNIT_ASSERT( ! ChunkCompressor::isCompressed( &p ) );
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,71 @@
+#include "CoreBudgetTest.h"
+#include "CoreBudget.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QThreadPool>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CoreBudgetTest );
+/**
+ *@details CoreBudgetTest 
+ */
+CoreBudgetTest::CoreBudgetTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+CoreBudgetTest::~CoreBudgetTest()
+{
+}
+
+void CoreBudgetTest::setUp()
+{
+}
+
+void CoreBudgetTest::tearDown()
+{
+}
+
+void CoreBudgetTest::test_share()
+{
+    // Use Case:
+    // budgets of cores shared between streams
+    // Expect:
+    // module thread counts capped at the per stream share,
+    // at least one thread per stream
+    CoreBudget& budget = CoreBudget::instance();
+    unsigned cores = budget.cores();
+    unsigned streams = budget.streams();
+    {
+        ConfigNode config;
+        config.setFromString( "<DedispersionPipeline><coreBudget cores=\"8\" streams=\"2\"/></DedispersionPipeline>" );
+        budget.configure( config );
+        CPPUNIT_ASSERT_EQUAL( 8U, budget.cores() );
+        CPPUNIT_ASSERT_EQUAL( 2U, budget.streams() );
+        CPPUNIT_ASSERT_EQUAL( 4U, budget.share() );
+        CPPUNIT_ASSERT_EQUAL( 4U, budget.threads() );
+        CPPUNIT_ASSERT_EQUAL( 4U, budget.threads(6) );
+        CPPUNIT_ASSERT_EQUAL( 2U, budget.threads(2) );
+        CPPUNIT_ASSERT( budget.pool()->maxThreadCount() <= 8 );
+    }
+    {
+        budget.configure( 3, 4 );
+        CPPUNIT_ASSERT_EQUAL( 1U, budget.share() );
+        CPPUNIT_ASSERT_EQUAL( 1U, budget.threads(4) );
+    }
+    try {
+        budget.configure( 0, 1 );
+        CPPUNIT_FAIL( "expecting an exception" );
+    }
+    catch( const QString& ) {}
+    budget.configure( cores, streams );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -3,6 +3,7 @@
 #include "DedispersionDataAnalysis.h"
 #include "DedispersionDataGenerator.h"
 #include "DedispersionSpectra.h"
+#include "SpectrumDataSet.h"
 
 
 namespace pelican {
@@ -76,5 +77,62 @@ void DedispersionAnalyserTest::test_singleEvent()
     }
 }
 
+void DedispersionAnalyserTest::test_boxcarWidth()
+{
+    // Use Case:
+    // A pulse three samples wide, searched with a width 3 boxcar
+    // Expect:
+    // a single event (plus the timestamp marker) at the start of the pulse
+    try {
+        SpectrumDataSetStokes stokes;
+        stokes.resize( 1, 1, 1, 1 ); // rms = 1
+        QList<SpectrumDataSetStokes*> blobs;
+        blobs.append( &stokes );
+
+        DedispersionSpectra inputData;
+        inputData.resize( 64, 2, 0.0, 1.0 );
+        inputData.setInputDataBlobs( blobs );
+        for( int t = 10; t < 13; ++t ) {
+            inputData.dmTrial(1)[t] = 5.0;
+        }
+
+        ConfigNode config;
+        config.setFromString( "<DedispersionAnalyser>\n"
+                              "<detectionThreshold in_sigma=\"6.0\" />\n"
+                              "<boxcarWidths value=\"1,3\" />\n"
+                              "</DedispersionAnalyser>" );
+        DedispersionAnalyser analyser(config);
+        CPPUNIT_ASSERT_EQUAL( 2, analyser.boxcarWidths().size() );
+        DedispersionDataAnalysis outputData;
+        CPPUNIT_ASSERT_EQUAL( 2, analyser.analyse( &inputData, &outputData ) );
+        const DedispersionEvent& e = outputData.events()[1];
+        CPPUNIT_ASSERT_EQUAL( 10U, e.timeBin() );
+        CPPUNIT_ASSERT_EQUAL( 3.0f, e.mfBinning() );
+        CPPUNIT_ASSERT_EQUAL( 15.0f, e.mfValue() );
+
+        // Use Case:
+        // two neighbouring samples above threshold in a width 1 boxcar
+        // Expect:
+        // an event for each, left for the clusterer to merge
+        DedispersionSpectra neighbours;
+        neighbours.resize( 64, 2, 0.0, 1.0 );
+        neighbours.setInputDataBlobs( blobs );
+        neighbours.dmTrial(0)[20] = 7.0;
+        neighbours.dmTrial(0)[21] = 8.0;
+        ConfigNode single;
+        single.setFromString( "<DedispersionAnalyser>\n"
+                              "<detectionThreshold in_sigma=\"6.0\" />\n"
+                              "<boxcarWidths value=\"1\" />\n"
+                              "</DedispersionAnalyser>" );
+        DedispersionAnalyser singleAnalyser(single);
+        DedispersionDataAnalysis neighbourData;
+        CPPUNIT_ASSERT_EQUAL( 3, singleAnalyser.analyse( &neighbours, &neighbourData ) );
+        CPPUNIT_ASSERT_EQUAL( 20U, neighbourData.events()[1].timeBin() );
+        CPPUNIT_ASSERT_EQUAL( 21U, neighbourData.events()[2].timeBin() );
+    } catch ( const QString& e ) {
+        CPPUNIT_FAIL( "THROW: " + e.toStdString() );
+    }
+}
+
 } // namespace ampp
 } // namespace pelican
@@ -0,0 +1,98 @@
+#include "DedispersionClustererTest.h"
+#include "DedispersionClusterer.h"
+#include "DedispersionDataAnalysis.h"
+#include "DedispersionSpectra.h"
+#include "pelican/utility/ConfigNode.h"
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( DedispersionClustererTest );
+/**
+ *@details DedispersionClustererTest 
+ */
+DedispersionClustererTest::DedispersionClustererTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+DedispersionClustererTest::~DedispersionClustererTest()
+{
+}
+
+void DedispersionClustererTest::setUp()
+{
+}
+
+void DedispersionClustererTest::tearDown()
+{
+}
+
+void DedispersionClustererTest::test_noEvents()
+{
+    // Use Case:
+    // Only the timestamp marker event
+    // Expect:
+    // no candidates, marker passed through
+    DedispersionSpectra spectra;
+    spectra.resize( 64, 10, 0.0, 1.0 );
+    DedispersionDataAnalysis events;
+    events.reset( &spectra );
+    events.addEvent( 0, 0, 1, 0.0 );
+
+    ConfigNode config;
+    DedispersionClusterer clusterer( config );
+    DedispersionDataAnalysis candidates;
+    CPPUNIT_ASSERT_EQUAL( 0, clusterer.cluster( &events, &candidates ) );
+    CPPUNIT_ASSERT_EQUAL( 1, candidates.eventsFound() );
+}
+
+void DedispersionClustererTest::test_cluster()
+{
+    // Use Case:
+    // Three linked events, one event close in time but far in DM,
+    // and one far in time
+    // Expect:
+    // three candidates in time order, the first carrying the peak
+    // and extent of its three members
+    DedispersionSpectra spectra;
+    spectra.resize( 64, 10, 0.0, 1.0 );
+    DedispersionDataAnalysis events;
+    events.reset( &spectra );
+    events.setRMS( 1.0 );
+    events.addEvent( 0, 0, 1, 0.0 );
+    events.addEvent( 3, 10, 1, 5.0 );
+    events.addEvent( 4, 11, 2, 9.0 );
+    events.addEvent( 4, 40, 1, 7.0 );
+    events.addEvent( 5, 12, 1, 6.0 );
+    events.addEvent( 9, 11, 1, 6.0 );
+
+    ConfigNode config;
+    DedispersionClusterer clusterer( config );
+    DedispersionDataAnalysis candidates;
+    CPPUNIT_ASSERT_EQUAL( 3, clusterer.cluster( &events, &candidates ) );
+    CPPUNIT_ASSERT_EQUAL( 4, candidates.eventsFound() );
+    CPPUNIT_ASSERT_EQUAL( 1.0f, candidates.getRMS() );
+
+    const DedispersionEvent& a = candidates.events()[1];
+    CPPUNIT_ASSERT_EQUAL( 3U, a.members() );
+    CPPUNIT_ASSERT_EQUAL( 11U, a.timeBin() );
+    CPPUNIT_ASSERT_EQUAL( 9.0f, a.mfValue() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 4.0, a.dm(), 0.0001 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 3.0, a.dmLow(), 0.0001 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 5.0, a.dmHigh(), 0.0001 );
+    CPPUNIT_ASSERT_EQUAL( 10U, a.timeBinLow() );
+    CPPUNIT_ASSERT_EQUAL( 13U, a.timeBinHigh() );
+
+    CPPUNIT_ASSERT_EQUAL( 1U, candidates.events()[2].members() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 9.0, candidates.events()[2].dm(), 0.0001 );
+    CPPUNIT_ASSERT_EQUAL( 40U, candidates.events()[3].timeBin() );
+}
+
+} // namespace ampp
+} // namespace pelican
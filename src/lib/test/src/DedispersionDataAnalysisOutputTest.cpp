@@ -1,11 +1,13 @@
 #include "DedispersionDataAnalysisOutputTest.h"
 #include "DedispersionDataAnalysisOutput.h"
 #include "DedispersionDataAnalysis.h"
+#include "CandidateFile.h"
 #include "DedispersionSpectra.h"
 #include "SpectrumDataSet.h"
 #include "pelican/utility/ConfigNode.h"
 #include "pelican/utility/test/TestFile.h"
 #include <QFile>
+#include <QTextStream>
 #include <QDebug>
 
 
@@ -62,5 +64,82 @@ void DedispersionDataAnalysisOutputTest::test_method()
     CPPUNIT_ASSERT( f.size() > 0 );
 }
 
+void DedispersionDataAnalysisOutputTest::test_binary()
+{
+    // Use Case:
+    // the same buffer of candidates written as text and as binary
+    // Expect:
+    // the binary file holds one record per candidate (not the first
+    // event) and one for the buffer, and converts back to the same text
+    test::TestFile textFile(true);
+    test::TestFile binaryFile(true);
+    SpectrumDataSetStokes sblob;
+    sblob.setLofarTimestamp( 1.3e9 );
+    sblob.setBlockRate( 0.001 );
+    QList<SpectrumDataSetStokes*> sblobs;
+    sblobs.append( &sblob );
+    DedispersionSpectra data; data.resize(10,10,1.0,0.1);
+    data.setInputDataBlobs( sblobs );
+    DedispersionDataAnalysis blob1;
+    blob1.reset(&data);
+    blob1.setRMS( 2.0 );
+    blob1.addEvent( 1, 1, 1, 1);
+    blob1.addEvent( 2, 3, 4, 20);
+    blob1.addEvent( 5, 6, 1, 30);
+    blob1.setDegradation( 1 );
+    {
+        ConfigNode config;
+        DedispersionDataAnalysisOutput writer(config);
+        writer.addFile(textFile.filename());
+        writer.send("stream1", &blob1);
+    }
+    {
+        ConfigNode config;
+        config.setFromString( "<DedispersionDataAnalysisOutput><format value=\"binary\"/>"
+                              "<beam id=\"3\"/></DedispersionDataAnalysisOutput>" );
+        DedispersionDataAnalysisOutput writer(config);
+        writer.addFile(binaryFile.filename());
+        writer.send("stream1", &blob1);
+    }
+    CPPUNIT_ASSERT_EQUAL( 32, (int)sizeof(CandidateFile::Header) );
+    CPPUNIT_ASSERT_EQUAL( 32, (int)sizeof(CandidateFile::Record) );
+
+    QFile in( binaryFile.filename() );
+    CPPUNIT_ASSERT( in.open( QIODevice::ReadOnly ) );
+    CandidateFile::Header header = CandidateFile::readHeader( in );
+    CPPUNIT_ASSERT_EQUAL( 3U, (unsigned)header.beam );
+    CandidateFile::Record records[4];
+    CPPUNIT_ASSERT_EQUAL( (qint64)3, CandidateFile::readRecords( in, records, 4 ) );
+    CPPUNIT_ASSERT_EQUAL( (int)CandidateFile::Event, (int)records[0].type );
+    CPPUNIT_ASSERT_EQUAL( 4U, (unsigned)records[0].width );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 5.0, records[0].snr, 1e-5 );
+    CPPUNIT_ASSERT_EQUAL( (int)CandidateFile::Buffer, (int)records[2].type );
+    CPPUNIT_ASSERT_EQUAL( 1U, (unsigned)records[2].buffer );
+    CPPUNIT_ASSERT_EQUAL( 1, (int)records[2].degradation );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 15.0, records[2].snr, 1e-5 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.3e9 / 86400 + 40587, records[2].mjd, 1e-6 );
+
+    QString converted;
+    {
+        QTextStream out( &converted );
+        CandidateFile::writeTextHeader( out );
+        for( int i = 0; i < 3; ++i ) {
+            CandidateFile::writeText( out, records[i] );
+        }
+    }
+    QFile text( textFile.filename() );
+    CPPUNIT_ASSERT( text.open( QIODevice::ReadOnly ) );
+    CPPUNIT_ASSERT_EQUAL( QString( text.readAll() ).toStdString(), converted.toStdString() );
+
+    {
+        // Use Case:
+        // a file that is not a candidate file
+        // Expect:
+        // throw
+        text.seek( 0 );
+        CPPUNIT_ASSERT_THROW( CandidateFile::readHeader( text ), QString );
+    }
+}
+
 } // namespace ampp
 } // namespace pelican
@@ -84,9 +84,10 @@ void DedispersionModuleTest::test_multipleBuffersPerBlob()
         _chainFinished = 0;
         _unlocked.clear();
         ddm.dedisperse( &weightedData ); // asynchronous tasks launch
-        while( _connectCount < multiple ) { sleep(1); }; // expect more times
-                                                         // due to maxshift
-        while( _chainFinished != _connectCount ) { sleep(1); };
+        CPPUNIT_ASSERT( ddm.waitForJobCompletion( 60000 ) );
+        CPPUNIT_ASSERT( _connectCount >= multiple ); // expect more times
+                                                     // due to maxshift
+        CPPUNIT_ASSERT_EQUAL( _connectCount, _chainFinished );
      }
      catch( const QString& s )
      {
@@ -441,8 +442,9 @@ void DedispersionModuleTest::test_dataConsistency() {
              WeightedSpectrumDataSet weightedData(spectrumData[i]);
              ddm.dedisperse( &weightedData ); // asynchronous task
          }
-         while( _connectCount != 2 ) { sleep(1); };
-         while( _chainFinished != _connectCount ) { sleep(1); };
+         CPPUNIT_ASSERT( ddm.waitForJobCompletion( 60000 ) );
+         CPPUNIT_ASSERT_EQUAL( 2, _connectCount );
+         CPPUNIT_ASSERT_EQUAL( _connectCount, _chainFinished );
          CPPUNIT_ASSERT( DedispersionDataGenerator::equal(spectrumData, spectrumDataCopy ));
     }
     catch( const QString& s )
@@ -453,10 +455,224 @@ void DedispersionModuleTest::test_dataConsistency() {
     DedispersionDataGenerator::deleteData(spectrumDataCopy);
 }
 
+void DedispersionModuleTest::test_quantisedInput()
+{
+    try {
+        float dm = 10.0;
+        unsigned nSamples = 3200;
+        DedispersionDataGenerator stokesData;
+        stokesData.setTimeSamplesPerBlock( nSamples );
+        QList<SpectrumDataSetStokes*> spectrumData = stokesData.generate( 1, dm );
+        SpectrumDataSetStokes* stokes = spectrumData[0];
+        unsigned nSubbands = stokes->nSubbands();
+        unsigned nChannels = nSubbands * stokes->nChannels();
+        unsigned bits[] = { 16, 8 };
+        float scale[] = { 2048.0, 16.0 };
+        float max[] = { 32767.0, 127.0 };
+        {
+            // Use Case:
+            // The signal on a background of values between the
+            // quantisation levels, dedispersed from 8 bit, 16 bit and
+            // float input buffers
+            // Expect:
+            // The quantised results to agree with the float path to within
+            // the rounding error summed over the channels
+            for( unsigned t = 0; t < nSamples; ++t ) {
+                for( unsigned s = 0; s < nSubbands; ++s ) {
+                    float* I = stokes->spectrumData( t, s, 0 );
+                    for( unsigned c = 0; c < stokes->nChannels(); ++c ) {
+                        I[c] += 0.37f * ( ( t * 7 + s * 3 + c ) % 5 ) - 0.61f;
+                    }
+                }
+            }
+            WeightedSpectrumDataSet weightedData( stokes );
+            std::vector<float> reference = dedisperseWithPrecision( &weightedData, nSamples,
+                    stokesData.startFrequency(), stokesData.bandwidthOfSample(), 32 );
+            for( int i = 0; i < 2; ++i ) {
+                std::vector<float> result = dedisperseWithPrecision( &weightedData, nSamples,
+                    stokesData.startFrequency(), stokesData.bandwidthOfSample(), bits[i] );
+                CPPUNIT_ASSERT_EQUAL( reference.size(), result.size() );
+                float tolerance = nChannels * 0.5 / scale[i];
+                for( unsigned j = 0; j < reference.size(); ++j ) {
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL( reference[j], result[j], tolerance );
+                }
+            }
+        }
+        {
+            // Use Case:
+            // Every sample beyond the range of both quantised formats, of
+            // either sign
+            // Expect:
+            // Every dedispersed sample to be the sum of the channels each
+            // clipped to +/- max/scale
+            float levels[] = { 20.0, -20.0 };
+            for( int l = 0; l < 2; ++l ) {
+                for( unsigned t = 0; t < nSamples; ++t ) {
+                    for( unsigned s = 0; s < nSubbands; ++s ) {
+                        float* I = stokes->spectrumData( t, s, 0 );
+                        for( unsigned c = 0; c < stokes->nChannels(); ++c ) I[c] = levels[l];
+                    }
+                }
+                WeightedSpectrumDataSet weightedData( stokes );
+                for( int i = 0; i < 2; ++i ) {
+                    std::vector<float> result = dedisperseWithPrecision( &weightedData, nSamples,
+                        stokesData.startFrequency(), stokesData.bandwidthOfSample(), bits[i] );
+                    CPPUNIT_ASSERT( ! result.empty() );
+                    float expected = ( levels[l] > 0 ? 1.0f : -1.0f ) * nChannels * max[i] / scale[i];
+                    for( unsigned j = 0; j < result.size(); ++j ) {
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL( expected, result[j], 1e-4 * nChannels );
+                    }
+                }
+            }
+        }
+        stokesData.deleteData(spectrumData);
+    }
+    catch( QString s )
+    {
+        CPPUNIT_FAIL(s.toStdString());
+    }
+}
+
+std::vector<float> DedispersionModuleTest::dedisperseWithPrecision( WeightedSpectrumDataSet* data,
+                              unsigned nSamples, float startFrequency,
+                              float channelBandwidth, unsigned bits )
+{
+    ConfigNode config;
+    QString configString = QString("<DedispersionModule>"
+                                   " <invertedData value=\"0\" />"
+                                   " <sampleNumber value=\"%1\" />"
+                                   " <frequencyChannel1 MHz=\"%2\"/>"
+                                   " <channelBandwidth MHz=\"%3\"/>"
+                                   " <dedispersionSamples value=\"200\" />"
+                                   " <dedispersionStepSize value=\"0.1\" />"
+                                   " <inputPrecision bits=\"%4\" />"
+                                   "</DedispersionModule>")
+                                  .arg( nSamples )
+                                  .arg( startFrequency )
+                                  .arg( channelBandwidth )
+                                  .arg( bits );
+    config.setFromString(configString);
+    DedispersionModule ddm(config);
+    ddm.connect( boost::bind( &DedispersionModuleTest::connected, this, _1 ) );
+    _connectData = 0;
+    _connectCount = 0;
+    ddm.dedisperse( data ); // asynchronous task
+    CPPUNIT_ASSERT( ddm.waitForJobCompletion( 60000 ) );
+    CPPUNIT_ASSERT_EQUAL( 1, _connectCount );
+    CPPUNIT_ASSERT( _connectData );
+    return _connectData->data();
+}
+
+void DedispersionModuleTest::test_hostResource()
+{
+    // Use Case:
+    // Dedisperse a pulse on a host worker pool (the only resource
+    // available when built without CUDA)
+    // Expect:
+    // The full dedispersed plane is returned, with the whole pulse
+    // recovered at its DM
+    try {
+        float dm = 10.0;
+        unsigned ddSamples = 200;
+        unsigned nSamples = 3200;
+        DedispersionDataGenerator stokesData;
+        stokesData.setTimeSamplesPerBlock( nSamples );
+        QList<SpectrumDataSetStokes*> spectrumData = stokesData.generate( 1, dm );
+        WeightedSpectrumDataSet weightedData(spectrumData[0]);
+
+        ConfigNode config;
+        QString configString = QString("<DedispersionModule>"
+                                       " <invertedData value=\"0\" />"
+                                       " <sampleNumber value=\"%1\" />"
+                                       " <frequencyChannel1 MHz=\"%2\"/>"
+                                       " <channelBandwidth MHz=\"%3\"/>"
+                                       " <dedispersionSamples value=\"%4\" />"
+                                       " <dedispersionStepSize value=\"0.1\" />"
+                                       " <hostResources count=\"1\" threads=\"2\" />"
+                                       "</DedispersionModule>")
+                                      .arg( nSamples )
+                                      .arg( stokesData.startFrequency())
+                                      .arg( stokesData.bandwidthOfSample())
+                                      .arg( ddSamples );
+        config.setFromString(configString);
+        DedispersionModule ddm(config);
+        ddm.connect( boost::bind( &DedispersionModuleTest::connected, this, _1 ) );
+        _connectData = 0;
+        _connectCount = 0;
+        ddm.dedisperse( &weightedData ); // asynchronous task
+        CPPUNIT_ASSERT( ddm.waitForJobCompletion( 60000 ) );
+        CPPUNIT_ASSERT_EQUAL( 1, _connectCount );
+        CPPUNIT_ASSERT( _connectData );
+        CPPUNIT_ASSERT( _connectData->hasFullPlane() );
+        CPPUNIT_ASSERT_EQUAL( (size_t)( ( nSamples - ddm.maxshift() ) * ddSamples ),
+                              _connectData->data().size() );
+        float expectedDMIntensity = spectrumData[0]->nSubbands() * spectrumData[0]->nChannels();
+        CPPUNIT_ASSERT_EQUAL( expectedDMIntensity, _connectData->dmAmplitude( 0, dm ) );
+        stokesData.deleteData(spectrumData);
+    }
+    catch( const QString& s )
+    {
+        CPPUNIT_FAIL(s.toStdString());
+    }
+}
+
+void DedispersionModuleTest::test_dmLimit()
+{
+    // Use Case:
+    // Shed the upper DM range of a single segment plan
+    // Expect:
+    // Only the trials below the limit, rounded up to whole kernel
+    // blocks, are dedispersed and the pulse below it is still found
+    try {
+        float dm = 10.0;
+        unsigned ddSamples = 200;
+        unsigned nSamples = 3200;
+        DedispersionDataGenerator stokesData;
+        stokesData.setTimeSamplesPerBlock( nSamples );
+        QList<SpectrumDataSetStokes*> spectrumData = stokesData.generate( 1, dm );
+        WeightedSpectrumDataSet weightedData(spectrumData[0]);
+
+        ConfigNode config;
+        QString configString = QString("<DedispersionModule>"
+                                       " <invertedData value=\"0\" />"
+                                       " <sampleNumber value=\"%1\" />"
+                                       " <frequencyChannel1 MHz=\"%2\"/>"
+                                       " <channelBandwidth MHz=\"%3\"/>"
+                                       " <dedispersionSamples value=\"%4\" />"
+                                       " <dedispersionStepSize value=\"0.1\" />"
+                                       "</DedispersionModule>")
+                                      .arg( nSamples )
+                                      .arg( stokesData.startFrequency())
+                                      .arg( stokesData.bandwidthOfSample())
+                                      .arg( ddSamples );
+        config.setFromString(configString);
+        DedispersionModule ddm(config);
+        ddm.setDMLimit( 11.5 ); // 115 trials, i.e. three blocks of 40
+        ddm.connect( boost::bind( &DedispersionModuleTest::connected, this, _1 ) );
+        _connectData = 0;
+        _connectCount = 0;
+        ddm.dedisperse( &weightedData ); // asynchronous task
+        CPPUNIT_ASSERT( ddm.waitForJobCompletion( 60000 ) );
+        CPPUNIT_ASSERT_EQUAL( 1, _connectCount );
+        CPPUNIT_ASSERT( _connectData );
+        CPPUNIT_ASSERT_EQUAL( 1, _connectData->plan().segments().size() );
+        CPPUNIT_ASSERT_EQUAL( 120U, _connectData->plan().numberOfDMs() );
+        CPPUNIT_ASSERT_EQUAL( (size_t)( ( nSamples - ddm.maxshift() ) * 120 ),
+                              _connectData->data().size() );
+        float expectedDMIntensity = spectrumData[0]->nSubbands() * spectrumData[0]->nChannels();
+        CPPUNIT_ASSERT_EQUAL( expectedDMIntensity, _connectData->dmAmplitude( 0, dm ) );
+        stokesData.deleteData(spectrumData);
+    }
+    catch( const QString& s )
+    {
+        CPPUNIT_FAIL(s.toStdString());
+    }
+}
+
 void DedispersionModuleTest::connected( DataBlob* dataOut ) {
+    _connectData = dynamic_cast<DedispersionSpectra* >(dataOut);
+    CPPUNIT_ASSERT( _connectData );
     ++_connectCount;
-    _connectData = 0;
-    CPPUNIT_ASSERT( ( _connectData = dynamic_cast<DedispersionSpectra* >(dataOut) ) );
 }
 
 void DedispersionModuleTest::connectFinished() {
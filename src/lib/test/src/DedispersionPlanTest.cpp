@@ -0,0 +1,86 @@
+#include "DedispersionPlanTest.h"
+#include "DedispersionPlan.h"
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( DedispersionPlanTest );
+/**
+ *@details DedispersionPlanTest 
+ */
+DedispersionPlanTest::DedispersionPlanTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+DedispersionPlanTest::~DedispersionPlanTest()
+{
+}
+
+void DedispersionPlanTest::setUp()
+{
+}
+
+void DedispersionPlanTest::tearDown()
+{
+}
+
+void DedispersionPlanTest::test_singleSegment()
+{
+    // Use Case:
+    // Fixed step plan, as configured by dedispersionStepSize
+    // Expect:
+    // a single full resolution segment
+    DedispersionPlan plan;
+    plan.setSingleSegment( 0.0, 0.1, 200 );
+    CPPUNIT_ASSERT_EQUAL( 1, plan.segments().size() );
+    CPPUNIT_ASSERT_EQUAL( 200U, plan.numberOfDMs() );
+    CPPUNIT_ASSERT_EQUAL( 1U, plan.maxDownsample() );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 19.9, plan.dmHigh(), 0.0001 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 200.0 * 1024, plan.cost( 1024 ), 0.1 );
+}
+
+void DedispersionPlanTest::test_generate()
+{
+    // Use Case:
+    // ALFABURST like observation searched up to DM 2000
+    // Expect:
+    // Segments to be contiguous with increasing step and downsampling,
+    // covering the requested range for less work than a fixed step
+    double fch1 = 1599.0;
+    double foff = -0.109375;
+    unsigned nChannels = 512;
+    double tsamp = 0.000128;
+    DedispersionPlan plan;
+    plan.setMaxDownsample( 8 );
+    plan.setDMMultiple( 40 );
+    plan.generate( fch1, foff, nChannels, tsamp, 0.0, 2000.0 );
+
+    const QList<DedispersionPlan::Segment>& segments = plan.segments();
+    CPPUNIT_ASSERT( segments.size() > 1 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, segments[0].dmLow(), 0.0001 );
+    CPPUNIT_ASSERT( plan.dmHigh() >= 2000.0 );
+    CPPUNIT_ASSERT( plan.maxDownsample() <= 8 );
+    for( int i = 0; i < segments.size(); ++i ) {
+        CPPUNIT_ASSERT_EQUAL( 0U, segments[i].numberOfDMs() % 40 );
+        if( i == 0 ) continue;
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( segments[i-1].dmHigh() + segments[i-1].dmStep(),
+                                      segments[i].dmLow(), 0.001 );
+        CPPUNIT_ASSERT( segments[i].dmStep() > segments[i-1].dmStep() );
+        CPPUNIT_ASSERT( segments[i].downsample() >= segments[i-1].downsample() );
+    }
+
+    // compare with a fixed step at the resolution of the first segment
+    DedispersionPlan fixed;
+    unsigned n = (unsigned)( 2000.0 / segments[0].dmStep() ) + 1;
+    fixed.setSingleSegment( 0.0, segments[0].dmStep(), n );
+    CPPUNIT_ASSERT( plan.cost( 1<<17 ) < fixed.cost( 1<<17 ) );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -1,5 +1,10 @@
 #include "DedispersionSpectraTest.h"
 #include "DedispersionSpectra.h"
+#include "ChunkCompressor.h"
+#include "pelican/utility/ConfigNode.h"
+#include "pelican/utility/test/TestFile.h"
+#include <QFile>
+#include <cstring>
 
 
 namespace pelican {
@@ -55,5 +60,101 @@ void DedispersionSpectraTest::test_dmIndex()
     CPPUNIT_ASSERT_EQUAL( maxDmAmplitude, spectra.dmAmplitude( timebins-1 , (int)dedispersionBins - 1 ) );
 }
 
+void DedispersionSpectraTest::test_segments()
+{
+    // Use Case:
+    // DM trials split into a full resolution and a downsampled segment
+    // Expect:
+    // each trial to map to its own block of the data at its own resolution
+    unsigned timebins = 64;
+    DedispersionPlan plan;
+    plan.setSingleSegment( 0.0, 0.5, 10 );
+    plan.addSegment( DedispersionPlan::Segment( 5.0, 1.0, 4, 4 ) );
+    DedispersionSpectra spectra;
+    spectra.resize( timebins, plan );
+    CPPUNIT_ASSERT_EQUAL( (size_t)( 10 * timebins + 4 * timebins / 4 ), spectra.data().size() );
+    CPPUNIT_ASSERT_EQUAL( 14, spectra.dmBins() );
+    CPPUNIT_ASSERT_EQUAL( (int)timebins, spectra.timeSamples() );
+    CPPUNIT_ASSERT_EQUAL( (int)timebins, spectra.timeSamples( 9 ) );
+    CPPUNIT_ASSERT_EQUAL( (int)timebins / 4, spectra.timeSamples( 10 ) );
+    CPPUNIT_ASSERT_EQUAL( 4U, spectra.downsampling( 13 ) );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 4.5, spectra.dm( 9 ), 0.0001 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 7.0, spectra.dm( 12 ), 0.0001 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 8.0, spectra.dmMax(), 0.0001 );
+    CPPUNIT_ASSERT_EQUAL( 9, spectra.dmIndex( 4.5f ) );
+    CPPUNIT_ASSERT_EQUAL( 12, spectra.dmIndex( 7.0f ) );
+
+    // a downsampled sample covers 4 full resolution samples
+    spectra.dmTrial( 12 )[2] = 3.0;
+    CPPUNIT_ASSERT_EQUAL( 3.0f, spectra.dmAmplitude( 8, 12 ) );
+    CPPUNIT_ASSERT_EQUAL( 3.0f, spectra.dmAmplitude( 11, 12 ) );
+    CPPUNIT_ASSERT_EQUAL( 3.0f, spectra.data()[ 10 * timebins + 2 * timebins / 4 + 2 ] );
+}
+
+void DedispersionSpectraTest::test_peakSummary()
+{
+    // Use Case:
+    // peak summary requested with a decimation that does not divide the data
+    // Expect:
+    // a partial last block and one [S/N, sample, width] entry per DM per block
+    unsigned timebins = 100;
+    DedispersionSpectra spectra;
+    CPPUNIT_ASSERT( ! spectra.hasPeakSummary() );
+    spectra.resize( timebins, 10, 0.0, 1.0 );
+    spectra.setPeakSummary( 32 );
+    CPPUNIT_ASSERT( spectra.hasPeakSummary() );
+    CPPUNIT_ASSERT_EQUAL( 4, spectra.summaryBlocks() );
+    CPPUNIT_ASSERT_EQUAL( (size_t)( 3 * 10 * 4 ), spectra.peaks().size() );
+    CPPUNIT_ASSERT_EQUAL( (size_t)( 2 * 10 ), spectra.dmStatistics().size() );
+    spectra.peaks()[ 3 * ( 5 * 4 + 2 ) + 1 ] = 70.0;
+    CPPUNIT_ASSERT_EQUAL( 70.0f, spectra.peak( 5, 2 )[1] );
+    spectra.dmStatistics()[ 2 * 5 + 1 ] = 2.0;
+    CPPUNIT_ASSERT_EQUAL( 2.0f, spectra.dmRMS( 5 ) );
+
+    spectra.setPeakSummary( 0 );
+    CPPUNIT_ASSERT( ! spectra.hasPeakSummary() );
+    CPPUNIT_ASSERT_EQUAL( (size_t)0, spectra.peaks().size() );
+}
+
+void DedispersionSpectraTest::test_dump()
+{
+    DedispersionSpectra spectra;
+    spectra.resize( 1000, 10, 0.0, 1.0 );
+    for( size_t i = 0; i < spectra.data().size(); ++i ) spectra.data()[i] = (float)( i % 100 );
+    size_t bytes = spectra.data().size() * sizeof(float);
+    {
+        // Use Case:
+        // dump without compression
+        // Expect:
+        // the raw floats
+        test::TestFile file(true);
+        spectra.dumpbin( file.filename() );
+        QFile f( file.filename() );
+        CPPUNIT_ASSERT( f.open( QIODevice::ReadOnly ) );
+        QByteArray data = f.readAll();
+        CPPUNIT_ASSERT_EQUAL( (int)bytes, data.size() );
+        CPPUNIT_ASSERT( std::memcmp( data.constData(), &spectra.data()[0], bytes ) == 0 );
+    }
+    {
+        // Use Case:
+        // dump through an active compressor
+        // Expect:
+        // compressed chunks that give back the floats
+        test::TestFile file(true);
+        ConfigNode config;
+        config.setFromString( "<Dump><compression active=\"true\" chunkSize=\"8192\"/></Dump>" );
+        ChunkCompressor compressor( config );
+        spectra.dumpbin( file.filename(), &compressor );
+        CPPUNIT_ASSERT_EQUAL( 5UL, compressor.statistics().chunks );
+        QFile f( file.filename() );
+        CPPUNIT_ASSERT( f.open( QIODevice::ReadOnly ) );
+        CPPUNIT_ASSERT( f.size() < (qint64)bytes );
+        QByteArray data, chunk;
+        while( ! ( chunk = ChunkCompressor::readChunk( &f ) ).isEmpty() ) data.append( chunk );
+        CPPUNIT_ASSERT_EQUAL( (int)bytes, data.size() );
+        CPPUNIT_ASSERT( std::memcmp( data.constData(), &spectra.data()[0], bytes ) == 0 );
+    }
+}
+
 } // namespace ampp
 } // namespace pelican
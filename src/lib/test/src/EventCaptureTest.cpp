@@ -0,0 +1,226 @@
+#include "EventCaptureTest.h"
+#include "EventCapture.h"
+#include "SpectrumDataSet.h"
+#include "TestDir.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QFile>
+#include <QByteArray>
+#include <cmath>
+#include <cstdlib>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( EventCaptureTest );
+
+namespace {
+
+ConfigNode captureConfig( const QString& dir, const QString& attributes )
+{
+    ConfigNode config;
+    config.setFromString( QString( "<DedispersionPipeline><capture active=\"true\" "
+                                   "directory=\"%1\" %2/></DedispersionPipeline>" )
+                                   .arg(dir).arg(attributes) );
+    return config;
+}
+
+// blobs of 16 spectra of 2 subbands x 4 channels at 1 ms, every
+// channel holding the number of the spectrum
+void addBlobs( EventCapture& capture, int first, int n )
+{
+    SpectrumDataSetStokes blob;
+    blob.resize( 16, 2, 1, 4 );
+    blob.setBlockRate( 0.001 );
+    for( int b = first; b < first + n; ++b ) {
+        blob.setLofarTimestamp( 1000.0 + b * 0.016 );
+        for( unsigned t = 0; t < 16; ++t ) {
+            for( unsigned s = 0; s < 2; ++s ) {
+                float* spectrum = blob.spectrumData( t, s, 0 );
+                for( unsigned c = 0; c < 4; ++c ) {
+                    spectrum[c] = b * 16 + t;
+                }
+            }
+        }
+        capture.add( &blob );
+    }
+}
+
+// the data following the SIGPROC header
+QByteArray readData( const QString& filename )
+{
+    QFile file( filename );
+    file.open( QIODevice::ReadOnly );
+    QByteArray contents = file.readAll();
+    int end = contents.indexOf( "HEADER_END" );
+    CPPUNIT_ASSERT( end > 0 );
+    return contents.mid( end + 10 );
+}
+
+} // namespace
+
+/**
+ *@details EventCaptureTest
+ */
+EventCaptureTest::EventCaptureTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+EventCaptureTest::~EventCaptureTest()
+{
+}
+
+void EventCaptureTest::setUp()
+{
+}
+
+void EventCaptureTest::tearDown()
+{
+}
+
+void EventCaptureTest::test_window()
+{
+    {
+        // Use Case:
+        // capture not configured
+        // Expect:
+        // inactive, nothing written
+        ConfigNode config;
+        config.setFromString( "<DedispersionPipeline/>" );
+        EventCapture capture( config );
+        CPPUNIT_ASSERT( ! capture.active() );
+        addBlobs( capture, 0, 4 );
+        capture.trigger( 1000.01, 1000.01, 0.0 );
+        capture.flush();
+        CPPUNIT_ASSERT( capture.files().isEmpty() );
+    }
+    {
+        // Use Case:
+        // a 1 s ring, triggered before the data after the event has arrived
+        // Expect:
+        // a single file written once the data is in, holding the 0.1 s
+        // either side of the event in time order
+        test::TestDir dir( "EventCaptureTest", true );
+        EventCapture capture( captureConfig( dir.absolutePath(), "seconds=\"1\" pre=\"0.1\" post=\"0.1\"" ) );
+        addBlobs( capture, 0, 50 );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.0, capture.length(), 1e-9 );
+        capture.trigger( 1000.7, 1000.7, 0.0 );
+        addBlobs( capture, 50, 50 );
+        capture.flush();
+        CPPUNIT_ASSERT_EQUAL( 1, capture.files().size() );
+        QByteArray data = readData( capture.files()[0] );
+        const float* spectra = reinterpret_cast<const float*>( data.constData() );
+        int n = data.size() / ( 8 * sizeof(float) );
+        CPPUNIT_ASSERT( n >= 200 && n <= 201 );
+        CPPUNIT_ASSERT( std::fabs( spectra[0] - 600.0 ) <= 1.0 );
+        for( int i = 0; i < n; ++i ) {
+            CPPUNIT_ASSERT_EQUAL( spectra[0] + i, spectra[i * 8] );
+            CPPUNIT_ASSERT_EQUAL( spectra[0] + i, spectra[i * 8 + 7] );
+        }
+        EventCapture::Statistics s = capture.statistics();
+        CPPUNIT_ASSERT_EQUAL( 0ULL, s.lost );
+    }
+    {
+        // Use Case:
+        // 8 bit capture
+        // Expect:
+        // one byte per channel
+        test::TestDir dir( "EventCaptureTest", true );
+        EventCapture capture( captureConfig( dir.absolutePath(),
+                    "seconds=\"1\" pre=\"0.1\" post=\"0.1\" dataBits=\"8\"" ) );
+        addBlobs( capture, 0, 50 );
+        capture.trigger( 1000.4, 1000.4, 0.0 );
+        capture.flush();
+        CPPUNIT_ASSERT_EQUAL( 1, capture.files().size() );
+        int n = readData( capture.files()[0] ).size() / 8;
+        CPPUNIT_ASSERT( n >= 200 && n <= 201 );
+    }
+}
+
+void EventCaptureTest::test_triggers()
+{
+    {
+        // Use Case:
+        // overlapping triggers
+        // Expect:
+        // merged into one file covering both
+        test::TestDir dir( "EventCaptureTest", true );
+        EventCapture capture( captureConfig( dir.absolutePath(), "seconds=\"1\" pre=\"0.1\" post=\"0.1\"" ) );
+        addBlobs( capture, 0, 20 );
+        capture.trigger( 1000.5, 1000.5, 0.0 );
+        capture.trigger( 1000.55, 1000.6, 0.0 );
+        addBlobs( capture, 20, 40 );
+        capture.flush();
+        EventCapture::Statistics s = capture.statistics();
+        CPPUNIT_ASSERT_EQUAL( 2U, s.triggers );
+        CPPUNIT_ASSERT_EQUAL( 1U, s.merged );
+        CPPUNIT_ASSERT_EQUAL( 1, capture.files().size() );
+        int n = readData( capture.files()[0] ).size() / ( 8 * sizeof(float) );
+        CPPUNIT_ASSERT( n >= 300 && n <= 301 );
+    }
+    {
+        // Use Case:
+        // more separate triggers than maxPending before the data arrives
+        // Expect:
+        // the extra trigger dropped
+        test::TestDir dir( "EventCaptureTest", true );
+        EventCapture capture( captureConfig( dir.absolutePath(),
+                    "seconds=\"2\" pre=\"0.01\" post=\"0.01\" maxPending=\"2\"" ) );
+        addBlobs( capture, 0, 10 );
+        capture.trigger( 1000.2, 1000.2, 0.0 );
+        capture.trigger( 1000.4, 1000.4, 0.0 );
+        capture.trigger( 1000.6, 1000.6, 0.0 );
+        addBlobs( capture, 10, 60 );
+        capture.flush();
+        EventCapture::Statistics s = capture.statistics();
+        CPPUNIT_ASSERT_EQUAL( 1U, s.dropped );
+        CPPUNIT_ASSERT_EQUAL( 2, capture.files().size() );
+    }
+    {
+        // Use Case:
+        // a window that starts before the oldest data in the ring
+        // Expect:
+        // the part still in the ring written
+        test::TestDir dir( "EventCaptureTest", true );
+        EventCapture capture( captureConfig( dir.absolutePath(), "seconds=\"0.5\" pre=\"0\" post=\"0.3\"" ) );
+        addBlobs( capture, 0, 100 );
+        capture.trigger( 1001.0, 1001.0, 0.0 );
+        capture.flush();
+        CPPUNIT_ASSERT_EQUAL( 1, capture.files().size() );
+        QByteArray data = readData( capture.files()[0] );
+        const float* spectra = reinterpret_cast<const float*>( data.constData() );
+        CPPUNIT_ASSERT_EQUAL( 1100.0f, spectra[0] );
+        int n = data.size() / ( 8 * sizeof(float) );
+        CPPUNIT_ASSERT( n >= 200 && n <= 201 );
+    }
+}
+
+void EventCaptureTest::test_sweep()
+{
+    // Use Case:
+    // 8 channels descending from 150 MHz in 1 MHz steps
+    // Expect:
+    // the cold plasma delay across the band, and the window extended
+    // after the event by that much
+    test::TestDir dir( "EventCaptureTest", true );
+    EventCapture capture( captureConfig( dir.absolutePath(), "seconds=\"2\" pre=\"0\" post=\"0\"" ) );
+    CPPUNIT_ASSERT_EQUAL( 0.0, capture.sweep( 100.0 ) );
+    capture.setBand( 150.0, -1.0 );
+    addBlobs( capture, 0, 1 );
+    double expected = 4148.741601 * 10.0 * ( 1.0 / ( 143.0 * 143.0 ) - 1.0 / ( 150.0 * 150.0 ) );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( expected, capture.sweep( 10.0 ), 1e-9 );
+    capture.trigger( 1000.1, 1000.1, 10.0 );
+    addBlobs( capture, 1, 100 );
+    capture.flush();
+    CPPUNIT_ASSERT_EQUAL( 1, capture.files().size() );
+    int n = readData( capture.files()[0] ).size() / ( 8 * sizeof(float) );
+    CPPUNIT_ASSERT( std::abs( n - (int)( expected / 0.001 ) ) <= 2 );
+}
+
+} // namespace ampp
+} // namespace pelican
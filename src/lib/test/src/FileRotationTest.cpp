@@ -0,0 +1,115 @@
+#include "FileRotationTest.h"
+#include "FileRotation.h"
+#include "TestDir.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QFileInfo>
+#include <fstream>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( FileRotationTest );
+/**
+ *@details FileRotationTest
+ */
+FileRotationTest::FileRotationTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+FileRotationTest::~FileRotationTest()
+{
+}
+
+void FileRotationTest::setUp()
+{
+}
+
+void FileRotationTest::tearDown()
+{
+}
+
+void FileRotationTest::test_next()
+{
+    {
+        // Use Case:
+        // no limits configured
+        // Expect:
+        // never rotate
+        ConfigNode config;
+        config.setFromString( "<SigprocStokesWriter/>" );
+        FileRotation rotation( config );
+        CPPUNIT_ASSERT( ! rotation.active() );
+        for( int i = 0; i < 10; ++i ) {
+            CPPUNIT_ASSERT( ! rotation.next( i * 1000.0, 1 << 30 ) );
+        }
+    }
+    {
+        // Use Case:
+        // size limit of 1 MB, blobs of 400 kB
+        // Expect:
+        // a new segment every second blob, before the limit is passed
+        ConfigNode config;
+        config.setFromString( "<SigprocStokesWriter><rotate size=\"1\"/></SigprocStokesWriter>" );
+        FileRotation rotation( config );
+        CPPUNIT_ASSERT( rotation.active() );
+        for( int i = 0; i < 9; ++i ) {
+            CPPUNIT_ASSERT_EQUAL( i > 0 && i % 2 == 0, rotation.next( i, 400000 ) );
+        }
+        // a blob bigger than the limit still gets written
+        CPPUNIT_ASSERT( rotation.next( 10.0, 2000000 ) );
+        CPPUNIT_ASSERT( rotation.next( 11.0, 2000000 ) );
+    }
+    {
+        // Use Case:
+        // duration limit of 10 s, blobs of 4 s of data
+        // Expect:
+        // a new segment once 10 s of data has been written
+        ConfigNode config;
+        config.setFromString( "<SigprocStokesWriter><rotate duration=\"10\"/></SigprocStokesWriter>" );
+        FileRotation rotation( config );
+        CPPUNIT_ASSERT( ! rotation.next( 100.0, 10 ) );
+        CPPUNIT_ASSERT( ! rotation.next( 104.0, 10 ) );
+        CPPUNIT_ASSERT( ! rotation.next( 108.0, 10 ) );
+        CPPUNIT_ASSERT( rotation.next( 112.0, 10 ) );
+        CPPUNIT_ASSERT( ! rotation.next( 116.0, 10 ) );
+        CPPUNIT_ASSERT( rotation.next( 124.0, 10 ) );
+    }
+}
+
+void FileRotationTest::test_segments()
+{
+    // Use Case:
+    // open and close preallocated segments
+    // Expect:
+    // distinct names and each file trimmed to the data written
+    test::TestDir dir( "FileRotationTest", true );
+    ConfigNode config;
+    config.setFromString( "<SigprocStokesWriter><rotate size=\"1\" preallocate=\"true\"/></SigprocStokesWriter>" );
+    FileRotation rotation( config );
+    QString prefix = dir.absolutePath() + "/test";
+    QString name1 = rotation.nextName( prefix ) + ".fil";
+    QString name2 = rotation.nextName( prefix ) + ".fil";
+    CPPUNIT_ASSERT( name1 != name2 );
+    CPPUNIT_ASSERT_EQUAL( 2, rotation.segments() );
+
+    std::ofstream file;
+    char data[100] = { 0 };
+    rotation.open( file, name1 );
+    file.write( data, 100 );
+    rotation.close( file, name1 );
+    CPPUNIT_ASSERT_EQUAL( (qint64)100, QFileInfo( name1 ).size() );
+
+    rotation.open( file, name2 );
+    file.write( data, 50 );
+    rotation.close( file, name2 );
+    CPPUNIT_ASSERT_EQUAL( (qint64)50, QFileInfo( name2 ).size() );
+}
+
+} // namespace ampp
+} // namespace pelican
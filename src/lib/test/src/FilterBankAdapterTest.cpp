@@ -3,6 +3,11 @@
 #include "pelican/core/test/AdapterTester.h"
 #include "SpectrumDataSet.h"
 #include "FilterBankAdapter.h"
+#include "SigprocStokesWriter.h"
+#include "TestDir.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QDir>
+#include <QStringList>
 
 namespace pelican {
 namespace ampp {
@@ -53,5 +58,79 @@ void FilterBankAdapterTest::test_readFile()
      }
 }
 
+// write 3 blobs of 16 spectra of 2 subbands x 4 channels as 8 bit
+// samples, returning the file written
+static QString writeFile( const QString& dir, const QString& compression )
+{
+    ConfigNode config;
+    config.setFromString( QString("<SigprocStokesWriter writeHeader=\"true\">"
+                                  "<file filepath=\"%1/test\"/>"
+                                  "<frequencyChannel1 MHz=\"150\"/>"
+                                  "<subbandsPerPacket value=\"2\"/>"
+                                  "<outputChannelsPerSubband value=\"4\"/>"
+                                  "<dataBits value=\"8\"/>"
+                                  "<scale min=\"0\" max=\"255\"/>"
+                                  "%2</SigprocStokesWriter>").arg(dir).arg(compression) );
+    {
+        SigprocStokesWriter writer( config );
+        SpectrumDataSetStokes blob;
+        blob.resize( 16, 2, 1, 4 );
+        for( int b = 0; b < 3; ++b ) {
+            for( unsigned t = 0; t < 16; ++t ) {
+                for( unsigned s = 0; s < 2; ++s ) {
+                    float* spectrum = blob.spectrumData( t, s, 0 );
+                    for( unsigned c = 0; c < 4; ++c ) {
+                        spectrum[c] = ( b * 16 + t ) % 4 + s * 4 + c;
+                    }
+                }
+            }
+            writer.send( "data", &blob );
+        }
+    }
+    QStringList files = QDir(dir).entryList( QStringList() << "test_*", QDir::Files );
+    CPPUNIT_ASSERT_EQUAL( 1, files.size() );
+    return dir + "/" + files[0];
+}
+
+void FilterBankAdapterTest::test_compressed()
+{
+     try {
+       // Use Case:
+       // the same data written with and without compression
+       // Expect:
+       // the compressed file to be adapted to the same spectra
+       test::TestDir plainDir( "FilterBankAdapterTest", true );
+       test::TestDir compressedDir( "FilterBankAdapterTest", true );
+       QString plain = writeFile( plainDir.absolutePath(), "" );
+       QString compressed = writeFile( compressedDir.absolutePath(),
+                                       "<compression active=\"true\"/>" );
+       CPPUNIT_ASSERT( plain.endsWith( ".fil" ) );
+       CPPUNIT_ASSERT( compressed.endsWith( ".filz" ) );
+
+       SpectrumDataSetStokes plainBlob, compressedBlob;
+       {
+           pelican::test::AdapterTester tester("FilterBankAdapter", "");
+           tester.setDataFile( plain );
+           tester.execute( &plainBlob );
+       }
+       {
+           pelican::test::AdapterTester tester("FilterBankAdapter", "");
+           tester.setDataFile( compressed );
+           tester.execute( &compressedBlob );
+       }
+       CPPUNIT_ASSERT_EQUAL( 48U, plainBlob.nTimeBlocks() );
+       CPPUNIT_ASSERT_EQUAL( 48U, compressedBlob.nTimeBlocks() );
+       CPPUNIT_ASSERT_EQUAL( 8U, compressedBlob.nChannels() );
+       for( unsigned t = 0; t < 48; ++t ) {
+           const float* a = plainBlob.spectrumData( t, 0, 0 );
+           const float* b = compressedBlob.spectrumData( t, 0, 0 );
+           for( unsigned c = 0; c < 8; ++c ) CPPUNIT_ASSERT_EQUAL( a[c], b[c] );
+       }
+     }
+     catch( QString& e ) {
+        CPPUNIT_FAIL( e.toStdString() );
+     }
+}
+
 } // namespace ampp
 } // namespace pelican
@@ -133,5 +133,43 @@ void GPU_ManagerTest::test_submitMultiCards()
      CPPUNIT_ASSERT_EQUAL( 0, m.jobsQueued() );
 
 }
+
+void GPU_ManagerTest::test_priority()
+{
+     // Use Case:
+     // Single gpu card, busy. A low priority job is queued
+     // before a high priority one
+     // Expect:
+     // the high priority job to be run first, and timing statistics
+     // to be collected for each job type
+     GPU_Manager m;
+     GPU_TestCard* card = new GPU_TestCard;
+     m.addResource( card );
+     GPU_Job busyJob;
+     GPU_Job lowJob;
+     GPU_Job highJob;
+     lowJob.setType( "background" );
+     highJob.setType( "trigger" );
+     highJob.setPriority( 5 );
+     m.submit(&busyJob);
+     do{ sleep(1); } while( busyJob.status() == GPU_Job::Queued );
+     m.submit(&lowJob);
+     m.submit(&highJob);
+     CPPUNIT_ASSERT_EQUAL( 2, m.jobsQueued() );
+     card->completeJob();
+     do{ sleep(1); } while( highJob.status() == GPU_Job::Queued );
+     CPPUNIT_ASSERT_EQUAL( &highJob, card->currentJob() );
+     CPPUNIT_ASSERT_EQUAL( GPU_Job::Queued, lowJob.status() );
+     card->completeJob();
+     do{ sleep(1); } while( lowJob.status() == GPU_Job::Queued );
+     card->completeJob();
+     do{ sleep(1); } while( lowJob.status() != GPU_Job::Finished );
+
+     QMap<QString, GPU_Manager::JobStatistics> stats = m.statistics();
+     CPPUNIT_ASSERT_EQUAL( 3, stats.size() );
+     CPPUNIT_ASSERT_EQUAL( 1UL, stats["trigger"].execution.count() );
+     CPPUNIT_ASSERT( stats["background"].queueWait.mean() >= stats["trigger"].queueWait.mean() );
+}
+
 } // namespace ampp
 } // namespace pelican
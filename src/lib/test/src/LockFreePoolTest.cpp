@@ -0,0 +1,145 @@
+#include "LockFreePoolTest.h"
+#include "LockFreePool.hpp"
+#include <QThread>
+#include <QAtomicInt>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( LockFreePoolTest );
+
+namespace {
+// takes an object from the pool, marks it as in use and returns it
+class PoolUser : public QThread {
+    public:
+        PoolUser( LockFreePool<QAtomicInt>* pool, int iterations )
+            : _pool(pool), _iterations(iterations), errors(0) {}
+        void run() {
+            for( int i = 0; i < _iterations; ++i ) {
+                QAtomicInt* obj = _pool->next();
+                if( ! obj->testAndSetOrdered( 0, 1 ) ) ++errors; // already in use
+                obj->testAndSetOrdered( 1, 0 );
+                _pool->unlock( obj );
+            }
+        }
+    private:
+        LockFreePool<QAtomicInt>* _pool;
+        int _iterations;
+    public:
+        int errors;
+};
+
+class PoolWaiter : public QThread {
+    public:
+        PoolWaiter( LockFreePool<int>* pool ) : _pool(pool), obj(0) {}
+        void run() { obj = _pool->next(); }
+    private:
+        LockFreePool<int>* _pool;
+    public:
+        int* obj;
+};
+} // namespace
+
+/**
+ *@details LockFreePoolTest 
+ */
+LockFreePoolTest::LockFreePoolTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+LockFreePoolTest::~LockFreePoolTest()
+{
+}
+
+void LockFreePoolTest::setUp()
+{
+}
+
+void LockFreePoolTest::tearDown()
+{
+}
+
+void LockFreePoolTest::test_order()
+{
+    // Use Case:
+    // take all the objects from a pool and return some of them
+    // Expect:
+    // objects handed out in the order they were returned,
+    // tryNext() returns 0 when the pool is empty
+    int data[5] = { 1, 2, 3, 4, 5 };
+    QList<int*> objects;
+    for( int i = 0; i < 5; ++i ) objects.append( &data[i] );
+    LockFreePool<int> pool( objects );
+    CPPUNIT_ASSERT( pool.allAvailable() );
+    CPPUNIT_ASSERT_EQUAL( 5, pool.numberAvailable() );
+    for( int i = 0; i < 5; ++i ) {
+        CPPUNIT_ASSERT_EQUAL( i + 1, *pool.next() );
+    }
+    CPPUNIT_ASSERT( ! pool.allAvailable() );
+    CPPUNIT_ASSERT( pool.tryNext() == 0 );
+    pool.unlock( &data[3] );
+    pool.unlock( &data[1] );
+    CPPUNIT_ASSERT_EQUAL( 2, pool.numberAvailable() );
+    CPPUNIT_ASSERT_EQUAL( 4, *pool.next() );
+    CPPUNIT_ASSERT_EQUAL( 2, *pool.tryNext() );
+    CPPUNIT_ASSERT_EQUAL( 0, pool.numberAvailable() );
+}
+
+void LockFreePoolTest::test_blocking()
+{
+    // Use Case:
+    // a thread waits on an empty pool, with and without spinning
+    // Expect:
+    // the thread parks and is woken when an object is returned
+    for( int spin = 0; spin < 2; ++spin ) {
+        int data = 7;
+        QList<int*> objects; objects.append( &data );
+        LockFreePool<int> pool( objects );
+        pool.setSpinCount( spin * 100 );
+        int* obj = pool.next();
+        PoolWaiter waiter( &pool );
+        waiter.start();
+        while( pool.statistics().parks == 0 ) {
+            QThread::yieldCurrentThread();
+        }
+        pool.unlock( obj );
+        CPPUNIT_ASSERT( waiter.wait( 10000 ) );
+        CPPUNIT_ASSERT( waiter.obj == &data );
+        CPPUNIT_ASSERT_EQUAL( spin * 100, pool.statistics().spins );
+        CPPUNIT_ASSERT( pool.statistics().wakes >= 1 );
+    }
+}
+
+void LockFreePoolTest::test_threads()
+{
+    // Use Case:
+    // many threads repeatedly take and return objects from a small pool
+    // Expect:
+    // no object is ever handed to two threads at once, and all are
+    // returned at the end
+    QAtomicInt data[3];
+    QList<QAtomicInt*> objects;
+    for( int i = 0; i < 3; ++i ) objects.append( &data[i] );
+    LockFreePool<QAtomicInt> pool( objects );
+    pool.setSpinCount( 10 );
+    QList<PoolUser*> users;
+    for( int i = 0; i < 8; ++i ) {
+        users.append( new PoolUser( &pool, 20000 ) );
+        users.last()->start();
+    }
+    foreach( PoolUser* user, users ) {
+        user->wait();
+        CPPUNIT_ASSERT_EQUAL( 0, user->errors );
+        delete user;
+    }
+    CPPUNIT_ASSERT( pool.allAvailable() );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,108 @@
+#include "OverloadMonitorTest.h"
+#include "OverloadMonitor.h"
+#include "pelican/utility/ConfigNode.h"
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( OverloadMonitorTest );
+/**
+ *@details OverloadMonitorTest 
+ */
+OverloadMonitorTest::OverloadMonitorTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+OverloadMonitorTest::~OverloadMonitorTest()
+{
+}
+
+void OverloadMonitorTest::setUp()
+{
+}
+
+void OverloadMonitorTest::tearDown()
+{
+}
+
+void OverloadMonitorTest::test_levels()
+{
+    ConfigNode config;
+    config.setFromString( "<DedispersionPipeline><overload active=\"true\" lag=\"1,2,4\" recover=\"0.5\" actions=\"export,threshold,dmrange\"/></DedispersionPipeline>" );
+    {
+        // Use Case:
+        // data keeping pace with the wall clock
+        // Expect:
+        // no shedding
+        OverloadMonitor monitor( config );
+        CPPUNIT_ASSERT( monitor.active() );
+        CPPUNIT_ASSERT_EQUAL( 3, monitor.levels() );
+        CPPUNIT_ASSERT_EQUAL( 0, monitor.update( 1000.0 ) );
+        CPPUNIT_ASSERT_EQUAL( 0, monitor.update( 1000.5 ) );
+        CPPUNIT_ASSERT( monitor.intervals().isEmpty() );
+    }
+    {
+        // Use Case:
+        // processing falls behind the data and then catches up
+        // Expect:
+        // level rises with the lag, actions applied in order,
+        // hysteresis on recovery and the interval recorded
+        OverloadMonitor monitor( config );
+        CPPUNIT_ASSERT_EQUAL( 0, monitor.update( 1000.0 ) );
+        // data time going backwards looks like 1.5 s of lag
+        CPPUNIT_ASSERT_EQUAL( 1, monitor.update( 998.5 ) );
+        CPPUNIT_ASSERT( monitor.lag() > 1.0 );
+        CPPUNIT_ASSERT( monitor.shedding( "export" ) );
+        CPPUNIT_ASSERT( ! monitor.shedding( "threshold" ) );
+        CPPUNIT_ASSERT_EQUAL( 3, monitor.update( 995.0 ) );
+        CPPUNIT_ASSERT( monitor.shedding( "dmrange" ) );
+        CPPUNIT_ASSERT( ! monitor.shedding( "unknown" ) );
+        // 3 s behind: below the level 3 threshold but not by enough to recover
+        CPPUNIT_ASSERT_EQUAL( 3, monitor.update( 997.0 ) );
+        // 1.5 s behind: still above half the level 2 threshold
+        CPPUNIT_ASSERT_EQUAL( 2, monitor.update( 998.5 ) );
+        CPPUNIT_ASSERT_EQUAL( 1, monitor.intervals().size() );
+        // caught up
+        CPPUNIT_ASSERT_EQUAL( 0, monitor.update( 1000.0 ) );
+        QList<OverloadMonitor::Interval> intervals = monitor.intervals();
+        CPPUNIT_ASSERT_EQUAL( 1, intervals.size() );
+        CPPUNIT_ASSERT_EQUAL( 998.5, intervals[0].start );
+        CPPUNIT_ASSERT_EQUAL( 1000.0, intervals[0].end );
+        CPPUNIT_ASSERT_EQUAL( 3, intervals[0].level );
+    }
+}
+
+void OverloadMonitorTest::test_config()
+{
+    {
+        // Use Case:
+        // no overload tag
+        // Expect:
+        // inactive, never sheds
+        ConfigNode config;
+        OverloadMonitor monitor( config );
+        CPPUNIT_ASSERT( ! monitor.active() );
+        CPPUNIT_ASSERT_EQUAL( 0, monitor.update( 0.0 ) );
+        CPPUNIT_ASSERT_EQUAL( 0, monitor.update( -100.0 ) );
+    }
+    try {
+        // Use Case:
+        // more lag thresholds than actions
+        // Expect:
+        // throw
+        ConfigNode config;
+        config.setFromString( "<DedispersionPipeline><overload active=\"true\" lag=\"1,2\" actions=\"export\"/></DedispersionPipeline>" );
+        OverloadMonitor monitor( config );
+        CPPUNIT_FAIL( "expecting an exception" );
+    }
+    catch( const QString& ) {}
+}
+
+} // namespace ampp
+} // namespace pelican
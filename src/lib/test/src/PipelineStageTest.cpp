@@ -0,0 +1,94 @@
+#include "PipelineStageTest.h"
+#include "PipelineStage.hpp"
+#include "BlockingQueue.hpp"
+#include <QList>
+#include <boost/bind.hpp>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( PipelineStageTest );
+
+namespace {
+void record( QList<int>* seen, int* value ) {
+    seen->append( *value );
+}
+
+class Producer : public QThread {
+    public:
+        Producer( BlockingQueue<int>* queue, int n ) : _queue(queue), _n(n) {}
+        void run() { for( int i = 0; i < _n; ++i ) _queue->push(i); }
+    private:
+        BlockingQueue<int>* _queue;
+        int _n;
+};
+} // namespace
+
+/**
+ *@details PipelineStageTest 
+ */
+PipelineStageTest::PipelineStageTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+PipelineStageTest::~PipelineStageTest()
+{
+}
+
+void PipelineStageTest::setUp()
+{
+}
+
+void PipelineStageTest::tearDown()
+{
+}
+
+void PipelineStageTest::test_queue()
+{
+    // Use Case:
+    // a producer thread pushes more items than the queue holds
+    // Expect:
+    // items popped in order, occupancy never above the capacity
+    BlockingQueue<int> queue( 2 );
+    Producer producer( &queue, 100 );
+    producer.start();
+    for( int i = 0; i < 100; ++i ) {
+        CPPUNIT_ASSERT_EQUAL( i, queue.pop() );
+    }
+    CPPUNIT_ASSERT( producer.wait( 1000 ) );
+    BlockingQueue<int>::Statistics stats = queue.statistics();
+    CPPUNIT_ASSERT_EQUAL( 100U, stats.pops );
+    CPPUNIT_ASSERT( stats.maxOccupancy <= 2 );
+    CPPUNIT_ASSERT_EQUAL( 0, queue.size() );
+}
+
+void PipelineStageTest::test_stage()
+{
+    // Use Case:
+    // push items to a stage and stop it
+    // Expect:
+    // all the items queued before stop() processed in order
+    QList<int> seen;
+    int data[20];
+    for( int i = 0; i < 20; ++i ) data[i] = i;
+    PipelineStage<int> stage( "record", boost::bind( &record, &seen, _1 ), 3 );
+    stage.start();
+    for( int i = 0; i < 20; ++i ) stage.push( &data[i] );
+    stage.stop();
+    CPPUNIT_ASSERT( stage.wait( 1000 ) );
+    CPPUNIT_ASSERT_EQUAL( 20U, stage.items() );
+    CPPUNIT_ASSERT_EQUAL( 20, seen.size() );
+    for( int i = 0; i < 20; ++i ) {
+        CPPUNIT_ASSERT_EQUAL( i, seen[i] );
+    }
+    CPPUNIT_ASSERT( stage.queueStatistics().maxOccupancy <= 3 );
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,128 @@
+#include "LockFreePool.hpp"
+
+#include <QtCore/QTime>
+#include <QtCore/QThread>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace pelican;
+using namespace pelican::ampp;
+
+/*
+ * Stress benchmark comparing the LockFreePool with the mutex based free list
+ * that LockingContainer and LockingPtrContainer used previously.
+ *
+ * Each thread repeatedly takes an object, does a little work on it and
+ * returns it. The pool holds half as many objects as there are threads so
+ * that callers regularly find it empty.
+ *
+ * usage: poolBenchmark [iterations per thread] [work per object]
+ */
+
+namespace {
+
+// the mutex protected free list used by the original containers
+template<typename T>
+class MutexPool {
+    public:
+        MutexPool( const QList<T*>& objects ) : _available(objects) {}
+        T* next() {
+            QMutexLocker lock(&_mutex);
+            while( ! _available.size() ) {
+                _waitCondition.wait(&_mutex);
+            }
+            return _available.takeFirst();
+        }
+        void unlock( T* data ) {
+            QMutexLocker lock(&_mutex);
+            _available.append(data);
+            _waitCondition.wakeOne();
+        }
+    private:
+        QWaitCondition _waitCondition;
+        QMutex _mutex;
+        QList<T*> _available;
+};
+
+struct Object {
+    volatile unsigned value;
+    char pad[60];
+};
+
+template<typename PoolT>
+class Worker : public QThread {
+    public:
+        Worker( PoolT* pool, int iterations, int work )
+            : _pool(pool), _iterations(iterations), _work(work) {}
+        void run() {
+            for( int i = 0; i < _iterations; ++i ) {
+                Object* obj = _pool->next();
+                for( int w = 0; w < _work; ++w ) obj->value += w;
+                _pool->unlock( obj );
+            }
+        }
+    private:
+        PoolT* _pool;
+        int _iterations;
+        int _work;
+};
+
+template<typename PoolT>
+double run( PoolT& pool, int threads, int iterations, int work )
+{
+    QList<Worker<PoolT>*> workers;
+    for( int i = 0; i < threads; ++i ) {
+        workers.append( new Worker<PoolT>( &pool, iterations, work ) );
+    }
+    QTime timer;
+    timer.start();
+    foreach( Worker<PoolT>* w, workers ) w->start();
+    foreach( Worker<PoolT>* w, workers ) w->wait();
+    int elapsed = timer.elapsed();
+    qDeleteAll( workers );
+    return ( elapsed > 0 ) ? (double)threads * iterations / elapsed : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int iterations = ( argc > 1 ) ? std::atoi( argv[1] ) : 100000;
+    int work = ( argc > 2 ) ? std::atoi( argv[2] ) : 64;
+
+    printf("---------------------------------------------------------------\n");
+    printf("- iterations/thread = %d\n", iterations);
+    printf("- work per object   = %d\n", work);
+    printf("- results in operations per ms\n");
+    printf("---------------------------------------------------------------\n");
+    printf("%8s %12s %12s %12s   %s\n", "threads", "mutex", "lockfree",
+           "spin(200)", "lockfree: casRetries/parks  spin: spins/parks");
+
+    for( int threads = 2; threads <= 64; threads *= 2 ) {
+        int nObjects = threads / 2;
+        QList<Object*> objects;
+        for( int i = 0; i < nObjects; ++i ) objects.append( new Object() );
+
+        MutexPool<Object> mutexPool( objects );
+        double mutexRate = run( mutexPool, threads, iterations, work );
+
+        LockFreePool<Object> parkPool( objects );
+        double parkRate = run( parkPool, threads, iterations, work );
+        LockFreePool<Object>::Statistics parkStats = parkPool.statistics();
+
+        LockFreePool<Object> spinPool( objects );
+        spinPool.setSpinCount( 200 );
+        double spinRate = run( spinPool, threads, iterations, work );
+        LockFreePool<Object>::Statistics spinStats = spinPool.statistics();
+
+        printf("%8d %12.1f %12.1f %12.1f   %d/%d  %d/%d\n", threads,
+               mutexRate, parkRate, spinRate,
+               parkStats.casRetries, parkStats.parks,
+               spinStats.spins, spinStats.parks);
+        qDeleteAll( objects );
+    }
+    return 0;
+}
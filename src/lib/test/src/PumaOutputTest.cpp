@@ -2,6 +2,8 @@
 #include <QtCore/QFile>
 #include <QtCore/QDir>
 #include <QtCore/QCoreApplication>
+#include <QtCore/QTime>
+#include <QtNetwork/QTcpServer>
 #include "PumaOutput.h"
 #include "pelican/utility/ClientTestServer.h"
 #include "pelican/utility/ConfigNode.h"
@@ -92,5 +94,49 @@ void PumaOutputTest::test_configuration()
     }
 }
 
+void PumaOutputTest::test_deadServer()
+{
+    try {
+      // Use Case:
+      // A server that nothing is listening on, and more blobs than the
+      // queue holds
+      // Expect:
+      // send() not held up; the blobs beyond the queue depth dropped and
+      // the failed connection counted
+      QTcpServer server;
+      server.listen( QHostAddress::LocalHost );
+      quint16 port = server.serverPort();
+      server.close();
+
+      QString xml = "<PumaOutput>\n"
+                    "<connection host=\"127.0.0.1\" port=\"" + QString::number(port) + "\" />\n"
+                    "<queue depth=\"4\" />\n"
+                    "<reconnect timeout=\"0.2\" minDelay=\"10\" />\n"
+                    "</PumaOutput>";
+      ConfigNode c;
+      c.setFromString(xml);
+      SpectrumDataSetStokes data;
+      data.resize( 16, 2, 1, 4 );
+      PumaOutput out( c );
+      QTime timer;
+      timer.start();
+      for( int i = 0; i < 10; ++i ) {
+          out.send("data", &data );
+      }
+      CPPUNIT_ASSERT( timer.elapsed() < 200 );
+      CPPUNIT_ASSERT( ! out.flush( 0.5 ) );
+      PumaOutput::Statistics s = out.statistics();
+      CPPUNIT_ASSERT_EQUAL( 4UL, s.queued );
+      CPPUNIT_ASSERT_EQUAL( 6UL, s.dropped );
+      CPPUNIT_ASSERT_EQUAL( 0UL, s.sent );
+      CPPUNIT_ASSERT_EQUAL( 0U, s.connects );
+      CPPUNIT_ASSERT_EQUAL( 1U, s.failures );
+    }
+    catch( QString& s )
+    {
+        CPPUNIT_FAIL(s.toStdString());
+    }
+}
+
 } // namespace ampp
 } // namespace pelican
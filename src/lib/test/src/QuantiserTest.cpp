@@ -0,0 +1,153 @@
+#include "QuantiserTest.h"
+#include "Quantiser.h"
+#include "pelican/utility/ConfigNode.h"
+#include <QString>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( QuantiserTest );
+/**
+ *@details QuantiserTest
+ */
+QuantiserTest::QuantiserTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+QuantiserTest::~QuantiserTest()
+{
+}
+
+void QuantiserTest::setUp()
+{
+}
+
+void QuantiserTest::tearDown()
+{
+}
+
+void QuantiserTest::test_pack()
+{
+    {
+        // Use Case:
+        // 8 bit static scaling
+        // Expect:
+        // values rounded to the nearest level and clipped to the range
+        Quantiser q( 8, 0.0, 255.0 );
+        float in[] = { -5.0, 0.4, 100.6, 300.0 };
+        unsigned char out[4];
+        q.pack( in, 4, out );
+        CPPUNIT_ASSERT_EQUAL( 0, (int)out[0] );
+        CPPUNIT_ASSERT_EQUAL( 0, (int)out[1] );
+        CPPUNIT_ASSERT_EQUAL( 101, (int)out[2] );
+        CPPUNIT_ASSERT_EQUAL( 255, (int)out[3] );
+
+        // halves rounded to even, as the writers always have
+        float halves[] = { 2.5, 3.5 };
+        q.pack( halves, 2, out );
+        CPPUNIT_ASSERT_EQUAL( 2, (int)out[0] );
+        CPPUNIT_ASSERT_EQUAL( 4, (int)out[1] );
+    }
+    {
+        // Use Case:
+        // 4, 2 and 1 bit samples
+        // Expect:
+        // the first sample of each byte in the least significant bits,
+        // as unpacked by FilterBankAdapter
+        Quantiser q4( 4, 0.0, 15.0 );
+        float in4[] = { 1.0, 2.0, 15.0, 0.0 };
+        unsigned char out[2];
+        CPPUNIT_ASSERT_EQUAL( (size_t)2, q4.packedSize( 4 ) );
+        q4.pack( in4, 4, out );
+        CPPUNIT_ASSERT_EQUAL( 0x21, (int)out[0] );
+        CPPUNIT_ASSERT_EQUAL( 0x0F, (int)out[1] );
+
+        Quantiser q2( 2, 0.0, 3.0 );
+        float in2[] = { 0.0, 1.0, 2.0, 3.0 };
+        CPPUNIT_ASSERT_EQUAL( (size_t)1, q2.packedSize( 4 ) );
+        q2.pack( in2, 4, out );
+        CPPUNIT_ASSERT_EQUAL( 0xE4, (int)out[0] );
+
+        Quantiser q1( 1, 0.0, 1.0 );
+        float in1[] = { 1.0, 0.0, 0.2, 0.0, 0.0, 0.0, 0.0, 0.9 };
+        CPPUNIT_ASSERT_EQUAL( (size_t)1, q1.packedSize( 8 ) );
+        q1.pack( in1, 8, out );
+        CPPUNIT_ASSERT_EQUAL( 0x81, (int)out[0] );
+    }
+    {
+        // Use Case:
+        // a number of samples that does not fill whole bytes
+        // Expect:
+        // throw
+        Quantiser q( 2, 0.0, 3.0 );
+        float in[] = { 0.0, 1.0, 2.0 };
+        unsigned char out[1];
+        CPPUNIT_ASSERT_THROW( q.pack( in, 3, out ), QString );
+    }
+}
+
+void QuantiserTest::test_adaptive()
+{
+    // Use Case:
+    // two channels with very different levels and spreads
+    // Expect:
+    // each channel's mean maps to the middle of the output range and
+    // large excursions saturate
+    Quantiser q( 8, 0.0, 255.0 );
+    q.setAdaptive( 3.0, 64 );
+    unsigned char out[2];
+    for( int i = 0; i < 512; ++i ) {
+        float sign = ( i % 2 ) ? 1.0 : -1.0;
+        float in[] = { 1000.0f + sign * 10.0f, -50.0f + sign * 2.0f };
+        q.pack( in, 2, out );
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 1000.0, q.mean(0), 0.5 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 10.0, q.rms(0), 0.5 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( -50.0, q.mean(1), 0.1 );
+    CPPUNIT_ASSERT_DOUBLES_EQUAL( 2.0, q.rms(1), 0.1 );
+
+    float mean[] = { 1000.0, -50.0 };
+    q.pack( mean, 2, out );
+    CPPUNIT_ASSERT( out[0] >= 126 && out[0] <= 129 );
+    CPPUNIT_ASSERT( out[1] >= 126 && out[1] <= 129 );
+
+    float outliers[] = { 1050.0, -60.0 };
+    q.pack( outliers, 2, out );
+    CPPUNIT_ASSERT_EQUAL( 255, (int)out[0] );
+    CPPUNIT_ASSERT_EQUAL( 0, (int)out[1] );
+}
+
+void QuantiserTest::test_config()
+{
+    {
+        // Use Case:
+        // adaptive quantisation configured with the writer
+        // Expect:
+        // settings taken up
+        ConfigNode config;
+        config.setFromString( "<SigprocStokesWriter><dataBits value=\"2\"/>"
+                              "<quantisation adaptive=\"true\" sigma=\"2\" timeConstant=\"16\"/>"
+                              "</SigprocStokesWriter>" );
+        Quantiser q( config );
+        CPPUNIT_ASSERT_EQUAL( 2U, q.bits() );
+        CPPUNIT_ASSERT( q.adaptive() );
+    }
+    {
+        // Use Case:
+        // unsupported sample size
+        // Expect:
+        // throw
+        ConfigNode config;
+        config.setFromString( "<SigprocStokesWriter><dataBits value=\"16\"/></SigprocStokesWriter>" );
+        CPPUNIT_ASSERT_THROW( Quantiser q( config ), QString );
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,138 @@
+#include "SigprocStokesWriter.h"
+#include "SpectrumDataSet.h"
+#include "pelican/utility/ConfigNode.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTime>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+using namespace pelican;
+using namespace pelican::ampp;
+
+/*
+ * Benchmark of the SigprocStokesWriter against the original per sample
+ * data path, which wrote each value with its own ofstream::write and
+ * flushed after every blob. Both write the same blobs to files in the
+ * given directory and the data written is checked to be identical.
+ *
+ * usage: sigprocWriterBenchmark [directory] [blobs] [policy]
+ */
+
+namespace {
+
+// the original data path
+void writeOriginal( std::ofstream& file, const SpectrumDataSetStokes* stokes,
+                    unsigned nBits, float cropMin, float cropMax )
+{
+    unsigned nSamples = stokes->nTimeBlocks();
+    unsigned nSubbands = stokes->nSubbands();
+    unsigned nChannels = stokes->nChannels();
+    unsigned nPolarisations = stokes->nPolarisations();
+    float nRange = (int) pow(2.0,(double) nBits)-1.0;
+    float const * data = stokes->data();
+    for (unsigned t = 0; t < nSamples; ++t) {
+        for (int s = nSubbands - 1; s >= 0 ; --s) {
+            long index = stokes->index(s, nSubbands, 0, nPolarisations, t, nChannels );
+            if( nBits == 32 ) {
+                for(unsigned i = 0; i < nChannels ; ++i) {
+                    file.write(reinterpret_cast<const char*>(&data[index + i]), sizeof(float));
+                }
+            }
+            else {
+                for(int i = nChannels - 1; i >= 0 ; --i) {
+                    float f = data[index + i];
+                    float ftmp = (f>cropMax)? (cropMax) : f;
+                    int ci = (ftmp<cropMin) ? 0 : (int)rint((ftmp-cropMin)*nRange/(cropMax-cropMin));
+                    file.write((const char*)&ci, sizeof(unsigned char));
+                }
+            }
+        }
+    }
+    file.flush();
+}
+
+// the newest .fil file written with the given prefix
+QString writerFile( const QString& dir, const QString& prefix )
+{
+    QStringList files = QDir(dir).entryList( QStringList() << prefix + "_*.fil",
+                                             QDir::Files, QDir::Time );
+    return files.isEmpty() ? QString() : dir + "/" + files[0];
+}
+
+// true if the tail of a matches the whole of b
+bool sameData( const QString& a, const QString& b )
+{
+    QFile fa(a), fb(b);
+    if( ! fa.open(QIODevice::ReadOnly) || ! fb.open(QIODevice::ReadOnly) ) return false;
+    if( fa.size() < fb.size() ) return false;
+    fa.seek( fa.size() - fb.size() );
+    return fa.readAll() == fb.readAll();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QString dir = ( argc > 1 ) ? argv[1] : QDir::tempPath();
+    int blobs = ( argc > 2 ) ? std::atoi( argv[2] ) : 200;
+    QString policy = ( argc > 3 ) ? argv[3] : "blob";
+
+    // a typical dedispersion stream blob
+    SpectrumDataSetStokes stokes;
+    stokes.resize( 64, 32, 1, 128 );
+    srand(1);
+    for( int i = 0; i < stokes.size(); ++i ) {
+        stokes.data()[i] = 128.0f + 64.0f * ( rand() / (float)RAND_MAX - 0.5f );
+    }
+    double mb = blobs * stokes.size() / 1.0e6;
+
+    printf("---------------------------------------------------------------\n");
+    printf("- %d blobs of %lu samples, flush policy %s\n", blobs,
+           (unsigned long)stokes.size(), policy.toStdString().c_str());
+    printf("- results in MB/s\n");
+    printf("---------------------------------------------------------------\n");
+    printf("%6s %12s %12s %8s\n", "bits", "original", "buffered", "same");
+
+    unsigned bitsList[] = { 32, 8 };
+    for( int b = 0; b < 2; ++b ) {
+        unsigned bits = bitsList[b];
+        QString prefix = QString("sigprocBenchmark%1").arg(bits);
+        QString original = dir + "/" + prefix + "_original.dat";
+
+        QTime timer;
+        std::ofstream file( original.toUtf8().data(), std::ios::out | std::ios::binary );
+        timer.start();
+        for( int i = 0; i < blobs; ++i ) writeOriginal( file, &stokes, bits, 0.0, 255.0 );
+        file.close();
+        double originalRate = mb * bits / 8 / ( std::max( 1, timer.elapsed() ) / 1000.0 );
+
+        QString xml = QString("<SigprocStokesWriter writeHeader=\"true\">"
+                              "<file filepath=\"%1/%2\"/>"
+                              "<frequencyChannel1 MHz=\"1500\"/>"
+                              "<dataBits value=\"%3\"/>"
+                              "<scale min=\"0\" max=\"255\"/>"
+                              "<subbandsPerPacket value=\"32\"/>"
+                              "<flush policy=\"%4\"/>"
+                              "</SigprocStokesWriter>")
+                              .arg(dir).arg(prefix).arg(bits).arg(policy);
+        ConfigNode config;
+        config.setFromString( xml );
+        double bufferedRate;
+        {
+            SigprocStokesWriter writer( config );
+            timer.restart();
+            for( int i = 0; i < blobs; ++i ) writer.send( "data", &stokes );
+            bufferedRate = mb * bits / 8 / ( std::max( 1, timer.elapsed() ) / 1000.0 );
+        }
+        QString buffered = writerFile( dir, prefix );
+        printf("%6u %12.1f %12.1f %8s\n", bits, originalRate, bufferedRate,
+               sameData( buffered, original ) ? "yes" : "NO");
+        QFile::remove( original );
+        QFile::remove( buffered );
+    }
+    return 0;
+}
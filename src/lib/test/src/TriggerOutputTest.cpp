@@ -0,0 +1,181 @@
+#include "TriggerOutputTest.h"
+#include "TriggerOutput.h"
+#include "DedispersionDataAnalysis.h"
+#include "DedispersionSpectra.h"
+#include "SpectrumDataSet.h"
+#include "pelican/utility/ConfigNode.h"
+#include "pelican/utility/test/TestFile.h"
+#include <QFile>
+#include <QStringList>
+#include <numeric>
+
+
+namespace pelican {
+
+namespace ampp {
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TriggerOutputTest );
+
+namespace {
+
+ConfigNode triggerConfig( const QString& logfile, const QString& threshold )
+{
+    ConfigNode config;
+    config.setFromString( QString( "<TriggerOutput><Trigger format=\"FRATS\"/>"
+                                   "<Logfile name=\"%1\"/>"
+                                   "<Telescope stationID=\"CS001\" beamID=\"3\"/>"
+                                   "<RADec rajd=\"83.63\" decjd=\"22.01\"/>"
+                                   "<frequencyChannel1 MHz=\"142.96875\"/>"
+                                   "<Threshold %2/></TriggerOutput>" )
+                                   .arg(logfile).arg(threshold) );
+    return config;
+}
+
+QStringList readLines( const QString& filename )
+{
+    QFile file( filename );
+    file.open( QIODevice::ReadOnly );
+    return QString( file.readAll() ).split( "\n", QString::SkipEmptyParts );
+}
+
+} // namespace
+
+/**
+ *@details TriggerOutputTest
+ */
+TriggerOutputTest::TriggerOutputTest()
+    : CppUnit::TestFixture()
+{
+}
+
+/**
+ *@details
+ */
+TriggerOutputTest::~TriggerOutputTest()
+{
+}
+
+void TriggerOutputTest::setUp()
+{
+}
+
+void TriggerOutputTest::tearDown()
+{
+}
+
+void TriggerOutputTest::test_trigger()
+{
+    // a buffer with candidates of S/N 5 and 15 after the first event
+    SpectrumDataSetStokes sblob;
+    sblob.setLofarTimestamp( 1.3e9 );
+    sblob.setBlockRate( 0.0078125 );
+    QList<SpectrumDataSetStokes*> sblobs;
+    sblobs.append( &sblob );
+    DedispersionSpectra data; data.resize(10,10,1.0,0.1);
+    data.setInputDataBlobs( sblobs );
+    data.setFirstSample( 0 );
+    DedispersionDataAnalysis blob;
+    blob.reset(&data);
+    blob.setRMS( 2.0 );
+    blob.addEvent( 0, 0, 1, 0 );
+    blob.addEvent( 2, 3, 4, 20 );
+    blob.addEvent( 5, 6, 1, 30 );
+    {
+        // Use Case:
+        // no candidate reaches the threshold, or too few events
+        // Expect:
+        // no trigger
+        test::TestFile file(true);
+        {
+            TriggerOutput out( triggerConfig( file.filename(), "snr=\"20\" events=\"1\"" ) );
+            CPPUNIT_ASSERT( ! out.trigger( &blob ) );
+            TriggerOutput few( triggerConfig( file.filename(), "snr=\"6\" events=\"5\"" ) );
+            CPPUNIT_ASSERT( ! few.trigger( &blob ) );
+            CPPUNIT_ASSERT_EQUAL( 0U, few.statistics().triggers );
+        }
+        CPPUNIT_ASSERT( readLines( file.filename() ).isEmpty() );
+    }
+    {
+        // Use Case:
+        // a qualifying candidate, sent directly and through the stream
+        // Expect:
+        // a message for the brightest candidate each time, numbered in turn
+        test::TestFile file(true);
+        {
+            TriggerOutput out( triggerConfig( file.filename(), "snr=\"6\" events=\"2\"" ) );
+            CPPUNIT_ASSERT( out.trigger( &blob ) );
+            out.send( "TriggerInput", &blob );
+            CPPUNIT_ASSERT_EQUAL( 2U, out.statistics().triggers );
+            CPPUNIT_ASSERT_EQUAL( 0U, out.statistics().stamped );
+        }
+        QStringList lines = readLines( file.filename() );
+        CPPUNIT_ASSERT_EQUAL( 2, lines.size() );
+        const QString& m = lines[0];
+        CPPUNIT_ASSERT( m.startsWith( "artemis:CS001##ID:" ) );
+        CPPUNIT_ASSERT( m.contains( "-030001##cFreqMHz:0142.96875##beamRA:0000083.63"
+                                    "##beamDec:000022.01##eTime:1300000000.046875000" ) );
+        CPPUNIT_ASSERT( m.endsWith( "##eSNR:015.00" ) );
+        CPPUNIT_ASSERT( lines[1].contains( "-030002##" ) );
+    }
+}
+
+void TriggerOutputTest::test_latency()
+{
+    SpectrumDataSetStokes sblob;
+    sblob.setLofarTimestamp( 1.3e9 );
+    sblob.setBlockRate( 0.0078125 );
+    QList<SpectrumDataSetStokes*> sblobs;
+    sblobs.append( &sblob );
+    DedispersionSpectra data; data.resize(10,10,1.0,0.1);
+    data.setInputDataBlobs( sblobs );
+    data.setFirstSample( 0 );
+    DedispersionDataAnalysis blob;
+    blob.reset(&data);
+    blob.setRMS( 2.0 );
+    blob.addEvent( 0, 0, 1, 0 );
+    blob.addEvent( 5, 6, 1, 30 );
+    {
+        // Use Case:
+        // the arrival of the data holding the candidate noted
+        // Expect:
+        // the trigger stamped with its latency, which is counted in the
+        // histogram
+        test::TestFile file(true);
+        {
+            TriggerOutput out( triggerConfig( file.filename(), "snr=\"6\" events=\"1\"" ) );
+            out.dataArrived( 1.3e9 - 1.0 );
+            out.dataArrived( 1.3e9 );
+            out.dataArrived( 1.3e9 + 1.0 );
+            CPPUNIT_ASSERT( out.trigger( &blob ) );
+            TriggerOutput::Statistics s = out.statistics();
+            CPPUNIT_ASSERT_EQUAL( 1U, s.stamped );
+            CPPUNIT_ASSERT( s.minLatency >= 0.0 && s.maxLatency < 1000.0 );
+            CPPUNIT_ASSERT_EQUAL( s.minLatency, s.meanLatency );
+            std::vector<unsigned> histogram = out.latencyHistogram();
+            CPPUNIT_ASSERT_EQUAL( 1U, std::accumulate( histogram.begin(), histogram.end(), 0U ) );
+        }
+        QStringList lines = readLines( file.filename() );
+        CPPUNIT_ASSERT_EQUAL( 1, lines.size() );
+        CPPUNIT_ASSERT( lines[0].contains( "##eSNR:015.00##latencyMs:" ) );
+    }
+    {
+        // Use Case:
+        // only later data has been seen
+        // Expect:
+        // the trigger sent without a latency
+        test::TestFile file(true);
+        {
+            TriggerOutput out( triggerConfig( file.filename(), "snr=\"6\" events=\"1\"" ) );
+            out.dataArrived( 1.3e9 + 1.0 );
+            CPPUNIT_ASSERT( out.trigger( &blob ) );
+            CPPUNIT_ASSERT_EQUAL( 1U, out.statistics().triggers );
+            CPPUNIT_ASSERT_EQUAL( 0U, out.statistics().stamped );
+        }
+        QStringList lines = readLines( file.filename() );
+        CPPUNIT_ASSERT_EQUAL( 1, lines.size() );
+        CPPUNIT_ASSERT( ! lines[0].contains( "latencyMs" ) );
+    }
+}
+
+} // namespace ampp
+} // namespace pelican
@@ -0,0 +1,118 @@
+#include "FileWriter.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QTime>
+#include <QtCore/QVector>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace pelican;
+using namespace pelican::ampp;
+
+/*
+ * Benchmark of the H5_LofarBFVoltageWriter data path. The original path
+ * wrote each real and imaginary value with its own FileWriter::write into
+ * 32 kB buffers; the new path splits a whole blob into its real and
+ * imaginary parts and writes each in one call into large blocks, with and
+ * without O_DIRECT. Rates are compared with a full LOFAR station.
+ *
+ * usage: voltageWriterBenchmark [directory] [MB per file] [blockSize]
+ */
+
+namespace {
+
+typedef std::complex<float> Complex;
+
+// a full station: 4 lanes of 8 kB packets, each of 16 time slices
+// at 195312.5 Hz
+const double stationPacketRate = 4 * 195312.5 / 16;
+const double stationPacketBytes = 8192;
+
+double original( const QString& dir, const QVector<Complex>& data, int blobs )
+{
+    FileWriter re, im;
+    re.open( (dir + "/voltageBenchmark_re.raw").toUtf8().data() );
+    im.open( (dir + "/voltageBenchmark_im.raw").toUtf8().data() );
+    QTime timer;
+    timer.start();
+    const float* in = reinterpret_cast<const float*>( data.constData() );
+    for( int b = 0; b < blobs; ++b ) {
+        for( int i = 0; i < data.size(); ++i ) {
+            re.write( reinterpret_cast<const char*>(&in[2 * i]), sizeof(float) );
+            im.write( reinterpret_cast<const char*>(&in[2 * i + 1]), sizeof(float) );
+        }
+    }
+    re.close();
+    im.close();
+    return std::max( 1, timer.elapsed() ) / 1000.0;
+}
+
+double bulk( const QString& dir, const QVector<Complex>& data, int blobs,
+             size_t blockSize, bool direct, bool* isDirect )
+{
+    FileWriter re( blockSize, 4 ), im( blockSize, 4 );
+    re.setDirect( direct );
+    im.setDirect( direct );
+    re.open( (dir + "/voltageBenchmark_re.raw").toUtf8().data() );
+    im.open( (dir + "/voltageBenchmark_im.raw").toUtf8().data() );
+    *isDirect = re.isDirect();
+    QVector<float> real( data.size() ), imag( data.size() );
+    QTime timer;
+    timer.start();
+    for( int b = 0; b < blobs; ++b ) {
+        const float* in = reinterpret_cast<const float*>( data.constData() );
+        for( int i = 0; i < data.size(); ++i ) {
+            real[i] = in[2 * i];
+            imag[i] = in[2 * i + 1];
+        }
+        re.write( reinterpret_cast<const char*>(real.constData()), real.size() * sizeof(float) );
+        im.write( reinterpret_cast<const char*>(imag.constData()), imag.size() * sizeof(float) );
+    }
+    re.close();
+    im.close();
+    return std::max( 1, timer.elapsed() ) / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    QString dir = ( argc > 1 ) ? argv[1] : QDir::tempPath();
+    int mbPerFile = ( argc > 2 ) ? std::atoi( argv[2] ) : 512;
+    size_t blockSize = ( argc > 3 ) ? std::atoi( argv[3] ) : 4194304;
+
+    // one blob of a typical voltage stream: 16 time samples of
+    // 61 subbands x 64 channels x 2 polarisations
+    QVector<Complex> data( 16 * 61 * 64 * 2 );
+    srand(1);
+    for( int i = 0; i < data.size(); ++i ) {
+        data[i] = Complex( rand() / (float)RAND_MAX, rand() / (float)RAND_MAX );
+    }
+    int blobs = std::max( 1, (int)( mbPerFile * 1.0e6 / ( data.size() * sizeof(float) ) ) );
+    double mb = blobs * data.size() * sizeof(Complex) / 1.0e6; // both files
+    double station = stationPacketRate * stationPacketBytes / 1.0e6;
+
+    printf("---------------------------------------------------------------\n");
+    printf("- %d blobs, %.0f MB in total, block size %lu\n", blobs, mb, (unsigned long)blockSize);
+    printf("- full station: %.0f MB/s of packets, %.0f MB/s as 32-bit voltages\n",
+           station, 2 * station);
+    printf("---------------------------------------------------------------\n");
+    printf("%-24s %10s %10s\n", "path", "MB/s", "x station");
+
+    double rate = mb / original( dir, data, blobs );
+    printf("%-24s %10.1f %10.2f\n", "per value, 32 kB", rate, rate / ( 2 * station ) );
+
+    bool isDirect;
+    rate = mb / bulk( dir, data, blobs, blockSize, false, &isDirect );
+    printf("%-24s %10.1f %10.2f\n", "bulk, page cache", rate, rate / ( 2 * station ) );
+
+    rate = mb / bulk( dir, data, blobs, blockSize, true, &isDirect );
+    printf("%-24s %10.1f %10.2f%s\n", "bulk, O_DIRECT", rate, rate / ( 2 * station ),
+           isDirect ? "" : "  (O_DIRECT unavailable)" );
+
+    QFile::remove( dir + "/voltageBenchmark_re.raw" );
+    QFile::remove( dir + "/voltageBenchmark_im.raw" );
+    return 0;
+}
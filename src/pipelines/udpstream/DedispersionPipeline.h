@@ -5,6 +5,7 @@
 #include "pelican/core/AbstractPipeline.h"
 #include "pelican/utility/LockingCircularBuffer.hpp"
 #include "LockingPtrContainer.hpp"
+#include "PipelineStage.hpp"
 #include "PPFChanneliser.h"
 #include "StokesGenerator.h"
 #include "RFI_Clipper.h"
@@ -12,12 +13,17 @@
 #include "AdapterTimeSeriesDataSet.h"
 #include "TimeSeriesDataSet.h"
 #include "SpectrumDataSet.h"
+#include "WeightedSpectrumDataSet.h"
 #include "SigprocStokesWriter.h"
 #include "TriggerOutput.h"
 #include "DedispersionModule.h"
 #include "DedispersionSpectra.h"
 #include "DedispersionAnalyser.h"
+#include "DedispersionClusterer.h"
 #include "DedispersionDataAnalysisOutput.h"
+#include "OverloadMonitor.h"
+#include "EventCapture.h"
+#include "ChunkCompressor.h"
 #include "timer.h"
 
 
@@ -35,7 +41,36 @@ namespace ampp {
  * @brief
  *     A dedispersion pipeline for streaming TimeSeries bemaformed Data
  * @details
- * 
+ *     With <pipelining active="true" depth="2"/> the Stokes generation, RFI
+ *     clipping and dedispersion buffer filling each run in their own thread
+ *     (PipelineStage) on consecutive chunks, while run() channelises the
+ *     next chunk. Stages are connected by queues of up to depth pooled
+ *     blobs, and each stage is a single thread so the stateful modules
+ *     see the chunks in order. stageReport() prints the occupancy of each
+ *     stage.
+ *
+ *     With <overload active="true" .../> (see OverloadMonitor) the pipeline
+ *     sheds load while it is falling behind the data. The actions, applied
+ *     cumulatively in the configured order, are
+ *       export    - do not retrieve dedispersed planes or write out the
+ *                   spectra of detections
+ *       threshold - raise the detection threshold by thresholdStep sigma
+ *       dmrange   - search only the DM trials below dmFraction of the
+ *                   maximum DM
+ *     Candidates found while degraded carry the shedding level.
+ *
+ *     With <capture active="true" .../> (see EventCapture) the clipped
+ *     Stokes data is kept in a ring in memory, and the data around each
+ *     candidate, widened by its dispersion sweep, is written out in the
+ *     background. Otherwise every blob searched is sent to the
+ *     SignalFoundSpectrum stream, as before.
+ *
+ *     With <trigger active="true"/> the pipeline makes its own TriggerOutput
+ *     (configured by <TriggerOutput> in the pipelineConfig) and calls it as
+ *     soon as each buffer has been searched and clustered, before anything
+ *     is written out, instead of sending the result to the TriggerInput
+ *     stream. The arrival of each chunk is noted so that the triggers
+ *     carry their latency.
  */
 
 class DedispersionPipeline : public AbstractPipeline
@@ -53,9 +88,26 @@ class DedispersionPipeline : public AbstractPipeline
         /// called internally to free up DataBlobs after they are finished with
         void updateBufferLock( const QList<DataBlob*>& );
 
+        /// print the busy fraction and queue occupancy of each pipeline stage
+        void stageReport() const;
+
     protected:
         void dedispersionAnalysis( DataBlob* data );
 
+    private:
+        // the pipelined stages
+        void _stokesStage( SpectrumDataSetC32* spectra );
+        void _rfiStage( SpectrumDataSetStokes* stokes );
+        void _dedispersionStage( WeightedSpectrumDataSet* weighted );
+        void _stopStages();
+        // apply the load shedding actions for the given level
+        void _shedLoad( int level );
+        // write out the data in which the candidates were found
+        void _writeSpectra( const DedispersionDataAnalysis& result,
+                            const DedispersionDataAnalysis& candidates );
+        // write the DM-time plane of a buffer with candidates to a file
+        void _dumpSpectra( const DedispersionSpectra* data );
+
     private:
         QString _streamIdentifier;
 
@@ -66,6 +118,7 @@ class DedispersionPipeline : public AbstractPipeline
         RFI_Clipper* _rfiClipper;
         DedispersionModule* _dedispersionModule;
         DedispersionAnalyser* _dedispersionAnalyser;
+        DedispersionClusterer* _dedispersionClusterer; // 0 if not clustering
 
         /// Local data blobs
 	SpectrumDataSetC32* _spectra;
@@ -79,6 +132,31 @@ class DedispersionPipeline : public AbstractPipeline
         LockingPtrContainer<SpectrumDataSetC32>* _rawBuffer;
         WeightedSpectrumDataSet* _weightedIntStokes;
 
+        // pipelined execution (0 when running each chunk to completion)
+        QList<SpectrumDataSetC32*> _spectraData;
+        LockingPtrContainer<SpectrumDataSetC32>* _spectraPool;
+        QList<WeightedSpectrumDataSet*> _weightedData;
+        LockingPtrContainer<WeightedSpectrumDataSet>* _weightedPool;
+        PipelineStage<SpectrumDataSetC32>* _stokesThread;
+        PipelineStage<SpectrumDataSetStokes>* _rfiThread;
+        PipelineStage<WeightedSpectrumDataSet>* _dedispersionThread;
+
+        // load shedding
+        OverloadMonitor* _overload;
+        int _shedLevel;
+        float _shedThresholdStep;
+        float _shedDMFraction;
+
+        // data written out around detections
+        EventCapture* _capture;
+
+        // low latency triggers (0 if using the TriggerInput stream)
+        TriggerOutput* _trigger;
+
+        // DM-time planes written out with the candidates (0 if not dumping)
+        ChunkCompressor* _dumpCompressor;
+        QString _dumpDirectory;
+
 #ifdef TIMING_ENABLED
         // Timers.
         TimerData _ppfTime;
@@ -4,6 +4,8 @@
 #include "DedispersionDataAnalysis.h"
 #include <boost/bind.hpp>
 #include "SpectrumDataSet.h"
+#include "CoreBudget.h"
+#include "Affinity.h"
 #include <QDebug>
 
 
@@ -23,10 +25,21 @@ DedispersionPipeline::DedispersionPipeline( const QString& streamIdentifier )
      _rawBuffer = 0;
      _dedispersionModule = 0;
      _dedispersionAnalyser = 0;
+     _dedispersionClusterer = 0;
      _ppfChanneliser = 0;
      _rfiClipper = 0;
      _stokesIntegrator = 0;
      _stokesGenerator = 0;
+     _spectraPool = 0;
+     _weightedPool = 0;
+     _stokesThread = 0;
+     _rfiThread = 0;
+     _dedispersionThread = 0;
+     _overload = 0;
+     _shedLevel = 0;
+     _capture = 0;
+     _trigger = 0;
+     _dumpCompressor = 0;
 
     // Initialise timer data.
 #ifdef TIMING_ENABLED
@@ -39,10 +52,26 @@ DedispersionPipeline::DedispersionPipeline( const QString& streamIdentifier )
  */
 DedispersionPipeline::~DedispersionPipeline()
 {
+    // finish any chunks still in the stages before removing the modules
+    _stopStages();
+    if( _stokesThread ) stageReport();
+    delete _stokesThread;
+    delete _rfiThread;
+    delete _dedispersionThread;
+    if( _overload ) _overload->report();
+    delete _overload;
     delete _dedispersionModule;
     delete _dedispersionAnalyser;
+    delete _dedispersionClusterer;
+    // after the module, which may still be reporting detections
+    delete _capture;
+    delete _trigger;
+    if( _dumpCompressor ) _dumpCompressor->report( "DedispersionPipeline spectra dump" );
+    delete _dumpCompressor;
     delete _stokesBuffer;
     delete _rawBuffer;
+    delete _spectraPool;
+    delete _weightedPool;
     delete _ppfChanneliser;
     delete _rfiClipper;
     delete _stokesIntegrator;
@@ -69,6 +98,15 @@ void DedispersionPipeline::init()
     _maxEventsFound = c.getOption("events", "max", "0").toUInt();
 
 
+    // share the cores with any other streams before the modules size
+    // their thread counts
+    CoreBudget::instance().configure(c);
+    CoreBudget::instance().registerStream();
+    // place this thread (and the OpenMP workers it starts) before the
+    // modules allocate their buffers
+    Affinity::instance().configure(c);
+    Affinity::instance().pinCurrentThread( Affinity::Compute, "DedispersionPipeline" );
+
     // Create modules
     _ppfChanneliser = (PPFChanneliser *) createModule("PPFChanneliser");
     _stokesGenerator = (StokesGenerator *) createModule("StokesGenerator");
@@ -76,6 +114,10 @@ void DedispersionPipeline::init()
     //    _stokesIntegrator = (StokesIntegrator *) createModule("StokesIntegrator");
     _dedispersionModule = (DedispersionModule*) createModule("DedispersionModule");
     _dedispersionAnalyser = (DedispersionAnalyser*) createModule("DedispersionAnalyser");
+    // optionally merge events from the same pulse into single candidates
+    if( c.getOption("clustering", "active", "false").toLower() == "true" ) {
+        _dedispersionClusterer = (DedispersionClusterer*) createModule("DedispersionClusterer");
+    }
     _dedispersionModule->connect( boost::bind( &DedispersionPipeline::dedispersionAnalysis, this, _1 ) );
     _dedispersionModule->unlockCallback( boost::bind( &DedispersionPipeline::updateBufferLock, this, _1 ) );
 
@@ -89,6 +131,48 @@ void DedispersionPipeline::init()
     //    _rawBuffer = new LockingPtrContainer<SpectrumDataSetC32>(&_spectra);
     _weightedIntStokes = (WeightedSpectrumDataSet*) createBlob("WeightedSpectrumDataSet");
 
+    // run the stages after the channeliser as a software pipeline
+    if( c.getOption("pipelining", "active", "false").toLower() == "true" ) {
+        int depth = c.getOption("pipelining", "depth", "2").toInt();
+        if( depth < 1 ) depth = 1;
+        _spectraData = createBlobs<SpectrumDataSetC32>("SpectrumDataSetC32", depth + 1);
+        _spectraPool = new LockingPtrContainer<SpectrumDataSetC32>(&_spectraData);
+        _weightedData = createBlobs<WeightedSpectrumDataSet>("WeightedSpectrumDataSet", depth + 1);
+        _weightedPool = new LockingPtrContainer<WeightedSpectrumDataSet>(&_weightedData);
+        _stokesThread = new PipelineStage<SpectrumDataSetC32>( "StokesGenerator",
+                 boost::bind( &DedispersionPipeline::_stokesStage, this, _1 ), depth );
+        _rfiThread = new PipelineStage<SpectrumDataSetStokes>( "RFI_Clipper",
+                 boost::bind( &DedispersionPipeline::_rfiStage, this, _1 ), depth );
+        _dedispersionThread = new PipelineStage<WeightedSpectrumDataSet>( "DedispersionBuffer",
+                 boost::bind( &DedispersionPipeline::_dedispersionStage, this, _1 ), depth );
+        _dedispersionThread->start();
+        _rfiThread->start();
+        _stokesThread->start();
+    }
+
+    // shed load if we fall behind the data
+    _overload = new OverloadMonitor(c);
+    _shedThresholdStep = c.getOption("overload", "thresholdStep", "1.0").toFloat();
+    _shedDMFraction = c.getOption("overload", "dmFraction", "0.5").toFloat();
+
+    // keep the recent data in memory for writing out around detections
+    _capture = new EventCapture(c);
+    _capture->setBand( _dedispersionModule->fch1(), _dedispersionModule->foff() );
+
+    // send triggers directly from the analysis
+    if( c.getOption("trigger", "active", "false").toLower() == "true" ) {
+        _trigger = new TriggerOutput( config( QString("TriggerOutput") ) );
+    }
+
+    // dump the DM-time plane of each buffer with candidates, compressed
+    // as configured by <compression>
+    if( c.getOption("spectraDump", "active", "false").toLower() == "true" ) {
+        _dumpDirectory = c.getOption("spectraDump", "directory", ".");
+        _dumpCompressor = new ChunkCompressor(c);
+    }
+
+    Affinity::instance().report();
+
     // Request remote data
     requestRemoteData( _streamIdentifier, 1 );
 }
@@ -101,9 +185,15 @@ void DedispersionPipeline::run(QHash<QString, DataBlob*>& remoteData)
     // This is a block of data containing a number of time series of length
     // N for each sub-band and polarisation.
     timeSeries = (TimeSeriesDataSetC32*) remoteData[_streamIdentifier];
+    if( _trigger ) _trigger->dataArrived( timeSeries->getLofarTimestamp() );
     dataOutput( timeSeries, _streamIdentifier);
     //    std::cout << "PIPELINE: Got data" << std::endl;
 
+    if( _overload->active() ) {
+        int level = _overload->update( timeSeries->getLofarTimestamp() );
+        if( level != _shedLevel ) _shedLoad( level );
+    }
+
     // Run the polyphase channeliser.
     // Generates spectra from a blocks of time series indexed by sub-band
     // and polarisation.
@@ -113,6 +203,27 @@ void DedispersionPipeline::run(QHash<QString, DataBlob*>& remoteData)
     //    SpectrumDataSetC32* spectra=_rawBuffer->next();
     //    _ppfChanneliser->run(timeSeries, spectra);
 
+    if( _stokesThread ) {
+        // channelise into a pooled blob and hand it on to the next stage.
+        // Blocks while all the blobs are in the later stages
+        SpectrumDataSetC32* spectra = _spectraPool->next();
+        _ppfChanneliser->run(timeSeries, spectra);
+        timerUpdate(&_ppfTime);
+#ifdef TIMING_ENABLED
+        unsigned blocks = spectra->nTimeBlocks();
+#endif
+        _stokesThread->push( spectra );
+#ifdef TIMING_ENABLED
+        timerUpdate(&_totalTime);
+        if( ++_iteration%(_dedispersionModule->numberOfSamples()/blocks) == 0 ) {
+            timerReport(&AdapterTimeSeriesDataSet::adapterTime, "Adapter Time");
+            timerReport(&_ppfTime, "Polyphase Filter");
+            stageReport();
+        }
+#endif
+        return;
+    }
+
     _ppfChanneliser->run(timeSeries, _spectra);
     //    std::cout << "PIPELINE: PPF done" << std::endl;
 
@@ -141,6 +252,7 @@ void DedispersionPipeline::run(QHash<QString, DataBlob*>& remoteData)
 
     //    dataOutput(&(_weightedIntStokes->stats()), "RFI_Stats");
     timerUpdate(&_rfiClipperTime);
+    _capture->add(stokes);
 
     timerStart(&_integratorTime);
     //    _stokesIntegrator->run(stokes, _intStokes);
@@ -173,39 +285,135 @@ void DedispersionPipeline::run(QHash<QString, DataBlob*>& remoteData)
 #endif
 }
 
+void DedispersionPipeline::_stokesStage( SpectrumDataSetC32* spectra ) {
+    timerStart(&_stokesTime);
+    SpectrumDataSetStokes* stokes=_stokesBuffer->next();
+    _stokesGenerator->run(spectra, stokes);
+    _spectraPool->unlock(spectra);
+    timerUpdate(&_stokesTime);
+    _rfiThread->push( stokes );
+}
+
+void DedispersionPipeline::_rfiStage( SpectrumDataSetStokes* stokes ) {
+    timerStart(&_rfiClipperTime);
+    WeightedSpectrumDataSet* weighted = _weightedPool->next();
+    weighted->reset(stokes);
+    _rfiClipper->run(weighted);
+    timerUpdate(&_rfiClipperTime);
+    _capture->add(stokes);
+    _dedispersionThread->push( weighted );
+}
+
+void DedispersionPipeline::_dedispersionStage( WeightedSpectrumDataSet* weighted ) {
+    timerStart(&_dedispersionTime);
+    _dedispersionModule->dedisperse( weighted );
+    timerUpdate(&_dedispersionTime);
+    _weightedPool->unlock(weighted);
+}
+
+void DedispersionPipeline::_stopStages() {
+    // each stage finishes its queue before the next is told to stop
+    if( _stokesThread ) { _stokesThread->stop(); _stokesThread->wait(); }
+    if( _rfiThread ) { _rfiThread->stop(); _rfiThread->wait(); }
+    if( _dedispersionThread ) { _dedispersionThread->stop(); _dedispersionThread->wait(); }
+}
+
+void DedispersionPipeline::_shedLoad( int level ) {
+    _shedLevel = level;
+    // without peak detection the whole plane is always retrieved, so only
+    // the spectra output is held back
+    bool shedExport = _overload->shedding( "export", level );
+    if( _dedispersionModule->peakDetection() ) {
+        _dedispersionModule->setPlaneExport( ! shedExport );
+    }
+    else if( shedExport ) {
+        std::cout << "DedispersionPipeline: peak detection is off, "
+                     "the dedispersed plane is still retrieved" << std::endl;
+    }
+    _dedispersionAnalyser->setThresholdOffset(
+            _overload->shedding( "threshold", level ) ? _shedThresholdStep : 0.0 );
+    _dedispersionModule->setDMLimit( _overload->shedding( "dmrange", level )
+            ? _shedDMFraction * _dedispersionModule->plan().dmHigh() : 0.0 );
+}
+
+void DedispersionPipeline::stageReport() const {
+    if( ! _stokesThread ) return;
+    _stokesThread->report();
+    _rfiThread->report();
+    _dedispersionThread->report();
+}
+
 void DedispersionPipeline::dedispersionAnalysis( DataBlob* blob ) {
 //qDebug() << "analysis()";
 //  std::cout << "PIPELINE: in dd analysis" << std::endl;
     DedispersionDataAnalysis result;
+    DedispersionDataAnalysis candidates;
     DedispersionSpectra* data = static_cast<DedispersionSpectra*>(blob);
     if ( _dedispersionAnalyser->analyse(data, &result) )
       {
+        // the event limits apply to the raw events, the candidates are written out
+        DedispersionDataAnalysis* output = &result;
+        if( _dedispersionClusterer ) {
+            _dedispersionClusterer->cluster( &result, &candidates );
+            output = &candidates;
+        }
+        // notify the outside world before doing anything else
+        if( _trigger ) _trigger->trigger( output );
+        output->setDegradation( _overload->level() );
+        bool writeSpectra = ! _overload->shedding( "export" );
         std::cout << "Found " << result.eventsFound() << " events" << std::endl;
         std::cout << "Limits: " << _minEventsFound << " " << _maxEventsFound << " events" << std::endl;
-        dataOutput( &result, "TriggerInput" );
+        if( ! _trigger ) dataOutput( output, "TriggerInput" );
 	if (_minEventsFound >= _maxEventsFound){
             std::cout << "Writing out..." << std::endl;
 	    if (result.eventsFound() >= _minEventsFound){
-	      dataOutput( &result, "DedispersionDataAnalysis" );
-	      foreach( const SpectrumDataSetStokes* d, result.data()->inputDataBlobs()) {
-		dataOutput( d, "SignalFoundSpectrum" );
-		//		    dataOutput( d->getRawData(), "RawDataFoundSpectrum" );
-	      }
+	      dataOutput( output, "DedispersionDataAnalysis" );
+	      if( writeSpectra ) _writeSpectra( result, *output );
 	    }
 	}
 	else{
 	  if (result.eventsFound() >= _minEventsFound && result.eventsFound() <= _maxEventsFound){
 	    std::cout << "Writing out..." << std::endl;
-	    dataOutput( &result, "DedispersionDataAnalysis" );
-	    foreach( const SpectrumDataSetStokes* d, result.data()->inputDataBlobs()) {
-	      dataOutput( d, "SignalFoundSpectrum" );
-	      //		    dataOutput( d->getRawData(), "RawDataFoundSpectrum" );
-	    }
+	    dataOutput( output, "DedispersionDataAnalysis" );
+	    if( writeSpectra ) _writeSpectra( result, *output );
 	  }
 	}
       }
 }
   
+void DedispersionPipeline::_writeSpectra( const DedispersionDataAnalysis& result,
+                                          const DedispersionDataAnalysis& candidates ) {
+    if( _dumpCompressor ) _dumpSpectra( result.data() );
+    if( ! _capture->active() ) {
+        foreach( const SpectrumDataSetStokes* d, result.data()->inputDataBlobs()) {
+            dataOutput( d, "SignalFoundSpectrum" );
+            //		    dataOutput( d->getRawData(), "RawDataFoundSpectrum" );
+        }
+        return;
+    }
+    // the capture writes the data around each candidate in the background
+    // the first event only marks the start of the buffer
+    const DedispersionSpectra* data = candidates.data();
+    const QList<DedispersionEvent>& events = candidates.events();
+    for( int i = 1; i < events.size(); ++i ) {
+        const DedispersionEvent& e = events[i];
+        _capture->trigger( data->getTime( e.timeBinLow() ),
+                           data->getTime( e.timeBinHigh() ), e.dmHigh() );
+    }
+}
+
+void DedispersionPipeline::_dumpSpectra( const DedispersionSpectra* data ) {
+    QString filename = QString("%1/spectra_%2.%3").arg(_dumpDirectory)
+                           .arg( data->getTime(0), 0, 'f', 6 )
+                           .arg( _dumpCompressor->active() ? "dmtz" : "dmt" );
+    try {
+        data->dumpbin( filename, _dumpCompressor );
+    }
+    catch( const QString& e ) {
+        std::cerr << e.toStdString() << std::endl;
+    }
+}
+
 void DedispersionPipeline::updateBufferLock( const QList<DataBlob*>& freeData ) {
      // find WeightedDataBlobs that can be unlocked
      foreach( DataBlob* blob, freeData ) {
@@ -1,5 +1,7 @@
 #include "UdpBFPipeline.h"
 #include "WeightedSpectrumDataSet.h"
+#include "CoreBudget.h"
+#include "Affinity.h"
 #include <iostream>
 
 using std::cout;
@@ -38,7 +40,15 @@ void UdpBFPipeline::init()
     ConfigNode c = config( QString("H5Pipeline") );
     _totalIterations= c.getOption("totalIterations", "value", "10000").toInt();    
     std::cout << _totalIterations << std::endl;
-// Create modules
+    // share the cores with any other streams before the modules size
+    // their thread counts
+    CoreBudget::instance().configure(c);
+    CoreBudget::instance().registerStream();
+    // place this thread (and the OpenMP workers it starts) before the
+    // modules allocate their buffers
+    Affinity::instance().configure(c);
+    Affinity::instance().pinCurrentThread( Affinity::Compute, "UdpBFPipeline" );
+
     // Create modules
     ppfChanneliser = (PPFChanneliser *) createModule("PPFChanneliser");
     stokesGenerator = (StokesGenerator *) createModule("StokesGenerator");
@@ -51,6 +61,8 @@ void UdpBFPipeline::init()
     intStokes = (SpectrumDataSetStokes*) createBlob("SpectrumDataSetStokes");
     weightedIntStokes = (WeightedSpectrumDataSet*) createBlob("WeightedSpectrumDataSet");
 
+    Affinity::instance().report();
+
     // Request remote data
     requestRemoteData(_streamIdentifier);
 